@@ -0,0 +1,597 @@
+// deferred_log.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <charconv>
+#include <type_traits>
+
+namespace neolib
+{
+    namespace logger
+    {
+        // Deferred (binary) logging: a call site records only its format site and the raw bytes of its arguments; the
+        // text is produced later by the logging thread, by format_site::decode() or, for binary log output, by a
+        // deferred_log_decoder. A format site id is a hash of the site's format string, argument signature, file and
+        // line so it is the same in every run of the same source.
+        // Format strings use "{}" placeholders ("{{" and "}}" are literal braces).
+        //
+        // Binary log records (integers are native byte order):
+        //   'S' u64 id, u32 line, u32 length + file, u32 length + format, u32 length + signature (once per site per output)
+        //   'M' u64 id, u32 severity, i32 category, u32 length + argument bytes
+        //   'T' u32 length + text (messages that were not deferred)
+        // A signature has one entry per argument: a type code ('b' bool, 'c' char, 'i' signed, 'u' unsigned,
+        // 'f' floating point, 'p' pointer, '?' other) followed by its size in bytes, or 's' for a length prefixed string.
+
+        template <typename T, typename = void>
+        struct deferred_argument
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "neolib::logger::deferred_argument: argument type not supported by deferred logging");
+            static void signature(std::string& aSignature)
+            {
+                if constexpr (std::is_same_v<T, bool>)
+                    aSignature += 'b';
+                else if constexpr (std::is_same_v<T, char>)
+                    aSignature += 'c';
+                else if constexpr (std::is_enum_v<T>)
+                    aSignature += (std::is_signed_v<std::underlying_type_t<T>> ? 'i' : 'u');
+                else if constexpr (std::is_integral_v<T>)
+                    aSignature += (std::is_signed_v<T> ? 'i' : 'u');
+                else if constexpr (std::is_floating_point_v<T>)
+                    aSignature += 'f';
+                else if constexpr (std::is_pointer_v<T>)
+                    aSignature += 'p';
+                else
+                    aSignature += '?';
+                aSignature += std::to_string(sizeof(T));
+            }
+            static void encode(std::string& aBuffer, T const& aValue)
+            {
+                aBuffer.append(reinterpret_cast<char const*>(&aValue), sizeof(T));
+            }
+            static void decode(char const*& aCursor, std::string& aOutput)
+            {
+                T value;
+                std::memcpy(&value, aCursor, sizeof(T));
+                aCursor += sizeof(T);
+                append(aOutput, value);
+            }
+        private:
+            template <typename U>
+            static void append_number(std::string& aOutput, U aValue)
+            {
+                char digits[64];
+                auto const result = std::to_chars(std::begin(digits), std::end(digits), aValue);
+                aOutput.append(digits, result.ptr);
+            }
+            static void append(std::string& aOutput, T const& aValue)
+            {
+                if constexpr (std::is_same_v<T, bool>)
+                    aOutput += (aValue ? "true" : "false");
+                else if constexpr (std::is_same_v<T, char>)
+                    aOutput += aValue;
+                else if constexpr (std::is_enum_v<T>)
+                    append_number(aOutput, static_cast<std::underlying_type_t<T>>(aValue));
+                else if constexpr (std::is_arithmetic_v<T>)
+                    append_number(aOutput, aValue);
+                else if constexpr (std::is_pointer_v<T>)
+                {
+                    aOutput += "0x";
+                    char digits[32];
+                    auto const result = std::to_chars(std::begin(digits), std::end(digits), reinterpret_cast<std::uintptr_t>(aValue), 16);
+                    aOutput.append(digits, result.ptr);
+                }
+                else
+                    aOutput += "{?}";
+            }
+        };
+
+        struct deferred_string_argument
+        {
+            static void signature(std::string& aSignature)
+            {
+                aSignature += 's';
+            }
+            static void encode(std::string& aBuffer, std::string_view const& aValue)
+            {
+                auto const size = static_cast<uint32_t>(aValue.size());
+                aBuffer.append(reinterpret_cast<char const*>(&size), sizeof(size));
+                aBuffer.append(aValue.data(), aValue.size());
+            }
+            static void decode(char const*& aCursor, std::string& aOutput)
+            {
+                uint32_t size;
+                std::memcpy(&size, aCursor, sizeof(size));
+                aCursor += sizeof(size);
+                aOutput.append(aCursor, size);
+                aCursor += size;
+            }
+        };
+
+        template <>
+        struct deferred_argument<std::string> : deferred_string_argument {};
+        template <>
+        struct deferred_argument<std::string_view> : deferred_string_argument {};
+        template <>
+        struct deferred_argument<char const*> : deferred_string_argument 
+        {
+            static void encode(std::string& aBuffer, char const* aValue)
+            {
+                deferred_string_argument::encode(aBuffer, aValue != nullptr ? std::string_view{ aValue } : std::string_view{});
+            }
+        };
+        template <>
+        struct deferred_argument<char*> : deferred_argument<char const*> {};
+
+        class format_site
+        {
+            friend class deferred_log_decoder;
+        public:
+            struct format_site_not_found : std::logic_error { format_site_not_found() : std::logic_error{ "neolib::logger::format_site::format_site_not_found" } {} };
+        public:
+            typedef uint64_t id_t;
+        private:
+            typedef void (*decoder_t)(std::string_view const& aFormat, char const* aArguments, std::string& aOutput);
+        public:
+            format_site(char const* aFile, uint32_t aLine) :
+                iId{ 0u }, iFile{ aFile }, iLine{ aLine }, iFormat{ nullptr }, iSignature{ nullptr }, iDecoder{ nullptr }
+            {
+            }
+            format_site(format_site const&) = delete;
+            format_site& operator=(format_site const&) = delete;
+        public:
+            // zero until the site is first reached
+            id_t id() const
+            {
+                return iDecoder.load(std::memory_order_acquire) != nullptr ? iId.load(std::memory_order_relaxed) : 0u;
+            }
+            char const* file() const
+            {
+                return iFile;
+            }
+            uint32_t line() const
+            {
+                return iLine;
+            }
+            char const* format() const
+            {
+                return iDecoder.load(std::memory_order_acquire) != nullptr ? iFormat.load(std::memory_order_relaxed) : "";
+            }
+            std::string_view signature() const
+            {
+                return iDecoder.load(std::memory_order_acquire) != nullptr ? std::string_view{ *iSignature.load(std::memory_order_relaxed) } : std::string_view{};
+            }
+        public:
+            template <typename... Args>
+            void bind(char const* aFormat)
+            {
+                if (iDecoder.load(std::memory_order_acquire) == nullptr)
+                {
+                    auto const& signature = signature_of<Args...>();
+                    iFormat.store(aFormat, std::memory_order_relaxed);
+                    iSignature.store(&signature, std::memory_order_relaxed);
+                    iId.store(hash(aFormat, signature, iFile, iLine), std::memory_order_relaxed);
+                    {
+                        std::lock_guard<std::mutex> lg{ registry_mutex() };
+                        registry().emplace(iId.load(std::memory_order_relaxed), this);
+                    }
+                    iDecoder.store(&decode_arguments<Args...>, std::memory_order_release);
+                }
+            }
+            template <typename... Args>
+            static void encode(std::string& aBuffer, Args const&... aArguments)
+            {
+                (deferred_argument<std::decay_t<Args>>::encode(aBuffer, aArguments), ...);
+            }
+            void decode(void const* aArguments, std::string& aOutput) const
+            {
+                auto const decoder = iDecoder.load(std::memory_order_acquire);
+                if (decoder != nullptr)
+                    decoder(iFormat.load(std::memory_order_relaxed), static_cast<char const*>(aArguments), aOutput);
+            }
+            static format_site const& find(id_t aId)
+            {
+                std::lock_guard<std::mutex> lg{ registry_mutex() };
+                auto existing = registry().find(aId);
+                if (existing != registry().end())
+                    return *existing->second;
+                throw format_site_not_found();
+            }
+            // decoding of a record consisting of a format site id followed by its argument bytes (sites reached by this process only)
+            static void decode(id_t aId, void const* aArguments, std::string& aOutput)
+            {
+                find(aId).decode(aArguments, aOutput);
+            }
+        public:
+            void write_definition(std::string& aOutput) const
+            {
+                aOutput += 'S';
+                append(aOutput, id());
+                append(aOutput, iLine);
+                append_string(aOutput, iFile);
+                append_string(aOutput, format());
+                append_string(aOutput, signature());
+            }
+            void write_record(std::string& aOutput, uint32_t aSeverity, int32_t aCategory, std::string_view const& aArguments) const
+            {
+                aOutput += 'M';
+                append(aOutput, id());
+                append(aOutput, aSeverity);
+                append(aOutput, aCategory);
+                append_string(aOutput, aArguments);
+            }
+            static void write_text_record(std::string& aOutput, std::string_view const& aText)
+            {
+                aOutput += 'T';
+                append_string(aOutput, aText);
+            }
+        private:
+            template <typename... Args>
+            static std::string const& signature_of()
+            {
+                static std::string const sSignature = []()
+                {
+                    std::string signature;
+                    (deferred_argument<std::decay_t<Args>>::signature(signature), ...);
+                    return signature;
+                }();
+                return sSignature;
+            }
+            static id_t hash(std::string_view const& aFormat, std::string_view const& aSignature, std::string_view const& aFile, uint32_t aLine)
+            {
+                // FNV-1a
+                id_t result = 0xcbf29ce484222325ull;
+                auto const add = [&](std::string_view const& aBytes)
+                {
+                    for (auto ch : aBytes)
+                    {
+                        result ^= static_cast<unsigned char>(ch);
+                        result *= 0x100000001b3ull;
+                    }
+                    result *= 0x100000001b3ull; // a zero byte separates the fields
+                };
+                add(aFormat);
+                add(aSignature);
+                add(aFile);
+                add(std::to_string(aLine));
+                return result;
+            }
+            template <typename T>
+            static void append(std::string& aOutput, T aValue)
+            {
+                aOutput.append(reinterpret_cast<char const*>(&aValue), sizeof(T));
+            }
+            static void append_string(std::string& aOutput, std::string_view const& aValue)
+            {
+                append(aOutput, static_cast<uint32_t>(aValue.size()));
+                aOutput.append(aValue.data(), aValue.size());
+            }
+            static bool next_placeholder(std::string_view& aFormat, std::string& aOutput)
+            {
+                while (!aFormat.empty())
+                {
+                    auto const ch = aFormat[0];
+                    if ((ch == '{' || ch == '}') && aFormat.size() > 1u && aFormat[1] == ch)
+                    {
+                        aOutput += ch;
+                        aFormat.remove_prefix(2u);
+                    }
+                    else if (ch == '{' && aFormat.size() > 1u && aFormat[1] == '}')
+                    {
+                        aFormat.remove_prefix(2u);
+                        return true;
+                    }
+                    else
+                    {
+                        aOutput += ch;
+                        aFormat.remove_prefix(1u);
+                    }
+                }
+                return false;
+            }
+            template <typename... Args>
+            static void decode_arguments(std::string_view const& aFormat, char const* aArguments, std::string& aOutput)
+            {
+                auto format = aFormat;
+                ((next_placeholder(format, aOutput), deferred_argument<std::decay_t<Args>>::decode(aArguments, aOutput)), ...);
+                next_placeholder(format, aOutput);
+            }
+            static std::unordered_map<id_t, format_site const*>& registry()
+            {
+                static std::unordered_map<id_t, format_site const*> sRegistry;
+                return sRegistry;
+            }
+            static std::mutex& registry_mutex()
+            {
+                static std::mutex sMutex;
+                return sMutex;
+            }
+        private:
+            std::atomic<id_t> iId;
+            char const* const iFile;
+            uint32_t const iLine;
+            std::atomic<char const*> iFormat;
+            std::atomic<std::string const*> iSignature;
+            std::atomic<decoder_t> iDecoder;
+        };
+
+        // Turns binary log records back into the text the logger would have written. Site definitions are read from the
+        // records themselves so the decoder does not need the process (or even the program) that wrote them.
+        class deferred_log_decoder
+        {
+        public:
+            struct bad_record : std::runtime_error { bad_record() : std::runtime_error{ "neolib::logger::deferred_log_decoder::bad_record" } {} };
+            struct unknown_site : std::runtime_error { unknown_site() : std::runtime_error{ "neolib::logger::deferred_log_decoder::unknown_site" } {} };
+        public:
+            struct site
+            {
+                std::string file;
+                uint32_t line;
+                std::string format;
+                std::string signature;
+            };
+        public:
+            // decodes the complete records at the start of aRecords appending their text to aOutput; returns the number of
+            // bytes consumed so a trailing partial record can be passed again with more data
+            std::size_t decode(std::string_view const& aRecords, std::string& aOutput)
+            {
+                std::size_t consumed = 0u;
+                for (;;)
+                {
+                    std::string_view record = aRecords.substr(consumed);
+                    if (record.empty() || !decode_record(record, aOutput))
+                        return consumed;
+                    consumed = aRecords.size() - record.size();
+                }
+            }
+            site const& find(format_site::id_t aId) const
+            {
+                auto existing = iSites.find(aId);
+                if (existing != iSites.end())
+                    return existing->second;
+                throw unknown_site();
+            }
+        private:
+            bool decode_record(std::string_view& aRecord, std::string& aOutput)
+            {
+                auto cursor = aRecord;
+                char tag;
+                if (!read(cursor, tag))
+                    return false;
+                switch (tag)
+                {
+                case 'S':
+                    {
+                        format_site::id_t id;
+                        site definition;
+                        if (!read(cursor, id) || !read(cursor, definition.line) || !read_string(cursor, definition.file) ||
+                            !read_string(cursor, definition.format) || !read_string(cursor, definition.signature))
+                            return false;
+                        iSites[id] = std::move(definition);
+                    }
+                    break;
+                case 'M':
+                    {
+                        format_site::id_t id;
+                        uint32_t severity;
+                        int32_t category;
+                        std::string_view arguments;
+                        if (!read(cursor, id) || !read(cursor, severity) || !read(cursor, category) || !read_string(cursor, arguments))
+                            return false;
+                        auto const& definition = find(id);
+                        decode_arguments(definition, arguments, aOutput);
+                        aOutput += '\n';
+                    }
+                    break;
+                case 'T':
+                    {
+                        std::string_view text;
+                        if (!read_string(cursor, text))
+                            return false;
+                        aOutput += text;
+                    }
+                    break;
+                default:
+                    throw bad_record();
+                }
+                aRecord = cursor;
+                return true;
+            }
+            static void decode_arguments(site const& aSite, std::string_view aArguments, std::string& aOutput)
+            {
+                std::string_view format = aSite.format;
+                std::string_view signature = aSite.signature;
+                while (!signature.empty())
+                {
+                    auto const code = signature[0];
+                    signature.remove_prefix(1u);
+                    std::size_t size = 0u;
+                    if (code != 's')
+                    {
+                        auto const result = std::from_chars(signature.data(), signature.data() + signature.size(), size);
+                        if (result.ec != std::errc{})
+                            throw bad_record();
+                        signature.remove_prefix(result.ptr - signature.data());
+                    }
+                    format_site::next_placeholder(format, aOutput);
+                    if (code == 's')
+                    {
+                        std::string_view value;
+                        if (!read_string(aArguments, value))
+                            throw bad_record();
+                        aOutput += value;
+                        continue;
+                    }
+                    if (aArguments.size() < size)
+                        throw bad_record();
+                    decode_value(code, aArguments.substr(0u, size), aOutput);
+                    aArguments.remove_prefix(size);
+                }
+                format_site::next_placeholder(format, aOutput);
+            }
+            static void decode_value(char aCode, std::string_view const& aBytes, std::string& aOutput)
+            {
+                switch (aCode)
+                {
+                case 'b':
+                    aOutput += (aBytes[0] != 0 ? "true" : "false");
+                    break;
+                case 'c':
+                    aOutput += aBytes[0];
+                    break;
+                case 'i':
+                    switch (aBytes.size())
+                    {
+                    case 1: append_number(aOutput, value<int8_t>(aBytes)); return;
+                    case 2: append_number(aOutput, value<int16_t>(aBytes)); return;
+                    case 4: append_number(aOutput, value<int32_t>(aBytes)); return;
+                    case 8: append_number(aOutput, value<int64_t>(aBytes)); return;
+                    }
+                    aOutput += "{?}";
+                    break;
+                case 'u':
+                    switch (aBytes.size())
+                    {
+                    case 1: append_number(aOutput, value<uint8_t>(aBytes)); return;
+                    case 2: append_number(aOutput, value<uint16_t>(aBytes)); return;
+                    case 4: append_number(aOutput, value<uint32_t>(aBytes)); return;
+                    case 8: append_number(aOutput, value<uint64_t>(aBytes)); return;
+                    }
+                    aOutput += "{?}";
+                    break;
+                case 'f':
+                    if (aBytes.size() == sizeof(float))
+                        append_number(aOutput, value<float>(aBytes));
+                    else if (aBytes.size() == sizeof(double))
+                        append_number(aOutput, value<double>(aBytes));
+                    else if (aBytes.size() == sizeof(long double))
+                        append_number(aOutput, value<long double>(aBytes));
+                    else
+                        aOutput += "{?}";
+                    break;
+                case 'p':
+                    {
+                        uint64_t address = 0u;
+                        if (aBytes.size() == sizeof(uint32_t))
+                            address = value<uint32_t>(aBytes);
+                        else if (aBytes.size() == sizeof(uint64_t))
+                            address = value<uint64_t>(aBytes);
+                        aOutput += "0x";
+                        char digits[32];
+                        auto const result = std::to_chars(std::begin(digits), std::end(digits), address, 16);
+                        aOutput.append(digits, result.ptr);
+                    }
+                    break;
+                case '?':
+                    aOutput += "{?}";
+                    break;
+                default:
+                    throw bad_record();
+                }
+            }
+            template <typename T>
+            static T value(std::string_view const& aBytes)
+            {
+                T result;
+                std::memcpy(&result, aBytes.data(), sizeof(T));
+                return result;
+            }
+            template <typename T>
+            static void append_number(std::string& aOutput, T aValue)
+            {
+                char digits[64];
+                auto const result = std::to_chars(std::begin(digits), std::end(digits), aValue);
+                aOutput.append(digits, result.ptr);
+            }
+            template <typename T>
+            static bool read(std::string_view& aCursor, T& aValue)
+            {
+                if (aCursor.size() < sizeof(T))
+                    return false;
+                std::memcpy(&aValue, aCursor.data(), sizeof(T));
+                aCursor.remove_prefix(sizeof(T));
+                return true;
+            }
+            static bool read_string(std::string_view& aCursor, std::string_view& aValue)
+            {
+                uint32_t size;
+                auto cursor = aCursor;
+                if (!read(cursor, size) || cursor.size() < size)
+                    return false;
+                aValue = cursor.substr(0u, size);
+                cursor.remove_prefix(size);
+                aCursor = cursor;
+                return true;
+            }
+            static bool read_string(std::string_view& aCursor, std::string& aValue)
+            {
+                std::string_view value;
+                if (!read_string(aCursor, value))
+                    return false;
+                aValue = value;
+                return true;
+            }
+        private:
+            std::unordered_map<format_site::id_t, site> iSites;
+        };
+    }
+}
+
+// the logger, severity and category are evaluated first and the arguments are only evaluated if the message will be logged
+#define deferred_log_category( logTarget, logSeverity, logCategory, ... ) \
+    do \
+    { \
+        auto& deferredLogger = (logTarget); \
+        neolib::logger::severity const deferredLogSeverity = (logSeverity); \
+        neolib::logger::category const deferredLogCategory{ logCategory }; \
+        if (deferredLogger.would_log(deferredLogSeverity, deferredLogCategory.id)) \
+        { \
+            static neolib::logger::format_site deferredLogSite{ __FILE__, static_cast<uint32_t>(__LINE__) }; \
+            deferredLogger.log_deferred(deferredLogSeverity, deferredLogCategory.id, deferredLogSite, __VA_ARGS__); \
+        } \
+    } while (false)
+
+#define deferred_log( logTarget, logSeverity, ... ) \
+    deferred_log_category( logTarget, logSeverity, neolib::logger::category_id{}, __VA_ARGS__ )
@@ -40,6 +40,7 @@
 #include <sstream>
 #include <neolib/core/string.hpp>
 #include <neolib/app/services.hpp>
+#include <neolib/app/deferred_log.hpp>
 
 namespace neolib
 {
@@ -76,12 +77,11 @@ namespace neolib
         const endl_t endl;
         const flush_t flush;
 
+        // message tokens are streamed into a buffer owned by the calling thread so no locking is required
         class client_logger_buffers
         {
         protected:
             typedef std::ostringstream buffer_t;
-        private:
-            typedef std::map<std::thread::id, buffer_t> buffer_list_t;
         public:
             static client_logger_buffers& instance()
             {
@@ -91,30 +91,9 @@ namespace neolib
         public:
             buffer_t& buffer()
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                thread_local struct cleanup
-                {
-                    client_logger_buffers& parent;
-                    ~cleanup()
-                    {
-                        std::lock_guard<std::recursive_mutex> lg{ parent.mutex() };
-                        parent.buffers().erase(std::this_thread::get_id());
-                    }
-                } cleanup{ *this };
-                return iBuffers[std::this_thread::get_id()];
-            }
-            buffer_list_t& buffers()
-            {
-                return iBuffers;
+                thread_local buffer_t tBuffer;
+                return tBuffer;
             }
-        private:
-            std::recursive_mutex& mutex() const
-            {
-                return iMutex;
-            }
-        private:
-            mutable std::recursive_mutex iMutex;
-            buffer_list_t iBuffers;
         };
 
         class i_logger;
@@ -148,6 +127,7 @@ namespace neolib
             virtual bool category_enabled(category_id aId) const = 0;
             virtual void enable_category(category_id aId) = 0;
             virtual void disable_category(category_id aId) = 0;
+            virtual bool would_log(severity aSeverity, category_id aCategory) const = 0;
         public:
             virtual bool has_formatter() const = 0;
             virtual i_formatter& formatter() const = 0;
@@ -207,11 +187,21 @@ namespace neolib
                 client_logger_buffers::instance().buffer() << aValue;
                 return *this;
             }
+            template <typename... Args>
+            void log_deferred(severity aSeverity, category_id aCategory, format_site& aSite, char const* aFormat, Args const&... aArguments)
+            {
+                aSite.bind<Args...>(aFormat);
+                thread_local std::string tArguments;
+                tArguments.clear();
+                format_site::encode(tArguments, aArguments...);
+                flush(aSite, aSeverity, aCategory, tArguments.data(), tArguments.size());
+            }
         public:
             virtual void commit() = 0;
             virtual void wait() const = 0;
         protected:
             virtual void flush(i_string const& aMessage) = 0;
+            virtual void flush(format_site const& aSite, severity aSeverity, category_id aCategory, void const* aArguments, std::size_t aArgumentsSize) = 0;
         };
 
         class formatter : public i_formatter
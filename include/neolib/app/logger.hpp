@@ -36,15 +36,21 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <algorithm>
 #include <map>
+#include <unordered_set>
 #include <vector>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <atomic>
 #include <chrono>
+#include <boost/lockfree/detail/prefix.hpp>
 #include <neolib/core/lifetime.hpp>
+#include <neolib/core/scoped.hpp>
 #include <neolib/app/i_logger.hpp>
 
 namespace neolib
@@ -58,27 +64,95 @@ namespace neolib
         protected:
             typedef std::string buffer_t;
         private:
+            // single producer (the owning client thread), single consumer (the logging thread or a thread calling commit());
+            // a message is either text or, if it has a format site, the encoded arguments of a deferred message
+            struct message
+            {
+                format_site const* site = nullptr;
+                severity messageSeverity = severity::Info;
+                category_id messageCategory = {};
+                std::string content;
+            };
+            class thread_buffer
+            {
+            public:
+                static constexpr std::size_t kCapacity = 1024u;
+            public:
+                thread_buffer() :
+                    iMessages{ kCapacity }, iWrite{ 0u }, iRead{ 0u }, iClosed{ false }
+                {
+                }
+            public:
+                bool empty() const noexcept
+                {
+                    return iRead.load(std::memory_order_acquire) == iWrite.load(std::memory_order_acquire);
+                }
+                bool try_push(format_site const* aSite, severity aSeverity, category_id aCategory, std::string_view const& aContent)
+                {
+                    auto const write = iWrite.load(std::memory_order_relaxed);
+                    if (write - iRead.load(std::memory_order_acquire) == kCapacity)
+                        return false;
+                    auto& slot = iMessages[write % kCapacity];
+                    slot.site = aSite;
+                    slot.messageSeverity = aSeverity;
+                    slot.messageCategory = aCategory;
+                    slot.content.assign(aContent);
+                    iWrite.store(write + 1u, std::memory_order_release);
+                    return true;
+                }
+                template <typename Consumer>
+                void drain(Consumer aConsumer)
+                {
+                    auto read = iRead.load(std::memory_order_relaxed);
+                    auto const write = iWrite.load(std::memory_order_acquire);
+                    for (; read != write; ++read)
+                        aConsumer(iMessages[read % kCapacity]);
+                    iRead.store(read, std::memory_order_release);
+                }
+                bool closed() const noexcept
+                {
+                    return iClosed.load(std::memory_order_acquire);
+                }
+                void close() noexcept
+                {
+                    iClosed.store(true, std::memory_order_release);
+                }
+            private:
+                std::vector<message> iMessages;
+                alignas(BOOST_LOCKFREE_CACHELINE_BYTES) std::atomic<std::size_t> iWrite;
+                alignas(BOOST_LOCKFREE_CACHELINE_BYTES) std::atomic<std::size_t> iRead;
+                std::atomic<bool> iClosed;
+            };
             typedef std::map<category_id, std::pair<bool, std::string>> category_map_t;
-            typedef std::map<std::thread::id, std::pair<std::shared_ptr<buffer_t>, std::shared_ptr<buffer_t>>> buffer_list_t;
+            typedef std::map<category_id, bool> category_state_map_t;
+            typedef std::vector<std::shared_ptr<thread_buffer>> buffer_list_t;
             typedef std::vector<i_logger*> copy_list_t;
+            static constexpr std::size_t kMaxCategoryCaches = 16u;
         public:
-            logger()
+            logger() :
+                iSerial{ next_serial() }
             {
             }
             ~logger()
             {
                 set_destroying();
+                // lets client threads forget their registrations with this logger
+                std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                for (auto& buffer : buffers())
+                    buffer->close();
             }
         public:
             void copy_to(i_logger& aLogger) override
             {
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 copies().push_back(&aLogger);
+                iHaveCopies = true;
             }
             void cancel_copy_to(i_logger& aLogger) override
             {
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 copies().erase(std::remove(copies().begin(), copies().end(), &aLogger), copies().end());
+                iHaveCopies = !copies().empty();
             }
             bool has_logging_thread() const override
             {
@@ -92,26 +166,44 @@ namespace neolib
                     throw logging_thread_already_created();
                 iLoggingThread.emplace([&]()
                 {
+                    iLoggingThreadId = std::this_thread::get_id();
                     for(;;)
                     {
-                        std::unique_lock<std::mutex> lk(commit_signal_mutex());
-                        iCommitSignal.wait(lk, [&]() { return any_available() || is_destroying(); });
+                        {
+                            std::unique_lock<std::mutex> lk(commit_signal_mutex());
+                            iLoggingThreadWaiting.store(true);
+                            std::atomic_thread_fence(std::memory_order_seq_cst);
+                            iCommitSignal.wait(lk, [&]() { return any_available() || is_destroying(); });
+                            iLoggingThreadWaiting.store(false);
+                        }
                         commit();
                         if (is_destroying())
                             break;
                     };
                 });
+                iLoggingThreadId = iLoggingThread->get_id();
             }
         public:
-            severity filter_severity() const override
+            // binary output is a stream of records (see deferred_log.hpp) that is turned into text by a deferred_log_decoder
+            bool binary_output() const
             {
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                return iFilterSeverity;
+                return iBinaryOutput;
             }
-            void set_filter_severity(severity aSeverity) override
+            void set_binary_output(bool aBinaryOutput)
             {
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                iFilterSeverity = aSeverity;
+                iBinaryOutput = aBinaryOutput;
+                iWrittenSites.clear();
+            }
+        public:
+            severity filter_severity() const override
+            {
+                return iFilterSeverity.load(std::memory_order_relaxed);
+            }
+            void set_filter_severity(severity aSeverity) override
+            {
+                iFilterSeverity.store(aSeverity, std::memory_order_relaxed);
             }
             using i_logger::register_category;
             using i_logger::category_enabled;
@@ -122,6 +214,7 @@ namespace neolib
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 iCategories[aId].first = true;
                 iCategories[aId].second = aName.to_std_string_view();
+                ++iCategoriesGeneration;
                 for (auto& copy : copies())
                     copy->register_category(aId, aName);
             }
@@ -131,12 +224,26 @@ namespace neolib
                 auto existing = iCategories.find(aId);
                 return existing != iCategories.end() && existing->second.first;
             }
+            bool would_log(severity aSeverity, category_id aCategory) const override
+            {
+                if (aSeverity >= filter_severity() && message_category_enabled(aCategory))
+                    return true;
+                if (iHaveCopies)
+                {
+                    std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                    for (auto& copy : copies())
+                        if (copy->would_log(aSeverity, aCategory))
+                            return true;
+                }
+                return false;
+            }
             void enable_category(category_id aId) override
             {
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 auto existing = iCategories.find(aId);
                 if (existing != iCategories.end())
                     existing->second.first = true;
+                ++iCategoriesGeneration;
                 for (auto& copy : copies())
                     copy->enable_category(aId);
             }
@@ -146,35 +253,36 @@ namespace neolib
                 auto existing = iCategories.find(aId);
                 if (existing != iCategories.end())
                     existing->second.first = false;
+                ++iCategoriesGeneration;
                 for (auto& copy : copies())
                     copy->disable_category(aId);
             }
         public:
             bool has_formatter() const override
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                return iFormatter != nullptr;
+                return iFormatter.load() != nullptr;
             }
             i_formatter& formatter() const override
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                if (iFormatter != nullptr)
-                    return *iFormatter;
+                auto const formatter = iFormatter.load();
+                if (formatter != nullptr)
+                    return *formatter;
                 throw no_formatter();
             }
             void set_formatter(i_formatter& aFormatter) override
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                iFormatter = std::shared_ptr<i_formatter>{ std::shared_ptr<i_formatter>{}, &aFormatter };
+                iFormatter = &aFormatter;
             }
             void clear_formatter() override
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 iFormatter = nullptr;
             }
         public:
             line_id_t line_id() const override
             {
+                auto const& formatting = formatting_line();
+                if (formatting.first == this)
+                    return formatting.second;
                 return iLineId;
             }
             void reset_line_id(line_id_t aLineId = DefaultInitialLineId) override
@@ -185,18 +293,24 @@ namespace neolib
             using i_logger::operator<<;
             i_logger& operator<<(severity aSeverity) override
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 set_message_severity(aSeverity);
-                for (auto& copy : copies())
-                    (*copy) << aSeverity;
+                if (iHaveCopies)
+                {
+                    std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                    for (auto& copy : copies())
+                        (*copy) << aSeverity;
+                }
                 return *this;
             }
             i_logger& operator<<(category_id aCategory) override
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 set_message_category(aCategory);
-                for (auto& copy : copies())
-                    (*copy) << aCategory;
+                if (iHaveCopies)
+                {
+                    std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                    for (auto& copy : copies())
+                        (*copy) << aCategory;
+                }
                 return *this;
             }
         protected:
@@ -219,58 +333,101 @@ namespace neolib
             }
             severity message_severity() const
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 return message_severity_ref();
             }
             void set_message_severity(severity aMessageSeverity)
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 message_severity_ref() = aMessageSeverity;
             }
             category_id message_category() const
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 return message_category_ref();
             }
             void set_message_category(category_id aid)
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 message_category_ref() = aid;
             }
             bool message_category_enabled() const
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                auto existing = iCategories.find(message_category());
-                return existing == iCategories.end() || existing->second.first;
+                return message_category_enabled(message_category());
+            }
+            bool message_category_enabled(category_id aCategory) const
+            {
+                // categories change rarely so each client thread checks against its own snapshot of them, one per logger
+                struct category_cache
+                {
+                    uint64_t logger = 0ull;
+                    uint64_t generation = 0ull;
+                    category_state_map_t categories;
+                };
+                thread_local std::vector<category_cache> tCaches;
+                auto cache = std::find_if(tCaches.begin(), tCaches.end(), [&](category_cache const& aCache) { return aCache.logger == iSerial; });
+                if (cache == tCaches.end())
+                {
+                    // serials are never reused so snapshots of destroyed loggers are only dropped once there are too many
+                    if (tCaches.size() >= kMaxCategoryCaches)
+                        tCaches.clear();
+                    cache = tCaches.insert(tCaches.end(), category_cache{ iSerial, 0ull, {} });
+                }
+                auto const generation = iCategoriesGeneration.load();
+                if (cache->generation != generation)
+                {
+                    std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                    cache->generation = iCategoriesGeneration;
+                    cache->categories.clear();
+                    for (auto const& category : iCategories)
+                        cache->categories.emplace(category.first, category.second.first);
+                }
+                auto existing = cache->categories.find(aCategory);
+                return existing == cache->categories.end() || existing->second;
             }
         public:
             void commit() override
             {
-                if (!iLoggingThread || std::this_thread::get_id() == iLoggingThread->get_id())
+                if (iLoggingThreadId.load() == std::thread::id{} || std::this_thread::get_id() == iLoggingThreadId.load())
                 {
-                    {
-                        std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                        for (auto& entry : buffers())
-                        {
-                            auto& buffers = entry.second;
-                            std::swap(buffers.first, buffers.second);
-                        }
-                    }
                     thread_local buffer_t tempBuffer;
-                    for (auto& entry : buffers())
                     {
-                        auto& buffer = *entry.second.second;
-                        if (!buffer.empty())
+                        std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                        for (auto b = buffers().begin(); b != buffers().end();)
                         {
-                            tempBuffer += buffer;
-                            buffer.clear();
+                            auto& buffer = **b;
+                            bool const closed = buffer.closed();
+                            buffer.drain([&](message const& aMessage)
+                            {
+                                if (iBinaryOutput)
+                                {
+                                    if (aMessage.site == nullptr)
+                                        format_site::write_text_record(tempBuffer, aMessage.content);
+                                    else
+                                    {
+                                        // a site's definition precedes its first record in each output
+                                        if (iWrittenSites.insert(aMessage.site->id()).second)
+                                            aMessage.site->write_definition(tempBuffer);
+                                        aMessage.site->write_record(tempBuffer, static_cast<uint32_t>(aMessage.messageSeverity),
+                                            static_cast<int32_t>(aMessage.messageCategory), aMessage.content);
+                                    }
+                                }
+                                else if (aMessage.site != nullptr)
+                                {
+                                    // deferred message: format from its encoded arguments now
+                                    aMessage.site->decode(aMessage.content.data(), tempBuffer);
+                                    tempBuffer += '\n';
+                                }
+                                else
+                                    tempBuffer += aMessage.content;
+                            });
+                            if (closed && buffer.empty())
+                                b = buffers().erase(b);
+                            else
+                                ++b;
                         }
                     }
                     commit(tempBuffer);
                     tempBuffer.clear();
                 }
                 else
-                    commit_signal().notify_one();
+                    signal_logging_thread();
             }
             void wait() const override
             {
@@ -286,28 +443,45 @@ namespace neolib
         protected:
             void flush(i_string const& aMessage) override
             {
-                bool notify = false;
-                { 
-                    std::scoped_lock lg{ mutex(), commit_signal_mutex() };
-                    if (message_severity() >= filter_severity() && message_category_enabled())
+                if (message_severity() >= filter_severity() && message_category_enabled())
+                    push(nullptr, message_severity(), message_category(), format(aMessage));
+                if (iHaveCopies)
+                {
+                    std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                    for (auto& copy : copies())
+                        copy->flush(aMessage);
+                }
+            }
+            void flush(format_site const& aSite, severity aSeverity, category_id aCategory, void const* aArguments, std::size_t aArgumentsSize) override
+            {
+                if (aSeverity >= filter_severity() && message_category_enabled(aCategory))
+                {
+                    if (!has_formatter())
                     {
-                        if (!has_formatter())
-                            buffer() += aMessage.to_std_string_view();
-                        else
-                        {
-                            thread_local string tempFormattedMessage;
-                            formatter().format(*this, aMessage, tempFormattedMessage);
-                            buffer() += tempFormattedMessage.to_std_string_view();
-                            tempFormattedMessage.clear();
-                        }
                         ++iLineId;
-                        notify = true;
+                        push(&aSite, aSeverity, aCategory, std::string_view{ static_cast<char const*>(aArguments), aArgumentsSize });
                     }
+                    else
+                    {
+                        // the formatter needs the text so a formatted message can't be deferred
+                        thread_local std::string tempDeferredMessage;
+                        thread_local string tempUnformattedMessage;
+                        aSite.decode(aArguments, tempDeferredMessage);
+                        tempDeferredMessage += '\n';
+                        tempUnformattedMessage.assign(tempDeferredMessage.data(), tempDeferredMessage.size());
+                        tempDeferredMessage.clear();
+                        scoped_object<severity> ss{ message_severity_ref(), aSeverity };
+                        scoped_object<category_id> sc{ message_category_ref(), aCategory };
+                        push(nullptr, aSeverity, aCategory, format(tempUnformattedMessage));
+                    }
+                }
+                if (iHaveCopies)
+                {
+                    std::lock_guard<std::recursive_mutex> lg{ mutex() };
                     for (auto& copy : copies())
-                        copy->flush(aMessage);
+                        if (copy->would_log(aSeverity, aCategory))
+                            copy->flush(aSite, aSeverity, aCategory, aArguments, aArgumentsSize);
                 }
-                if (notify)
-                    commit_signal().notify_one();
             }
         protected:
             virtual void commit(buffer_t const& aBuffer) = 0;
@@ -331,6 +505,11 @@ namespace neolib
                 }
             }
         private:
+            static uint64_t next_serial()
+            {
+                static std::atomic<uint64_t> sNextSerial = 1ull;
+                return sNextSerial++;
+            }
             severity const& message_severity_ref() const
             {
                 thread_local severity tMessageSeverity = severity::Info;
@@ -349,47 +528,96 @@ namespace neolib
             {
                 return const_cast<category_id&>(const_cast<self_type const&>(*this).message_category_ref());
             }
+            // the formatter runs on the calling thread so that it sees the caller's context (thread, time, severity and
+            // category); line_id() reports the id of the message being formatted
+            std::string_view format(i_string const& aMessage)
+            {
+                auto const lineId = iLineId++;
+                auto const formatter = iFormatter.load();
+                if (formatter == nullptr)
+                    return aMessage.to_std_string_view();
+                thread_local string tempFormattedMessage;
+                tempFormattedMessage.clear();
+                scoped_object<std::pair<self_type const*, line_id_t>> sf{ formatting_line(), { this, lineId } };
+                formatter->format(*this, aMessage, tempFormattedMessage);
+                return tempFormattedMessage.to_std_string_view();
+            }
+            static std::pair<self_type const*, line_id_t>& formatting_line()
+            {
+                thread_local std::pair<self_type const*, line_id_t> tFormattingLine;
+                return tFormattingLine;
+            }
             bool any_available() const
             {
                 std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                for (auto& entry : buffers())
-                {
-                    auto& buffer = *entry.second.first;
-                    if (!buffer.empty())
+                for (auto& buffer : buffers())
+                    if (!buffer->empty())
                         return true;
-                }
                 return false;
             }
-            buffer_t const& buffer() const
+            void push(format_site const* aSite, severity aSeverity, category_id aCategory, std::string_view const& aContent)
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
-                thread_local struct cleanup
+                auto& buffer = this_thread_buffer();
+                while (!buffer.try_push(aSite, aSeverity, aCategory, aContent))
                 {
-                    logger const& parent;
-                    destroyed_flag parentDestroyed;
-                    ~cleanup()
+                    // buffer full: apply back pressure until the consumer has caught up
+                    if (iLoggingThreadId.load() == std::thread::id{})
+                        commit();
+                    else
                     {
-                        if (!parentDestroyed)
-                        {
-                            parent.wait();
-                            std::lock_guard<std::recursive_mutex> lg{ parent.mutex() };
-                            parent.buffers().erase(std::this_thread::get_id());
-                        }
+                        signal_logging_thread();
+                        std::this_thread::yield();
                     }
-                } cleanup{ *this, *this };
-                auto existing = iBuffers.find(std::this_thread::get_id());
-                if (existing != iBuffers.end())
-                    return *existing->second.first;
-                existing = iBuffers.insert(buffer_list_t::value_type{ std::this_thread::get_id(), buffer_list_t::mapped_type{ std::make_shared<buffer_t>(), std::make_shared<buffer_t>() } }).first;
-                return *existing->second.first;
+                }
+                signal_logging_thread();
+            }
+            void signal_logging_thread() const
+            {
+                // pairs with the logging thread setting iLoggingThreadWaiting before checking for available messages
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (iLoggingThreadWaiting.load(std::memory_order_relaxed))
+                {
+                    { std::lock_guard<std::mutex> lk{ commit_signal_mutex() }; }
+                    commit_signal().notify_one();
+                }
             }
-            buffer_t& buffer()
+            thread_buffer& this_thread_buffer() const
             {
-                return const_cast<buffer_t&>(const_cast<logger const&>(*this).buffer());
+                // a thread can log to several loggers (directly or via copy_to) so it keeps one registration per logger
+                thread_local struct registrations
+                {
+                    struct registration
+                    {
+                        uint64_t logger;
+                        std::shared_ptr<thread_buffer> buffer;
+                    };
+                    std::vector<registration> entries;
+                    std::size_t last = 0u;
+                    ~registrations()
+                    {
+                        for (auto& entry : entries)
+                            entry.buffer->close();
+                    }
+                } tRegistrations;
+                auto& entries = tRegistrations.entries;
+                if (tRegistrations.last < entries.size() && entries[tRegistrations.last].logger == iSerial)
+                    return *entries[tRegistrations.last].buffer;
+                for (std::size_t index = 0u; index < entries.size(); ++index)
+                    if (entries[index].logger == iSerial)
+                    {
+                        tRegistrations.last = index;
+                        return *entries[index].buffer;
+                    }
+                // a buffer is only closed by its client thread on exit or by its logger on destruction
+                std::erase_if(entries, [](auto const& aEntry) { return aEntry.buffer->closed(); });
+                entries.push_back({ iSerial, std::make_shared<thread_buffer>() });
+                tRegistrations.last = entries.size() - 1u;
+                std::lock_guard<std::recursive_mutex> lg{ mutex() };
+                buffers().push_back(entries.back().buffer);
+                return *entries.back().buffer;
             }
             buffer_list_t& buffers() const
             {
-                std::lock_guard<std::recursive_mutex> lg{ mutex() };
                 return iBuffers;
             }
             copy_list_t const& copies() const
@@ -401,16 +629,23 @@ namespace neolib
                 return iCopies;
             }
         private:
+            uint64_t const iSerial;
             mutable std::recursive_mutex iMutex;
             mutable std::mutex iCommitSignalMutex;
             mutable std::condition_variable iCommitSignal;
             std::optional<std::thread> iLoggingThread;
-            severity iFilterSeverity = severity::Info;
+            std::atomic<std::thread::id> iLoggingThreadId;
+            std::atomic<bool> iLoggingThreadWaiting = false;
+            std::atomic<severity> iFilterSeverity = severity::Info;
             category_map_t iCategories;
-            std::shared_ptr<i_formatter> iFormatter;
-            line_id_t iLineId = DefaultInitialLineId;
+            std::atomic<uint64_t> iCategoriesGeneration = 1ull;
+            std::atomic<i_formatter*> iFormatter = nullptr;
+            bool iBinaryOutput = false;
+            std::unordered_set<format_site::id_t> iWrittenSites;
+            std::atomic<line_id_t> iLineId = DefaultInitialLineId;
             mutable buffer_list_t iBuffers;
             copy_list_t iCopies;
+            std::atomic<bool> iHaveCopies = false;
         public:
             static uuid const& iid() { static uuid const sIid{ Instance + 0x442ed95b, 0x215c, 0x4b6e, 0xb945, { 0xf9, 0x61, 0xc4, 0xca, 0xd8, 0x7b } }; return sIid; }
         };
@@ -42,10 +42,12 @@
 #include <boost/pool/pool_alloc.hpp>
 #include <boost/pool/singleton_pool.hpp>
 #include <neolib/core/memory.hpp>
+#include <neolib/core/size_class_allocator.hpp>
 
 namespace neolib
 {
 
+    // Non-omega instances allocate from the shared size_class_pool; ChunkSize and Instance only partition omega pools.
     template <typename T, std::size_t ChunkSize = 4096, bool Omega = false, std::size_t Instance = 0>
     class neo_pool_allocator
     {
@@ -201,7 +203,9 @@ namespace neolib
     public:
         static pointer allocate(size_type aCount = 1)
         {
-            if (aCount == 1)
+            if constexpr (!Omega)
+                return size_class_allocator<T>::allocate(aCount);
+            else if (aCount == 1)
                 return reinterpret_cast<pointer>(get_pool().allocate());
             else
                 return backup_allocator().allocate(aCount);
@@ -210,12 +214,7 @@ namespace neolib
         static void deallocate(pointer aObject, size_type aCount = 1)
         {
             if constexpr (!Omega)
-            {
-                if (aCount == 1)
-                    get_pool().deallocate(aObject);
-                else
-                    backup_allocator().deallocate(aObject, aCount);
-            }
+                size_class_allocator<T>::deallocate(aObject, aCount);
         }
 
         static void construct(pointer aObject, const_reference val)
@@ -240,10 +239,18 @@ namespace neolib
             get_pool().omega_recycle();
         }
 
+        static size_class_statistics statistics() requires (!Omega)
+        {
+            return size_class_allocator<T>::statistics();
+        }
+
         template <typename CharT, typename Traits>
         static void info(std::basic_ostream<CharT, Traits>& aOutput)
         {
-            get_pool().info(aOutput);
+            if constexpr (!Omega)
+                aOutput << statistics() << std::endl;
+            else
+                get_pool().info(aOutput);
         }
 
         template <typename U>
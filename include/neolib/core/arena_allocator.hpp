@@ -0,0 +1,261 @@
+// arena_allocator.hpp
+/*
+ *  Copyright (c) 2020 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+namespace neolib
+{
+    // Bump allocator that hands out memory from large blocks and only gives it back when the whole arena is
+    // released. A thread can make an arena current with monotonic_arena::scope; default constructed
+    // arena_allocator instances then allocate from it.
+    class monotonic_arena
+    {
+    public:
+        struct no_current_arena : std::logic_error { no_current_arena() : std::logic_error("neolib::monotonic_arena::no_current_arena") {} };
+    public:
+        class scope
+        {
+        public:
+            scope(monotonic_arena& aArena) :
+                iPrevious{ tCurrent }
+            {
+                tCurrent = &aArena;
+            }
+            ~scope()
+            {
+                tCurrent = iPrevious;
+            }
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+        private:
+            monotonic_arena* iPrevious;
+        };
+    private:
+        struct block
+        {
+            block* iNext;
+            std::size_t iSize;
+        };
+        static constexpr std::size_t header_size = (sizeof(block) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    public:
+        static constexpr std::size_t default_block_size = 64u * 1024u;
+        static constexpr std::size_t max_block_size = 4u * 1024u * 1024u;
+        // construction
+    public:
+        monotonic_arena(std::size_t aInitialBlockSize = default_block_size) :
+            iInitialBlockSize{ aInitialBlockSize },
+            iNextBlockSize{ aInitialBlockSize },
+            iBlocks{ nullptr },
+            iNext{ nullptr },
+            iEnd{ nullptr },
+            iBlockCount{ 0u },
+            iReserved{ 0u },
+            iAllocated{ 0u }
+        {
+        }
+        ~monotonic_arena()
+        {
+            release();
+        }
+        monotonic_arena(const monotonic_arena&) = delete;
+        monotonic_arena& operator=(const monotonic_arena&) = delete;
+        // operations
+    public:
+        static monotonic_arena* current()
+        {
+            return tCurrent;
+        }
+        void* allocate(std::size_t aSize, std::size_t aAlignment = alignof(std::max_align_t))
+        {
+            char* result = align(iNext, aAlignment);
+            if (iNext == nullptr || result > iEnd || aSize > static_cast<std::size_t>(iEnd - result))
+            {
+                grow(aSize + aAlignment);
+                result = align(iNext, aAlignment);
+            }
+            iNext = result + aSize;
+            iAllocated += aSize;
+            return result;
+        }
+        // frees every block in O(blocks); nothing allocated from the arena may be used afterwards
+        void release()
+        {
+            while (iBlocks != nullptr)
+            {
+                block* next = iBlocks->iNext;
+                ::operator delete(iBlocks);
+                iBlocks = next;
+            }
+            iNextBlockSize = iInitialBlockSize;
+            iNext = nullptr;
+            iEnd = nullptr;
+            iBlockCount = 0u;
+            iReserved = 0u;
+            iAllocated = 0u;
+        }
+    public:
+        std::size_t blocks() const
+        {
+            return iBlockCount;
+        }
+        std::size_t reserved() const
+        {
+            return iReserved;
+        }
+        std::size_t allocated() const
+        {
+            return iAllocated;
+        }
+        // implementation
+    private:
+        static char* align(char* aAddress, std::size_t aAlignment)
+        {
+            return reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(aAddress) + aAlignment - 1u) & ~(static_cast<std::uintptr_t>(aAlignment) - 1u));
+        }
+        void grow(std::size_t aMinimumSize)
+        {
+            std::size_t const size = std::max(iNextBlockSize, aMinimumSize + header_size);
+            block* newBlock = static_cast<block*>(::operator new(size));
+            newBlock->iNext = iBlocks;
+            newBlock->iSize = size;
+            iBlocks = newBlock;
+            iNext = reinterpret_cast<char*>(newBlock) + header_size;
+            iEnd = reinterpret_cast<char*>(newBlock) + size;
+            ++iBlockCount;
+            iReserved += size;
+            iNextBlockSize = std::min(iNextBlockSize * 2u, max_block_size);
+        }
+    private:
+        std::size_t iInitialBlockSize;
+        std::size_t iNextBlockSize;
+        block* iBlocks;
+        char* iNext;
+        char* iEnd;
+        std::size_t iBlockCount;
+        std::size_t iReserved;
+        std::size_t iAllocated;
+        static inline thread_local monotonic_arena* tCurrent = nullptr;
+    };
+
+    // Allocates from the arena it was constructed with or, if none, from the arena current at the time of
+    // allocation. Deallocation does nothing; memory is reclaimed when the arena is released.
+    template <typename T>
+    class arena_allocator
+    {
+        template <typename>
+        friend class arena_allocator;
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+        typedef std::false_type is_always_equal;
+        template <typename U>
+        struct rebind
+        {
+            typedef arena_allocator<U> other;
+        };
+
+        // construction
+    public:
+        arena_allocator() noexcept :
+            iArena{ monotonic_arena::current() }
+        {
+        }
+        arena_allocator(monotonic_arena& aArena) noexcept :
+            iArena{ &aArena }
+        {
+        }
+        arena_allocator(const arena_allocator& aOther) noexcept :
+            iArena{ aOther.iArena }
+        {
+        }
+        template <typename U>
+        arena_allocator(const arena_allocator<U>& aOther) noexcept :
+            iArena{ aOther.iArena }
+        {
+        }
+        arena_allocator& operator=(const arena_allocator& aOther) noexcept
+        {
+            iArena = aOther.iArena;
+            return *this;
+        }
+
+        // operations
+    public:
+        pointer allocate(size_type aCount)
+        {
+            monotonic_arena* arena = (iArena != nullptr ? iArena : monotonic_arena::current());
+            if (arena == nullptr)
+                throw monotonic_arena::no_current_arena();
+            return static_cast<pointer>(arena->allocate(sizeof(T) * aCount, alignof(T)));
+        }
+        void deallocate(pointer, size_type) noexcept
+        {
+        }
+        monotonic_arena* arena() const
+        {
+            return iArena;
+        }
+
+        template <typename U>
+        bool operator==(const arena_allocator<U>& aOther) const { return iArena == aOther.iArena; }
+        template <typename U>
+        bool operator!=(const arena_allocator<U>& aOther) const { return iArena != aOther.iArena; }
+
+    private:
+        monotonic_arena* iArena;
+    };
+
+    template <typename Alloc>
+    struct is_arena_allocator : std::false_type {};
+    template <typename T>
+    struct is_arena_allocator<arena_allocator<T>> : std::true_type {};
+    template <typename Alloc>
+    constexpr bool is_arena_allocator_v = is_arena_allocator<Alloc>::value;
+}
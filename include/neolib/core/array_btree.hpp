@@ -0,0 +1,634 @@
+/*
+ *  array_btree.hpp
+ *
+ *  Copyright (c) 2020 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <memory>
+#include <vector>
+
+namespace neolib
+{
+    // Order statistic B+ tree with the same interface as array_tree. Leaves are the caller's nodes (threaded through
+    // previous/next); branches are wide and cache line aligned with their children's element counts stored
+    // contiguously so a positional lookup scans a few cache lines per level instead of chasing a pointer per level.
+    template <typename Alloc, std::size_t Fanout = 16>
+    class array_btree
+    {
+        static_assert(Fanout >= 4, "neolib::array_btree: fanout too small");
+    public:
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Alloc allocator_type;
+        // whole trees can be joined and split without visiting their nodes
+        static constexpr bool joinable = true;
+    protected:
+        class node;
+    private:
+        class branch;
+        class link
+        {
+            friend array_btree;
+            friend node;
+        protected:
+            link() :
+                iParent{ nullptr }, iSlot{ 0 }
+            {
+            }
+        protected:
+            branch* iParent;
+            size_type iSlot;
+        };
+    protected:
+        class node : public link
+        {
+            friend array_btree;
+
+        public:
+            node(bool aNil = false) :
+                iNil{ aNil }, iPrevious{ nullptr }, iNext{ nullptr }, iSize{ 0 }
+            {
+            }
+            node(const node& aOther) :
+                iNil{ aOther.iNil }, iPrevious{ nullptr }, iNext{ nullptr }, iSize{ 0 }
+            {
+            }
+
+        public:
+            bool is_nil() const
+            {
+                return iNil;
+            }
+            node* previous() const
+            {
+                return iPrevious;
+            }
+            void set_previous(node* aPrevious)
+            {
+                iPrevious = aPrevious;
+            }
+            node* next() const
+            {
+                return iNext;
+            }
+            void set_next(node* aNext)
+            {
+                iNext = aNext;
+            }
+            size_type size() const
+            {
+                return iSize;
+            }
+            void set_size(size_type aSize)
+            {
+                if (!is_nil())
+                {
+                    size_type const difference = aSize - iSize; // modular
+                    iSize = aSize;
+                    for (link* l = this; l->iParent != nullptr; l = l->iParent)
+                        l->iParent->iCounts[l->iSlot] += difference;
+                }
+            }
+
+        private:
+            bool iNil;
+            node* iPrevious;
+            node* iNext;
+            size_type iSize;
+        };
+    private:
+        class alignas(64) branch : public link
+        {
+            friend array_btree;
+            friend node;
+        public:
+            branch(bool aLeaves) :
+                iLeaves{ aLeaves }, iChildCount{ 0 }
+            {
+            }
+        private:
+            bool iLeaves;
+            size_type iChildCount;
+            size_type iCounts[Fanout];
+            link* iChildren[Fanout];
+        };
+        typedef typename std::allocator_traits<allocator_type>:: template rebind_alloc<branch> branch_allocator_type;
+
+    public:
+        array_btree(const Alloc& aAllocator = Alloc()) :
+            iAllocator{ aAllocator },
+            iRoot{ nullptr },
+            iFront{ nullptr },
+            iBack{ nullptr },
+            iNil{ true }
+        {
+        }
+        array_btree(const array_btree& aOther) :
+            iAllocator{ aOther.iAllocator },
+            iRoot{ nullptr },
+            iFront{ nullptr },
+            iBack{ nullptr },
+            iNil{ true }
+        {
+        }
+        array_btree(array_btree&& other) :
+            iAllocator{ std::move(other.iAllocator) },
+            iRoot{ nullptr },
+            iFront{ nullptr },
+            iBack{ nullptr },
+            iNil{ true }
+        {
+            std::swap(iRoot, other.iRoot);
+            std::swap(iFront, other.iFront);
+            std::swap(iBack, other.iBack);
+        }
+        ~array_btree()
+        {
+            free_branches(iRoot);
+        }
+
+    public:
+        node* nil_node() const
+        {
+            return const_cast<node*>(&iNil);
+        }
+        node* front_node() const
+        {
+            return iFront;
+        }
+        void set_front_node(node* aFront)
+        {
+            iFront = aFront;
+        }
+        node* back_node() const
+        {
+            return iBack;
+        }
+        void set_back_node(node* aBack)
+        {
+            iBack = aBack;
+        }
+        node* find_node(size_type aPosition, size_type& aNodeIndex) const
+        {
+            aNodeIndex = 0;
+            branch* b = iRoot;
+            while (b != nullptr)
+            {
+                size_type i = 0;
+                size_type const* counts = b->iCounts;
+                size_type const childCount = b->iChildCount;
+                while (i < childCount && aPosition >= counts[i])
+                {
+                    aPosition -= counts[i];
+                    aNodeIndex += counts[i];
+                    ++i;
+                }
+                if (i == childCount)
+                    break;
+                if (b->iLeaves)
+                    return static_cast<node*>(b->iChildren[i]);
+                b = static_cast<branch*>(b->iChildren[i]);
+            }
+            return nil_node();
+        }
+        // number of elements before aNode
+        size_type node_index(const node* aNode) const
+        {
+            size_type result = 0;
+            for (const link* l = aNode; l->iParent != nullptr; l = l->iParent)
+                for (size_type i = 0; i < l->iSlot; ++i)
+                    result += l->iParent->iCounts[i];
+            return result;
+        }
+        // leaves are threaded so a new leaf is placed directly after its previous node, which must already be in the
+        // tree; aPosition is accepted for compatibility with array_tree
+        // detaches a node that belonged to another index so that it can be inserted into this one
+        static void reset_node(node* aNode, size_type aOwnSize)
+        {
+            aNode->iParent = nullptr;
+            aNode->iSlot = 0;
+            aNode->iSize = aOwnSize;
+        }
+        void insert_node(node* aNode, size_type /* aPosition */)
+        {
+            branch* target;
+            size_type slot;
+            if (iRoot == nullptr)
+            {
+                iRoot = allocate_branch(true);
+                target = iRoot;
+                slot = 0;
+            }
+            else if (aNode->previous() != nullptr)
+            {
+                target = aNode->previous()->iParent;
+                slot = aNode->previous()->iSlot + 1;
+            }
+            else
+            {
+                target = iRoot;
+                while (!target->iLeaves)
+                    target = static_cast<branch*>(target->iChildren[0]);
+                slot = 0;
+            }
+            insert_child(target, slot, aNode, aNode->size());
+            for (link* l = aNode->iParent; l->iParent != nullptr; l = l->iParent)
+                l->iParent->iCounts[l->iSlot] += aNode->size();
+        }
+        void insert_linked_node(node* aNode)
+        {
+            insert_node(aNode, 0);
+        }
+        void delete_node(node* aNode)
+        {
+            branch* b = aNode->iParent;
+            size_type const size = b->iCounts[aNode->iSlot];
+            for (link* l = b; l->iParent != nullptr; l = l->iParent)
+                l->iParent->iCounts[l->iSlot] -= size;
+            remove_child(b, aNode->iSlot);
+            aNode->iParent = nullptr;
+            aNode->iSlot = 0;
+            rebalance(b);
+        }
+        // replaces the tree with one built bottom up in O(n) from the aNodeCount nodes linked from the front node;
+        // aOwnSize(node) gives the number of elements in a node
+        template <typename OwnSize>
+        void rebuild(size_type aNodeCount, OwnSize aOwnSize)
+        {
+            free_branches(iRoot);
+            iRoot = nullptr;
+            if (aNodeCount == 0)
+                return;
+            std::vector<link*, typename std::allocator_traits<allocator_type>::template rebind_alloc<link*>> level;
+            level.reserve(aNodeCount);
+            for (node* n = iFront; n != nullptr; n = n->next())
+            {
+                n->iSize = aOwnSize(*n);
+                level.push_back(n);
+            }
+            bool leaves = true;
+            do
+            {
+                // children are shared out evenly so no branch other than the root is less than half full
+                size_type const branches = (level.size() + Fanout - 1) / Fanout;
+                size_type child = 0;
+                for (size_type b = 0; b < branches; ++b)
+                {
+                    branch* newBranch = allocate_branch(leaves);
+                    size_type const take = level.size() / branches + (b < level.size() % branches ? 1 : 0);
+                    for (size_type i = 0; i < take; ++i, ++child)
+                        place_child(newBranch, i, level[child], leaves ? static_cast<node*>(level[child])->iSize : total(static_cast<branch*>(level[child])));
+                    level[b] = newBranch;
+                }
+                level.resize(branches);
+                leaves = false;
+            } while (level.size() > 1);
+            iRoot = static_cast<branch*>(level[0]);
+        }
+        // appends the nodes of aOther to this tree in O(log n) leaving aOther empty; both trees' allocators must
+        // compare equal
+        void join(array_btree& aOther)
+        {
+            if (aOther.iFront == nullptr)
+                return;
+            if (iBack != nullptr)
+            {
+                iBack->set_next(aOther.iFront);
+                aOther.iFront->set_previous(iBack);
+            }
+            else
+                iFront = aOther.iFront;
+            iBack = aOther.iBack;
+            branch* const right = aOther.iRoot;
+            aOther.iRoot = nullptr;
+            aOther.iFront = nullptr;
+            aOther.iBack = nullptr;
+            iRoot = join(iRoot, right);
+        }
+        // moves aFirst and the nodes after it to aRest, which must be empty, in O(log n) joins of the pieces either
+        // side of the path from aFirst to the root
+        void split_off(node* aFirst, array_btree& aRest)
+        {
+            node* const last = iBack;
+            iBack = aFirst->previous();
+            if (iBack != nullptr)
+                iBack->set_next(nullptr);
+            else
+                iFront = nullptr;
+            aFirst->set_previous(nullptr);
+            aRest.iFront = aFirst;
+            aRest.iBack = last;
+            branch* left = nullptr;
+            branch* right = nullptr;
+            branch* b = aFirst->iParent;
+            size_type leftEnd = aFirst->iSlot;
+            size_type rightBegin = aFirst->iSlot;
+            while (b != nullptr)
+            {
+                branch* const parent = b->iParent;
+                size_type const slot = b->iSlot;
+                b->iParent = nullptr;
+                b->iSlot = 0;
+                if (rightBegin < b->iChildCount)
+                {
+                    branch* piece = allocate_branch(b->iLeaves);
+                    for (size_type i = rightBegin; i < b->iChildCount; ++i)
+                        place_child(piece, i - rightBegin, b->iChildren[i], b->iCounts[i]);
+                    right = join(right, piece);
+                }
+                b->iChildCount = leftEnd;
+                if (leftEnd != 0)
+                    left = join(b, left);
+                else
+                    free_branch(b);
+                // above the leaf branch the child on the path is the one being cut
+                b = parent;
+                leftEnd = slot;
+                rightBegin = slot + 1;
+            }
+            iRoot = collapse(left);
+            aRest.iRoot = collapse(right);
+        }
+        void swap(array_btree& aOther)
+        {
+            std::swap(iAllocator, aOther.iAllocator);
+            std::swap(iRoot, aOther.iRoot);
+            std::swap(iFront, aOther.iFront);
+            std::swap(iBack, aOther.iBack);
+        }
+
+    private:
+        branch* allocate_branch(bool aLeaves)
+        {
+            branch* newBranch = std::allocator_traits<branch_allocator_type>::allocate(iAllocator, 1);
+            std::allocator_traits<branch_allocator_type>::construct(iAllocator, newBranch, aLeaves);
+            return newBranch;
+        }
+        void free_branch(branch* aBranch)
+        {
+            std::allocator_traits<branch_allocator_type>::destroy(iAllocator, aBranch);
+            std::allocator_traits<branch_allocator_type>::deallocate(iAllocator, aBranch, 1);
+        }
+        void free_branches(branch* aBranch)
+        {
+            if (aBranch == nullptr)
+                return;
+            if (!aBranch->iLeaves)
+                for (size_type i = 0; i < aBranch->iChildCount; ++i)
+                    free_branches(static_cast<branch*>(aBranch->iChildren[i]));
+            free_branch(aBranch);
+        }
+        static size_type height(const branch* aBranch)
+        {
+            size_type result = 1;
+            for (; !aBranch->iLeaves; aBranch = static_cast<const branch*>(aBranch->iChildren[0]))
+                ++result;
+            return result;
+        }
+        static size_type total(const branch* aBranch)
+        {
+            size_type result = 0;
+            for (size_type i = 0; i < aBranch->iChildCount; ++i)
+                result += aBranch->iCounts[i];
+            return result;
+        }
+        static void place_child(branch* aBranch, size_type aSlot, link* aChild, size_type aCount)
+        {
+            for (size_type i = aBranch->iChildCount; i > aSlot; --i)
+            {
+                aBranch->iChildren[i] = aBranch->iChildren[i - 1];
+                aBranch->iCounts[i] = aBranch->iCounts[i - 1];
+                aBranch->iChildren[i]->iSlot = i;
+            }
+            aBranch->iChildren[aSlot] = aChild;
+            aBranch->iCounts[aSlot] = aCount;
+            aChild->iParent = aBranch;
+            aChild->iSlot = aSlot;
+            ++aBranch->iChildCount;
+        }
+        static void remove_child(branch* aBranch, size_type aSlot)
+        {
+            --aBranch->iChildCount;
+            for (size_type i = aSlot; i < aBranch->iChildCount; ++i)
+            {
+                aBranch->iChildren[i] = aBranch->iChildren[i + 1];
+                aBranch->iCounts[i] = aBranch->iCounts[i + 1];
+                aBranch->iChildren[i]->iSlot = i;
+            }
+        }
+        // does not update the counts of aBranch's ancestors
+        void insert_child(branch* aBranch, size_type aSlot, link* aChild, size_type aCount)
+        {
+            if (aBranch->iChildCount == Fanout)
+            {
+                branch* right = split(aBranch);
+                if (aSlot > aBranch->iChildCount)
+                {
+                    aSlot -= aBranch->iChildCount;
+                    aBranch = right;
+                }
+            }
+            place_child(aBranch, aSlot, aChild, aCount);
+        }
+        branch* split(branch* aBranch)
+        {
+            branch* right = allocate_branch(aBranch->iLeaves);
+            size_type const half = Fanout / 2;
+            size_type moved = 0;
+            for (size_type i = half; i < Fanout; ++i)
+            {
+                moved += aBranch->iCounts[i];
+                place_child(right, i - half, aBranch->iChildren[i], aBranch->iCounts[i]);
+            }
+            aBranch->iChildCount = half;
+            if (aBranch->iParent == nullptr)
+            {
+                iRoot = allocate_branch(false);
+                place_child(iRoot, 0, aBranch, total(aBranch));
+                place_child(iRoot, 1, right, moved);
+            }
+            else
+            {
+                // the parent may split in turn so the moved count is transferred along both ancestor chains
+                insert_child(aBranch->iParent, aBranch->iSlot + 1, right, 0);
+                for (link* l = aBranch; l->iParent != nullptr; l = l->iParent)
+                    l->iParent->iCounts[l->iSlot] -= moved;
+                for (link* l = right; l->iParent != nullptr; l = l->iParent)
+                    l->iParent->iCounts[l->iSlot] += moved;
+            }
+            return right;
+        }
+        // joins two trees each of whose leaves are all at the same depth and of which only the roots may be less than
+        // half full; the shorter tree is hung off the taller one's facing edge which then splits or merges as needed
+        branch* join(branch* aLeft, branch* aRight)
+        {
+            if (aLeft == nullptr)
+                return aRight;
+            if (aRight == nullptr)
+                return aLeft;
+            size_type const leftHeight = height(aLeft);
+            size_type const rightHeight = height(aRight);
+            if (leftHeight == rightHeight)
+            {
+                if (aLeft->iChildCount + aRight->iChildCount <= Fanout)
+                {
+                    for (size_type i = 0; i < aRight->iChildCount; ++i)
+                        place_child(aLeft, aLeft->iChildCount, aRight->iChildren[i], aRight->iCounts[i]);
+                    free_branch(aRight);
+                    return aLeft;
+                }
+                while (aLeft->iChildCount < Fanout / 2)
+                {
+                    place_child(aLeft, aLeft->iChildCount, aRight->iChildren[0], aRight->iCounts[0]);
+                    remove_child(aRight, 0);
+                }
+                while (aRight->iChildCount < Fanout / 2)
+                {
+                    size_type const last = aLeft->iChildCount - 1;
+                    place_child(aRight, 0, aLeft->iChildren[last], aLeft->iCounts[last]);
+                    --aLeft->iChildCount;
+                }
+                branch* const root = allocate_branch(false);
+                place_child(root, 0, aLeft, total(aLeft));
+                place_child(root, 1, aRight, total(aRight));
+                return root;
+            }
+            bool const leftTaller = leftHeight > rightHeight;
+            branch* const shorter = leftTaller ? aRight : aLeft;
+            iRoot = leftTaller ? aLeft : aRight;
+            branch* target = iRoot;
+            for (size_type levels = (leftTaller ? leftHeight - rightHeight : rightHeight - leftHeight); levels > 1; --levels)
+                target = static_cast<branch*>(target->iChildren[leftTaller ? target->iChildCount - 1 : 0]);
+            size_type const count = total(shorter);
+            insert_child(target, leftTaller ? target->iChildCount : 0, shorter, count);
+            for (link* l = shorter->iParent; l->iParent != nullptr; l = l->iParent)
+                l->iParent->iCounts[l->iSlot] += count;
+            rebalance(shorter);
+            return iRoot;
+        }
+        branch* collapse(branch* aRoot)
+        {
+            while (aRoot != nullptr && !aRoot->iLeaves && aRoot->iChildCount == 1)
+            {
+                branch* const child = static_cast<branch*>(aRoot->iChildren[0]);
+                free_branch(aRoot);
+                aRoot = child;
+                aRoot->iParent = nullptr;
+                aRoot->iSlot = 0;
+            }
+            return aRoot;
+        }
+        void rebalance(branch* aBranch)
+        {
+            if (aBranch->iParent == nullptr)
+            {
+                if (aBranch->iChildCount == 0)
+                {
+                    free_branch(aBranch);
+                    iRoot = nullptr;
+                }
+                else if (aBranch->iChildCount == 1 && !aBranch->iLeaves)
+                {
+                    iRoot = static_cast<branch*>(aBranch->iChildren[0]);
+                    iRoot->iParent = nullptr;
+                    iRoot->iSlot = 0;
+                    free_branch(aBranch);
+                }
+                return;
+            }
+            if (aBranch->iChildCount >= Fanout / 2)
+                return;
+            branch* parent = aBranch->iParent;
+            branch* left = aBranch;
+            branch* right = aBranch;
+            if (aBranch->iSlot > 0)
+                left = static_cast<branch*>(parent->iChildren[aBranch->iSlot - 1]);
+            else if (parent->iChildCount > 1)
+                right = static_cast<branch*>(parent->iChildren[1]);
+            else
+            {
+                rebalance(parent);
+                return;
+            }
+            if (left->iChildCount + right->iChildCount <= Fanout)
+            {
+                size_type const moved = parent->iCounts[right->iSlot];
+                while (right->iChildCount != 0)
+                {
+                    place_child(left, left->iChildCount, right->iChildren[0], right->iCounts[0]);
+                    remove_child(right, 0);
+                }
+                parent->iCounts[left->iSlot] += moved;
+                remove_child(parent, right->iSlot);
+                free_branch(right);
+                rebalance(parent);
+            }
+            else if (left != aBranch)
+            {
+                // a joined subtree can be short by more than one child
+                while (aBranch->iChildCount < Fanout / 2)
+                {
+                    size_type const last = left->iChildCount - 1;
+                    size_type const count = left->iCounts[last];
+                    link* child = left->iChildren[last];
+                    --left->iChildCount;
+                    parent->iCounts[left->iSlot] -= count;
+                    place_child(aBranch, 0, child, count);
+                    parent->iCounts[aBranch->iSlot] += count;
+                }
+            }
+            else
+            {
+                while (aBranch->iChildCount < Fanout / 2)
+                {
+                    size_type const count = right->iCounts[0];
+                    link* child = right->iChildren[0];
+                    remove_child(right, 0);
+                    parent->iCounts[right->iSlot] -= count;
+                    place_child(aBranch, aBranch->iChildCount, child, count);
+                    parent->iCounts[aBranch->iSlot] += count;
+                }
+            }
+        }
+
+    private:
+        branch_allocator_type iAllocator;
+        branch* iRoot;
+        node* iFront;
+        node* iBack;
+        node iNil;
+    };
+}
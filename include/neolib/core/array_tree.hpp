@@ -47,6 +47,8 @@ namespace neolib
         typedef std::size_t size_type;
         typedef std::ptrdiff_t difference_type;
         typedef Alloc allocator_type;
+        // a red-black index is rebuilt or updated per node rather than joined and split
+        static constexpr bool joinable = false;
     protected:
         class node
         {
@@ -250,6 +252,8 @@ namespace neolib
         }
         ~array_tree()
         {
+            if (iNil == nullptr)
+                return;
             std::allocator_traits<node_allocator_type>::destroy(iAllocator, iNil);
             std::allocator_traits<node_allocator_type>::deallocate(iAllocator, iNil, 1);
         }
@@ -319,9 +323,28 @@ namespace neolib
             aNodeIndex = index;
             return x;
         }
+        // number of elements before aNode
+        size_type node_index(const node* aNode) const
+        {
+            node* x = const_cast<node*>(aNode);
+            size_type result = size_left(x);
+            for (node* p = x->parent(); p != nil_node(); x = p, p = p->parent())
+                if (x == p->right())
+                    result += size(p) - size(x);
+            return result;
+        }
+        // detaches a node that belonged to another index so that it can be inserted into this one
+        static void reset_node(node* aNode, size_type aOwnSize)
+        {
+            aNode->set_parent(nullptr);
+            aNode->set_left(nullptr);
+            aNode->set_right(nullptr);
+            aNode->iSize = aOwnSize;
+        }
         void insert_node(node* aNode, size_type aPosition)
         {
             node* z = aNode;
+            z->set_color(node::RED);
             node* y = nil_node();
             node* x = root_node();
             size_type index = size_left(x);
@@ -357,6 +380,44 @@ namespace neolib
                 z->parent()->set_size(z->parent()->size() + z->size());
             insert_fixup(z);
         }
+        // inserts a node already linked in after aNode->previous() which, if not null, must be in the tree; only
+        // the nodes on the path to the root are visited rather than those along a search by position
+        void insert_linked_node(node* aNode)
+        {
+            node* z = aNode;
+            z->set_color(node::RED);
+            z->set_left(nil_node());
+            z->set_right(nil_node());
+            node* y = nil_node();
+            bool left = true;
+            if (z->previous() == nullptr)
+            {
+                for (node* x = root_node(); x != nil_node(); x = x->left())
+                    y = x;
+            }
+            else if (z->previous()->right() == nil_node())
+            {
+                y = z->previous();
+                left = false;
+            }
+            else
+            {
+                for (node* x = z->previous()->right(); x != nil_node(); x = x->left())
+                    y = x;
+            }
+            z->set_parent(y);
+            if (y == nil_node())
+                set_root_node(z);
+            else
+            {
+                if (left)
+                    y->set_left(z);
+                else
+                    y->set_right(z);
+                y->set_size(y->size() + z->size());
+            }
+            insert_fixup(z);
+        }
         void delete_node(node* aNode)
         {
             node* z = aNode;
@@ -400,6 +461,18 @@ namespace neolib
             if (performDeleteFixup)
                 delete_fixup(x);
         }
+        // replaces the tree with a balanced one built in O(n) from the aNodeCount nodes linked from the front node;
+        // aOwnSize(node) gives the number of elements in a node excluding its subtrees
+        template <typename OwnSize>
+        void rebuild(size_type aNodeCount, OwnSize aOwnSize)
+        {
+            size_type redDepth = 0;
+            for (size_type n = aNodeCount + 1; n > 1; n >>= 1)
+                ++redDepth;
+            node* next = front_node();
+            set_root_node(build(next, aNodeCount, 0, redDepth, aOwnSize));
+            root_node()->set_parent(nil_node());
+        }
         void swap(array_tree& aOther)
         {
             std::swap(iAllocator, aOther.iAllocator);
@@ -410,6 +483,27 @@ namespace neolib
         }
 
     private:
+        // every subtree is split evenly so only the last, incomplete, level is coloured red
+        template <typename OwnSize>
+        node* build(node*& aNext, size_type aCount, size_type aDepth, size_type aRedDepth, OwnSize& aOwnSize)
+        {
+            if (aCount == 0)
+                return nil_node();
+            size_type const leftCount = (aCount - 1) / 2;
+            node* left = build(aNext, leftCount, aDepth + 1, aRedDepth, aOwnSize);
+            node* result = aNext;
+            aNext = aNext->next();
+            node* right = build(aNext, aCount - leftCount - 1, aDepth + 1, aRedDepth, aOwnSize);
+            result->set_color(aDepth == aRedDepth ? node::RED : node::BLACK);
+            result->set_left(left);
+            result->set_right(right);
+            if (left != nil_node())
+                left->set_parent(result);
+            if (right != nil_node())
+                right->set_parent(result);
+            result->iSize = aOwnSize(*result) + left->size() + right->size();
+            return result;
+        }
         void insert_fixup(node* aNode)
         {
             node* z = aNode;
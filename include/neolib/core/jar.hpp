@@ -38,9 +38,13 @@
 #include <neolib/neolib.hpp>
 #include <optional>
 #include <vector>
+#include <deque>
 #include <set>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
+#include <type_traits>
+#include <utility>
 #include <neolib/core/vector.hpp>
 #include <neolib/core/mutex.hpp>
 #include <neolib/core/reference_counted.hpp>
@@ -175,6 +179,14 @@ namespace neolib
         template<typename T> struct is_smart_ptr<ref_ptr<T>> : std::true_type {};
         template<typename T>
         inline constexpr bool is_smart_ptr_v = is_smart_ptr<T>::value;
+
+        template <typename Mutex, typename = std::void_t<>>
+        struct is_shared_mutex : std::false_type {};
+        template <typename Mutex>
+        struct is_shared_mutex<Mutex, std::void_t<decltype(std::declval<Mutex&>().lock_shared())>> : std::true_type {};
+        // readers take a shared lock if the mutex supports one
+        template <typename Mutex>
+        using shared_lock_t = std::conditional_t<is_shared_mutex<Mutex>::value, std::shared_lock<Mutex>, std::scoped_lock<Mutex>>;
     }
 
     template <typename T, typename Container = vector<T>, typename CookieType = cookie, typename MutexType = null_mutex>
@@ -453,6 +465,377 @@ namespace neolib
         reverse_indices_t iReverseIndices;
     };
 
+    // small cookies keep most of their bits for the slot index (2047 slots, 31 generations)
+    template <typename CookieType>
+    constexpr std::size_t default_generation_bits_v = sizeof(CookieType) == 2u ? 5u : sizeof(CookieType) * 8u / 4u;
+    // retiring the slots of small cookies would exhaust the jar after some 63k insert/erase cycles so their
+    // generations wrap instead
+    template <typename CookieType>
+    constexpr bool default_retire_slots_v = sizeof(CookieType) > 2u;
+    constexpr std::size_t default_minimum_free_slots_v = 64u;
+
+    // A jar whose cookies carry a generation count in their upper GenerationBits bits so that a cookie for a
+    // removed item is not mistaken for a later item occupying the same slot. Freed slots are reused oldest first
+    // and only once more than MinimumFreeSlots are free so a slot's generations are spread over many reuses of
+    // the jar. A slot whose generations are exhausted is retired so a cookie is never reissued, at the cost of
+    // the jar eventually running out of slots; if RetireSlots is false (the default for small cookies) the
+    // generation count wraps instead and a cookie held across that many reuses of its slot becomes valid again.
+    // Lookup is slot (index + generation check) then dense item; readers take a shared lock if MutexType
+    // provides one (e.g. std::shared_mutex). The lock is only held for the lookup: the references and iterators
+    // returned by operator[] and find() are unprotected once they are returned so, with concurrent writers, only
+    // visit() gives safe access to an item.
+    template <typename T, typename Container = vector<T>, typename CookieType = cookie, typename MutexType = null_mutex, std::size_t GenerationBits = default_generation_bits_v<CookieType>, bool RetireSlots = default_retire_slots_v<CookieType>, std::size_t MinimumFreeSlots = default_minimum_free_slots_v>
+    class basic_generational_jar : public reference_counted<i_basic_jar<abstract_t<T>, abstract_t<Container>, CookieType>>
+    {
+    public:
+        typedef CookieType cookie_type;
+    public:
+        typedef T value_type;
+        typedef Container container_type;
+        typedef typename container_type::const_iterator const_iterator;
+        typedef typename container_type::iterator iterator;
+        typedef MutexType mutex_type;
+    private:
+        typedef typename container_type::size_type reverse_index_t;
+        struct slot
+        {
+            reverse_index_t denseIndex;
+            cookie_type generation;
+        };
+        typedef std::vector<slot> slots_t;
+        typedef std::vector<cookie_type> cookies_t;
+        typedef std::deque<cookie_type> slot_indices_t;
+        typedef std::scoped_lock<mutex_type> write_lock;
+        typedef detail::shared_lock_t<mutex_type> read_lock;
+    private:
+        static constexpr std::size_t COOKIE_BITS = sizeof(cookie_type) * 8u;
+        static_assert(GenerationBits > 1u && GenerationBits < COOKIE_BITS, "neolib::basic_generational_jar: invalid generation bit count");
+        static constexpr std::size_t INDEX_BITS = COOKIE_BITS - GenerationBits;
+        static constexpr cookie_type INDEX_MASK = static_cast<cookie_type>((static_cast<uint64_t>(1u) << INDEX_BITS) - 1u);
+        static constexpr cookie_type FIRST_GENERATION = 1u;
+        static constexpr cookie_type LAST_GENERATION = static_cast<cookie_type>((static_cast<uint64_t>(1u) << GenerationBits) - 1u);
+        static constexpr reverse_index_t INVALID_REVERSE_INDEX = static_cast<reverse_index_t>(~reverse_index_t{});
+    public:
+        basic_generational_jar()
+        {
+        }
+    public:
+        bool empty() const override
+        {
+            return items().empty();
+        }
+        std::size_t size() const override
+        {
+            return items().size();
+        }
+        bool contains(cookie_type aCookie) const override
+        {
+            read_lock lock{ mutex() };
+            return dense_index(aCookie) != INVALID_REVERSE_INDEX;
+        }
+        const_iterator find(cookie_type aCookie) const override
+        {
+            read_lock lock{ mutex() };
+            auto const denseIndex = dense_index(aCookie);
+            if (denseIndex != INVALID_REVERSE_INDEX)
+                return std::next(begin(), denseIndex);
+            return end();
+        }
+        iterator find(cookie_type aCookie) override
+        {
+            read_lock lock{ mutex() };
+            auto const denseIndex = dense_index(aCookie);
+            if (denseIndex != INVALID_REVERSE_INDEX)
+                return std::next(begin(), denseIndex);
+            return end();
+        }
+        const value_type& operator[](cookie_type aCookie) const override
+        {
+            read_lock lock{ mutex() };
+            auto const denseIndex = dense_index(aCookie);
+            if (denseIndex == INVALID_REVERSE_INDEX)
+                throw cookie_invalid();
+            return items()[denseIndex];
+        }
+        value_type& operator[](cookie_type aCookie) override
+        {
+            return const_cast<value_type&>(to_const(*this)[aCookie]);
+        }
+        const value_type& at_index(std::size_t aIndex) const override
+        {
+            return items().at(aIndex);
+        }
+        value_type& at_index(std::size_t aIndex) override
+        {
+            return items().at(aIndex);
+        }
+        // calls aVisitor with the item while holding a (shared) lock; returns false if the cookie is stale
+        template <typename Visitor>
+        bool visit(cookie_type aCookie, Visitor&& aVisitor) const
+        {
+            read_lock lock{ mutex() };
+            auto const denseIndex = dense_index(aCookie);
+            if (denseIndex == INVALID_REVERSE_INDEX)
+                return false;
+            aVisitor(items()[denseIndex]);
+            return true;
+        }
+        cookie_type insert(abstract_t<value_type> const& aItem) override
+        {
+            auto cookie = next_cookie();
+            try
+            {
+                add(cookie, aItem);
+            }
+            catch (...)
+            {
+                return_cookie(cookie);
+                throw;
+            }
+            return cookie;
+        }
+        template <typename... Args>
+        cookie_type emplace(Args&&... aArgs)
+        {
+            auto cookie = next_cookie();
+            try
+            {
+                add(cookie, std::forward<Args>(aArgs)...);
+            }
+            catch (...)
+            {
+                return_cookie(cookie);
+                throw;
+            }
+            return cookie;
+        }
+        iterator add(cookie_type aCookie, abstract_t<value_type> const& aItem) override
+        {
+            return add<const abstract_t<value_type>&>(aCookie, aItem);
+        }
+        iterator erase(const_iterator aItem) override
+        {
+            return remove(*aItem);
+        }
+        template <typename... Args>
+        iterator add(cookie_type aCookie, Args&&... aArgs)
+        {
+            write_lock lock{ mutex() };
+            auto const slotIndex = slot_index(aCookie);
+            if (slotIndex >= slots().size() || slots()[slotIndex].generation != generation(aCookie))
+                throw cookie_invalid();
+            if (slots()[slotIndex].denseIndex != INVALID_REVERSE_INDEX)
+                throw cookie_already_added();
+            std::optional<iterator> result;
+            if constexpr (!detail::is_smart_ptr_v<value_type>)
+                result = items().emplace(items().end(), std::forward<Args>(aArgs)...);
+            else if constexpr (detail::is_smart_ptr_v<value_type> && std::is_abstract_v<typename value_type::element_type>)
+                result = items().emplace(items().end(), std::forward<Args>(aArgs)...);
+            else if constexpr (detail::is_smart_ptr_v<value_type> && !std::is_abstract_v<typename value_type::element_type>)
+                result = items().insert(items().end(), value_type{ new typename value_type::element_type{std::forward<Args>(aArgs)...} });
+            try
+            {
+                dense_cookies().push_back(aCookie);
+            }
+            catch (...)
+            {
+                items().pop_back();
+                throw;
+            }
+            slots()[slotIndex].denseIndex = items().size() - 1;
+            return *result;
+        }
+        iterator remove(abstract_t<value_type> const& aItem) override
+        {
+            return remove(item_cookie(aItem));
+        }
+        iterator remove(cookie_type aCookie) override
+        {
+            write_lock lock{ mutex() };
+            auto const denseIndex = dense_index(aCookie);
+            if (denseIndex == INVALID_REVERSE_INDEX)
+                throw cookie_invalid();
+            if (denseIndex < items().size() - 1)
+            {
+                std::swap(items()[denseIndex], items().back());
+                std::swap(dense_cookies()[denseIndex], dense_cookies().back());
+                slots()[slot_index(dense_cookies()[denseIndex])].denseIndex = denseIndex;
+            }
+            items().pop_back();
+            dense_cookies().pop_back();
+            release_slot(slot_index(aCookie));
+            return std::next(items().begin(), denseIndex);
+        }
+        // removes every item satisfying aPredicate compacting the remaining items (preserving their order) in a single pass;
+        // returns the number of items removed
+        template <typename Predicate>
+        std::size_t erase_if(Predicate aPredicate)
+        {
+            write_lock lock{ mutex() };
+            reverse_index_t const count = items().size();
+            reverse_index_t kept = 0u;
+            for (reverse_index_t index = 0u; index < count; ++index)
+            {
+                if (aPredicate(std::as_const(items()[index])))
+                {
+                    release_slot(slot_index(dense_cookies()[index]));
+                    continue;
+                }
+                if (kept != index)
+                {
+                    items()[kept] = std::move(items()[index]);
+                    dense_cookies()[kept] = dense_cookies()[index];
+                    slots()[slot_index(dense_cookies()[kept])].denseIndex = kept;
+                }
+                ++kept;
+            }
+            while (items().size() > kept)
+                items().pop_back();
+            dense_cookies().resize(kept);
+            return count - kept;
+        }
+    public:
+        cookie_type item_cookie(abstract_t<value_type> const& aItem) const override
+        {
+            if constexpr (!std::is_pointer_v<value_type>)
+                return dense_cookies()[&static_cast<value_type const&>(aItem) - &items()[0]];
+            else
+                throw no_pointer_value_type_cookie_lookup();
+        }
+        cookie_type next_cookie() override
+        {
+            write_lock lock{ mutex() };
+            // the last slot index is not used so that no cookie is invalid_cookie
+            bool const slotsExhausted = slots().size() >= INDEX_MASK;
+            if (free_slots().size() > MinimumFreeSlots || (slotsExhausted && !free_slots().empty()))
+            {
+                auto const slotIndex = free_slots().front();
+                free_slots().pop_front();
+                return make_cookie(slotIndex, slots()[slotIndex].generation);
+            }
+            if (slotsExhausted)
+                throw cookies_exhausted();
+            slots().push_back(slot{ INVALID_REVERSE_INDEX, FIRST_GENERATION });
+            return make_cookie(static_cast<cookie_type>(slots().size() - 1u), FIRST_GENERATION);
+        }
+        void return_cookie(cookie_type aCookie) override
+        {
+            write_lock lock{ mutex() };
+            auto const slotIndex = slot_index(aCookie);
+            if (slotIndex >= slots().size() || slots()[slotIndex].generation != generation(aCookie) || slots()[slotIndex].denseIndex != INVALID_REVERSE_INDEX)
+                throw cookie_invalid();
+            release_slot(slotIndex);
+        }
+    public:
+        mutex_type& mutex() const
+        {
+            return iMutex;
+        }
+        const_iterator cbegin() const override
+        {
+            return items().begin();
+        }
+        const_iterator begin() const override
+        {
+            return cbegin();
+        }
+        iterator begin() override
+        {
+            return items().begin();
+        }
+        const_iterator cend() const override
+        {
+            return items().end();
+        }
+        const_iterator end() const override
+        {
+            return cend();
+        }
+        iterator end() override
+        {
+            return items().end();
+        }
+    public:
+        // slots are released rather than reset so cookies issued before a clear remain invalid
+        void clear() override
+        {
+            write_lock lock{ mutex() };
+            for (auto const cookie : dense_cookies())
+                release_slot(slot_index(cookie));
+            dense_cookies().clear();
+            items().clear();
+        }
+        const container_type& items() const override
+        {
+            return iItems;
+        }
+        container_type& items() override
+        {
+            return iItems;
+        }
+    private:
+        static cookie_type make_cookie(cookie_type aSlotIndex, cookie_type aGeneration)
+        {
+            return static_cast<cookie_type>((static_cast<uint64_t>(aGeneration) << INDEX_BITS) | aSlotIndex);
+        }
+        static cookie_type slot_index(cookie_type aCookie)
+        {
+            return static_cast<cookie_type>(aCookie & INDEX_MASK);
+        }
+        static cookie_type generation(cookie_type aCookie)
+        {
+            return static_cast<cookie_type>(static_cast<uint64_t>(aCookie) >> INDEX_BITS);
+        }
+        reverse_index_t dense_index(cookie_type aCookie) const
+        {
+            auto const slotIndex = slot_index(aCookie);
+            if (slotIndex >= slots().size())
+                return INVALID_REVERSE_INDEX;
+            auto const& s = slots()[slotIndex];
+            if (s.generation != generation(aCookie))
+                return INVALID_REVERSE_INDEX;
+            return s.denseIndex;
+        }
+        void release_slot(cookie_type aSlotIndex)
+        {
+            auto& s = slots()[aSlotIndex];
+            s.denseIndex = INVALID_REVERSE_INDEX;
+            if (s.generation != LAST_GENERATION)
+                ++s.generation;
+            else if constexpr (RetireSlots)
+                return;
+            else
+                s.generation = FIRST_GENERATION; // generation zero is never used so that no cookie is zero
+            free_slots().push_back(aSlotIndex);
+        }
+        const cookies_t& dense_cookies() const
+        {
+            return iDenseCookies;
+        }
+        cookies_t& dense_cookies()
+        {
+            return iDenseCookies;
+        }
+        const slots_t& slots() const
+        {
+            return iSlots;
+        }
+        slots_t& slots()
+        {
+            return iSlots;
+        }
+        slot_indices_t& free_slots()
+        {
+            return iFreeSlots;
+        }
+    private:
+        mutable mutex_type iMutex;
+        container_type iItems;
+        cookies_t iDenseCookies;
+        slots_t iSlots;
+        slot_indices_t iFreeSlots;
+    };
+
     typedef basic_cookie_ref_ptr<cookie> cookie_ref_ptr;
     typedef basic_cookie_ref_ptr<small_cookie> small_cookie_ref_ptr;
 
@@ -460,4 +843,8 @@ namespace neolib
     using jar = basic_jar<T, vector<T>, cookie, MutexType>;
     template <typename T, typename MutexType = null_mutex>
     using small_jar = basic_jar<T, vector<T>, small_cookie, MutexType>;
+    template <typename T, typename MutexType = null_mutex>
+    using generational_jar = basic_generational_jar<T, vector<T>, cookie, MutexType>;
+    template <typename T, typename MutexType = null_mutex>
+    using small_generational_jar = basic_generational_jar<T, vector<T>, small_cookie, MutexType>;
 }
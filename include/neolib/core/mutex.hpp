@@ -65,6 +65,7 @@
 
 #include <neolib/neolib.hpp>
 #include <mutex>
+#include <vector>
 #include <boost/thread/locks.hpp>
 #include <boost/lockfree/detail/prefix.hpp>
 #include <boost/fiber/detail/spinlock.hpp>
@@ -277,4 +278,39 @@ namespace neolib
     private:
         Mutexes& iMutexes;
     };
+
+    // Locks a whole container of mutexes as one; a mutex added to the container while it is held is only
+    // unlocked by the matching (re)lock that acquired it, so the container may grow under a nested lock.
+    template <typename Mutexes>
+    class multi_mutex : public i_lockable
+    {
+    public:
+        multi_mutex(Mutexes& aMutexes) :
+            iMutexes{ aMutexes }
+        {
+        }
+    public:
+        void lock() noexcept override
+        {
+            boost::lock(iMutexes.begin(), iMutexes.end());
+            iLockedCounts.push_back(iMutexes.size());
+        }
+        void unlock() noexcept override
+        {
+            auto const count = iLockedCounts.back();
+            iLockedCounts.pop_back();
+            for (std::size_t index = 0u; index < count; ++index)
+                iMutexes[index].unlock();
+        }
+        bool try_lock() noexcept override
+        {
+            if (boost::try_lock(iMutexes.begin(), iMutexes.end()) != iMutexes.end())
+                return false;
+            iLockedCounts.push_back(iMutexes.size());
+            return true;
+        }
+    private:
+        Mutexes& iMutexes;
+        std::vector<std::size_t> iLockedCounts;
+    };
 }
@@ -1230,9 +1230,12 @@ namespace neolib
             if (right.is_identity())
                 return left;
             basic_matrix<T, 4u, 4u> result;
-            for (uint32_t column = 0u; column < 4u; ++column)
-                for (uint32_t row = 0u; row < 4u; ++row)
-                    result[column][row] = simd_fma_4d(left[0u][row], right[column][0u], left[1u][row], right[column][1u], left[2u][row], right[column][2u], left[3u][row], right[column][3u]);
+            if constexpr (std::is_same_v<T, double>)
+                simd_mat44_mul(left.data(), right.data(), &result[0u][0u]);
+            else
+                for (uint32_t column = 0u; column < 4u; ++column)
+                    for (uint32_t row = 0u; row < 4u; ++row)
+                        result[column][row] = simd_fma_4d(left[0u][row], right[column][0u], left[1u][row], right[column][1u], left[2u][row], right[column][2u], left[3u][row], right[column][3u]);
             return result;
         }
 
@@ -1254,8 +1257,13 @@ namespace neolib
             if (left.is_identity())
                 return right;
             basic_vector<T, 4u, column_vector> result;
-            for (uint32_t row = 0u; row < 4u; ++row)
-                result[row] = simd_fma_4d(left[0][row], right[0], left[1][row], right[1], left[2][row], right[2], left[3][row], right[3]);
+            if constexpr (std::is_same_v<T, double>)
+                simd_mat44_transform_4d(left.data(), right.v.data(), result.v.data());
+            else if constexpr (std::is_same_v<T, float>)
+                simd_mat44f_transform_4f(left.data(), right.v.data(), result.v.data(), 1u);
+            else
+                for (uint32_t row = 0u; row < 4u; ++row)
+                    result[row] = simd_fma_4d(left[0][row], right[0], left[1][row], right[1], left[2][row], right[2], left[3][row], right[3]);
             return result;
         }
 
@@ -1373,20 +1381,69 @@ namespace neolib
             if (left.is_identity())
                 return right;
             basic_vector<T, 3u, column_vector> result;
-            for (uint32_t row = 0u; row < 3u; ++row)
-                result[row] = static_cast<T>(simd_fma_4d(left[0][row], right[0], left[1][row], right[1], left[2][row], right[2], left[3][row], 1.0));
+            if constexpr (std::is_same_v<T, double>)
+                simd_mat44_transform_3d(left.data(), right.v.data(), result.v.data(), 1u);
+            else
+                for (uint32_t row = 0u; row < 3u; ++row)
+                    result[row] = static_cast<T>(simd_fma_4d(left[0][row], right[0], left[1][row], right[1], left[2][row], right[2], left[3][row], 1.0));
             return result;
         }
 
+        // Batched transforms: the matrix is loaded into registers once for the whole range. [aFirst, aLast) and the
+        // destination range may be the same range but must not otherwise overlap.
+
+        inline void batch_transform(const mat44& aTransformation, const vec3* aFirst, const vec3* aLast, vec3* aDestination)
+        {
+            static_assert(sizeof(vec3) == sizeof(scalar) * 3u, "neolib::math: vec3 must be tightly packed");
+            if (aTransformation.is_identity())
+            {
+                if (aDestination != aFirst)
+                    std::copy(aFirst, aLast, aDestination);
+                return;
+            }
+            if (aFirst != aLast)
+                simd_mat44_transform_3d(aTransformation.data(), aFirst->v.data(), aDestination->v.data(), static_cast<std::size_t>(aLast - aFirst));
+        }
+
+        inline void batch_transform(const mat44f& aTransformation, const vec4f* aFirst, const vec4f* aLast, vec4f* aDestination)
+        {
+            static_assert(sizeof(vec4f) == sizeof(float) * 4u, "neolib::math: vec4f must be tightly packed");
+            if (aTransformation.is_identity())
+            {
+                if (aDestination != aFirst)
+                    std::copy(aFirst, aLast, aDestination);
+                return;
+            }
+            if (aFirst != aLast)
+                simd_mat44f_transform_4f(aTransformation.data(), aFirst->v.data(), aDestination->v.data(), static_cast<std::size_t>(aLast - aFirst));
+        }
+
         template <typename T>
         inline std::vector<basic_vector<T, 3u, column_vector>> operator*(const basic_matrix<T, 4u, 4u>& left, const std::vector<basic_vector<T, 3u, column_vector>>& right)
         {
             if (left.is_identity())
                 return right;
             std::vector<basic_vector<T, 3u, column_vector>> result;
-            result.reserve(right.size());
-            for (auto const& v : right)
-                result.push_back(left * v);
+            if constexpr (std::is_same_v<T, double>)
+            {
+                result = right;
+                batch_transform(left, result.data(), result.data() + result.size(), result.data());
+            }
+            else
+            {
+                result.reserve(right.size());
+                for (auto const& v : right)
+                    result.push_back(left * v);
+            }
+            return result;
+        }
+
+        inline std::vector<vec4f> operator*(const mat44f& left, const std::vector<vec4f>& right)
+        {
+            if (left.is_identity())
+                return right;
+            std::vector<vec4f> result = right;
+            batch_transform(left, result.data(), result.data() + result.size(), result.data());
             return result;
         }
 
@@ -1564,6 +1621,36 @@ namespace neolib
             return result;
         }
 
+        // Single matrix AABB transforms bound the transformed box per axis from the min/max of each matrix term
+        // rather than transforming eight corners; the result is the same.
+
+        inline void aabb_transform(const aabb* aFirst, const aabb* aLast, aabb* aDestination, const mat44& aTransformation)
+        {
+            static_assert(sizeof(aabb) == sizeof(vec3) * 2u, "neolib::math: aabb must be tightly packed");
+            if (aTransformation.is_identity())
+            {
+                if (aDestination != aFirst)
+                    std::copy(aFirst, aLast, aDestination);
+                return;
+            }
+            if (aFirst != aLast)
+                simd_mat44_transform_aabb(aTransformation.data(), aFirst->min.v.data(), aDestination->min.v.data(), static_cast<std::size_t>(aLast - aFirst));
+        }
+
+        inline aabb aabb_transform(const aabb& aAabb, const mat44& aTransformation)
+        {
+            aabb result;
+            aabb_transform(&aAabb, &aAabb + 1, &result, aTransformation);
+            return result;
+        }
+
+        inline std::vector<aabb> aabb_transform(const std::vector<aabb>& aAabbs, const mat44& aTransformation)
+        {
+            std::vector<aabb> result = aAabbs;
+            aabb_transform(result.data(), result.data() + result.size(), result.data(), aTransformation);
+            return result;
+        }
+
         inline aabb to_aabb(const vec3& aOrigin, scalar aSize)
         {
             return aabb{ aOrigin - aSize / 2.0, aOrigin + aSize / 2.0 };
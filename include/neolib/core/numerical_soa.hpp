@@ -0,0 +1,612 @@
+// numerical_soa.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <type_traits>
+#include <utility>
+#include <iterator>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <neolib/core/numerical.hpp>
+
+namespace neolib
+{
+    namespace math
+    {
+        namespace detail
+        {
+            // Structure-of-arrays kernels: each operates on the index range [aBegin, aEnd) of one or more component arrays.
+            // The AVX2 versions evaluate each expression in the same order as the scalar versions so results are identical.
+
+            template <typename T>
+            inline void fake_soa_transform_3(T const* aMatrix, std::array<T const*, 3> const& aInput, std::array<T*, 3> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                {
+                    T const x = aInput[0u][i];
+                    T const y = aInput[1u][i];
+                    T const z = aInput[2u][i];
+                    for (std::size_t row = 0u; row < 3u; ++row)
+                        aOutput[row][i] = ((aMatrix[row] * x + aMatrix[4u + row] * y) + aMatrix[8u + row] * z) + aMatrix[12u + row];
+                }
+            }
+
+            template <typename T, std::size_t Size>
+            inline void fake_soa_dot(std::array<T const*, Size> const& aLeft, std::array<T const*, Size> const& aRight, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                {
+                    T result = aLeft[0u][i] * aRight[0u][i];
+                    for (std::size_t component = 1u; component < Size; ++component)
+                        result = result + aLeft[component][i] * aRight[component][i];
+                    aOutput[i] = result;
+                }
+            }
+
+            template <typename T>
+            inline void fake_soa_cross(std::array<T const*, 3> const& aLeft, std::array<T const*, 3> const& aRight, std::array<T*, 3> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                {
+                    T const x = aLeft[1u][i] * aRight[2u][i] - aLeft[2u][i] * aRight[1u][i];
+                    T const y = aLeft[2u][i] * aRight[0u][i] - aLeft[0u][i] * aRight[2u][i];
+                    T const z = aLeft[0u][i] * aRight[1u][i] - aLeft[1u][i] * aRight[0u][i];
+                    aOutput[0u][i] = x;
+                    aOutput[1u][i] = y;
+                    aOutput[2u][i] = z;
+                }
+            }
+
+            template <typename T, std::size_t Size>
+            inline void fake_soa_normalize(std::array<T const*, Size> const& aInput, std::array<T*, Size> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                {
+                    T ss = aInput[0u][i] * aInput[0u][i];
+                    for (std::size_t component = 1u; component < Size; ++component)
+                        ss = ss + aInput[component][i] * aInput[component][i];
+                    T const im = constants::one<T> / std::sqrt(ss);
+                    for (std::size_t component = 0u; component < Size; ++component)
+                        aOutput[component][i] = aInput[component][i] * im;
+                }
+            }
+
+            template <typename T>
+            inline void fake_soa_lerp(T const* aLeft, T const* aRight, T aAmount, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                    aOutput[i] = (aRight[i] - aLeft[i]) * aAmount + aLeft[i];
+            }
+
+            template <typename T>
+            inline void fake_soa_bezier_cubic(T aP0, T aP1, T aP2, T aP3, T const* aParameters, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                {
+                    T const t = aParameters[i];
+                    T const u = constants::one<T> - t;
+                    aOutput[i] = (((u * u * u) * aP0 + (constants::three<T> * u * u * t) * aP1) + (constants::three<T> * u * t * t) * aP2) + (t * t * t) * aP3;
+                }
+            }
+
+            template <typename T>
+            inline void fake_soa_min_max(T const* aInput, T& aMin, T& aMax, std::size_t aBegin, std::size_t aEnd)
+            {
+                for (std::size_t i = aBegin; i < aEnd; ++i)
+                {
+                    aMin = std::min(aMin, aInput[i]);
+                    aMax = std::max(aMax, aInput[i]);
+                }
+            }
+
+#if defined(NEOLIB_AVX2_TARGET)
+            template <typename T>
+            struct avx2_lanes;
+            template <>
+            struct avx2_lanes<double> { static constexpr std::size_t value = 4u; };
+            template <>
+            struct avx2_lanes<float> { static constexpr std::size_t value = 8u; };
+
+            NEOLIB_AVX2_TARGET inline __m256d avx2_load(double const* aSource) { return _mm256_loadu_pd(aSource); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_load(float const* aSource) { return _mm256_loadu_ps(aSource); }
+            NEOLIB_AVX2_TARGET inline void avx2_store(double* aDestination, __m256d aValue) { _mm256_storeu_pd(aDestination, aValue); }
+            NEOLIB_AVX2_TARGET inline void avx2_store(float* aDestination, __m256 aValue) { _mm256_storeu_ps(aDestination, aValue); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_set1(double aValue) { return _mm256_set1_pd(aValue); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_set1(float aValue) { return _mm256_set1_ps(aValue); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_add(__m256d aLeft, __m256d aRight) { return _mm256_add_pd(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_add(__m256 aLeft, __m256 aRight) { return _mm256_add_ps(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_sub(__m256d aLeft, __m256d aRight) { return _mm256_sub_pd(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_sub(__m256 aLeft, __m256 aRight) { return _mm256_sub_ps(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_mul(__m256d aLeft, __m256d aRight) { return _mm256_mul_pd(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_mul(__m256 aLeft, __m256 aRight) { return _mm256_mul_ps(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_div(__m256d aLeft, __m256d aRight) { return _mm256_div_pd(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_div(__m256 aLeft, __m256 aRight) { return _mm256_div_ps(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_sqrt(__m256d aValue) { return _mm256_sqrt_pd(aValue); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_sqrt(__m256 aValue) { return _mm256_sqrt_ps(aValue); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_min(__m256d aLeft, __m256d aRight) { return _mm256_min_pd(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_min(__m256 aLeft, __m256 aRight) { return _mm256_min_ps(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256d avx2_max(__m256d aLeft, __m256d aRight) { return _mm256_max_pd(aLeft, aRight); }
+            NEOLIB_AVX2_TARGET inline __m256 avx2_max(__m256 aLeft, __m256 aRight) { return _mm256_max_ps(aLeft, aRight); }
+
+            template <typename T>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_transform_3(T const* aMatrix, std::array<T const*, 3> const& aInput, std::array<T*, 3> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                std::size_t i = aBegin;
+                for (; i + lanes <= aEnd; i += lanes)
+                {
+                    auto const x = avx2_load(aInput[0u] + i);
+                    auto const y = avx2_load(aInput[1u] + i);
+                    auto const z = avx2_load(aInput[2u] + i);
+                    for (std::size_t row = 0u; row < 3u; ++row)
+                        avx2_store(aOutput[row] + i, avx2_add(avx2_add(avx2_add(
+                            avx2_mul(avx2_set1(aMatrix[row]), x), avx2_mul(avx2_set1(aMatrix[4u + row]), y)), 
+                            avx2_mul(avx2_set1(aMatrix[8u + row]), z)), avx2_set1(aMatrix[12u + row])));
+                }
+                fake_soa_transform_3(aMatrix, aInput, aOutput, i, aEnd);
+            }
+
+            template <typename T, std::size_t Size>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_dot(std::array<T const*, Size> const& aLeft, std::array<T const*, Size> const& aRight, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                std::size_t i = aBegin;
+                for (; i + lanes <= aEnd; i += lanes)
+                {
+                    auto result = avx2_mul(avx2_load(aLeft[0u] + i), avx2_load(aRight[0u] + i));
+                    for (std::size_t component = 1u; component < Size; ++component)
+                        result = avx2_add(result, avx2_mul(avx2_load(aLeft[component] + i), avx2_load(aRight[component] + i)));
+                    avx2_store(aOutput + i, result);
+                }
+                fake_soa_dot(aLeft, aRight, aOutput, i, aEnd);
+            }
+
+            template <typename T>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_cross(std::array<T const*, 3> const& aLeft, std::array<T const*, 3> const& aRight, std::array<T*, 3> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                std::size_t i = aBegin;
+                for (; i + lanes <= aEnd; i += lanes)
+                {
+                    auto const lx = avx2_load(aLeft[0u] + i), ly = avx2_load(aLeft[1u] + i), lz = avx2_load(aLeft[2u] + i);
+                    auto const rx = avx2_load(aRight[0u] + i), ry = avx2_load(aRight[1u] + i), rz = avx2_load(aRight[2u] + i);
+                    avx2_store(aOutput[0u] + i, avx2_sub(avx2_mul(ly, rz), avx2_mul(lz, ry)));
+                    avx2_store(aOutput[1u] + i, avx2_sub(avx2_mul(lz, rx), avx2_mul(lx, rz)));
+                    avx2_store(aOutput[2u] + i, avx2_sub(avx2_mul(lx, ry), avx2_mul(ly, rx)));
+                }
+                fake_soa_cross(aLeft, aRight, aOutput, i, aEnd);
+            }
+
+            template <typename T, std::size_t Size>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_normalize(std::array<T const*, Size> const& aInput, std::array<T*, Size> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                auto const one = avx2_set1(constants::one<T>);
+                std::size_t i = aBegin;
+                for (; i + lanes <= aEnd; i += lanes)
+                {
+                    auto ss = avx2_mul(avx2_load(aInput[0u] + i), avx2_load(aInput[0u] + i));
+                    for (std::size_t component = 1u; component < Size; ++component)
+                        ss = avx2_add(ss, avx2_mul(avx2_load(aInput[component] + i), avx2_load(aInput[component] + i)));
+                    auto const im = avx2_div(one, avx2_sqrt(ss));
+                    for (std::size_t component = 0u; component < Size; ++component)
+                        avx2_store(aOutput[component] + i, avx2_mul(avx2_load(aInput[component] + i), im));
+                }
+                fake_soa_normalize(aInput, aOutput, i, aEnd);
+            }
+
+            template <typename T>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_lerp(T const* aLeft, T const* aRight, T aAmount, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                auto const amount = avx2_set1(aAmount);
+                std::size_t i = aBegin;
+                for (; i + lanes <= aEnd; i += lanes)
+                {
+                    auto const left = avx2_load(aLeft + i);
+                    avx2_store(aOutput + i, avx2_add(avx2_mul(avx2_sub(avx2_load(aRight + i), left), amount), left));
+                }
+                fake_soa_lerp(aLeft, aRight, aAmount, aOutput, i, aEnd);
+            }
+
+            template <typename T>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_bezier_cubic(T aP0, T aP1, T aP2, T aP3, T const* aParameters, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                auto const p0 = avx2_set1(aP0), p1 = avx2_set1(aP1), p2 = avx2_set1(aP2), p3 = avx2_set1(aP3);
+                auto const one = avx2_set1(constants::one<T>), three = avx2_set1(constants::three<T>);
+                std::size_t i = aBegin;
+                for (; i + lanes <= aEnd; i += lanes)
+                {
+                    auto const t = avx2_load(aParameters + i);
+                    auto const u = avx2_sub(one, t);
+                    auto const b0 = avx2_mul(avx2_mul(u, u), u);
+                    auto const b1 = avx2_mul(avx2_mul(avx2_mul(three, u), u), t);
+                    auto const b2 = avx2_mul(avx2_mul(avx2_mul(three, u), t), t);
+                    auto const b3 = avx2_mul(avx2_mul(t, t), t);
+                    avx2_store(aOutput + i, avx2_add(avx2_add(avx2_add(avx2_mul(b0, p0), avx2_mul(b1, p1)), avx2_mul(b2, p2)), avx2_mul(b3, p3)));
+                }
+                fake_soa_bezier_cubic(aP0, aP1, aP2, aP3, aParameters, aOutput, i, aEnd);
+            }
+
+            template <typename T>
+            NEOLIB_AVX2_TARGET inline void avx2_soa_min_max(T const* aInput, T& aMin, T& aMax, std::size_t aBegin, std::size_t aEnd)
+            {
+                std::size_t constexpr lanes = avx2_lanes<T>::value;
+                std::size_t i = aBegin;
+                if (i + lanes <= aEnd)
+                {
+                    auto low = avx2_set1(aMin);
+                    auto high = avx2_set1(aMax);
+                    for (; i + lanes <= aEnd; i += lanes)
+                    {
+                        auto const value = avx2_load(aInput + i);
+                        low = avx2_min(low, value);
+                        high = avx2_max(high, value);
+                    }
+                    T lows[lanes];
+                    T highs[lanes];
+                    avx2_store(lows, low);
+                    avx2_store(highs, high);
+                    aMin = *std::min_element(std::begin(lows), std::end(lows));
+                    aMax = *std::max_element(std::begin(highs), std::end(highs));
+                }
+                fake_soa_min_max(aInput, aMin, aMax, i, aEnd);
+            }
+#endif
+
+            template <typename T>
+            inline void soa_transform_3(T const* aMatrix, std::array<T const*, 3> const& aInput, std::array<T*, 3> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_transform_3(aMatrix, aInput, aOutput, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_transform_3(aMatrix, aInput, aOutput, aBegin, aEnd);
+#endif
+                fake_soa_transform_3(aMatrix, aInput, aOutput, aBegin, aEnd);
+            }
+
+            template <typename T, std::size_t Size>
+            inline void soa_dot(std::array<T const*, Size> const& aLeft, std::array<T const*, Size> const& aRight, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_dot(aLeft, aRight, aOutput, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_dot(aLeft, aRight, aOutput, aBegin, aEnd);
+#endif
+                fake_soa_dot(aLeft, aRight, aOutput, aBegin, aEnd);
+            }
+
+            template <typename T>
+            inline void soa_cross(std::array<T const*, 3> const& aLeft, std::array<T const*, 3> const& aRight, std::array<T*, 3> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_cross(aLeft, aRight, aOutput, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_cross(aLeft, aRight, aOutput, aBegin, aEnd);
+#endif
+                fake_soa_cross(aLeft, aRight, aOutput, aBegin, aEnd);
+            }
+
+            template <typename T, std::size_t Size>
+            inline void soa_normalize(std::array<T const*, Size> const& aInput, std::array<T*, Size> const& aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_normalize(aInput, aOutput, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_normalize(aInput, aOutput, aBegin, aEnd);
+#endif
+                fake_soa_normalize(aInput, aOutput, aBegin, aEnd);
+            }
+
+            template <typename T>
+            inline void soa_lerp(T const* aLeft, T const* aRight, T aAmount, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_lerp(aLeft, aRight, aAmount, aOutput, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_lerp(aLeft, aRight, aAmount, aOutput, aBegin, aEnd);
+#endif
+                fake_soa_lerp(aLeft, aRight, aAmount, aOutput, aBegin, aEnd);
+            }
+
+            template <typename T>
+            inline void soa_bezier_cubic(T aP0, T aP1, T aP2, T aP3, T const* aParameters, T* aOutput, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_bezier_cubic(aP0, aP1, aP2, aP3, aParameters, aOutput, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_bezier_cubic(aP0, aP1, aP2, aP3, aParameters, aOutput, aBegin, aEnd);
+#endif
+                fake_soa_bezier_cubic(aP0, aP1, aP2, aP3, aParameters, aOutput, aBegin, aEnd);
+            }
+
+            template <typename T>
+            inline void soa_min_max(T const* aInput, T& aMin, T& aMax, std::size_t aBegin, std::size_t aEnd)
+            {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+                if (!use_simd())
+                    return fake_soa_min_max(aInput, aMin, aMax, aBegin, aEnd);
+#endif
+#if defined(NEOLIB_AVX2_TARGET)
+                if (avx2_supported())
+                    return avx2_soa_min_max(aInput, aMin, aMax, aBegin, aEnd);
+#endif
+                fake_soa_min_max(aInput, aMin, aMax, aBegin, aEnd);
+            }
+        }
+
+        // Structure-of-arrays storage for many vectors: each component is held in its own contiguous array so bulk
+        // operations work on a full SIMD register of vectors at a time. Conversion to and from the array-of-structs
+        // basic_vector containers (e.g. vertices) is explicit.
+        template <typename T, uint32_t Size>
+        class basic_vector_soa
+        {
+            typedef basic_vector_soa<T, Size> self_type;
+        public:
+            struct size_mismatch : std::logic_error { size_mismatch() : std::logic_error("neolib::math::basic_vector_soa::size_mismatch") {} };
+        public:
+            typedef T value_type;
+            typedef basic_vector<T, Size, column_vector> vector_type;
+            typedef std::vector<vector_type> aos_type;
+            typedef std::vector<value_type> component_type;
+            typedef std::size_t size_type;
+        public:
+            basic_vector_soa()
+            {
+            }
+            explicit basic_vector_soa(size_type aCount)
+            {
+                resize(aCount);
+            }
+            explicit basic_vector_soa(const aos_type& aVectors)
+            {
+                assign(aVectors.begin(), aVectors.end());
+            }
+            template <typename InputIter>
+            basic_vector_soa(InputIter aFirst, InputIter aLast)
+            {
+                assign(aFirst, aLast);
+            }
+        public:
+            static constexpr uint32_t dimension() { return Size; }
+            size_type size() const { return iComponents[0u].size(); }
+            bool empty() const { return iComponents[0u].empty(); }
+            void reserve(size_type aCapacity) { for (auto& c : iComponents) c.reserve(aCapacity); }
+            void resize(size_type aCount) { for (auto& c : iComponents) c.resize(aCount); }
+            void clear() { for (auto& c : iComponents) c.clear(); }
+            void push_back(const vector_type& aVector) { for (uint32_t component = 0u; component < Size; ++component) iComponents[component].push_back(aVector[component]); }
+            vector_type operator[](size_type aIndex) const { vector_type result; for (uint32_t component = 0u; component < Size; ++component) result[component] = iComponents[component][aIndex]; return result; }
+            void set(size_type aIndex, const vector_type& aVector) { for (uint32_t component = 0u; component < Size; ++component) iComponents[component][aIndex] = aVector[component]; }
+            template <typename InputIter>
+            void assign(InputIter aFirst, InputIter aLast)
+            {
+                clear();
+                if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIter>::iterator_category>)
+                    reserve(static_cast<size_type>(std::distance(aFirst, aLast)));
+                for (; aFirst != aLast; ++aFirst)
+                    push_back(*aFirst);
+            }
+            aos_type to_aos() const
+            {
+                aos_type result;
+                result.reserve(size());
+                for (size_type i = 0u; i < size(); ++i)
+                    result.push_back((*this)[i]);
+                return result;
+            }
+        public:
+            const component_type& component(uint32_t aComponent) const { return iComponents[aComponent]; }
+            const value_type* data(uint32_t aComponent) const { return iComponents[aComponent].data(); }
+            value_type* data(uint32_t aComponent) { return iComponents[aComponent].data(); }
+            std::array<const value_type*, Size> data() const { std::array<const value_type*, Size> result; for (uint32_t component = 0u; component < Size; ++component) result[component] = data(component); return result; }
+            std::array<value_type*, Size> data() { std::array<value_type*, Size> result; for (uint32_t component = 0u; component < Size; ++component) result[component] = data(component); return result; }
+            const component_type& x() const { return component(0u); }
+            template <typename SFINAE = component_type>
+            const std::enable_if_t<(Size > 1u), SFINAE>& y() const { return component(1u); }
+            template <typename SFINAE = component_type>
+            const std::enable_if_t<(Size > 2u), SFINAE>& z() const { return component(2u); }
+            template <typename SFINAE = component_type>
+            const std::enable_if_t<(Size > 3u), SFINAE>& w() const { return component(3u); }
+        public:
+            bool operator==(const self_type& right) const { return iComponents == right.iComponents; }
+            bool operator!=(const self_type& right) const { return !(*this == right); }
+        private:
+            std::array<component_type, Size> iComponents;
+        };
+
+        typedef basic_vector_soa<double, 2u> vector2_soa;
+        typedef basic_vector_soa<double, 3u> vector3_soa;
+        typedef basic_vector_soa<float, 2u> vector2f_soa;
+        typedef basic_vector_soa<float, 3u> vector3f_soa;
+
+        typedef vector2_soa vec2_soa;
+        typedef vector3_soa vec3_soa;
+        typedef vector2f_soa vec2f_soa;
+        typedef vector3f_soa vec3f_soa;
+
+        typedef vec3_soa vertices_soa;
+
+        template <typename T, uint32_t Size>
+        inline basic_vector_soa<T, Size> to_soa(const std::vector<basic_vector<T, Size, column_vector>>& aVectors)
+        {
+            return basic_vector_soa<T, Size>{ aVectors };
+        }
+
+        template <typename T, uint32_t Size>
+        inline std::vector<basic_vector<T, Size, column_vector>> to_aos(const basic_vector_soa<T, Size>& aVectors)
+        {
+            return aVectors.to_aos();
+        }
+
+        // Bulk operations. Each result element is computed as the corresponding basic_vector operation would compute it;
+        // results may be written over an input of the same size.
+
+        template <typename T>
+        inline void batch_transform(const basic_matrix<T, 4u, 4u>& aTransformation, const basic_vector_soa<T, 3u>& aInput, basic_vector_soa<T, 3u>& aOutput)
+        {
+            if (&aOutput != &aInput)
+                aOutput.resize(aInput.size());
+            if (aTransformation.is_identity())
+            {
+                if (&aOutput != &aInput)
+                    aOutput = aInput;
+                return;
+            }
+            detail::soa_transform_3(aTransformation.data(), aInput.data(), aOutput.data(), 0u, aInput.size());
+        }
+
+        template <typename T>
+        inline basic_vector_soa<T, 3u> operator*(const basic_matrix<T, 4u, 4u>& left, const basic_vector_soa<T, 3u>& right)
+        {
+            basic_vector_soa<T, 3u> result;
+            batch_transform(left, right, result);
+            return result;
+        }
+
+        template <typename T, uint32_t Size>
+        inline std::vector<T> dot(const basic_vector_soa<T, Size>& left, const basic_vector_soa<T, Size>& right)
+        {
+            if (left.size() != right.size())
+                throw typename basic_vector_soa<T, Size>::size_mismatch();
+            std::vector<T> result(left.size());
+            detail::soa_dot<T, Size>(left.data(), right.data(), result.data(), 0u, left.size());
+            return result;
+        }
+
+        template <typename T>
+        inline basic_vector_soa<T, 3u> cross(const basic_vector_soa<T, 3u>& left, const basic_vector_soa<T, 3u>& right)
+        {
+            if (left.size() != right.size())
+                throw typename basic_vector_soa<T, 3u>::size_mismatch();
+            basic_vector_soa<T, 3u> result{ left.size() };
+            detail::soa_cross(left.data(), right.data(), result.data(), 0u, left.size());
+            return result;
+        }
+
+        template <typename T, uint32_t Size>
+        inline void normalize(basic_vector_soa<T, Size>& aVectors)
+        {
+            auto const input = std::as_const(aVectors).data();
+            detail::soa_normalize<T, Size>(input, aVectors.data(), 0u, aVectors.size());
+        }
+
+        template <typename T, uint32_t Size>
+        inline basic_vector_soa<T, Size> normalized(const basic_vector_soa<T, Size>& aVectors)
+        {
+            basic_vector_soa<T, Size> result{ aVectors.size() };
+            detail::soa_normalize<T, Size>(aVectors.data(), result.data(), 0u, aVectors.size());
+            return result;
+        }
+
+        template <typename T, uint32_t Size>
+        inline basic_vector_soa<T, Size> lerp(const basic_vector_soa<T, Size>& aV1, const basic_vector_soa<T, Size>& aV2, T aAmount)
+        {
+            if (aV1.size() != aV2.size())
+                throw typename basic_vector_soa<T, Size>::size_mismatch();
+            basic_vector_soa<T, Size> result{ aV1.size() };
+            for (uint32_t component = 0u; component < Size; ++component)
+                detail::soa_lerp(aV1.data(component), aV2.data(component), aAmount, result.data(component), 0u, aV1.size());
+            return result;
+        }
+
+        // Evaluates one cubic Bezier curve at each of the parameters aParameters.
+        template <typename T, uint32_t Size>
+        inline basic_vector_soa<T, Size> bezier_cubic(basic_vector<T, Size> const& p0, basic_vector<T, Size> const& p1, basic_vector<T, Size> const& p2, basic_vector<T, Size> const& p3, std::vector<T> const& aParameters)
+        {
+            basic_vector_soa<T, Size> result{ aParameters.size() };
+            for (uint32_t component = 0u; component < Size; ++component)
+                detail::soa_bezier_cubic(p0[component], p1[component], p2[component], p3[component], aParameters.data(), result.data(component), 0u, aParameters.size());
+            return result;
+        }
+
+        // Returns the componentwise minimum and maximum of a non-empty set of vectors.
+        template <typename T, uint32_t Size>
+        inline std::pair<basic_vector<T, Size>, basic_vector<T, Size>> min_max(const basic_vector_soa<T, Size>& aVectors)
+        {
+            if (aVectors.empty())
+                throw std::out_of_range("neolib::math::min_max: no vectors");
+            std::pair<basic_vector<T, Size>, basic_vector<T, Size>> result;
+            for (uint32_t component = 0u; component < Size; ++component)
+            {
+                result.first[component] = result.second[component] = aVectors.data(component)[0u];
+                detail::soa_min_max(aVectors.data(component), result.first[component], result.second[component], 1u, aVectors.size());
+            }
+            return result;
+        }
+
+        template <typename T>
+        inline aabb to_aabb(const basic_vector_soa<T, 3u>& aVertices, const mat44& aTransformation = mat44::identity())
+        {
+            if (aVertices.empty())
+                return aabb_transform(aabb{}, aTransformation);
+            auto const bounds = min_max(aVertices);
+            return aabb_transform(aabb{ bounds.first.template as<scalar>(), bounds.second.template as<scalar>() }, aTransformation);
+        }
+
+        template <typename T>
+        inline aabb_2d to_aabb_2d(const basic_vector_soa<T, 2u>& aVertices)
+        {
+            if (aVertices.empty())
+                return aabb_2d{};
+            auto const bounds = min_max(aVertices);
+            return aabb_2d{ bounds.first.template as<scalar>(), bounds.second.template as<scalar>() };
+        }
+    }
+}
@@ -0,0 +1,641 @@
+/*
+ *  persistent_segmented_array.hpp
+ *
+ *  Copyright (c) 2020 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <memory>
+#include <iterator>
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <neolib/core/vecarray.hpp>
+
+namespace neolib
+{
+    // Immutable version of a persistent_segmented_array. Segments and index nodes are reference counted and never
+    // changed once shared so a snapshot can be copied and read on any thread without locking while the container
+    // it was taken from carries on being edited.
+    template <typename T, std::size_t SegmentSize = 64, typename Alloc = std::allocator<T>, std::size_t Fanout = 16>
+    class segmented_array_snapshot
+    {
+        static_assert(Fanout >= 4, "neolib::segmented_array_snapshot: fanout too small");
+        typedef segmented_array_snapshot<T, SegmentSize, Alloc, Fanout> self_type;
+    public:
+        typedef T value_type;
+        typedef Alloc allocator_type;
+        typedef value_type& reference;
+        typedef value_type const& const_reference;
+        typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+        typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
+        typedef typename std::allocator_traits<allocator_type>::size_type size_type;
+        typedef typename std::allocator_traits<allocator_type>::difference_type difference_type;
+    protected:
+        typedef neolib::vecarray<T, SegmentSize, SegmentSize, neolib::nocheck> segment_type;
+        struct node
+        {
+            bool const iLeaf;
+            node(bool aLeaf) : iLeaf{ aLeaf } {}
+        };
+        typedef std::shared_ptr<node> node_pointer;
+        struct leaf : node
+        {
+            segment_type iSegment;
+            leaf() : node{ true } {}
+            leaf(const leaf& aOther) : node{ true }, iSegment{ aOther.iSegment } {}
+        };
+        struct branch : node
+        {
+            size_type iChildCount;
+            std::array<size_type, Fanout> iCounts;
+            std::array<node_pointer, Fanout> iChildren;
+            branch() : node{ false }, iChildCount{ 0 }, iCounts{} {}
+            branch(const branch& aOther) : node{ false }, iChildCount{ aOther.iChildCount }, iCounts{ aOther.iCounts }, iChildren{ aOther.iChildren } {}
+        };
+    public:
+        class const_iterator
+        {
+            friend class segmented_array_snapshot;
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef typename segmented_array_snapshot::value_type value_type;
+            typedef typename segmented_array_snapshot::difference_type difference_type;
+            typedef typename segmented_array_snapshot::const_pointer pointer;
+            typedef typename segmented_array_snapshot::const_reference reference;
+        public:
+            const_iterator() :
+                iRoot{ nullptr }, iPosition{ 0 }, iSegment{ nullptr }, iSegmentStart{ 0 }, iSegmentEnd{ 0 }
+            {
+            }
+        private:
+            const_iterator(const node* aRoot, size_type aPosition) :
+                iRoot{ aRoot }, iPosition{ aPosition }, iSegment{ nullptr }, iSegmentStart{ 0 }, iSegmentEnd{ 0 }
+            {
+            }
+        public:
+            const_iterator& operator++() { ++iPosition; return *this; }
+            const_iterator& operator--() { --iPosition; return *this; }
+            const_iterator operator++(int) { const_iterator ret(*this); operator++(); return ret; }
+            const_iterator operator--(int) { const_iterator ret(*this); operator--(); return ret; }
+            const_iterator& operator+=(difference_type aDifference) { iPosition += aDifference; return *this; }
+            const_iterator& operator-=(difference_type aDifference) { iPosition -= aDifference; return *this; }
+            const_iterator operator+(difference_type aDifference) const { const_iterator result(*this); result += aDifference; return result; }
+            const_iterator operator-(difference_type aDifference) const { const_iterator result(*this); result -= aDifference; return result; }
+            const_reference operator[](difference_type aDifference) const { return *((*this) + aDifference); }
+            friend difference_type operator-(const const_iterator& aLhs, const const_iterator& aRhs) { return static_cast<difference_type>(aLhs.iPosition) - static_cast<difference_type>(aRhs.iPosition); }
+            const_reference operator*() const
+            {
+                // the segment is looked up again only when the position leaves the one last used
+                if (iSegment == nullptr || iPosition < iSegmentStart || iPosition >= iSegmentEnd)
+                {
+                    iSegment = &find_segment(iRoot, iPosition, iSegmentStart);
+                    iSegmentEnd = iSegmentStart + iSegment->size();
+                }
+                return (*iSegment)[iPosition - iSegmentStart];
+            }
+            const_pointer operator->() const { return &operator*(); }
+            bool operator==(const const_iterator& aOther) const { return iPosition == aOther.iPosition; }
+            bool operator!=(const const_iterator& aOther) const { return iPosition != aOther.iPosition; }
+            bool operator<(const const_iterator& aOther) const { return iPosition < aOther.iPosition; }
+            bool operator<=(const const_iterator& aOther) const { return iPosition <= aOther.iPosition; }
+            bool operator>(const const_iterator& aOther) const { return iPosition > aOther.iPosition; }
+            bool operator>=(const const_iterator& aOther) const { return iPosition >= aOther.iPosition; }
+            size_type position() const { return iPosition; }
+        private:
+            const node* iRoot;
+            size_type iPosition;
+            mutable const segment_type* iSegment;
+            mutable size_type iSegmentStart;
+            mutable size_type iSegmentEnd;
+        };
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+        typedef const_iterator iterator;
+        typedef const_reverse_iterator reverse_iterator;
+
+    public:
+        segmented_array_snapshot() :
+            iSize{ 0 }
+        {
+        }
+    protected:
+        segmented_array_snapshot(node_pointer aRoot, size_type aSize) :
+            iRoot{ std::move(aRoot) }, iSize{ aSize }
+        {
+        }
+
+    public:
+        size_type size() const
+        {
+            return iSize;
+        }
+        bool empty() const
+        {
+            return iSize == 0;
+        }
+        const_iterator cbegin() const
+        {
+            return const_iterator{ iRoot.get(), 0 };
+        }
+        const_iterator begin() const
+        {
+            return cbegin();
+        }
+        const_iterator cend() const
+        {
+            return const_iterator{ iRoot.get(), iSize };
+        }
+        const_iterator end() const
+        {
+            return cend();
+        }
+        const_reverse_iterator crbegin() const
+        {
+            return const_reverse_iterator(cend());
+        }
+        const_reverse_iterator rbegin() const
+        {
+            return crbegin();
+        }
+        const_reverse_iterator crend() const
+        {
+            return const_reverse_iterator(cbegin());
+        }
+        const_reverse_iterator rend() const
+        {
+            return crend();
+        }
+        const_reference front() const
+        {
+            return (*this)[0];
+        }
+        const_reference back() const
+        {
+            return (*this)[iSize - 1];
+        }
+        const_reference operator[](size_type aIndex) const
+        {
+            size_type segmentStart;
+            return find_segment(iRoot.get(), aIndex, segmentStart)[aIndex - segmentStart];
+        }
+        const_reference at(size_type aIndex) const
+        {
+            if (aIndex >= iSize)
+                throw std::out_of_range("neolib::segmented_array_snapshot::at");
+            return (*this)[aIndex];
+        }
+
+    protected:
+        const_iterator iterator_at(size_type aPosition) const
+        {
+            return const_iterator{ iRoot.get(), aPosition };
+        }
+        static const segment_type& find_segment(const node* aNode, size_type aPosition, size_type& aSegmentStart)
+        {
+            aSegmentStart = 0;
+            while (!aNode->iLeaf)
+            {
+                auto const& b = static_cast<const branch&>(*aNode);
+                size_type slot = 0;
+                while (slot + 1 < b.iChildCount && aPosition >= b.iCounts[slot])
+                {
+                    aPosition -= b.iCounts[slot];
+                    aSegmentStart += b.iCounts[slot];
+                    ++slot;
+                }
+                aNode = b.iChildren[slot].get();
+            }
+            return static_cast<const leaf&>(*aNode).iSegment;
+        }
+
+    protected:
+        node_pointer iRoot;
+        size_type iSize;
+    };
+
+    // Segmented array whose snapshot() is O(1): the snapshot shares every segment and index node with the container
+    // and the container copies a node only when it is about to change one that is still shared, so a mutation
+    // copies no more than the path from the root to the segments it touches. Copying the container is O(1) for
+    // the same reason. The index is a B+ tree without parent pointers or linked segments (unlike segmented_array's
+    // intrusive index) so that subtrees can be shared between versions. snapshot() must be called on the thread
+    // that owns the container; the snapshot itself may then be handed to any thread.
+    template <typename T, std::size_t SegmentSize = 64, typename Alloc = std::allocator<T>, std::size_t Fanout = 16>
+    class persistent_segmented_array : public segmented_array_snapshot<T, SegmentSize, Alloc, Fanout>
+    {
+        typedef persistent_segmented_array<T, SegmentSize, Alloc, Fanout> self_type;
+        typedef segmented_array_snapshot<T, SegmentSize, Alloc, Fanout> base_type;
+    public:
+        typedef base_type snapshot_type;
+        using typename base_type::value_type;
+        using typename base_type::allocator_type;
+        using typename base_type::reference;
+        using typename base_type::const_reference;
+        using typename base_type::pointer;
+        using typename base_type::const_pointer;
+        using typename base_type::size_type;
+        using typename base_type::difference_type;
+        using typename base_type::const_iterator;
+        using typename base_type::const_reverse_iterator;
+        using typename base_type::iterator;
+        using typename base_type::reverse_iterator;
+    private:
+        using typename base_type::segment_type;
+        using typename base_type::node;
+        using typename base_type::node_pointer;
+        using typename base_type::leaf;
+        using typename base_type::branch;
+        typedef typename std::allocator_traits<allocator_type>::template rebind_alloc<leaf> leaf_allocator_type;
+        typedef typename std::allocator_traits<allocator_type>::template rebind_alloc<branch> branch_allocator_type;
+        struct path_entry
+        {
+            branch* iBranch;
+            size_type iSlot;
+        };
+        // a split needs a full branch with Fanout / 2 full siblings so the depth cannot approach this
+        static constexpr size_type max_depth = 64;
+        typedef std::array<path_entry, max_depth> path;
+
+    public:
+        persistent_segmented_array(const Alloc& aAllocator = Alloc()) :
+            iAllocator{ aAllocator }
+        {
+        }
+        persistent_segmented_array(const size_type aCount, const value_type& aValue, const Alloc& aAllocator = Alloc()) :
+            iAllocator{ aAllocator }
+        {
+            insert(base_type::end(), aCount, aValue);
+        }
+        template <typename InputIterator>
+        persistent_segmented_array(InputIterator aFirst, InputIterator aLast, const Alloc& aAllocator = Alloc()) :
+            iAllocator{ aAllocator }
+        {
+            insert(base_type::end(), aFirst, aLast);
+        }
+        persistent_segmented_array(const persistent_segmented_array& aOther) :
+            base_type{ aOther }, iAllocator{ aOther.iAllocator }
+        {
+        }
+        persistent_segmented_array(persistent_segmented_array&& aOther) :
+            base_type{ std::move(aOther) }, iAllocator{ aOther.iAllocator }
+        {
+            aOther.iSize = 0;
+        }
+        persistent_segmented_array(const snapshot_type& aSnapshot, const Alloc& aAllocator = Alloc()) :
+            base_type{ aSnapshot }, iAllocator{ aAllocator }
+        {
+        }
+        persistent_segmented_array& operator=(const persistent_segmented_array& aOther)
+        {
+            base_type::operator=(aOther);
+            return *this;
+        }
+        persistent_segmented_array& operator=(persistent_segmented_array&& aOther)
+        {
+            base_type::operator=(std::move(aOther));
+            aOther.iSize = 0;
+            return *this;
+        }
+        persistent_segmented_array& operator=(const snapshot_type& aSnapshot)
+        {
+            base_type::operator=(aSnapshot);
+            return *this;
+        }
+
+    public:
+        snapshot_type snapshot() const
+        {
+            return snapshot_type{ *this };
+        }
+        using base_type::operator[];
+        reference operator[](size_type aIndex)
+        {
+            path p;
+            size_type depth;
+            size_type offset = aIndex;
+            return unshared_leaf(offset, p, depth).iSegment[offset];
+        }
+        iterator insert(const_iterator aPosition, const value_type& aValue)
+        {
+            return insert(aPosition, &aValue, &aValue + 1);
+        }
+        iterator insert(const_iterator aPosition, size_type aCount, const value_type& aValue)
+        {
+            size_type const position = aPosition.position();
+            segment_type const chunk(std::min<size_type>(aCount, SegmentSize), aValue);
+            for (size_type inserted = 0; inserted < aCount;)
+            {
+                size_type const count = std::min(aCount - inserted, chunk.size());
+                do_insert(position + inserted, chunk.begin(), chunk.begin() + count);
+                inserted += count;
+            }
+            return base_type::iterator_at(position);
+        }
+        template <class InputIterator>
+        typename std::enable_if<!std::is_integral<InputIterator>::value, iterator>::type
+        insert(const_iterator aPosition, InputIterator aFirst, InputIterator aLast)
+        {
+            return do_insert(aPosition.position(), aFirst, aLast);
+        }
+        iterator erase(const_iterator aPosition)
+        {
+            return erase(aPosition, std::next(aPosition));
+        }
+        iterator erase(const_iterator aFirst, const_iterator aLast)
+        {
+            size_type const position = aFirst.position();
+            for (size_type count = aLast - aFirst; count > 0;)
+            {
+                path p;
+                size_type depth;
+                size_type offset = position;
+                segment_type& segment = unshared_leaf(offset, p, depth).iSegment;
+                size_type const removed = std::min(count, segment.size() - offset);
+                segment.erase(segment.begin() + offset, segment.begin() + offset + removed);
+                count -= removed;
+                base_type::iSize -= removed;
+                if (segment.empty())
+                    remove_node(p, depth);
+                else
+                    adjust_counts(p, depth, static_cast<size_type>(0) - removed);
+            }
+            return base_type::iterator_at(position);
+        }
+        void clear()
+        {
+            base_type::iRoot.reset();
+            base_type::iSize = 0;
+        }
+        void push_front(const value_type& aValue)
+        {
+            insert(base_type::begin(), aValue);
+        }
+        void push_back(const value_type& aValue)
+        {
+            insert(base_type::end(), aValue);
+        }
+        void pop_front()
+        {
+            erase(base_type::begin());
+        }
+        void pop_back()
+        {
+            erase(std::prev(base_type::end()));
+        }
+        void swap(persistent_segmented_array& aOther)
+        {
+            std::swap(base_type::iRoot, aOther.iRoot);
+            std::swap(base_type::iSize, aOther.iSize);
+            std::swap(iAllocator, aOther.iAllocator);
+        }
+
+    private:
+        template <class InputIterator>
+        typename std::enable_if<!std::is_same<typename std::iterator_traits<InputIterator>::iterator_category, std::input_iterator_tag>::value, iterator>::type
+        do_insert(size_type aPosition, InputIterator aFirst, InputIterator aLast)
+        {
+            size_type remaining = std::distance(aFirst, aLast);
+            if (remaining == 0)
+                return base_type::iterator_at(aPosition);
+            if (base_type::iRoot == nullptr)
+                base_type::iRoot = allocate_leaf();
+            base_type::iSize += remaining;
+            path p;
+            size_type depth;
+            size_type offset = aPosition;
+            segment_type& segment = unshared_leaf(offset, p, depth).iSegment;
+            if (segment.size() + remaining <= SegmentSize)
+            {
+                segment.insert(segment.begin() + offset, aFirst, aLast);
+                adjust_counts(p, depth, remaining);
+                return base_type::iterator_at(aPosition);
+            }
+            // the new elements followed by the tail of the segment are spread over new segments that follow it
+            segment_type tail{ std::make_move_iterator(segment.begin() + offset), std::make_move_iterator(segment.end()) };
+            segment.erase(segment.begin() + offset, segment.end());
+            size_type const fill = std::min(remaining, SegmentSize - offset);
+            InputIterator stop = std::next(aFirst, fill);
+            segment.insert(segment.end(), aFirst, stop);
+            aFirst = stop;
+            remaining -= fill;
+            adjust_counts(p, depth, fill - tail.size());
+            for (auto tailNext = tail.begin(); remaining > 0 || tailNext != tail.end();)
+            {
+                node_pointer newLeaf = allocate_leaf();
+                segment_type& newSegment = static_cast<leaf&>(*newLeaf).iSegment;
+                size_type const take = std::min(remaining, SegmentSize);
+                stop = std::next(aFirst, take);
+                newSegment.insert(newSegment.end(), aFirst, stop);
+                aFirst = stop;
+                remaining -= take;
+                size_type const takeTail = std::min(static_cast<size_type>(tail.end() - tailNext), SegmentSize - newSegment.size());
+                newSegment.insert(newSegment.end(), std::make_move_iterator(tailNext), std::make_move_iterator(tailNext + takeTail));
+                tailNext += takeTail;
+                insert_after(p, depth, std::move(newLeaf));
+            }
+            return base_type::iterator_at(aPosition);
+        }
+        template <class InputIterator>
+        typename std::enable_if<std::is_same<typename std::iterator_traits<InputIterator>::iterator_category, std::input_iterator_tag>::value, iterator>::type
+        do_insert(size_type aPosition, InputIterator aFirst, InputIterator aLast)
+        {
+            for (size_type position = aPosition; aFirst != aLast; ++position)
+            {
+                value_type const value = *aFirst++;
+                do_insert(position, &value, &value + 1);
+            }
+            return base_type::iterator_at(aPosition);
+        }
+        node_pointer allocate_leaf()
+        {
+            return std::allocate_shared<leaf>(leaf_allocator_type{ iAllocator });
+        }
+        node_pointer allocate_branch()
+        {
+            return std::allocate_shared<branch>(branch_allocator_type{ iAllocator });
+        }
+        // a node referenced only by this container can be changed in place; one still shared with a snapshot (or
+        // a copy) is replaced by a copy which shares the node's children in turn
+        void unshare(node_pointer& aNode)
+        {
+            if (aNode.use_count() == 1)
+            {
+                // pairs with the release of any other reference so its reads happen before our writes
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return;
+            }
+            if (aNode->iLeaf)
+                aNode = std::allocate_shared<leaf>(leaf_allocator_type{ iAllocator }, static_cast<const leaf&>(*aNode));
+            else
+                aNode = std::allocate_shared<branch>(branch_allocator_type{ iAllocator }, static_cast<const branch&>(*aNode));
+        }
+        // unshares the path to the segment containing aPosition (or to the last segment if aPosition is the end)
+        // and converts aPosition into an offset within that segment
+        leaf& unshared_leaf(size_type& aPosition, path& aPath, size_type& aDepth)
+        {
+            node_pointer* current = &this->iRoot;
+            aDepth = 0;
+            for (;;)
+            {
+                unshare(*current);
+                if ((*current)->iLeaf)
+                    return static_cast<leaf&>(**current);
+                branch& b = static_cast<branch&>(**current);
+                size_type slot = 0;
+                while (slot + 1 < b.iChildCount && aPosition >= b.iCounts[slot])
+                {
+                    aPosition -= b.iCounts[slot];
+                    ++slot;
+                }
+                aPath[aDepth++] = path_entry{ &b, slot };
+                current = &b.iChildren[slot];
+            }
+        }
+        static size_type total(const node& aNode)
+        {
+            if (aNode.iLeaf)
+                return static_cast<const leaf&>(aNode).iSegment.size();
+            auto const& b = static_cast<const branch&>(aNode);
+            size_type result = 0;
+            for (size_type i = 0; i < b.iChildCount; ++i)
+                result += b.iCounts[i];
+            return result;
+        }
+        // aDifference wraps around for a decrease
+        static void adjust_counts(const path& aPath, size_type aDepth, size_type aDifference)
+        {
+            for (size_type level = 0; level < aDepth; ++level)
+                aPath[level].iBranch->iCounts[aPath[level].iSlot] += aDifference;
+        }
+        static void insert_child(branch& aBranch, size_type aSlot, node_pointer aChild)
+        {
+            for (size_type i = aBranch.iChildCount; i > aSlot; --i)
+            {
+                aBranch.iChildren[i] = std::move(aBranch.iChildren[i - 1]);
+                aBranch.iCounts[i] = aBranch.iCounts[i - 1];
+            }
+            aBranch.iCounts[aSlot] = total(*aChild);
+            aBranch.iChildren[aSlot] = std::move(aChild);
+            ++aBranch.iChildCount;
+        }
+        // inserts a node whose elements are not yet counted immediately after the node the path leads to, splitting
+        // full branches on the way up, and makes the path lead to the new node
+        void insert_after(path& aPath, size_type& aDepth, node_pointer aNode)
+        {
+            size_type const added = total(*aNode);
+            node_pointer sibling = std::move(aNode);
+            bool pathToSibling = true;
+            for (size_type level = aDepth; level-- > 0;)
+            {
+                branch& b = *aPath[level].iBranch;
+                size_type const previous = aPath[level].iSlot;
+                size_type const slot = previous + 1;
+                // the previous child may have been split below so its count is refreshed
+                b.iCounts[previous] = total(*b.iChildren[previous]);
+                if (b.iChildCount < Fanout)
+                {
+                    insert_child(b, slot, std::move(sibling));
+                    if (pathToSibling)
+                        aPath[level].iSlot = slot;
+                    adjust_counts(aPath, level, added);
+                    return;
+                }
+                node_pointer right = allocate_branch();
+                branch& r = static_cast<branch&>(*right);
+                size_type const half = Fanout / 2;
+                for (size_type i = half; i < Fanout; ++i)
+                {
+                    r.iChildren[i - half] = std::move(b.iChildren[i]);
+                    r.iCounts[i - half] = b.iCounts[i];
+                }
+                r.iChildCount = Fanout - half;
+                b.iChildCount = half;
+                if (slot <= half)
+                {
+                    insert_child(b, slot, std::move(sibling));
+                    aPath[level].iSlot = pathToSibling ? slot : previous;
+                    pathToSibling = false;
+                }
+                else
+                {
+                    insert_child(r, slot - half, std::move(sibling));
+                    aPath[level] = path_entry{ &r, pathToSibling ? slot - half : previous - half };
+                    pathToSibling = true;
+                }
+                sibling = std::move(right);
+            }
+            // the root was split so the tree grows by a level
+            node_pointer newRoot = allocate_branch();
+            branch& nr = static_cast<branch&>(*newRoot);
+            insert_child(nr, 0, std::move(base_type::iRoot));
+            insert_child(nr, 1, std::move(sibling));
+            base_type::iRoot = std::move(newRoot);
+            std::move_backward(aPath.begin(), aPath.begin() + aDepth, aPath.begin() + aDepth + 1);
+            aPath[0] = path_entry{ &nr, pathToSibling ? 1u : 0u };
+            ++aDepth;
+        }
+        // removes the (empty) node the path leads to along with any branches left without children
+        void remove_node(const path& aPath, size_type aDepth)
+        {
+            for (size_type level = aDepth; level-- > 0;)
+            {
+                branch& b = *aPath[level].iBranch;
+                size_type const slot = aPath[level].iSlot;
+                size_type const removed = b.iCounts[slot];
+                for (size_type i = slot; i + 1 < b.iChildCount; ++i)
+                {
+                    b.iChildren[i] = std::move(b.iChildren[i + 1]);
+                    b.iCounts[i] = b.iCounts[i + 1];
+                }
+                b.iChildren[--b.iChildCount].reset();
+                if (b.iChildCount != 0)
+                {
+                    adjust_counts(aPath, level, static_cast<size_type>(0) - removed);
+                    // a root with a single child is replaced by that child
+                    while (!base_type::iRoot->iLeaf && static_cast<branch&>(*base_type::iRoot).iChildCount == 1)
+                    {
+                        node_pointer child = std::move(static_cast<branch&>(*base_type::iRoot).iChildren[0]);
+                        base_type::iRoot = std::move(child);
+                    }
+                    return;
+                }
+            }
+            base_type::iRoot.reset();
+        }
+
+    private:
+        allocator_type iAllocator;
+    };
+}
@@ -38,6 +38,10 @@
 #include <neolib/neolib.hpp>
 #include <random>
 #include <thread>
+#include <span>
+#include <type_traits>
+#include <algorithm>
+#include <neolib/core/simd.hpp>
 
 namespace neolib 
 {
@@ -48,12 +52,13 @@ namespace neolib
         typedef T value_type;
         typedef Gen generator_type;
         typedef typename generator_type::result_type generator_result_type;
-        static const std::size_t state_size = generator_type::state_size;
+        static constexpr std::size_t state_size = generator_type::state_size;
+        // number of values a secure (randomly seeded) generator produces before it is reseeded from std::random_device: at
+        // least the generator's state size (a Mersenne Twister's whole state can be recovered from that many outputs) and
+        // never less than the Mersenne Twister's so a generator with a small state does not reseed far more often
+        static constexpr std::size_t reseed_interval = std::max<std::size_t>(state_size, std::mt19937::state_size);
     private:
-        template <bool IsInteger>
-        struct distribution_selector;
-        template <>
-        struct distribution_selector<true>
+        struct integer_distribution_selector
         {
             typedef generator_result_type interval_value_type;
             typedef std::uniform_int_distribution<interval_value_type> distribution_type;
@@ -62,8 +67,7 @@ namespace neolib
                 return std::make_pair(aLower, aUpper);
             }
         };
-        template <>
-        struct distribution_selector<false>
+        struct real_distribution_selector
         {
             typedef value_type interval_value_type;
             typedef std::uniform_real_distribution<interval_value_type> distribution_type;
@@ -72,7 +76,7 @@ namespace neolib
                 return std::make_pair(aLower, std::nextafter(aUpper, std::numeric_limits<interval_value_type>::max()));
             }
         };
-        typedef typename distribution_selector<std::is_integral<value_type>::value> distribution_selector_type;
+        typedef std::conditional_t<std::is_integral<value_type>::value, integer_distribution_selector, real_distribution_selector> distribution_selector_type;
     public:
         typedef typename distribution_selector_type::distribution_type distribution_type;
         typedef typename distribution_selector_type::interval_value_type interval_value_type;
@@ -146,8 +150,54 @@ namespace neolib
             increment_counter();
             return static_cast<value_type>(distribution(static_cast<value_type>(aLower), static_cast<value_type>(aUpper))(iGen));
         }
+        // fills aOutput with values in [aLower, aUpper] as if by repeated calls to get(aLower, aUpper); a generator
+        // providing bulk operations (e.g. simd_xoshiro256ss_engine) is used directly
+        template <typename T2>
+        void fill(std::span<value_type> aOutput, T2 aLower, T2 aUpper)
+        {
+            while (!aOutput.empty())
+            {
+                std::size_t const count = iSecure ? std::min(aOutput.size(), traits_type::reseed_interval - std::min(iCounter, traits_type::reseed_interval)) : aOutput.size();
+                if (count == 0u)
+                {
+                    increment_counter();
+                    aOutput.front() = static_cast<value_type>(distribution(static_cast<value_type>(aLower), static_cast<value_type>(aUpper))(iGen));
+                    aOutput = aOutput.subspan(1u);
+                    continue;
+                }
+                if (iSecure)
+                    iCounter += count;
+                fill_unchecked(aOutput.first(count), static_cast<value_type>(aLower), static_cast<value_type>(aUpper));
+                aOutput = aOutput.subspan(count);
+            }
+        }
         // implementation
     private:
+        void fill_unchecked(std::span<value_type> aOutput, value_type aLower, value_type aUpper)
+        {
+            if constexpr (std::is_same_v<generator_type, simd_xoshiro256ss_engine> && std::is_same_v<value_type, uint32_t>)
+            {
+                uint32_t const range = aUpper - aLower + 1u;
+                if (range == 0u)
+                    iGen.fill(aOutput);
+                else
+                    iGen.fill_bounded(aOutput, range);
+                if (aLower != 0u)
+                    for (auto& x : aOutput)
+                        x += aLower;
+            }
+            else if constexpr (std::is_same_v<generator_type, simd_xoshiro256ss_engine> && std::is_same_v<value_type, double>)
+            {
+                auto const interval = traits_type::interval(aLower, aUpper);
+                iGen.fill_uniform(aOutput, interval.first, interval.second);
+            }
+            else
+            {
+                auto d = distribution(aLower, aUpper);
+                for (auto& x : aOutput)
+                    x = static_cast<value_type>(d(iGen));
+            }
+        }
         distribution_type distribution(value_type aLower, value_type aUpper)
         {
             auto interval = traits_type::interval(aLower, aUpper);
@@ -155,7 +205,7 @@ namespace neolib
         }
         void increment_counter()
         {
-            if (iSecure && ++iCounter > traits_type::state_size)
+            if (iSecure && ++iCounter > traits_type::reseed_interval)
             {
                 iCounter = 0;
                 iGen.seed(std::random_device{}());
@@ -169,6 +219,7 @@ namespace neolib
     };
 
     using random = basic_random<uint32_t>;
+    using simd_random = basic_random<uint32_t, simd_xoshiro256ss_engine>;
 
     template <typename T>
     struct primes
@@ -39,16 +39,24 @@
 #include <neolib/neolib.hpp>
 #include <memory>
 #include <iterator>
+#include <functional>
+#include <map>
+#include <atomic>
+#include <cassert>
 #include <neolib/core/vecarray.hpp>
 #include <neolib/core/array_tree.hpp>
+#include <neolib/core/array_btree.hpp>
 
 namespace neolib
 {
-    template <typename T, std::size_t SegmentSize = 64, typename Alloc = std::allocator<T> >
-    class segmented_array : private array_tree<Alloc>
+    // Elements live in fixed capacity segments indexed by Tree. splice() and split() cost O(log n + k/SegmentSize)
+    // only with a joinable index, i.e. array_btree (see btree_segmented_array below); with the default red-black
+    // array_tree each of the k/SegmentSize moved segments is indexed separately, or the index rebuilt.
+    template <typename T, std::size_t SegmentSize = 64, typename Alloc = std::allocator<T>, typename Tree = array_tree<Alloc> >
+    class segmented_array : private Tree
     {
-        typedef segmented_array<T, SegmentSize, Alloc> self_type;
-        typedef array_tree<Alloc> base_type;
+        typedef segmented_array<T, SegmentSize, Alloc, Tree> self_type;
+        typedef Tree base_type;
     public:
         typedef T value_type;
         typedef Alloc allocator_type;
@@ -81,6 +89,35 @@ namespace neolib
             segment_type iSegment;
         };
         typedef typename std::allocator_traits<allocator_type>:: template rebind_alloc<node> node_allocator_type;
+        // segments keyed by the address of their first element; built by the first iter() and kept up to date after
+        typedef std::map<const value_type*, node*, std::less<const value_type*>, typename std::allocator_traits<allocator_type>:: template rebind_alloc<std::pair<const value_type* const, node*>>> address_index;
+        class fill_iterator
+        {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const T* pointer;
+            typedef const T& reference;
+        public:
+            fill_iterator(const T& aValue, size_type aIndex) : iValue{ &aValue }, iIndex{ aIndex } {}
+        public:
+            reference operator*() const { return *iValue; }
+            fill_iterator& operator++() { ++iIndex; return *this; }
+            fill_iterator operator++(int) { fill_iterator result{ *this }; ++iIndex; return result; }
+            fill_iterator& operator--() { --iIndex; return *this; }
+            fill_iterator operator--(int) { fill_iterator result{ *this }; --iIndex; return result; }
+            fill_iterator& operator+=(difference_type aDifference) { iIndex += aDifference; return *this; }
+            fill_iterator& operator-=(difference_type aDifference) { iIndex -= aDifference; return *this; }
+            fill_iterator operator+(difference_type aDifference) const { fill_iterator result{ *this }; result += aDifference; return result; }
+            fill_iterator operator-(difference_type aDifference) const { fill_iterator result{ *this }; result -= aDifference; return result; }
+            difference_type operator-(const fill_iterator& aOther) const { return static_cast<difference_type>(iIndex) - static_cast<difference_type>(aOther.iIndex); }
+            bool operator==(const fill_iterator& aOther) const { return iIndex == aOther.iIndex; }
+            bool operator!=(const fill_iterator& aOther) const { return iIndex != aOther.iIndex; }
+        private:
+            const T* iValue;
+            size_type iIndex;
+        };
     public:
         class iterator
         {
@@ -330,33 +367,35 @@ namespace neolib
 
     public:
         segmented_array(const Alloc& aAllocator = Alloc()) :
-            iAllocator{ aAllocator }, iSize{ 0 }
+            iAllocator{ aAllocator }, iSize{ 0 }, iSegmentCount{ 0 }
         {
         }
         segmented_array(const size_type aCount, const value_type& aValue, const Alloc& aAllocator = Alloc()) :
-            iAllocator{ aAllocator }, iSize{ 0 }
+            iAllocator{ aAllocator }, iSize{ 0 }, iSegmentCount{ 0 }
         {
             insert(begin(), aCount, aValue);
         }
         template <typename InputIterator>
         segmented_array(InputIterator aFirst, InputIterator aLast, const Alloc& aAllocator = Alloc()) :
-            iAllocator{ aAllocator }, iSize{ 0 }
+            iAllocator{ aAllocator }, iSize{ 0 }, iSegmentCount{ 0 }
         {
             insert(begin(), aFirst, aLast);
         }
         segmented_array(const segmented_array& aOther, const Alloc& aAllocator = Alloc()) :
-            iAllocator{ aAllocator }, iSize{ 0 }
+            base_type{}, iAllocator{ aAllocator }, iSize{ 0 }, iSegmentCount{ 0 }
         {
             insert(begin(), aOther.begin(), aOther.end());
         }
         segmented_array(segmented_array&& aOther) :
             base_type{ std::move(aOther) },
-            iAllocator{ std::move(aOther.iAllocator) }, iSize{ aOther.iSize }
+            iAllocator{ std::move(aOther.iAllocator) }, iSize{ aOther.iSize }, iSegmentCount{ aOther.iSegmentCount }, iAddressIndex{ aOther.iAddressIndex.exchange(nullptr, std::memory_order_relaxed) }
         {
             aOther.iSize = 0;
+            aOther.iSegmentCount = 0;
         }
         ~segmented_array()
         {
+            reset_address_index();
             erase(begin(), end());
         }
         segmented_array& operator=(segmented_array&& aOther)
@@ -420,9 +459,42 @@ namespace neolib
         {
             return reverse_iterator(begin());
         }
+        // O(log n): the element's segment is looked up by address and the segment's position found through the index;
+        // elements of the first and last segments are found directly so small containers never build the index
         const_iterator citer(const value_type& aValue) const
         {
-            return cbegin() + (&aValue - &(*this)[0]);
+            auto const contains = [&aValue](node const* aNode)
+            {
+                segment_type const& segment = aNode->segment();
+                return !std::less<const value_type*>{}(&aValue, &segment[0]) && std::less<const value_type*>{}(&aValue, &segment[0] + segment.size());
+            };
+            if (iSize == 0)
+                return cend();
+            node* const front = static_cast<node*>(base_type::front_node());
+            if (contains(front))
+            {
+                size_type const segmentPosition = static_cast<size_type>(&aValue - &front->segment()[0]);
+                return const_iterator{ *this, front, segmentPosition, segmentPosition };
+            }
+            node* const back = static_cast<node*>(base_type::back_node());
+            if (contains(back))
+            {
+                size_type const segmentPosition = static_cast<size_type>(&aValue - &back->segment()[0]);
+                return const_iterator{ *this, back, iSize - back->segment().size() + segmentPosition, segmentPosition };
+            }
+            address_index const& addressIndex = address_index_for_lookup();
+            auto const following = addressIndex.upper_bound(&aValue);
+            if (following != addressIndex.begin())
+            {
+                node* const n = std::prev(following)->second;
+                segment_type const& segment = n->segment();
+                if (std::less<const value_type*>{}(&aValue, &segment[0] + segment.size()))
+                {
+                    size_type const segmentPosition = static_cast<size_type>(&aValue - &segment[0]);
+                    return const_iterator{ *this, n, base_type::node_index(n) + segmentPosition, segmentPosition };
+                }
+            }
+            return cend();
         }
         const_iterator iter(const value_type& aValue) const
         {
@@ -430,7 +502,7 @@ namespace neolib
         }
         iterator iter(const value_type& aValue)
         {
-            return begin() + (&aValue - &(*this)[0]);
+            return begin() + (citer(aValue) - cbegin());
         }
         const_reference front() const
         {
@@ -452,6 +524,10 @@ namespace neolib
         {
             return insert(aPosition, static_cast<size_type>(1), aValue);
         }
+        iterator insert(const_iterator aPosition, value_type&& aValue)
+        {
+            return do_insert(aPosition, std::make_move_iterator(&aValue), std::make_move_iterator(&aValue + 1));
+        }
         template <typename... Args>
         iterator emplace_insert(const_iterator aPosition, Args&&... aArguments)
         {
@@ -473,14 +549,7 @@ namespace neolib
         }
         iterator insert(const_iterator aPosition, size_type aCount, const value_type& aValue)
         {
-            auto pos = aPosition.iContainerPosition;
-            while (aCount > 0)
-            {
-                aPosition = insert(aPosition, &aValue, &aValue+1);
-                ++aPosition;
-                --aCount;
-            }
-            return iterator{*this, pos};
+            return do_insert(aPosition, fill_iterator{ aValue, 0 }, fill_iterator{ aValue, aCount });
         }
         template <typename... Args>
         iterator emplace_insert(const_iterator aPosition, size_type aCount, Args&&... aArguments)
@@ -489,8 +558,8 @@ namespace neolib
             while (aCount > 0)
             {
                 // todo: shouldn't be creating a temporary for emplace
-                auto const& temp = value_type{ std::forward<Args>(aArguments)... };
-                aPosition = insert(aPosition, &temp, &temp + 1);
+                auto temp = value_type{ std::forward<Args>(aArguments)... };
+                aPosition = insert(aPosition, std::move(temp));
                 ++aPosition;
                 --aCount;
             }
@@ -546,11 +615,12 @@ namespace neolib
             else
             {
                 segment_type& segmentLast = aLast.iNode->segment();
+                bool const rebuild = rebuild_cheaper(aLast.iContainerPosition - aFirst.iContainerPosition);
                 for (node* inbetweenNode = static_cast<node*>(aFirst.iNode->next()); inbetweenNode != aLast.iNode;)
                 {
                     node* next = static_cast<node*>(inbetweenNode->next());
                     size_type inbetweenRemoved = inbetweenNode->segment().size();
-                    free_node(inbetweenNode);
+                    free_node(inbetweenNode, !rebuild);
                     iSize -= inbetweenRemoved;
                     inbetweenNode = next;
                 }
@@ -559,15 +629,17 @@ namespace neolib
                 segmentFirst.erase(segmentFirst.begin() + aFirst.iSegmentPosition, segmentFirst.end());
                 segmentLast.erase(segmentLast.begin(), segmentLast.begin() + aLast.iSegmentPosition);
                 if (segmentFirst.empty())
-                    free_node(aFirst.iNode);
-                else
+                    free_node(aFirst.iNode, !rebuild);
+                else if (!rebuild)
                     aFirst.iNode->set_size(aFirst.iNode->size() - firstRemoved);
                 iSize -= firstRemoved;
                 if (segmentLast.empty())
-                    free_node(aLast.iNode);
-                else
+                    free_node(aLast.iNode, !rebuild);
+                else if (!rebuild)
                     aLast.iNode->set_size(aLast.iNode->size() - secondRemoved);
                 iSize -= secondRemoved;
+                if (rebuild)
+                    rebuild_index();
             }
             return iterator{*this, aFirst.iContainerPosition};
         }
@@ -579,11 +651,121 @@ namespace neolib
         {
             erase(--end());
         }
+        // moves the elements of aOther to before aPosition without copying them, leaving aOther empty; the
+        // allocators of both containers must compare equal. A B+ tree segment index is split at aPosition and
+        // joined with aOther's in O(log n). A red-black index has each of the k/SegmentSize moved segments
+        // indexed in O(log n), or is rebuilt in O((n + k)/SegmentSize) when that is cheaper.
+        void splice(const_iterator aPosition, segmented_array& aOther)
+        {
+            if (&aOther == this || aOther.empty())
+                return;
+            assert(iAllocator == aOther.iAllocator);
+            node* const before = split_segment(aPosition);
+            node* const after = static_cast<node*>(before != nullptr ? before->next() : base_type::front_node());
+            node* const first = static_cast<node*>(aOther.front_node());
+            node* const last = static_cast<node*>(aOther.back_node());
+            size_type const segments = aOther.iSegmentCount;
+            size_type const elements = aOther.iSize;
+            iSize += aOther.iSize;
+            iSegmentCount += segments;
+            reset_address_index();
+            aOther.reset_address_index();
+            if constexpr (base_type::joinable)
+            {
+                base_type tail{ allocator_type{ iAllocator } };
+                if (after != nullptr)
+                    base_type::split_off(after, tail);
+                base_type::join(aOther);
+                base_type::join(tail);
+                aOther.iSize = 0;
+                aOther.iSegmentCount = 0;
+                return;
+            }
+            aOther.base_type::set_front_node(nullptr);
+            aOther.base_type::set_back_node(nullptr);
+            aOther.iSize = 0;
+            aOther.iSegmentCount = 0;
+            aOther.rebuild_index();
+            first->set_previous(before);
+            if (before != nullptr)
+                before->set_next(first);
+            else
+                base_type::set_front_node(first);
+            last->set_next(after);
+            if (after != nullptr)
+                after->set_previous(last);
+            else
+                base_type::set_back_node(last);
+            if (rebuild_cheaper(elements))
+                rebuild_index();
+            else
+            {
+                for (node* n = first;; n = static_cast<node*>(n->next()))
+                {
+                    base_type::reset_node(n, n->segment().size());
+                    base_type::insert_linked_node(n);
+                    if (n == last)
+                        break;
+                }
+            }
+        }
+        // removes the elements from aPosition onwards and returns them as a new container without copying them.
+        // A B+ tree segment index is split in O(log n) and the k/SegmentSize detached segments are only counted.
+        // A red-black index has each detached segment unindexed in O(log n), or the remaining index rebuilt in
+        // O((n - k)/SegmentSize) when that is cheaper, and the new container's index built in O(k/SegmentSize).
+        segmented_array split(const_iterator aPosition)
+        {
+            segmented_array result{ allocator_type{ iAllocator } };
+            if (aPosition.iContainerPosition == iSize)
+                return result;
+            node* const before = split_segment(aPosition);
+            node* const first = static_cast<node*>(before != nullptr ? before->next() : base_type::front_node());
+            node* const last = static_cast<node*>(base_type::back_node());
+            reset_address_index();
+            if constexpr (base_type::joinable)
+            {
+                size_type segments = 0;
+                for (node* n = first; n != nullptr; n = static_cast<node*>(n->next()))
+                    ++segments;
+                base_type::split_off(first, result);
+                result.iSize = iSize - aPosition.iContainerPosition;
+                result.iSegmentCount = segments;
+                iSize = aPosition.iContainerPosition;
+                iSegmentCount -= segments;
+                return result;
+            }
+            bool const rebuild = rebuild_cheaper(iSize - aPosition.iContainerPosition);
+            size_type segments = 0;
+            for (node* n = first; n != nullptr; n = static_cast<node*>(n->next()))
+            {
+                if (!rebuild)
+                    base_type::delete_node(n);
+                ++segments;
+            }
+            if (before != nullptr)
+                before->set_next(nullptr);
+            else
+                base_type::set_front_node(nullptr);
+            base_type::set_back_node(before);
+            first->set_previous(nullptr);
+            result.base_type::set_front_node(first);
+            result.base_type::set_back_node(last);
+            result.iSize = iSize - aPosition.iContainerPosition;
+            result.iSegmentCount = segments;
+            iSize = aPosition.iContainerPosition;
+            iSegmentCount -= segments;
+            if (rebuild)
+                rebuild_index();
+            result.rebuild_index();
+            return result;
+        }
         void swap(segmented_array& aOther)
         {
             base_type::swap(aOther);
             std::swap(iAllocator, aOther.iAllocator);
             std::swap(iSize, aOther.iSize);
+            std::swap(iSegmentCount, aOther.iSegmentCount);
+            iAddressIndex.store(aOther.iAddressIndex.exchange(iAddressIndex.load(std::memory_order_relaxed), std::memory_order_relaxed), std::memory_order_relaxed);
         }
 
     private:
@@ -594,6 +776,7 @@ namespace neolib
             size_type count = std::distance(aFirst, aLast);
             if (count == 0)
                 return iterator{*this, aPosition.iNode, aPosition.iContainerPosition, aPosition.iSegmentPosition};
+            size_type const inserted = count;
             node* before = aPosition.iNode;
             node* after = aPosition.iNode ? static_cast<node*>(aPosition.iNode->next()) : nullptr;
             node* lastNode = aPosition.iNode;
@@ -642,16 +825,17 @@ namespace neolib
                     iSize += count;
                 }
             }
-            size_type index = aPosition.iContainerPosition - aPosition.iSegmentPosition;
-            for (node* newNode = aPosition.iNode;; newNode = static_cast<node*>(newNode->next()))
+            if (rebuild_cheaper(inserted))
+                rebuild_index();
+            else
             {
-                if (newNode != before && newNode != after)
+                for (node* newNode = aPosition.iNode;; newNode = static_cast<node*>(newNode->next()))
                 {
-                    base_type::insert_node(newNode, index);
+                    if (newNode != before && newNode != after)
+                        base_type::insert_linked_node(newNode);
+                    if (newNode == lastNode)
+                        break;
                 }
-                index += newNode->segment().size();
-                if (newNode == lastNode)
-                    break;
             }
             if (aPosition.iSegmentPosition != aPosition.iNode->segment().size()) // was not end
                 return iterator{*this, aPosition.iNode, aPosition.iContainerPosition, aPosition.iSegmentPosition};
@@ -670,6 +854,60 @@ namespace neolib
             }
             return iterator{*this, pos};
         }
+        // moves the elements from aPosition to the end of its segment into a new segment so that aPosition is
+        // the start of a segment; returns the segment before aPosition, if any
+        node* split_segment(const_iterator aPosition)
+        {
+            if (empty())
+                return nullptr;
+            if (aPosition.iContainerPosition == iSize)
+                return static_cast<node*>(base_type::back_node());
+            if (aPosition.iSegmentPosition == 0)
+                return static_cast<node*>(aPosition.iNode->previous());
+            segment_type& segment = aPosition.iNode->segment();
+            size_type const moved = segment.size() - aPosition.iSegmentPosition;
+            node* tail = allocate_node(aPosition.iNode);
+            tail->segment().insert(tail->segment().begin(), std::make_move_iterator(segment.begin() + aPosition.iSegmentPosition), std::make_move_iterator(segment.end()));
+            segment.erase(segment.begin() + aPosition.iSegmentPosition, segment.end());
+            aPosition.iNode->set_size(aPosition.iNode->size() - moved);
+            tail->set_size(moved);
+            base_type::insert_linked_node(tail);
+            return aPosition.iNode;
+        }
+        // updating the index per segment only visits the (mostly cached) path to the root whereas a rebuild visits
+        // every segment so it only pays once most of the elements are affected
+        bool rebuild_cheaper(size_type aElements) const
+        {
+            return aElements * 2 >= iSize;
+        }
+        // the address index costs a map node per segment so is only built by the first lookup outside the first and
+        // last segments, which may be made by concurrent const readers; after that mutations, which require exclusive
+        // access, keep it up to date. It is held out of line so a container that never uses it only pays a pointer; a
+        // reader that loses the race to publish its index discards it and uses the winner's. segmented_tree iterators
+        // look up a node's position in the child list holding it whenever they climb back up to that node, so a child
+        // list builds (and then keeps) its index the first time a traversal climbs back up to a node outside its first
+        // and last segments.
+        address_index const& address_index_for_lookup() const
+        {
+            address_index* existing = iAddressIndex.load(std::memory_order_acquire);
+            if (existing == nullptr)
+            {
+                auto addressIndex = std::make_unique<address_index>(typename address_index::allocator_type{ iAllocator });
+                for (node* n = static_cast<node*>(base_type::front_node()); n != nullptr; n = static_cast<node*>(n->next()))
+                    addressIndex->emplace(&n->segment()[0], n);
+                if (iAddressIndex.compare_exchange_strong(existing, addressIndex.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+                    existing = addressIndex.release();
+            }
+            return *existing;
+        }
+        void reset_address_index()
+        {
+            delete iAddressIndex.exchange(nullptr, std::memory_order_relaxed);
+        }
+        void rebuild_index()
+        {
+            base_type::rebuild(iSegmentCount, [](typename base_type::node& aNode) { return static_cast<node&>(aNode).segment().size(); });
+        }
         node* find_node(size_type aContainerPosition, size_type& aSegmentPosition) const
         {
             size_type nodeIndex = 0;
@@ -686,7 +924,9 @@ namespace neolib
             if (aCount == 0)
                 return aPosition.iNode;
             node* lastNode = nullptr;
-            if (aCount > 0 && aPosition.iNode && aPosition.iNode->next() != nullptr && aCount <= static_cast<node*>(aPosition.iNode->next())->segment().available())
+            // the tail of the segment being split is moved into the last node so that must fit as well
+            if (aCount > 0 && aPosition.iNode && aPosition.iNode->next() != nullptr && aCount <= static_cast<node*>(aPosition.iNode->next())->segment().available() &&
+                aPosition.iNode->segment().size() - aPosition.iSegmentPosition <= static_cast<node*>(aPosition.iNode->next())->segment().available())
             {
                 lastNode = static_cast<node*>(aPosition.iNode->next());
                 aCount -= std::min(aCount, lastNode->segment().available());
@@ -713,6 +953,9 @@ namespace neolib
                 std::allocator_traits<node_allocator_type>::deallocate(iAllocator, newNode, 1);
                 throw;
             }
+            ++iSegmentCount;
+            if (auto addressIndex = iAddressIndex.load(std::memory_order_relaxed))
+                addressIndex->emplace(&newNode->segment()[0], newNode);
             if (aAfter == nullptr)
             {
                 base_type::set_front_node(newNode);
@@ -732,10 +975,11 @@ namespace neolib
             }
             return newNode;
         }
-        void free_node(node* aNode)
+        void free_node(node* aNode, bool aUpdateIndex = true)
         {
             if (aNode)
             {
+                --iSegmentCount;
                 if (aNode->next())
                     aNode->next()->set_previous(aNode->previous());
                 if (aNode->previous())
@@ -744,7 +988,10 @@ namespace neolib
                     base_type::set_back_node(aNode->previous());
                 if (base_type::front_node() == aNode)
                     base_type::set_front_node(aNode->next());
-                base_type::delete_node(aNode);
+                if (aUpdateIndex)
+                    base_type::delete_node(aNode);
+                if (auto addressIndex = iAddressIndex.load(std::memory_order_relaxed))
+                    addressIndex->erase(&aNode->segment()[0]);
             }
             std::allocator_traits<node_allocator_type>::destroy(iAllocator, aNode);
             std::allocator_traits<node_allocator_type>::deallocate(iAllocator, aNode, 1);
@@ -753,17 +1000,24 @@ namespace neolib
     private:
         node_allocator_type iAllocator;
         size_type iSize;
+        size_type iSegmentCount;
+        mutable std::atomic<address_index*> iAddressIndex = nullptr;
     };
 
-    template <typename T, std::size_t SegmentSize, typename Alloc>
-    inline bool operator==(segmented_array<T, SegmentSize, Alloc> const& lhs, segmented_array<T, SegmentSize, Alloc> const& rhs)
+    template <typename T, std::size_t SegmentSize, typename Alloc, typename Tree>
+    inline bool operator==(segmented_array<T, SegmentSize, Alloc, Tree> const& lhs, segmented_array<T, SegmentSize, Alloc, Tree> const& rhs)
     {
         return lhs.size() == rhs.size() && std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
     }
 
-    template <typename T, std::size_t SegmentSize, typename Alloc>
-    inline bool operator!=(segmented_array<T, SegmentSize, Alloc> const& lhs, segmented_array<T, SegmentSize, Alloc> const& rhs)
+    template <typename T, std::size_t SegmentSize, typename Alloc, typename Tree>
+    inline bool operator!=(segmented_array<T, SegmentSize, Alloc, Tree> const& lhs, segmented_array<T, SegmentSize, Alloc, Tree> const& rhs)
     {
         return !(lhs == rhs);
     }
+
+    // segmented_array indexed by an order statistic B+ tree rather than a red-black tree; faster random access and
+    // middle insertion for large arrays
+    template <typename T, std::size_t SegmentSize = 64, typename Alloc = std::allocator<T> >
+    using btree_segmented_array = segmented_array<T, SegmentSize, Alloc, array_btree<Alloc>>;
 }
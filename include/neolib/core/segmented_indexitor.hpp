@@ -0,0 +1,1002 @@
+/*
+*  segmented_indexitor.hpp
+*
+*  Copyright (c) 2026 Leigh Johnston.
+*
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are
+*  met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*
+*     * Neither the name of Leigh Johnston nor the names of any
+*       other contributors to this software may be used to endorse or
+*       promote products derived from this software without specific prior
+*       written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+*  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+*  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+*  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+*  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+*  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+*  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+*  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+*  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+*  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <memory>
+#include <iterator>
+#include <type_traits>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <array>
+#include <new>
+#include <neolib/core/index_array_tree.hpp>
+#include <neolib/core/simd.hpp>
+
+namespace neolib
+{
+    // An indexitor whose tree nodes are segments of up to SegmentSize elements rather than single elements. Each
+    // segment keeps a contiguous array of foreign index prefix sums so a foreign index lookup is one descent of the
+    // (much shallower) segment tree followed by a bisection/SIMD scan of a few cache lines. Prefix sums are brought
+    // up to date lazily from a per-segment "dirty from" position so a run of adjacent edits to a segment costs a
+    // single recalculation at the next lookup; as const lookups may perform that recalculation concurrent access
+    // to a const segmented_indexitor requires external synchronization.
+    template <typename T, typename ForeignIndex, std::size_t SegmentSize = 64, typename Alloc = std::allocator<std::pair<T, const ForeignIndex>>>
+    class segmented_indexitor : private index_array_tree<ForeignIndex, Alloc>
+    {
+        typedef segmented_indexitor<T, ForeignIndex, SegmentSize, Alloc> self_type;
+        typedef index_array_tree<ForeignIndex, Alloc> base_type;
+    public:
+        typedef T data_type;
+        typedef ForeignIndex foreign_index_type;
+        typedef std::pair<data_type, const foreign_index_type> value_type;
+        typedef value_type& reference;
+        typedef const value_type& const_reference;
+        typedef std::pair<const foreign_index_type, const foreign_index_type> skip_type;
+        typedef Alloc allocator_type;
+        typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+        typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
+        typedef typename std::allocator_traits<allocator_type>::size_type size_type;
+        typedef typename std::allocator_traits<allocator_type>::difference_type difference_type;
+    private:
+        static_assert(SegmentSize >= 2u, "neolib::segmented_indexitor: segment size too small");
+        // bisect a segment's prefix sums until at most this many remain and then count the remainder (SIMD)
+        static constexpr size_type LinearSearchThreshold = 16u;
+        class segment
+        {
+        private:
+            struct entry
+            {
+                value_type value;
+                skip_type skip;
+            };
+
+        public:
+            segment() :
+                iSize{ 0u }, iExtent{}, iDirtyFrom{ 0u }
+            {
+                iPrefix[0] = foreign_index_type{};
+            }
+            segment(const segment&) = delete;
+            ~segment()
+            {
+                erase(0u, size());
+            }
+
+        public:
+            size_type size() const
+            {
+                return iSize;
+            }
+            bool full() const
+            {
+                return iSize == SegmentSize;
+            }
+            // foreign extent of the whole segment
+            foreign_index_type extent() const
+            {
+                return iExtent;
+            }
+            const value_type& value(size_type aIndex) const
+            {
+                return at(aIndex).value;
+            }
+            value_type& value(size_type aIndex)
+            {
+                return at(aIndex).value;
+            }
+            const skip_type& skip(size_type aIndex) const
+            {
+                return at(aIndex).skip;
+            }
+            foreign_index_type extent(size_type aIndex) const
+            {
+                auto const& e = at(aIndex);
+                return e.skip.first + e.value.second + e.skip.second;
+            }
+            // foreign index of an element relative to the start of the segment
+            foreign_index_type prefix(size_type aIndex) const
+            {
+                if (aIndex > iDirtyFrom)
+                    update_prefix();
+                return iPrefix[aIndex];
+            }
+            // index of the element whose foreign extent contains aForeignIndex (relative to the start of the segment)
+            template <typename Pred>
+            size_type find(foreign_index_type aForeignIndex, Pred aPred) const
+            {
+                update_prefix();
+                size_type first = 0u;
+                size_type count = iSize;
+                while (count > LinearSearchThreshold)
+                {
+                    size_type const half = count / 2u;
+                    if (!aPred(aForeignIndex, iPrefix[first + half]))
+                    {
+                        first += half + 1u;
+                        count -= half + 1u;
+                    }
+                    else
+                        count = half;
+                }
+                if constexpr (std::is_same_v<Pred, std::less<foreign_index_type>> || std::is_same_v<Pred, std::less<>>)
+                    first += simd_count_not_greater(iPrefix.data() + first, count, aForeignIndex);
+                else
+                    for (; count > 0u && !aPred(aForeignIndex, iPrefix[first]); --count)
+                        ++first;
+                return first != 0u ? first - 1u : 0u;
+            }
+            foreign_index_type insert(size_type aIndex, const value_type& aValue, const skip_type& aSkip)
+            {
+                entry newEntry{ aValue, aSkip };
+                shift(aIndex, aIndex + 1u, iSize - aIndex);
+                ::new (address(aIndex)) entry{ std::move(newEntry) };
+                ++iSize;
+                dirty(aIndex);
+                foreign_index_type const added = extent(aIndex);
+                iExtent += added;
+                return added;
+            }
+            // returns the change in the segment's foreign extent
+            foreign_index_type replace(size_type aIndex, const value_type& aValue, const skip_type& aSkip)
+            {
+                entry newEntry{ aValue, aSkip };
+                foreign_index_type const oldExtent = extent(aIndex);
+                at(aIndex).~entry();
+                ::new (address(aIndex)) entry{ std::move(newEntry) };
+                dirty(aIndex);
+                foreign_index_type const difference = extent(aIndex) - oldExtent;
+                iExtent += difference;
+                return difference;
+            }
+            // returns the foreign extent removed
+            foreign_index_type erase(size_type aIndex, size_type aCount)
+            {
+                foreign_index_type removed{};
+                for (size_type i = aIndex; i < aIndex + aCount; ++i)
+                {
+                    removed += extent(i);
+                    at(i).~entry();
+                }
+                shift(aIndex + aCount, aIndex, iSize - aIndex - aCount);
+                iSize -= aCount;
+                dirty(aIndex);
+                iExtent -= removed;
+                return removed;
+            }
+            // moves the elements from aIndex onwards to the end of aDestination; returns the foreign extent moved
+            foreign_index_type move_tail(size_type aIndex, segment& aDestination)
+            {
+                foreign_index_type moved{};
+                for (size_type i = aIndex; i < iSize; ++i)
+                {
+                    moved += extent(i);
+                    ::new (aDestination.address(aDestination.iSize++)) entry{ std::move(at(i)) };
+                    at(i).~entry();
+                }
+                aDestination.dirty(aDestination.iSize - (iSize - aIndex));
+                aDestination.iExtent += moved;
+                iSize = aIndex;
+                dirty(aIndex);
+                iExtent -= moved;
+                return moved;
+            }
+
+        private:
+            void* address(size_type aIndex)
+            {
+                return &iStorage[aIndex * sizeof(entry)];
+            }
+            entry& at(size_type aIndex)
+            {
+                return *std::launder(reinterpret_cast<entry*>(&iStorage[aIndex * sizeof(entry)]));
+            }
+            const entry& at(size_type aIndex) const
+            {
+                return *std::launder(reinterpret_cast<const entry*>(&iStorage[aIndex * sizeof(entry)]));
+            }
+            void shift(size_type aFrom, size_type aTo, size_type aCount)
+            {
+                if (aTo > aFrom)
+                    for (size_type i = aCount; i-- > 0u;)
+                    {
+                        ::new (address(aTo + i)) entry{ std::move(at(aFrom + i)) };
+                        at(aFrom + i).~entry();
+                    }
+                else
+                    for (size_type i = 0u; i < aCount; ++i)
+                    {
+                        ::new (address(aTo + i)) entry{ std::move(at(aFrom + i)) };
+                        at(aFrom + i).~entry();
+                    }
+            }
+            void dirty(size_type aIndex)
+            {
+                if (iDirtyFrom > aIndex)
+                    iDirtyFrom = aIndex;
+            }
+            void update_prefix() const
+            {
+                for (size_type i = iDirtyFrom; i < iSize; ++i)
+                    iPrefix[i + 1u] = iPrefix[i] + extent(i);
+                iDirtyFrom = iSize;
+            }
+
+        private:
+            size_type iSize;
+            foreign_index_type iExtent;
+            mutable size_type iDirtyFrom;
+            mutable std::array<foreign_index_type, SegmentSize + 1u> iPrefix;
+            alignas(entry) unsigned char iStorage[SegmentSize * sizeof(entry)];
+        };
+        class node : public base_type::node
+        {
+        public:
+            node()
+            {
+            }
+
+        public:
+            const segment& get_segment() const
+            {
+                return iSegment;
+            }
+            segment& get_segment()
+            {
+                return iSegment;
+            }
+
+        private:
+            segment iSegment;
+        };
+        typedef typename std::allocator_traits<allocator_type>:: template rebind_alloc<node> node_allocator_type;
+    public:
+        class iterator
+        {
+            friend class segmented_indexitor;
+            friend class segmented_indexitor::const_iterator;
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef segmented_indexitor::value_type value_type;
+            typedef segmented_indexitor::difference_type difference_type;
+            typedef segmented_indexitor::pointer pointer;
+            typedef segmented_indexitor::reference reference;
+
+        public:
+            iterator() :
+                iContainer{}, iNode{}, iContainerPosition{ 0 }, iSegmentPosition{ 0 }
+            {
+            }
+            iterator(const iterator& aOther) :
+                iContainer{ aOther.iContainer }, iNode{ aOther.iNode }, iContainerPosition{ aOther.iContainerPosition }, iSegmentPosition{ aOther.iSegmentPosition }
+            {
+            }
+            iterator& operator=(const iterator& aOther)
+            {
+                iContainer = aOther.iContainer;
+                iNode = aOther.iNode;
+                iContainerPosition = aOther.iContainerPosition;
+                iSegmentPosition = aOther.iSegmentPosition;
+                return *this;
+            }
+        private:
+            iterator(segmented_indexitor& aContainer, size_type aContainerPosition) :
+                iContainer{ &aContainer }, iNode{ nullptr }, iContainerPosition{ aContainerPosition }, iSegmentPosition{ 0 }
+            {
+                iNode = iContainer->find_node(aContainerPosition, iSegmentPosition);
+                if (iNode == nullptr)
+                    *this = iContainer->end();
+            }
+            iterator(segmented_indexitor& aContainer, node* aNode, size_type aContainerPosition, size_type aSegmentPosition) :
+                iContainer{ &aContainer }, iNode{ aNode }, iContainerPosition{ aContainerPosition }, iSegmentPosition{ aSegmentPosition }
+            {
+            }
+
+        public:
+            iterator& operator++()
+            {
+                if (++iSegmentPosition == iNode->get_segment().size())
+                {
+                    iNode = static_cast<node*>(iNode->next());
+                    iSegmentPosition = 0;
+                }
+                ++iContainerPosition;
+                return *this;
+            }
+            iterator& operator--()
+            {
+                if (iNode == nullptr)
+                {
+                    iNode = static_cast<node*>(iContainer->back_node());
+                    iSegmentPosition = iNode->get_segment().size() - 1;
+                }
+                else if (iSegmentPosition == 0)
+                {
+                    iNode = static_cast<node*>(iNode->previous());
+                    iSegmentPosition = iNode->get_segment().size() - 1;
+                }
+                else
+                    --iSegmentPosition;
+                --iContainerPosition;
+                return *this;
+            }
+            iterator operator++(int) { iterator ret{*this}; operator++(); return ret; }
+            iterator operator--(int) { iterator ret{*this}; operator--(); return ret; }
+            iterator& operator+=(difference_type aDifference)
+            {
+                if (aDifference < 0)
+                    return operator-=(-aDifference);
+                else if (iNode == nullptr || aDifference >= static_cast<difference_type>(iNode->get_segment().size() - iSegmentPosition))
+                    *this = iterator{*iContainer, container_position() + aDifference};
+                else
+                {
+                    iContainerPosition += aDifference;
+                    iSegmentPosition += aDifference;
+                }
+                return *this;
+            }
+            iterator& operator-=(difference_type aDifference)
+            {
+                if (aDifference < 0)
+                    return operator+=(-aDifference);
+                else if (iNode == nullptr || aDifference > static_cast<difference_type>(iSegmentPosition))
+                    *this = iterator{*iContainer, container_position() - aDifference};
+                else
+                {
+                    iContainerPosition -= aDifference;
+                    iSegmentPosition -= aDifference;
+                }
+                return *this;
+            }
+            iterator operator+(difference_type aDifference) const { iterator result{*this}; result += aDifference; return result; }
+            iterator operator-(difference_type aDifference) const { iterator result{*this}; result -= aDifference; return result; }
+            reference operator[](difference_type aDifference) const { return *((*this) + aDifference); }
+            difference_type operator-(const iterator& aOther) const { return static_cast<difference_type>(container_position())-static_cast<difference_type>(aOther.container_position()); }
+            reference operator*() const { return iNode->get_segment().value(iSegmentPosition); }
+            pointer operator->() const { return &operator*(); }
+            bool operator==(const iterator& aOther) const { return container_position() == aOther.container_position(); }
+            bool operator!=(const iterator& aOther) const { return container_position() != aOther.container_position(); }
+            bool operator<(const iterator& aOther) const { return container_position() < aOther.container_position(); }
+            bool operator<=(const iterator& aOther) const { return container_position() <= aOther.container_position(); }
+            bool operator>(const iterator& aOther) const { return container_position() > aOther.container_position(); }
+            bool operator>=(const iterator& aOther) const { return container_position() >= aOther.container_position(); }
+
+        private:
+            size_type container_position() const { return iContainerPosition; }
+
+        private:
+            segmented_indexitor* iContainer;
+            node* iNode;
+            size_type iContainerPosition;
+            size_type iSegmentPosition;
+        };
+        class const_iterator
+        {
+            friend class segmented_indexitor;
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef segmented_indexitor::value_type value_type;
+            typedef segmented_indexitor::difference_type difference_type;
+            typedef segmented_indexitor::const_pointer pointer;
+            typedef segmented_indexitor::const_reference reference;
+
+        public:
+            const_iterator() :
+                iContainer{}, iNode{}, iContainerPosition{ 0 }, iSegmentPosition{ 0 }
+            {
+            }
+            const_iterator(const const_iterator& aOther) :
+                iContainer{ aOther.iContainer }, iNode{ aOther.iNode }, iContainerPosition{ aOther.iContainerPosition }, iSegmentPosition{ aOther.iSegmentPosition }
+            {
+            }
+            const_iterator(const typename segmented_indexitor::iterator& aOther) :
+                iContainer{ aOther.iContainer }, iNode{ aOther.iNode }, iContainerPosition{ aOther.iContainerPosition }, iSegmentPosition{ aOther.iSegmentPosition }
+            {
+            }
+            const_iterator& operator=(const const_iterator& aOther)
+            {
+                iContainer = aOther.iContainer;
+                iNode = aOther.iNode;
+                iContainerPosition = aOther.iContainerPosition;
+                iSegmentPosition = aOther.iSegmentPosition;
+                return *this;
+            }
+            const_iterator& operator=(const typename segmented_indexitor::iterator& aOther)
+            {
+                iContainer = aOther.iContainer;
+                iNode = aOther.iNode;
+                iContainerPosition = aOther.iContainerPosition;
+                iSegmentPosition = aOther.iSegmentPosition;
+                return *this;
+            }
+        private:
+            const_iterator(const segmented_indexitor& aContainer, size_type aContainerPosition) :
+                iContainer{ &aContainer }, iNode{ nullptr }, iContainerPosition{ aContainerPosition }, iSegmentPosition{ 0 }
+            {
+                iNode = iContainer->find_node(aContainerPosition, iSegmentPosition);
+                if (iNode == nullptr)
+                    *this = iContainer->end();
+            }
+            const_iterator(const segmented_indexitor& aContainer, node* aNode, size_type aContainerPosition, size_type aSegmentPosition) :
+                iContainer{ &aContainer }, iNode{ aNode }, iContainerPosition{ aContainerPosition }, iSegmentPosition{ aSegmentPosition }
+            {
+            }
+
+        public:
+            const_iterator& operator++()
+            {
+                if (++iSegmentPosition == iNode->get_segment().size())
+                {
+                    iNode = static_cast<node*>(iNode->next());
+                    iSegmentPosition = 0;
+                }
+                ++iContainerPosition;
+                return *this;
+            }
+            const_iterator& operator--()
+            {
+                if (iNode == nullptr)
+                {
+                    iNode = static_cast<node*>(iContainer->back_node());
+                    iSegmentPosition = iNode->get_segment().size() - 1;
+                }
+                else if (iSegmentPosition == 0)
+                {
+                    iNode = static_cast<node*>(iNode->previous());
+                    iSegmentPosition = iNode->get_segment().size() - 1;
+                }
+                else
+                    --iSegmentPosition;
+                --iContainerPosition;
+                return *this;
+            }
+            const_iterator operator++(int) { const_iterator ret{*this}; operator++(); return ret; }
+            const_iterator operator--(int) { const_iterator ret{*this}; operator--(); return ret; }
+            const_iterator& operator+=(difference_type aDifference)
+            {
+                if (aDifference < 0)
+                    return operator-=(-aDifference);
+                else if (iNode == nullptr || aDifference >= static_cast<difference_type>(iNode->get_segment().size() - iSegmentPosition))
+                    *this = const_iterator{*iContainer, container_position() + aDifference};
+                else
+                {
+                    iContainerPosition += aDifference;
+                    iSegmentPosition += aDifference;
+                }
+                return *this;
+            }
+            const_iterator& operator-=(difference_type aDifference)
+            {
+                if (aDifference < 0)
+                    return operator+=(-aDifference);
+                else if (iNode == nullptr || aDifference > static_cast<difference_type>(iSegmentPosition))
+                    *this = const_iterator{*iContainer, container_position() - aDifference};
+                else
+                {
+                    iContainerPosition -= aDifference;
+                    iSegmentPosition -= aDifference;
+                }
+                return *this;
+            }
+            const_iterator operator+(difference_type aDifference) const { const_iterator result{*this}; result += aDifference; return result; }
+            const_iterator operator-(difference_type aDifference) const { const_iterator result{*this}; result -= aDifference; return result; }
+            const_reference operator[](difference_type aDifference) const { return *((*this) + aDifference); }
+            friend difference_type operator-(const const_iterator& aLhs, const const_iterator& aRhs) { return static_cast<difference_type>(aLhs.container_position())-static_cast<difference_type>(aRhs.container_position()); }
+            const_reference operator*() const { return iNode->get_segment().value(iSegmentPosition); }
+            const_pointer operator->() const { return &operator*(); }
+            bool operator==(const const_iterator& aOther) const { return container_position() == aOther.container_position(); }
+            bool operator!=(const const_iterator& aOther) const { return container_position() != aOther.container_position(); }
+            bool operator<(const const_iterator& aOther) const { return container_position() < aOther.container_position(); }
+            bool operator<=(const const_iterator& aOther) const { return container_position() <= aOther.container_position(); }
+            bool operator>(const const_iterator& aOther) const { return container_position() > aOther.container_position(); }
+            bool operator>=(const const_iterator& aOther) const { return container_position() >= aOther.container_position(); }
+
+        private:
+            size_type container_position() const { return iContainerPosition; }
+
+        private:
+            const segmented_indexitor* iContainer;
+            node* iNode;
+            size_type iContainerPosition;
+            size_type iSegmentPosition;
+        };
+        typedef std::reverse_iterator<iterator> reverse_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    public:
+        segmented_indexitor(const Alloc& aAllocator = Alloc()) :
+            iAllocator(aAllocator), iSize(0)
+        {
+        }
+        segmented_indexitor(const size_type aCount, const value_type& aValue, const Alloc& aAllocator = Alloc()) :
+            iAllocator(aAllocator), iSize(0)
+        {
+            insert(begin(), aCount, aValue);
+        }
+        template <typename InputIterator>
+        segmented_indexitor(InputIterator aFirst, InputIterator aLast, const Alloc& aAllocator = Alloc()) :
+            iAllocator(aAllocator), iSize(0)
+        {
+            insert(begin(), aFirst, aLast);
+        }
+        segmented_indexitor(const segmented_indexitor& aOther, const Alloc& aAllocator = Alloc()) :
+            base_type(), iAllocator(aAllocator), iSize(0)
+        {
+            for (auto i = aOther.begin(); i != aOther.end(); ++i)
+                push_back(*i, skip_type{ aOther.skip_before(i), aOther.skip_after(i) });
+        }
+        ~segmented_indexitor()
+        {
+            clear();
+        }
+        segmented_indexitor& operator=(const segmented_indexitor& aOther)
+        {
+            segmented_indexitor newContents{aOther};
+            newContents.swap(*this);
+            return *this;
+        }
+
+    public:
+        size_type size() const
+        {
+            return iSize;
+        }
+        bool empty() const
+        {
+            return iSize == 0;
+        }
+        const_iterator begin() const
+        {
+            return const_iterator{*this, static_cast<node*>(base_type::front_node()), 0, 0};
+        }
+        const_iterator end() const
+        {
+            return const_iterator{*this, nullptr, size(), 0};
+        }
+        iterator begin()
+        {
+            return iterator{*this, static_cast<node*>(base_type::front_node()), 0, 0};
+        }
+        iterator end()
+        {
+            return iterator{*this, nullptr, size(), 0};
+        }
+        const_reverse_iterator rbegin() const
+        {
+            return const_reverse_iterator{end()};
+        }
+        const_reverse_iterator rend() const
+        {
+            return const_reverse_iterator{begin()};
+        }
+        reverse_iterator rbegin()
+        {
+            return reverse_iterator{end()};
+        }
+        reverse_iterator rend()
+        {
+            return reverse_iterator{begin()};
+        }
+        const_reference front() const
+        {
+            return *begin();
+        }
+        reference front()
+        {
+            return *begin();
+        }
+        const_reference back() const
+        {
+            return *--end();
+        }
+        reference back()
+        {
+            return *--end();
+        }
+        size_type index(const_iterator aPosition) const
+        {
+            if (aPosition.iNode != nullptr)
+                return do_index(aPosition.iNode) + aPosition.iSegmentPosition;
+            else
+                return size();
+        }
+        iterator insert(const_iterator aPosition, const value_type& aValue, const skip_type& aSkip = skip_type{})
+        {
+            node* segmentNode = aPosition.iNode;
+            size_type segmentPosition = aPosition.iSegmentPosition;
+            if (segmentNode == nullptr)
+            {
+                segmentNode = static_cast<node*>(base_type::back_node());
+                segmentPosition = segmentNode != nullptr ? segmentNode->get_segment().size() : 0;
+            }
+            if (segmentNode == nullptr)
+                segmentNode = allocate_node(nullptr, 0);
+            else if (segmentNode->get_segment().full())
+            {
+                size_type const segmentStart = aPosition.container_position() - segmentPosition;
+                node* newNode = allocate_node(static_cast<node*>(segmentNode->next()), segmentStart + SegmentSize);
+                if (segmentPosition == SegmentSize)
+                {
+                    segmentNode = newNode;
+                    segmentPosition = 0;
+                }
+                else
+                {
+                    size_type const half = SegmentSize / 2u;
+                    foreign_index_type const moved = segmentNode->get_segment().move_tail(half, newNode->get_segment());
+                    segmentNode->set_size(segmentNode->size() - (SegmentSize - half));
+                    segmentNode->set_foreign_index(segmentNode->foreign_index() - moved);
+                    newNode->set_size(newNode->size() + (SegmentSize - half));
+                    newNode->set_foreign_index(newNode->foreign_index() + moved);
+                    if (segmentPosition > half)
+                    {
+                        segmentNode = newNode;
+                        segmentPosition -= half;
+                    }
+                }
+            }
+            foreign_index_type const extent = segmentNode->get_segment().insert(segmentPosition, aValue, aSkip);
+            segmentNode->set_size(segmentNode->size() + 1);
+            segmentNode->set_foreign_index(segmentNode->foreign_index() + extent);
+            ++iSize;
+            return iterator{*this, segmentNode, aPosition.container_position(), segmentPosition};
+        }
+        const_reference operator[](size_type aIndex) const
+        {
+            return *(begin() + aIndex);
+        }
+        reference operator[](size_type aIndex)
+        {
+            return *(begin() + aIndex);
+        }
+        template <class InputIterator>
+        typename std::enable_if<!std::is_integral<InputIterator>::value, iterator>::type
+            insert(const_iterator aPosition, InputIterator aFirst, InputIterator aLast)
+        {
+            return do_insert(aPosition, aFirst, aLast);
+        }
+        template <class InputIterator, class SkipIterator>
+        typename std::enable_if<!std::is_integral<InputIterator>::value, iterator>::type
+        insert(const_iterator aPosition, InputIterator aFirst, InputIterator aLast, SkipIterator aSkipFirst, SkipIterator aSkipSecond)
+        {
+            return do_insert(aPosition, aFirst, aLast, aSkipFirst, aSkipSecond);
+        }
+        iterator insert(const_iterator aPosition, size_type aCount, const value_type& aValue, const skip_type& aSkip = skip_type{})
+        {
+            auto pos = aPosition.container_position();
+            while (aCount > 0)
+            {
+                aPosition = insert(aPosition, aValue, aSkip);
+                ++aPosition;
+                --aCount;
+            }
+            return iterator{*this, pos};
+        }
+        void clear()
+        {
+            for (node* n = static_cast<node*>(base_type::front_node()); n != nullptr;)
+            {
+                node* next = static_cast<node*>(n->next());
+                free_node(n);
+                n = next;
+            }
+            iSize = 0;
+        }
+        void push_front(const value_type& aValue, const skip_type& aSkip = skip_type{})
+        {
+            insert(begin(), aValue, aSkip);
+        }
+        void push_back(const value_type& aValue, const skip_type& aSkip = skip_type{})
+        {
+            insert(end(), aValue, aSkip);
+        }
+        void resize(std::size_t aNewSize, const value_type& aValue = value_type{}, const skip_type& aSkip = skip_type{})
+        {
+            if (size() < aNewSize)
+                insert(end(), aNewSize - size(), aValue, aSkip);
+            else
+                erase(begin() + aNewSize, end());
+        }
+        iterator erase(const_iterator aPosition)
+        {
+            return erase(aPosition, aPosition + 1);
+        }
+        iterator erase(const_iterator aFirst, const_iterator aLast)
+        {
+            auto const pos = aFirst.container_position();
+            size_type count = aLast.container_position() - pos;
+            node* segmentNode = aFirst.iNode;
+            size_type segmentPosition = aFirst.iSegmentPosition;
+            while (count > 0)
+            {
+                segment& s = segmentNode->get_segment();
+                size_type const erasing = std::min(count, s.size() - segmentPosition);
+                node* next = static_cast<node*>(segmentNode->next());
+                if (erasing == s.size())
+                    free_node(segmentNode);
+                else
+                {
+                    foreign_index_type const removed = s.erase(segmentPosition, erasing);
+                    segmentNode->set_size(segmentNode->size() - erasing);
+                    segmentNode->set_foreign_index(segmentNode->foreign_index() - removed);
+                }
+                iSize -= erasing;
+                count -= erasing;
+                segmentNode = next;
+                segmentPosition = 0;
+            }
+            return iterator{*this, pos};
+        }
+        void pop_front()
+        {
+            erase(begin());
+        }
+        void pop_back()
+        {
+            erase(--end());
+        }
+        void swap(segmented_indexitor& aOther)
+        {
+            base_type::swap(aOther);
+            std::swap(iAllocator, aOther.iAllocator);
+            std::swap(iSize, aOther.iSize);
+        }
+
+    public:
+        // updated in place; subsequent edits to the same segment share a single prefix sum recalculation
+        void update_foreign_index(const_iterator aPosition, const foreign_index_type& aForeignIndex, const skip_type& aSkip = skip_type{})
+        {
+            segment& s = aPosition.iNode->get_segment();
+            foreign_index_type const difference = s.replace(aPosition.iSegmentPosition, value_type{ s.value(aPosition.iSegmentPosition).first, aForeignIndex }, aSkip);
+            aPosition.iNode->set_foreign_index(aPosition.iNode->foreign_index() + difference);
+        }
+        template <typename Pred = std::less<foreign_index_type>>
+        std::pair<const_iterator, foreign_index_type> find_by_foreign_index(foreign_index_type aForeignIndex, Pred aPred = Pred{}) const
+        {
+            size_type nodeIndex{};
+            foreign_index_type nodeForeignIndex{};
+            node* n = find_node_by_foreign_index(aForeignIndex, nodeIndex, nodeForeignIndex, aPred);
+            if (n != nullptr)
+            {
+                segment const& s = n->get_segment();
+                foreign_index_type const segmentForeignIndex = aForeignIndex - nodeForeignIndex;
+                size_type const segmentPosition = s.find(segmentForeignIndex, aPred);
+                foreign_index_type const elementForeignIndex = s.prefix(segmentPosition);
+                skip_type const& skip = s.skip(segmentPosition);
+                if (!aPred(segmentForeignIndex - elementForeignIndex, skip.first) &&
+                    aPred(segmentForeignIndex - elementForeignIndex, s.extent(segmentPosition) - skip.second))
+                    return std::make_pair(const_iterator{*this, n, nodeIndex + segmentPosition, segmentPosition}, nodeForeignIndex + elementForeignIndex + skip.first);
+            }
+            return std::make_pair(end(), foreign_index(end()));
+        }
+        template <typename Pred = std::less<foreign_index_type>>
+        std::pair<iterator, foreign_index_type> find_by_foreign_index(foreign_index_type aForeignIndex, Pred aPred = Pred{})
+        {
+            auto const result = std::as_const(*this).find_by_foreign_index(aForeignIndex, aPred);
+            return std::make_pair(iterator{*this, result.first.iNode, result.first.iContainerPosition, result.first.iSegmentPosition}, result.second);
+        }
+        foreign_index_type foreign_index(const_iterator aPosition) const
+        {
+            if (aPosition.iNode != nullptr)
+            {
+                segment const& s = aPosition.iNode->get_segment();
+                return do_foreign_index(aPosition.iNode) + s.prefix(aPosition.iSegmentPosition) + s.skip(aPosition.iSegmentPosition).first;
+            }
+            else
+                return base_type::root_node()->foreign_index();
+        }
+        foreign_index_type skip_before(const_iterator aPosition) const
+        {
+            if (aPosition.iNode != nullptr)
+                return aPosition.iNode->get_segment().skip(aPosition.iSegmentPosition).first;
+            else
+                return foreign_index_type{};
+        }
+        foreign_index_type skip_after(const_iterator aPosition) const
+        {
+            if (aPosition.iNode != nullptr)
+                return aPosition.iNode->get_segment().skip(aPosition.iSegmentPosition).second;
+            else
+                return foreign_index_type{};
+        }
+
+    private:
+        template <class InputIterator>
+        iterator do_insert(const_iterator aPosition, InputIterator aFirst, InputIterator aLast)
+        {
+            auto pos = aPosition.container_position();
+            while (aFirst != aLast)
+            {
+                aPosition = insert(aPosition, *aFirst++);
+                ++aPosition;
+            }
+            return iterator{*this, pos};
+        }
+        template <class InputIterator, class SkipIterator>
+        iterator do_insert(const_iterator aPosition, InputIterator aFirst, InputIterator aLast, SkipIterator aSkipFirst, SkipIterator aSkipLast)
+        {
+            auto pos = aPosition.container_position();
+            while (aFirst != aLast && aSkipFirst != aSkipLast)
+            {
+                aPosition = insert(aPosition, *aFirst++, *aSkipFirst++);
+                ++aPosition;
+            }
+            return iterator{*this, pos};
+        }
+        size_type do_index(const node* aNode) const
+        {
+            if (aNode != base_type::root_node())
+            {
+                if (aNode == aNode->parent()->left())
+                    return do_index(static_cast<const node*>(aNode->parent())) - aNode->size() + aNode->left_size();
+                else
+                    return do_index(static_cast<const node*>(aNode->parent())) + aNode->parent()->centre_size() + aNode->left_size();
+            }
+            else
+                return base_type::root_node()->left_size();
+        }
+        foreign_index_type do_foreign_index(const node* aNode) const
+        {
+            if (aNode != base_type::root_node())
+            {
+                if (aNode == aNode->parent()->left())
+                    return do_foreign_index(static_cast<const node*>(aNode->parent())) - aNode->foreign_index() + aNode->left_foreign_index();
+                else
+                    return do_foreign_index(static_cast<const node*>(aNode->parent())) + aNode->parent()->centre_foreign_index() + aNode->left_foreign_index();
+            }
+            else
+                return base_type::root_node()->left_foreign_index();
+        }
+        // unlike the base class searches these use a segment's own size/extent so only a node and its left child are visited per level
+        node* find_node(size_type aContainerPosition, size_type& aSegmentPosition) const
+        {
+            typename base_type::node* x = base_type::root_node();
+            size_type index = 0;
+            while (x != base_type::nil_node())
+            {
+                typename base_type::node* const left = x->left();
+                if (aContainerPosition < index + left->size())
+                {
+                    x = left;
+                    continue;
+                }
+                index += left->size();
+                size_type const segmentSize = static_cast<node*>(x)->get_segment().size();
+                if (aContainerPosition < index + segmentSize)
+                {
+                    aSegmentPosition = aContainerPosition - index;
+                    return static_cast<node*>(x);
+                }
+                index += segmentSize;
+                x = x->right();
+            }
+            return nullptr;
+        }
+        template <typename Pred>
+        node* find_node_by_foreign_index(foreign_index_type aForeignIndex, size_type& aNodeIndex, foreign_index_type& aNodeForeignIndex, Pred aPred) const
+        {
+            typename base_type::node* x = base_type::root_node();
+            size_type index = 0;
+            foreign_index_type foreignIndex{};
+            while (x != base_type::nil_node())
+            {
+                typename base_type::node* const left = x->left();
+                if (aPred(aForeignIndex, foreignIndex + left->foreign_index()))
+                {
+                    x = left;
+                    continue;
+                }
+                index += left->size();
+                foreignIndex += left->foreign_index();
+                segment const& s = static_cast<node*>(x)->get_segment();
+                if (aPred(aForeignIndex, foreignIndex + s.extent()))
+                {
+                    aNodeIndex = index;
+                    aNodeForeignIndex = foreignIndex;
+                    return static_cast<node*>(x);
+                }
+                index += s.size();
+                foreignIndex += s.extent();
+                x = x->right();
+            }
+            return nullptr;
+        }
+        // creates an empty segment before aBefore (or at the back if aBefore is null) at container position aContainerPosition
+        node* allocate_node(node* aBefore, size_type aContainerPosition)
+        {
+            node* newNode = std::allocator_traits<node_allocator_type>::allocate(iAllocator, 1);
+            try
+            {
+                std::allocator_traits<node_allocator_type>::construct(iAllocator, newNode);
+            }
+            catch (...)
+            {
+                std::allocator_traits<node_allocator_type>::deallocate(iAllocator, newNode, 1);
+                throw;
+            }
+            if (base_type::front_node() == nullptr)
+            {
+                base_type::set_front_node(newNode);
+                base_type::set_back_node(newNode);
+            }
+            else
+            {
+                newNode->set_next(aBefore);
+                if (aBefore)
+                {
+                    if (aBefore->previous())
+                    {
+                        newNode->set_previous(aBefore->previous());
+                        aBefore->previous()->set_next(newNode);
+                    }
+                    aBefore->set_previous(newNode);
+                    if (base_type::front_node() == aBefore)
+                        base_type::set_front_node(newNode);
+                }
+                else
+                {
+                    base_type::back_node()->set_next(newNode);
+                    newNode->set_previous(base_type::back_node());
+                    base_type::set_back_node(newNode);
+                }
+            }
+            base_type::insert_node(newNode, aContainerPosition);
+            return newNode;
+        }
+        void free_node(node* aNode)
+        {
+            if (aNode->next())
+                aNode->next()->set_previous(aNode->previous());
+            if (aNode->previous())
+                aNode->previous()->set_next(aNode->next());
+            if (base_type::back_node() == aNode)
+                base_type::set_back_node(aNode->previous());
+            if (base_type::front_node() == aNode)
+                base_type::set_front_node(aNode->next());
+            base_type::delete_node(aNode);
+            std::allocator_traits<node_allocator_type>::destroy(iAllocator, aNode);
+            std::allocator_traits<node_allocator_type>::deallocate(iAllocator, aNode, 1);
+        }
+
+    private:
+        node_allocator_type iAllocator;
+        size_type iSize;
+    };
+}
@@ -46,6 +46,8 @@ namespace neolib
     {
         typedef segmented_tree<T, N, Alloc> self_type;
         typedef self_type tree_type;
+    public:
+        struct invalid_splice : std::logic_error { invalid_splice() : std::logic_error("neolib::segmented_tree::invalid_splice") {} };
     public:
         typedef T value_type;
         typedef Alloc allocator_type;
@@ -85,15 +87,15 @@ namespace neolib
                     iContents.root.~root_place_holder();
                     new (&iContents.value) value_type{ other.iContents.value };
                 }
+                update_parents(*this);
             }
             node(node&& other) :
-                iParent{},
+                iParent{ other.iParent },
                 iSkipChildren{ false },
                 iDescendentCount{ 0 },
                 iSkippedDescendentCount{ 0 },
                 iContents{ root_place_holder{} }
             {
-                std::swap(iParent, other.iParent);
                 std::swap(iChildren, other.iChildren);
                 std::swap(iSkipChildren, other.iSkipChildren);
                 std::swap(iDescendentCount, other.iDescendentCount);
@@ -132,6 +134,7 @@ namespace neolib
                     iContents.value = other.iContents.value;
                 else
                     iContents.root = other.iContents.root;
+                update_parents(*this);
                 return *this;
             }
             node& operator=(node&& other)
@@ -221,15 +224,33 @@ namespace neolib
             }
             void increment_descendent_count()
             {
-                ++iDescendentCount;
+                increment_descendent_count(1);
+            }
+            void increment_descendent_count(std::size_t aCount)
+            {
+                iDescendentCount += aCount;
                 if (!is_root())
-                    parent().increment_descendent_count();
+                    parent().increment_descendent_count(aCount);
             }
             void decrement_descendent_count()
             {
-                --iDescendentCount;
+                decrement_descendent_count(1);
+            }
+            void decrement_descendent_count(std::size_t aCount)
+            {
+                iDescendentCount -= aCount;
                 if (!is_root())
-                    parent().decrement_descendent_count();
+                    parent().decrement_descendent_count(aCount);
+            }
+            // number of nodes in this subtree, this node included
+            std::size_t subtree_count() const
+            {
+                return 1 + descendent_count();
+            }
+            // contribution of this subtree to its ancestors' skipped descendent counts
+            std::size_t subtree_skipped_count() const
+            {
+                return children_skipped() ? descendent_count() : skipped_descendent_count();
             }
             std::size_t skipped_descendent_count() const
             {
@@ -247,13 +268,12 @@ namespace neolib
                 if (!is_root())
                     parent().decrement_skipped_descendent_count(aCount);
             }
+            // only the direct children need updating: grandchildren live in their parents' child lists whose
+            // segments do not move when a node does
             void update_parents(node& parent)
             {
                 for (auto& child : parent.children())
-                {
                     child.iParent = &parent;
-                    update_parents(child);
-                }
             }
         private:
             node* iParent;
@@ -824,10 +844,57 @@ namespace neolib
         {
             auto mutablePos = std::next(begin(), std::distance(cbegin(), pos));
             node& parent = mutablePos.parent_node();
+            std::size_t const count = mutablePos.our_node().subtree_count();
+            std::size_t const skipped = mutablePos.our_node().subtree_skipped_count();
             auto result = iterator{ parent, parent.children().erase(mutablePos.base()) };
-            parent.decrement_descendent_count();
+            parent.decrement_descendent_count(count);
+            if (skipped != 0)
+                parent.decrement_skipped_descendent_count(skipped);
             return result;
         }
+        // moves subtree, together with its descendants, from other to before position without copying it; the
+        // allocators of both trees must compare equal
+        sibling_iterator splice(const_sibling_iterator position, segmented_tree& /* other */, const_sibling_iterator subtree)
+        {
+            return splice(position, subtree);
+        }
+        // moves subtree, together with its descendants, to before position without copying it
+        sibling_iterator splice(const_sibling_iterator position, const_sibling_iterator subtree)
+        {
+            node* destination = &const_cast<node&>(position.parent_node());
+            node& source = const_cast<node&>(subtree.parent_node());
+            node& moving = const_cast<node&>(subtree.our_node());
+            for (node const* n = destination;; n = &n->parent())
+            {
+                if (n == &moving)
+                    throw invalid_splice();
+                if (n->is_root())
+                    break;
+            }
+            auto const sourceIndex = subtree.base() - source.children().cbegin();
+            auto destinationIndex = position.base() - destination->children().cbegin();
+            if (destination == &source && destinationIndex > sourceIndex)
+                --destinationIndex;
+            // erasing from the source child list can move a sibling of the subtree that is the destination
+            auto const destinationSiblingIndex = (!destination->is_root() && &destination->parent() == &source ?
+                source.children().citer(*destination) - source.children().cbegin() : -1);
+            std::size_t const count = moving.subtree_count();
+            std::size_t const skipped = moving.subtree_skipped_count();
+            node temp{ std::move(moving) };
+            source.children().erase(source.children().begin() + sourceIndex);
+            source.decrement_descendent_count(count);
+            if (skipped != 0)
+                source.decrement_skipped_descendent_count(skipped);
+            if (destinationSiblingIndex != -1)
+                destination = &source.children()[static_cast<size_type>(destinationSiblingIndex - (destinationSiblingIndex > sourceIndex ? 1 : 0))];
+            auto& children = destination->children();
+            auto result = children.insert(children.begin() + destinationIndex, std::move(temp));
+            result->iParent = destination;
+            destination->increment_descendent_count(count);
+            if (skipped != 0)
+                destination->increment_skipped_descendent_count(skipped);
+            return sibling_iterator{ *destination, result };
+        }
         void sort()
         {
             sort(std::less<value_type>{});
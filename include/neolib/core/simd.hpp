@@ -37,10 +37,21 @@
 
 #include <neolib/neolib.hpp>
 #include <array>
+#include <atomic>
 #include <thread>
 #include <cstdlib>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <cmath>
 #if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
 #include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #endif
 #if defined(USE_EMM) || defined(USE_EMM_DYNAMIC) 
 #include <emmintrin.h>
@@ -57,6 +68,61 @@ namespace neolib
 #endif
 
 #if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+    // AVX2 and AVX-512 code paths are compiled with a function target attribute (the rest of the build need not enable them)
+    // and are only taken if the processor and OS support them
+#if defined(__clang__)
+    #define NEOLIB_AVX2_TARGET __attribute__((target("avx2")))
+    #define NEOLIB_AVX512_TARGET __attribute__((target("avx512f")))
+#elif defined(__GNUC__)
+    // AVX-512 implies FMA which GCC would otherwise contract separate multiplies and adds into
+    #define NEOLIB_AVX2_TARGET __attribute__((target("avx2")))
+    #define NEOLIB_AVX512_TARGET __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#else
+    #define NEOLIB_AVX2_TARGET
+    #define NEOLIB_AVX512_TARGET
+#endif
+    inline bool avx2_supported()
+    {
+        static bool const sSupported = []()
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER)
+            int info[4] = {};
+            __cpuid(info, 1);
+            bool const osxsave = (info[2] & (1 << 27)) != 0;
+            if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return false;
+#endif
+        }();
+        return sSupported;
+    }
+
+    inline bool avx512_supported()
+    {
+        static bool const sSupported = []()
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_cpu_supports("avx512f") != 0;
+#elif defined(_MSC_VER)
+            int info[4] = {};
+            __cpuid(info, 1);
+            bool const osxsave = (info[2] & (1 << 27)) != 0;
+            if (!osxsave || (_xgetbv(0) & 0xE6) != 0xE6)
+                return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 16)) != 0;
+#else
+            return false;
+#endif
+        }();
+        return sSupported;
+    }
+
     inline double to_scalar(__m256d const& avxRegister, std::size_t index)
     {
 #ifdef _WIN32
@@ -142,151 +208,837 @@ namespace neolib
     #define simd_mul_4d fake_simd_mul_4d
 #endif
 
-    /////////////////////////////////////////////////////////////////////////////
-    // The Software is provided "AS IS" and possibly with faults. 
-    // Intel disclaims any and all warranties and guarantees, express, implied or
-    // otherwise, arising, with respect to the software delivered hereunder,
-    // including but not limited to the warranty of merchantability, the warranty
-    // of fitness for a particular purpose, and any warranty of non-infringement
-    // of the intellectual property rights of any third party.
-    // Intel neither assumes nor authorizes any person to assume for it any other
-    // liability. Customer will use the software at its own risk. Intel will not
-    // be liable to customer for any direct or indirect damages incurred in using
-    // the software. In no event will Intel be liable for loss of profits, loss of
-    // use, loss of data, business interruption, nor for punitive, incidental,
-    // consequential, or special damages of any kind, even if advised of
-    // the possibility of such damages.
-    //
-    // Copyright (c) 2003 Intel Corporation
-    //
-    // Third-party brands and names are the property of their respective owners
-    //
-    ///////////////////////////////////////////////////////////////////////////
-    // Random Number Generation for SSE / SSE2
-    // Source File
-    // Version 0.1
-    // Author Kipp Owens, Rajiv Parikh
-    ////////////////////////////////////////////////////////////////////////
+    // xoshiro256** (Blackman and Vigna) run as simd_xoshiro256ss_lanes independent streams; a step advances every
+    // lane once producing one output per lane. aState holds the four state words each as a row of lanes.
+
+    constexpr std::size_t simd_xoshiro256ss_lanes = 8u;
+
+    inline void fake_simd_xoshiro256ss(uint64_t* aState, uint64_t* aOutput, std::size_t aSteps)
+    {
+        std::size_t constexpr lanes = simd_xoshiro256ss_lanes;
+        uint64_t* const s0 = aState;
+        uint64_t* const s1 = aState + lanes;
+        uint64_t* const s2 = aState + lanes * 2u;
+        uint64_t* const s3 = aState + lanes * 3u;
+        for (std::size_t step = 0u; step < aSteps; ++step, aOutput += lanes)
+            for (std::size_t lane = 0u; lane < lanes; ++lane)
+            {
+                aOutput[lane] = std::rotl(s1[lane] * 5u, 7) * 9u;
+                uint64_t const t = s1[lane] << 17;
+                s2[lane] ^= s0[lane];
+                s3[lane] ^= s1[lane];
+                s1[lane] ^= s2[lane];
+                s0[lane] ^= s3[lane];
+                s2[lane] ^= t;
+                s3[lane] = std::rotl(s3[lane], 45);
+            }
+    }
+
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+    // AVX2 has no 64-bit multiply or rotate so x * 5 and x * 9 are computed as (x << 2) + x and (x << 3) + x
+    NEOLIB_AVX2_TARGET inline void avx2_simd_xoshiro256ss(uint64_t* aState, uint64_t* aOutput, std::size_t aSteps)
+    {
+        std::size_t constexpr lanes = simd_xoshiro256ss_lanes;
+        std::size_t constexpr registers = lanes / 4u;
+        __m256i s[4][registers];
+        for (std::size_t word = 0u; word < 4u; ++word)
+            for (std::size_t r = 0u; r < registers; ++r)
+                s[word][r] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(aState + word * lanes + r * 4u));
+        for (std::size_t step = 0u; step < aSteps; ++step, aOutput += lanes)
+            for (std::size_t r = 0u; r < registers; ++r)
+            {
+                __m256i const x5 = _mm256_add_epi64(_mm256_slli_epi64(s[1][r], 2), s[1][r]);
+                __m256i const rotated = _mm256_or_si256(_mm256_slli_epi64(x5, 7), _mm256_srli_epi64(x5, 57));
+                __m256i const result = _mm256_add_epi64(_mm256_slli_epi64(rotated, 3), rotated);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOutput + r * 4u), result);
+                __m256i const t = _mm256_slli_epi64(s[1][r], 17);
+                s[2][r] = _mm256_xor_si256(s[2][r], s[0][r]);
+                s[3][r] = _mm256_xor_si256(s[3][r], s[1][r]);
+                s[1][r] = _mm256_xor_si256(s[1][r], s[2][r]);
+                s[0][r] = _mm256_xor_si256(s[0][r], s[3][r]);
+                s[2][r] = _mm256_xor_si256(s[2][r], t);
+                s[3][r] = _mm256_or_si256(_mm256_slli_epi64(s[3][r], 45), _mm256_srli_epi64(s[3][r], 19));
+            }
+        for (std::size_t word = 0u; word < 4u; ++word)
+            for (std::size_t r = 0u; r < registers; ++r)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(aState + word * lanes + r * 4u), s[word][r]);
+    }
+#endif
+
+    inline void simd_xoshiro256ss(uint64_t* aState, uint64_t* aOutput, std::size_t aSteps)
+    {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_xoshiro256ss(aState, aOutput, aSteps);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_xoshiro256ss(aState, aOutput, aSteps);
+#endif
+        fake_simd_xoshiro256ss(aState, aOutput, aSteps);
+    }
+
+    // A UniformRandomBitGenerator producing the interleaved output of simd_xoshiro256ss_lanes xoshiro256** streams;
+    // the lanes are seeded from one splitmix64 seeded state, each lane 2^128 steps on from the previous one. The output
+    // sequence is the same whichever code path generates it and however it is consumed (single values or bulk fills).
+    class simd_xoshiro256ss_engine
+    {
+    public:
+        typedef uint64_t result_type;
+        static constexpr std::size_t lanes = simd_xoshiro256ss_lanes;
+        static constexpr std::size_t state_size = lanes * 4u;
+        static constexpr result_type default_seed = 0x853C49E6748FEA9Bull;
+    private:
+        static constexpr std::size_t buffer_steps = 8u;
+        static constexpr std::size_t buffer_size = lanes * buffer_steps;
+    public:
+        simd_xoshiro256ss_engine()
+        {
+            seed(default_seed);
+        }
+        explicit simd_xoshiro256ss_engine(result_type aSeed)
+        {
+            seed(aSeed);
+        }
+    public:
+        static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    public:
+        void seed(result_type aSeed = default_seed)
+        {
+            uint64_t lane[4];
+            for (auto& word : lane)
+            {
+                uint64_t z = (aSeed += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                word = z ^ (z >> 31);
+            }
+            for (std::size_t l = 0u; l < lanes; ++l)
+            {
+                for (std::size_t word = 0u; word < 4u; ++word)
+                    iState[word * lanes + l] = lane[word];
+                jump(lane);
+            }
+            iBufferPosition = buffer_size;
+            iHalfPending = false;
+        }
+        result_type operator()()
+        {
+            if (iBufferPosition == buffer_size)
+            {
+                simd_xoshiro256ss(iState.data(), iBuffer.data(), buffer_steps);
+                iBufferPosition = 0u;
+            }
+            return iBuffer[iBufferPosition++];
+        }
+        void discard(unsigned long long aCount)
+        {
+            for (; aCount > 0u; --aCount)
+                (*this)();
+        }
+    public:
+        void fill(std::span<uint64_t> aOutput)
+        {
+            auto next = aOutput.begin();
+            while (next != aOutput.end() && iBufferPosition != buffer_size)
+                *next++ = iBuffer[iBufferPosition++];
+            std::size_t const steps = static_cast<std::size_t>(aOutput.end() - next) / lanes;
+            if (steps != 0u)
+            {
+                simd_xoshiro256ss(iState.data(), &*next, steps);
+                next += steps * lanes;
+            }
+            while (next != aOutput.end())
+                *next++ = (*this)();
+        }
+        // each 64-bit output supplies two values, upper half first; the lower half left over by an odd count is
+        // carried to the start of the next 32-bit fill so consecutive fills see the same sequence as a single fill
+        void fill(std::span<uint32_t> aOutput)
+        {
+            std::size_t i = 0u;
+            if (iHalfPending && !aOutput.empty())
+            {
+                aOutput[i++] = iPendingHalf;
+                iHalfPending = false;
+            }
+            std::array<uint64_t, buffer_size> chunk;
+            while (i < aOutput.size())
+            {
+                std::size_t const count = std::min(chunk.size() * 2u, aOutput.size() - i);
+                fill(std::span<uint64_t>{ chunk.data(), (count + 1u) / 2u });
+                for (std::size_t j = 0u; j < count; ++j)
+                    aOutput[i + j] = static_cast<uint32_t>(j % 2u == 0u ? chunk[j / 2u] >> 32 : chunk[j / 2u]);
+                if (count % 2u == 1u)
+                {
+                    iPendingHalf = static_cast<uint32_t>(chunk[count / 2u]);
+                    iHalfPending = true;
+                }
+                i += count;
+            }
+        }
+        // uniform in [0, aUpper) without modulo bias (Lemire's nearly divisionless method)
+        uint32_t bounded(uint32_t aUpper)
+        {
+            return bounded(aUpper, static_cast<uint32_t>((*this)() >> 32));
+        }
+        void fill_bounded(std::span<uint32_t> aOutput, uint32_t aUpper)
+        {
+            fill(aOutput);
+            for (auto& x : aOutput)
+                x = bounded(aUpper, x);
+        }
+        // uniform in [aLower, aUpper) with 53 bits of precision
+        double uniform(double aLower = 0.0, double aUpper = 1.0)
+        {
+            return aLower + to_unit((*this)()) * (aUpper - aLower);
+        }
+        void fill_uniform(std::span<double> aOutput, double aLower = 0.0, double aUpper = 1.0)
+        {
+            static_assert(sizeof(double) == sizeof(uint64_t));
+            std::array<uint64_t, buffer_size> chunk;
+            for (std::size_t i = 0u; i < aOutput.size(); i += chunk.size())
+            {
+                std::size_t const count = std::min(chunk.size(), aOutput.size() - i);
+                fill(std::span<uint64_t>{ chunk.data(), count });
+                for (std::size_t j = 0u; j < count; ++j)
+                    aOutput[i + j] = aLower + to_unit(chunk[j]) * (aUpper - aLower);
+            }
+        }
+        // normally distributed (Box-Muller), two values per pair of uniform values
+        void fill_normal(std::span<double> aOutput, double aMean = 0.0, double aStandardDeviation = 1.0)
+        {
+            std::array<uint64_t, buffer_size> chunk;
+            for (std::size_t i = 0u; i < aOutput.size(); i += chunk.size())
+            {
+                std::size_t const count = std::min(chunk.size(), aOutput.size() - i);
+                std::size_t const pairs = (count + 1u) / 2u;
+                fill(std::span<uint64_t>{ chunk.data(), pairs * 2u });
+                for (std::size_t j = 0u; j < pairs; ++j)
+                {
+                    double const radius = std::sqrt(-2.0 * std::log(1.0 - to_unit(chunk[j * 2u])));
+                    double const theta = 6.283185307179586476925286766559 * to_unit(chunk[j * 2u + 1u]);
+                    aOutput[i + j * 2u] = aMean + aStandardDeviation * radius * std::cos(theta);
+                    if (j * 2u + 1u < count)
+                        aOutput[i + j * 2u + 1u] = aMean + aStandardDeviation * radius * std::sin(theta);
+                }
+            }
+        }
+    private:
+        static double to_unit(uint64_t aValue)
+        {
+            return static_cast<double>(aValue >> 11) * 0x1.0p-53;
+        }
+        uint32_t bounded(uint32_t aUpper, uint32_t aRandom)
+        {
+            uint64_t m = static_cast<uint64_t>(aRandom) * aUpper;
+            uint32_t low = static_cast<uint32_t>(m);
+            if (low < aUpper)
+            {
+                uint32_t const threshold = static_cast<uint32_t>(0u - aUpper) % aUpper;
+                while (low < threshold)
+                {
+                    m = static_cast<uint64_t>(static_cast<uint32_t>((*this)() >> 32)) * aUpper;
+                    low = static_cast<uint32_t>(m);
+                }
+            }
+            return static_cast<uint32_t>(m >> 32);
+        }
+        static void jump(uint64_t (&aState)[4])
+        {
+            static constexpr uint64_t sJump[] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDABCCA6E9B2Bull };
+            uint64_t result[4] = {};
+            for (uint64_t bits : sJump)
+                for (int b = 0; b < 64; ++b)
+                {
+                    if (bits & (uint64_t{ 1u } << b))
+                        for (std::size_t word = 0u; word < 4u; ++word)
+                            result[word] ^= aState[word];
+                    uint64_t const t = aState[1] << 17;
+                    aState[2] ^= aState[0];
+                    aState[3] ^= aState[1];
+                    aState[1] ^= aState[2];
+                    aState[0] ^= aState[3];
+                    aState[2] ^= t;
+                    aState[3] = std::rotl(aState[3], 45);
+                }
+            std::copy(std::begin(result), std::end(result), std::begin(aState));
+        }
+    private:
+        std::array<uint64_t, state_size> iState;
+        std::array<uint64_t, buffer_size> iBuffer;
+        std::size_t iBufferPosition;
+        uint32_t iPendingHalf = 0u;
+        bool iHalfPending = false;
+    };
 
     namespace detail
     {
+        inline simd_xoshiro256ss_engine& simd_rand_engine()
+        {
+            thread_local simd_xoshiro256ss_engine tEngine;
+            return tEngine;
+        }
+    }
+
+    inline void simd_srand(uint32_t seed)
+    {
+        detail::simd_rand_engine().seed(seed);
+    }
+        
+    inline void simd_srand(std::thread::id seed)
+    {
+        simd_srand(static_cast<uint32_t>(std::hash<std::thread::id>{}(seed)));
+    }
+
+    // the full 32-bit range (the upper half of one engine output); the SSE LCG this replaced returned only 15 bits
+    // and the std::rand fallback returned [0, RAND_MAX] so callers scaling by those ranges must use simd_rand(aUpper)
+    inline uint32_t simd_rand()
+    {
+        return static_cast<uint32_t>(detail::simd_rand_engine()() >> 32);
+    }
+
+    template <typename T>
+    inline T simd_rand(T aUpper)
+    {
+        return static_cast<T>(detail::simd_rand_engine().bounded(static_cast<uint32_t>(aUpper)));
+    }
+
+    // counts the elements of [aFirst, aFirst + aCount) that are not greater than aValue (i.e. !(aValue < element));
+    // applied to a sorted range this is the offset of its upper bound
+    template <typename T>
+    inline std::size_t fake_simd_count_not_greater(T const* aFirst, std::size_t aCount, T aValue)
+    {
+        std::size_t result = 0u;
+        for (std::size_t i = 0u; i < aCount; ++i)
+            result += (aValue < aFirst[i] ? 0u : 1u);
+        return result;
+    }
+
 #if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
-        inline __m128i& simd_rand_seed()
+    inline std::size_t emm_simd_count_not_greater(double const* aFirst, std::size_t aCount, double aValue)
+    {
+        __m128d const value = _mm_set1_pd(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 2u <= aCount; i += 2u)
+            result += std::popcount(static_cast<uint32_t>(_mm_movemask_pd(_mm_cmpngt_pd(_mm_loadu_pd(aFirst + i), value))));
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
+    }
+
+    inline std::size_t emm_simd_count_not_greater(float const* aFirst, std::size_t aCount, float aValue)
+    {
+        __m128 const value = _mm_set1_ps(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 4u <= aCount; i += 4u)
+            result += std::popcount(static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpngt_ps(_mm_loadu_ps(aFirst + i), value))));
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
+    }
+
+    inline std::size_t emm_simd_count_not_greater(int32_t const* aFirst, std::size_t aCount, int32_t aValue)
+    {
+        __m128i const value = _mm_set1_epi32(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 4u <= aCount; i += 4u)
         {
-            alignas(16) thread_local __m128i tSeed;
-            return tSeed;
+            __m128i const greater = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(aFirst + i)), value);
+            result += 4u - std::popcount(static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(greater))));
         }
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
+    }
 #endif
+
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+    NEOLIB_AVX2_TARGET inline std::size_t avx2_simd_count_not_greater(double const* aFirst, std::size_t aCount, double aValue)
+    {
+        __m256d const value = _mm256_set1_pd(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 4u <= aCount; i += 4u)
+            result += std::popcount(static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(aFirst + i), value, _CMP_NGT_UQ))));
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
     }
 
-#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
-    inline void emm_simd_srand(uint32_t seed)
+    NEOLIB_AVX2_TARGET inline std::size_t avx2_simd_count_not_greater(float const* aFirst, std::size_t aCount, float aValue)
+    {
+        __m256 const value = _mm256_set1_ps(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 8u <= aCount; i += 8u)
+            result += std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(aFirst + i), value, _CMP_NGT_UQ))));
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
+    }
+
+    NEOLIB_AVX2_TARGET inline std::size_t avx2_simd_count_not_greater(int32_t const* aFirst, std::size_t aCount, int32_t aValue)
+    {
+        __m256i const value = _mm256_set1_epi32(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 8u <= aCount; i += 8u)
+        {
+            __m256i const greater = _mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(aFirst + i)), value);
+            result += 8u - std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(greater))));
+        }
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
+    }
+
+    NEOLIB_AVX2_TARGET inline std::size_t avx2_simd_count_not_greater(int64_t const* aFirst, std::size_t aCount, int64_t aValue)
     {
-        detail::simd_rand_seed() = _mm_set_epi32(seed, seed + 1, seed, seed + 1);
+        __m256i const value = _mm256_set1_epi64x(aValue);
+        std::size_t result = 0u;
+        std::size_t i = 0u;
+        for (; i + 4u <= aCount; i += 4u)
+        {
+            __m256i const greater = _mm256_cmpgt_epi64(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(aFirst + i)), value);
+            result += 4u - std::popcount(static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(greater))));
+        }
+        return result + fake_simd_count_not_greater(aFirst + i, aCount - i, aValue);
     }
 #endif
 
-    inline void fake_simd_srand(uint32_t seed)
+    template <typename T>
+    inline std::size_t simd_count_not_greater(T const* aFirst, std::size_t aCount, T aValue)
     {
-        std::srand(seed);
+        return fake_simd_count_not_greater(aFirst, aCount, aValue);
     }
 
-#if defined(USE_EMM)
-    #define simd_srand emm_simd_srand
-#elif defined(USE_EMM_DYNAMIC)
-    inline void simd_srand(uint32_t seed)
+    inline std::size_t simd_count_not_greater(double const* aFirst, std::size_t aCount, double aValue)
     {
-        if (use_simd())
-            emm_simd_srand(seed);
-        else
-            fake_simd_srand(seed);
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        return emm_simd_count_not_greater(aFirst, aCount, aValue);
+#else
+        return fake_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+    }
+
+    inline std::size_t simd_count_not_greater(float const* aFirst, std::size_t aCount, float aValue)
+    {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        return emm_simd_count_not_greater(aFirst, aCount, aValue);
+#else
+        return fake_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
     }
+
+    inline std::size_t simd_count_not_greater(int32_t const* aFirst, std::size_t aCount, int32_t aValue)
+    {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        return emm_simd_count_not_greater(aFirst, aCount, aValue);
 #else
-    #define simd_srand fake_simd_srand
+        return fake_simd_count_not_greater(aFirst, aCount, aValue);
 #endif
-        
-    inline void simd_srand(std::thread::id seed)
+    }
+
+    inline std::size_t simd_count_not_greater(int64_t const* aFirst, std::size_t aCount, int64_t aValue)
     {
-        simd_srand(static_cast<uint32_t>(std::hash<std::thread::id>{}(seed)));
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_count_not_greater(aFirst, aCount, aValue);
+#endif
+        return fake_simd_count_not_greater(aFirst, aCount, aValue);
+    }
+
+    // 4x4 matrix kernels. Matrices are 16 contiguous elements in column-major order; a result element is
+    // accumulated as ((m0 * x + m1 * y) + m2 * z) + m3 * w.
+
+    inline void fake_simd_mat44_mul(double const* aLeft, double const* aRight, double* aResult)
+    {
+        double result[16];
+        for (std::size_t column = 0u; column < 4u; ++column)
+            for (std::size_t row = 0u; row < 4u; ++row)
+                result[column * 4u + row] = fake_simd_fma_4d(aLeft[row], aRight[column * 4u], aLeft[4u + row], aRight[column * 4u + 1u], 
+                    aLeft[8u + row], aRight[column * 4u + 2u], aLeft[12u + row], aRight[column * 4u + 3u]);
+        std::copy(std::begin(result), std::end(result), aResult);
+    }
+
+    // transforms the points (x, y, z, 1) found every aStride elements of aInput writing (x', y', z') to the same offsets in aOutput;
+    // aOutput may equal aInput
+    inline void fake_simd_mat44_transform_3d(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride)
+    {
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += aStride, aOutput += aStride)
+        {
+            double const x = aInput[0u];
+            double const y = aInput[1u];
+            double const z = aInput[2u];
+            for (std::size_t row = 0u; row < 3u; ++row)
+                aOutput[row] = ((aMatrix[row] * x + aMatrix[4u + row] * y) + aMatrix[8u + row] * z) + aMatrix[12u + row];
+        }
+    }
+
+    inline void fake_simd_mat44_transform_4d(double const* aMatrix, double const* aInput, double* aOutput)
+    {
+        double const x = aInput[0u];
+        double const y = aInput[1u];
+        double const z = aInput[2u];
+        double const w = aInput[3u];
+        for (std::size_t row = 0u; row < 4u; ++row)
+            aOutput[row] = ((aMatrix[row] * x + aMatrix[4u + row] * y) + aMatrix[8u + row] * z) + aMatrix[12u + row] * w;
+    }
+
+    // transforms the axis aligned boxes (min x, min y, min z, max x, max y, max z) found every aStride elements of aInput
+    // by the affine part of aMatrix; the result is exactly the bounds of the eight transformed corners
+    inline void fake_simd_mat44_transform_aabb(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride)
+    {
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += aStride, aOutput += aStride)
+        {
+            double const box[6] = { aInput[0u], aInput[1u], aInput[2u], aInput[3u], aInput[4u], aInput[5u] };
+            for (std::size_t row = 0u; row < 3u; ++row)
+            {
+                double low = 0.0;
+                double high = 0.0;
+                for (std::size_t axis = 0u; axis < 3u; ++axis)
+                {
+                    double const a = aMatrix[axis * 4u + row] * box[axis];
+                    double const b = aMatrix[axis * 4u + row] * box[3u + axis];
+                    low = axis == 0u ? std::min(a, b) : low + std::min(a, b);
+                    high = axis == 0u ? std::max(a, b) : high + std::max(a, b);
+                }
+                aOutput[row] = low + aMatrix[12u + row];
+                aOutput[3u + row] = high + aMatrix[12u + row];
+            }
+        }
+    }
+
+    inline void fake_simd_mat44f_transform_4f(float const* aMatrix, float const* aInput, float* aOutput, std::size_t aCount)
+    {
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += 4u, aOutput += 4u)
+        {
+            float const x = aInput[0u];
+            float const y = aInput[1u];
+            float const z = aInput[2u];
+            float const w = aInput[3u];
+            for (std::size_t row = 0u; row < 4u; ++row)
+                aOutput[row] = ((aMatrix[row] * x + aMatrix[4u + row] * y) + aMatrix[8u + row] * z) + aMatrix[12u + row] * w;
+        }
     }
 
 #if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
-    inline uint32_t emm_simd_rand()
+    inline void emm_simd_mat44_mul(double const* aLeft, double const* aRight, double* aResult)
     {
-        thread_local std::array<uint32_t, 4> result = {};
-        thread_local std::size_t resultCounter = 4;
-        if (resultCounter < 4)
-            return result[resultCounter++];
-        alignas(16) __m128i cur_seed_split;
-        alignas(16) __m128i multiplier;
-        alignas(16) __m128i adder;
-        alignas(16) __m128i mod_mask;
-        alignas(16) __m128i sra_mask;
-        alignas(16) __m128i ans;
-        alignas(16) static const uint32_t mult[4] =
-        { 214013, 17405, 214013, 69069 };
-        alignas(16) static const uint32_t gadd[4] =
-        { 2531011, 10395331, 13737667, 1 };
-        alignas(16) static const uint32_t mask[4] =
-        { 0xFFFFFFFF, 0, 0xFFFFFFFF, 0 };
-        alignas(16) static const uint32_t masklo[4] =
-        { 0x00007FFF, 0x00007FFF, 0x00007FFF, 0x00007FFF };
+        __m128d const l0 = _mm_loadu_pd(aLeft), l1 = _mm_loadu_pd(aLeft + 2u);
+        __m128d const l2 = _mm_loadu_pd(aLeft + 4u), l3 = _mm_loadu_pd(aLeft + 6u);
+        __m128d const l4 = _mm_loadu_pd(aLeft + 8u), l5 = _mm_loadu_pd(aLeft + 10u);
+        __m128d const l6 = _mm_loadu_pd(aLeft + 12u), l7 = _mm_loadu_pd(aLeft + 14u);
+        __m128d result[8];
+        for (std::size_t column = 0u; column < 4u; ++column)
+        {
+            __m128d const x = _mm_set1_pd(aRight[column * 4u]);
+            __m128d const y = _mm_set1_pd(aRight[column * 4u + 1u]);
+            __m128d const z = _mm_set1_pd(aRight[column * 4u + 2u]);
+            __m128d const w = _mm_set1_pd(aRight[column * 4u + 3u]);
+            result[column * 2u] = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(l0, x), _mm_mul_pd(l2, y)), _mm_mul_pd(l4, z)), _mm_mul_pd(l6, w));
+            result[column * 2u + 1u] = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(l1, x), _mm_mul_pd(l3, y)), _mm_mul_pd(l5, z)), _mm_mul_pd(l7, w));
+        }
+        for (std::size_t i = 0u; i < 8u; ++i)
+            _mm_storeu_pd(aResult + i * 2u, result[i]);
+    }
 
-        adder = _mm_load_si128((__m128i*) gadd);
-        multiplier = _mm_load_si128((__m128i*) mult);
-        mod_mask = _mm_load_si128((__m128i*) mask);
-        sra_mask = _mm_load_si128((__m128i*) masklo);
+    inline void emm_simd_mat44_transform_3d(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride)
+    {
+        __m128d const c0 = _mm_loadu_pd(aMatrix), c1 = _mm_loadu_pd(aMatrix + 4u), c2 = _mm_loadu_pd(aMatrix + 8u), c3 = _mm_loadu_pd(aMatrix + 12u);
+        __m128d const c0z = _mm_load_sd(aMatrix + 2u), c1z = _mm_load_sd(aMatrix + 6u), c2z = _mm_load_sd(aMatrix + 10u), c3z = _mm_load_sd(aMatrix + 14u);
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += aStride, aOutput += aStride)
+        {
+            __m128d const x = _mm_set1_pd(aInput[0u]);
+            __m128d const y = _mm_set1_pd(aInput[1u]);
+            __m128d const z = _mm_set1_pd(aInput[2u]);
+            __m128d const xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0, x), _mm_mul_pd(c1, y)), _mm_mul_pd(c2, z)), c3);
+            __m128d const zz = _mm_add_sd(_mm_add_sd(_mm_add_sd(_mm_mul_sd(c0z, x), _mm_mul_sd(c1z, y)), _mm_mul_sd(c2z, z)), c3z);
+            _mm_storeu_pd(aOutput, xy);
+            _mm_store_sd(aOutput + 2u, zz);
+        }
+    }
 
-        cur_seed_split = _mm_shuffle_epi32(detail::simd_rand_seed(), _MM_SHUFFLE(2, 3, 0, 1));
+    inline void emm_simd_mat44_transform_4d(double const* aMatrix, double const* aInput, double* aOutput)
+    {
+        __m128d const x = _mm_set1_pd(aInput[0u]);
+        __m128d const y = _mm_set1_pd(aInput[1u]);
+        __m128d const z = _mm_set1_pd(aInput[2u]);
+        __m128d const w = _mm_set1_pd(aInput[3u]);
+        __m128d const low = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(aMatrix), x), _mm_mul_pd(_mm_loadu_pd(aMatrix + 4u), y)), 
+            _mm_mul_pd(_mm_loadu_pd(aMatrix + 8u), z)), _mm_mul_pd(_mm_loadu_pd(aMatrix + 12u), w));
+        __m128d const high = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(aMatrix + 2u), x), _mm_mul_pd(_mm_loadu_pd(aMatrix + 6u), y)), 
+            _mm_mul_pd(_mm_loadu_pd(aMatrix + 10u), z)), _mm_mul_pd(_mm_loadu_pd(aMatrix + 14u), w));
+        _mm_storeu_pd(aOutput, low);
+        _mm_storeu_pd(aOutput + 2u, high);
+    }
 
-        detail::simd_rand_seed() = _mm_mul_epu32(detail::simd_rand_seed(), multiplier);
+    inline void emm_simd_mat44f_transform_4f(float const* aMatrix, float const* aInput, float* aOutput, std::size_t aCount)
+    {
+        __m128 const c0 = _mm_loadu_ps(aMatrix), c1 = _mm_loadu_ps(aMatrix + 4u), c2 = _mm_loadu_ps(aMatrix + 8u), c3 = _mm_loadu_ps(aMatrix + 12u);
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += 4u, aOutput += 4u)
+        {
+            __m128 const v = _mm_loadu_ps(aInput);
+            __m128 const result = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(c0, _mm_shuffle_ps(v, v, 0x00)), _mm_mul_ps(c1, _mm_shuffle_ps(v, v, 0x55))),
+                _mm_mul_ps(c2, _mm_shuffle_ps(v, v, 0xAA))), _mm_mul_ps(c3, _mm_shuffle_ps(v, v, 0xFF)));
+            _mm_storeu_ps(aOutput, result);
+        }
+    }
+#endif
 
-        multiplier = _mm_shuffle_epi32(multiplier, _MM_SHUFFLE(2, 3, 0, 1));
-        cur_seed_split = _mm_mul_epu32(cur_seed_split, multiplier);
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+    NEOLIB_AVX2_TARGET inline void avx2_simd_mat44_mul(double const* aLeft, double const* aRight, double* aResult)
+    {
+        __m256d const c0 = _mm256_loadu_pd(aLeft), c1 = _mm256_loadu_pd(aLeft + 4u), c2 = _mm256_loadu_pd(aLeft + 8u), c3 = _mm256_loadu_pd(aLeft + 12u);
+        __m256d result[4];
+        for (std::size_t column = 0u; column < 4u; ++column)
+            result[column] = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(c0, _mm256_broadcast_sd(aRight + column * 4u)), _mm256_mul_pd(c1, _mm256_broadcast_sd(aRight + column * 4u + 1u))),
+                _mm256_mul_pd(c2, _mm256_broadcast_sd(aRight + column * 4u + 2u))), _mm256_mul_pd(c3, _mm256_broadcast_sd(aRight + column * 4u + 3u)));
+        for (std::size_t column = 0u; column < 4u; ++column)
+            _mm256_storeu_pd(aResult + column * 4u, result[column]);
+    }
 
-        detail::simd_rand_seed() = _mm_and_si128(detail::simd_rand_seed(), mod_mask);
+    NEOLIB_AVX2_TARGET inline void avx2_simd_mat44_transform_3d(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride)
+    {
+        __m256d const c0 = _mm256_loadu_pd(aMatrix), c1 = _mm256_loadu_pd(aMatrix + 4u), c2 = _mm256_loadu_pd(aMatrix + 8u), c3 = _mm256_loadu_pd(aMatrix + 12u);
+        __m256i const xyz = _mm256_set_epi64x(0, -1, -1, -1);
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += aStride, aOutput += aStride)
+        {
+            __m256d const result = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(c0, _mm256_broadcast_sd(aInput)), _mm256_mul_pd(c1, _mm256_broadcast_sd(aInput + 1u))),
+                _mm256_mul_pd(c2, _mm256_broadcast_sd(aInput + 2u))), c3);
+            _mm256_maskstore_pd(aOutput, xyz, result);
+        }
+    }
 
-        cur_seed_split = _mm_and_si128(cur_seed_split, mod_mask);
-        cur_seed_split = _mm_shuffle_epi32(cur_seed_split, _MM_SHUFFLE(2, 3, 0, 1));
+    NEOLIB_AVX2_TARGET inline void avx2_simd_mat44_transform_4d(double const* aMatrix, double const* aInput, double* aOutput)
+    {
+        __m256d const result = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(_mm256_loadu_pd(aMatrix), _mm256_broadcast_sd(aInput)), _mm256_mul_pd(_mm256_loadu_pd(aMatrix + 4u), _mm256_broadcast_sd(aInput + 1u))),
+            _mm256_mul_pd(_mm256_loadu_pd(aMatrix + 8u), _mm256_broadcast_sd(aInput + 2u))), _mm256_mul_pd(_mm256_loadu_pd(aMatrix + 12u), _mm256_broadcast_sd(aInput + 3u)));
+        _mm256_storeu_pd(aOutput, result);
+    }
 
-        detail::simd_rand_seed() = _mm_or_si128(detail::simd_rand_seed(), cur_seed_split);
-        detail::simd_rand_seed() = _mm_add_epi32(detail::simd_rand_seed(), adder);
+    NEOLIB_AVX2_TARGET inline void avx2_simd_mat44_transform_aabb(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride)
+    {
+        __m256d const c0 = _mm256_loadu_pd(aMatrix), c1 = _mm256_loadu_pd(aMatrix + 4u), c2 = _mm256_loadu_pd(aMatrix + 8u), c3 = _mm256_loadu_pd(aMatrix + 12u);
+        __m256i const xyz = _mm256_set_epi64x(0, -1, -1, -1);
+        for (std::size_t i = 0u; i < aCount; ++i, aInput += aStride, aOutput += aStride)
+        {
+            __m256d const ax = _mm256_mul_pd(c0, _mm256_broadcast_sd(aInput)), bx = _mm256_mul_pd(c0, _mm256_broadcast_sd(aInput + 3u));
+            __m256d const ay = _mm256_mul_pd(c1, _mm256_broadcast_sd(aInput + 1u)), by = _mm256_mul_pd(c1, _mm256_broadcast_sd(aInput + 4u));
+            __m256d const az = _mm256_mul_pd(c2, _mm256_broadcast_sd(aInput + 2u)), bz = _mm256_mul_pd(c2, _mm256_broadcast_sd(aInput + 5u));
+            __m256d const low = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_min_pd(ax, bx), _mm256_min_pd(ay, by)), _mm256_min_pd(az, bz)), c3);
+            __m256d const high = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_max_pd(ax, bx), _mm256_max_pd(ay, by)), _mm256_max_pd(az, bz)), c3);
+            _mm256_maskstore_pd(aOutput, xyz, low);
+            _mm256_maskstore_pd(aOutput + 3u, xyz, high);
+        }
+    }
+
+    NEOLIB_AVX2_TARGET inline void avx2_simd_mat44f_transform_4f(float const* aMatrix, float const* aInput, float* aOutput, std::size_t aCount)
+    {
+        __m256 const c0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(aMatrix));
+        __m256 const c1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(aMatrix + 4u));
+        __m256 const c2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(aMatrix + 8u));
+        __m256 const c3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(aMatrix + 12u));
+        std::size_t i = 0u;
+        for (; i + 2u <= aCount; i += 2u, aInput += 8u, aOutput += 8u)
+        {
+            __m256 const v = _mm256_loadu_ps(aInput);
+            __m256 const result = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(c0, _mm256_shuffle_ps(v, v, 0x00)), _mm256_mul_ps(c1, _mm256_shuffle_ps(v, v, 0x55))),
+                _mm256_mul_ps(c2, _mm256_shuffle_ps(v, v, 0xAA))), _mm256_mul_ps(c3, _mm256_shuffle_ps(v, v, 0xFF)));
+            _mm256_storeu_ps(aOutput, result);
+        }
+        if (i < aCount)
+        {
+            __m128 const v = _mm_loadu_ps(aInput);
+            __m128 const result = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm256_castps256_ps128(c0), _mm_shuffle_ps(v, v, 0x00)), _mm_mul_ps(_mm256_castps256_ps128(c1), _mm_shuffle_ps(v, v, 0x55))),
+                _mm_mul_ps(_mm256_castps256_ps128(c2), _mm_shuffle_ps(v, v, 0xAA))), _mm_mul_ps(_mm256_castps256_ps128(c3), _mm_shuffle_ps(v, v, 0xFF)));
+            _mm_storeu_ps(aOutput, result);
+        }
+    }
 
-        _mm_storeu_si128(&ans, detail::simd_rand_seed());
-        result = { to_scalar(ans, 0), to_scalar(ans, 1), to_scalar(ans, 2), to_scalar(ans, 3) };
-        resultCounter = 0;
-        return result[resultCounter];
+    // the AVX-512 kernels process two double precision points/boxes or four single precision vectors per iteration with
+    // the matrix columns duplicated across the register halves (or quarters); they multiply and add separately, in the
+    // same order as the other paths, rather than fuse so every path gives bit identical results
+    NEOLIB_AVX512_TARGET inline void avx512_simd_mat44_transform_3d(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount)
+    {
+        __m512d const c0 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix)), c1 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix + 4u));
+        __m512d const c2 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix + 8u)), c3 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix + 12u));
+        __m512i const xIndex = _mm512_set_epi64(3, 3, 3, 3, 0, 0, 0, 0);
+        __m512i const yIndex = _mm512_set_epi64(4, 4, 4, 4, 1, 1, 1, 1);
+        __m512i const zIndex = _mm512_set_epi64(5, 5, 5, 5, 2, 2, 2, 2);
+        std::size_t i = 0u;
+        for (; i + 2u <= aCount; i += 2u, aInput += 6u, aOutput += 6u)
+        {
+            __m512d const v = _mm512_maskz_loadu_pd(0x3F, aInput);
+            __m512d const result = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(
+                _mm512_mul_pd(c0, _mm512_permutexvar_pd(xIndex, v)), _mm512_mul_pd(c1, _mm512_permutexvar_pd(yIndex, v))),
+                _mm512_mul_pd(c2, _mm512_permutexvar_pd(zIndex, v))), c3);
+            _mm512_mask_compressstoreu_pd(aOutput, 0x77, result);
+        }
+        if (i < aCount)
+        {
+            __m512d const v = _mm512_maskz_loadu_pd(0x07, aInput);
+            __m512d const result = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(
+                _mm512_mul_pd(c0, _mm512_permutexvar_pd(xIndex, v)), _mm512_mul_pd(c1, _mm512_permutexvar_pd(yIndex, v))),
+                _mm512_mul_pd(c2, _mm512_permutexvar_pd(zIndex, v))), c3);
+            _mm512_mask_storeu_pd(aOutput, 0x07, result);
+        }
+    }
+
+    NEOLIB_AVX512_TARGET inline void avx512_simd_mat44_transform_aabb(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount)
+    {
+        __m512d const c0 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix)), c1 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix + 4u));
+        __m512d const c2 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix + 8u)), c3 = _mm512_broadcast_f64x4(_mm256_loadu_pd(aMatrix + 12u));
+        // indices into the twelve doubles of two consecutive boxes (first register then second)
+        __m512i const minX = _mm512_set_epi64(6, 6, 6, 6, 0, 0, 0, 0), maxX = _mm512_set_epi64(9, 9, 9, 9, 3, 3, 3, 3);
+        __m512i const minY = _mm512_set_epi64(7, 7, 7, 7, 1, 1, 1, 1), maxY = _mm512_set_epi64(10, 10, 10, 10, 4, 4, 4, 4);
+        __m512i const minZ = _mm512_set_epi64(8, 8, 8, 8, 2, 2, 2, 2), maxZ = _mm512_set_epi64(11, 11, 11, 11, 5, 5, 5, 5);
+        // low/high halves back to (min, max) box layout
+        __m512i const firstOut = _mm512_set_epi64(5, 4, 10, 9, 8, 2, 1, 0);
+        __m512i const secondOut = _mm512_set_epi64(0, 0, 0, 0, 14, 13, 12, 6);
+        std::size_t i = 0u;
+        for (; i + 2u <= aCount; i += 2u, aInput += 12u, aOutput += 12u)
+        {
+            __m512d const v0 = _mm512_loadu_pd(aInput);
+            __m512d const v1 = _mm512_maskz_loadu_pd(0x0F, aInput + 8u);
+            __m512d const ax = _mm512_mul_pd(c0, _mm512_permutex2var_pd(v0, minX, v1)), bx = _mm512_mul_pd(c0, _mm512_permutex2var_pd(v0, maxX, v1));
+            __m512d const ay = _mm512_mul_pd(c1, _mm512_permutex2var_pd(v0, minY, v1)), by = _mm512_mul_pd(c1, _mm512_permutex2var_pd(v0, maxY, v1));
+            __m512d const az = _mm512_mul_pd(c2, _mm512_permutex2var_pd(v0, minZ, v1)), bz = _mm512_mul_pd(c2, _mm512_permutex2var_pd(v0, maxZ, v1));
+            __m512d const low = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_min_pd(ax, bx), _mm512_min_pd(ay, by)), _mm512_min_pd(az, bz)), c3);
+            __m512d const high = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_max_pd(ax, bx), _mm512_max_pd(ay, by)), _mm512_max_pd(az, bz)), c3);
+            _mm512_storeu_pd(aOutput, _mm512_permutex2var_pd(low, firstOut, high));
+            _mm512_mask_storeu_pd(aOutput + 8u, 0x0F, _mm512_permutex2var_pd(low, secondOut, high));
+        }
+        if (i < aCount)
+            avx2_simd_mat44_transform_aabb(aMatrix, aInput, aOutput, aCount - i, 6u);
+    }
+
+    NEOLIB_AVX512_TARGET inline void avx512_simd_mat44f_transform_4f(float const* aMatrix, float const* aInput, float* aOutput, std::size_t aCount)
+    {
+        __m512 const c0 = _mm512_broadcast_f32x4(_mm_loadu_ps(aMatrix)), c1 = _mm512_broadcast_f32x4(_mm_loadu_ps(aMatrix + 4u));
+        __m512 const c2 = _mm512_broadcast_f32x4(_mm_loadu_ps(aMatrix + 8u)), c3 = _mm512_broadcast_f32x4(_mm_loadu_ps(aMatrix + 12u));
+        for (std::size_t i = 0u; i < aCount; i += 4u, aInput += 16u, aOutput += 16u)
+        {
+            __mmask16 const mask = aCount - i >= 4u ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << ((aCount - i) * 4u)) - 1u);
+            __m512 const v = _mm512_maskz_loadu_ps(mask, aInput);
+            __m512 const result = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+                _mm512_mul_ps(c0, _mm512_permute_ps(v, 0x00)), _mm512_mul_ps(c1, _mm512_permute_ps(v, 0x55))),
+                _mm512_mul_ps(c2, _mm512_permute_ps(v, 0xAA))), _mm512_mul_ps(c3, _mm512_permute_ps(v, 0xFF)));
+            _mm512_mask_storeu_ps(aOutput, mask, result);
+        }
     }
 #endif
 
-    inline uint32_t fake_simd_rand()
+    inline void simd_mat44_mul(double const* aLeft, double const* aRight, double* aResult)
     {
-        thread_local std::array<uint32_t, 4> result = {};
-        thread_local std::size_t resultCounter = 4;
-        if (resultCounter < 4)
-            return result[resultCounter++];
-        result = { static_cast<uint32_t>(std::rand()), static_cast<uint32_t>(std::rand()), static_cast<uint32_t>(std::rand()), static_cast<uint32_t>(std::rand()) };
-        resultCounter = 0;
-        return result[resultCounter];
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_mat44_mul(aLeft, aRight, aResult);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_mat44_mul(aLeft, aRight, aResult);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        emm_simd_mat44_mul(aLeft, aRight, aResult);
+#else
+        fake_simd_mat44_mul(aLeft, aRight, aResult);
+#endif
     }
 
-#if defined(USE_EMM)
-    #define simd_rand emm_simd_rand
-#elif defined(USE_EMM_DYNAMIC)
-    inline uint32_t simd_rand()
+    inline void simd_mat44_transform_3d(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride = 3u)
     {
-        if (use_simd())
-            return emm_simd_rand();
-        else
-            return fake_simd_rand();
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_mat44_transform_3d(aMatrix, aInput, aOutput, aCount, aStride);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (aStride == 3u && avx512_supported())
+            return avx512_simd_mat44_transform_3d(aMatrix, aInput, aOutput, aCount);
+        if (avx2_supported())
+            return avx2_simd_mat44_transform_3d(aMatrix, aInput, aOutput, aCount, aStride);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        emm_simd_mat44_transform_3d(aMatrix, aInput, aOutput, aCount, aStride);
+#else
+        fake_simd_mat44_transform_3d(aMatrix, aInput, aOutput, aCount, aStride);
+#endif
     }
+
+    inline void simd_mat44_transform_4d(double const* aMatrix, double const* aInput, double* aOutput)
+    {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_mat44_transform_4d(aMatrix, aInput, aOutput);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx2_supported())
+            return avx2_simd_mat44_transform_4d(aMatrix, aInput, aOutput);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        emm_simd_mat44_transform_4d(aMatrix, aInput, aOutput);
 #else
-    #define simd_rand fake_simd_srand
+        fake_simd_mat44_transform_4d(aMatrix, aInput, aOutput);
 #endif
+    }
 
-    template <typename T>
-    inline T simd_rand(T aUpper)
+    inline void simd_mat44_transform_aabb(double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t aStride = 6u)
     {
-        return static_cast<T>(simd_rand() % static_cast<uint32_t>(aUpper));
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_mat44_transform_aabb(aMatrix, aInput, aOutput, aCount, aStride);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (aStride == 6u && aCount > 1u && avx512_supported())
+            return avx512_simd_mat44_transform_aabb(aMatrix, aInput, aOutput, aCount);
+        if (avx2_supported())
+            return avx2_simd_mat44_transform_aabb(aMatrix, aInput, aOutput, aCount, aStride);
+#endif
+        fake_simd_mat44_transform_aabb(aMatrix, aInput, aOutput, aCount, aStride);
+    }
+
+    inline void simd_mat44f_transform_4f(float const* aMatrix, float const* aInput, float* aOutput, std::size_t aCount)
+    {
+#if defined(USE_AVX_DYNAMIC) || defined(USE_EMM_DYNAMIC)
+        if (!use_simd())
+            return fake_simd_mat44f_transform_4f(aMatrix, aInput, aOutput, aCount);
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (avx512_supported())
+            return avx512_simd_mat44f_transform_4f(aMatrix, aInput, aOutput, aCount);
+        if (avx2_supported())
+            return avx2_simd_mat44f_transform_4f(aMatrix, aInput, aOutput, aCount);
+#endif
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        emm_simd_mat44f_transform_4f(aMatrix, aInput, aOutput, aCount);
+#else
+        fake_simd_mat44f_transform_4f(aMatrix, aInput, aOutput, aCount);
+#endif
     }
 }
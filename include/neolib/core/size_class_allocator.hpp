@@ -0,0 +1,543 @@
+// size_class_allocator.hpp
+/*
+ *  Copyright (c) 2020 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <ostream>
+
+namespace neolib
+{
+    struct size_class_statistics
+    {
+        std::size_t block_size;
+        std::size_t magazine_size;
+        std::size_t spans;
+        std::size_t reserved;       // bytes obtained from the system for this size class
+        std::size_t capacity;       // blocks carved from spans so far
+        std::size_t in_use;
+        std::size_t thread_cached;  // free blocks held in per-thread magazines
+        std::size_t depot;          // free blocks held in the shared depot
+
+        double occupancy() const
+        {
+            return capacity != 0 ? static_cast<double>(in_use) / capacity : 0.0;
+        }
+        // fraction of reserved memory that is not holding a live block
+        double fragmentation() const
+        {
+            return reserved != 0 ? 1.0 - static_cast<double>(in_use * block_size) / reserved : 0.0;
+        }
+    };
+
+    template <typename CharT, typename Traits>
+    inline std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& aStream, const size_class_statistics& aStatistics)
+    {
+        aStream << aStatistics.block_size << " bytes: "
+            << aStatistics.spans << " span(s), "
+            << aStatistics.in_use << "/" << aStatistics.capacity << " in use (" << static_cast<uint32_t>(aStatistics.occupancy() * 100.0) << "%), "
+            << aStatistics.thread_cached << " thread cached, "
+            << aStatistics.depot << " in depot, "
+            << static_cast<uint32_t>(aStatistics.fragmentation() * 100.0) << "% fragmentation";
+        return aStream;
+    }
+
+    namespace size_class_detail
+    {
+        constexpr std::size_t granularity = 16u;
+        constexpr std::size_t max_block_size = 4096u;
+        constexpr std::size_t size_class_count = 28u;
+
+        constexpr std::array<std::size_t, size_class_count> block_sizes()
+        {
+            // 16 byte steps up to 128 bytes then four steps per power of two
+            std::array<std::size_t, size_class_count> result = {};
+            std::size_t index = 0u;
+            for (std::size_t size = granularity; size <= 128u; size += granularity)
+                result[index++] = size;
+            for (std::size_t base = 128u; base < max_block_size; base *= 2u)
+                for (std::size_t step = 1u; step <= 4u; ++step)
+                    result[index++] = base + step * base / 4u;
+            return result;
+        }
+
+        constexpr std::array<std::uint8_t, max_block_size / granularity + 1u> size_class_lookup()
+        {
+            std::array<std::uint8_t, max_block_size / granularity + 1u> result = {};
+            std::size_t sizeClass = 0u;
+            for (std::size_t index = 0u; index < result.size(); ++index)
+            {
+                while (block_sizes()[sizeClass] < index * granularity)
+                    ++sizeClass;
+                result[index] = static_cast<std::uint8_t>(sizeClass);
+            }
+            return result;
+        }
+
+        inline constexpr std::array<std::size_t, size_class_count> sBlockSizes = block_sizes();
+        inline constexpr std::array<std::uint8_t, max_block_size / granularity + 1u> sSizeClassLookup = size_class_lookup();
+    }
+
+    // Thread-aware pool of fixed size classes. Each thread allocates from and frees to its own pair of magazines
+    // per size class without locking; full magazines move to and from a shared depot in batches. A magazine
+    // returned to the depot, and any block freed by a thread whose cache has been torn down, is pushed lock-free;
+    // only taking a batch from the depot (or carving a new one from a span) locks the size class.
+    class size_class_pool
+    {
+    public:
+        static constexpr std::size_t granularity = size_class_detail::granularity;
+        static constexpr std::size_t max_block_size = size_class_detail::max_block_size;
+        static constexpr std::size_t span_size = 64u * 1024u;
+        static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__ < granularity ? __STDCPP_DEFAULT_NEW_ALIGNMENT__ : granularity;
+        static constexpr std::size_t size_class_count = size_class_detail::size_class_count;
+    private:
+        struct link { link* iNext; };
+        struct magazine { link* iNext; magazine* iNextMagazine; };
+        static_assert(sizeof(magazine) <= granularity);
+    public:
+        static constexpr bool is_pooled(std::size_t aSize, std::size_t aAlignment = alignment)
+        {
+            return aSize <= max_block_size && aAlignment <= alignment;
+        }
+        static constexpr std::size_t size_class(std::size_t aSize)
+        {
+            return size_class_detail::sSizeClassLookup[(aSize + granularity - 1u) / granularity];
+        }
+        static constexpr std::size_t block_size(std::size_t aSizeClass)
+        {
+            return size_class_detail::sBlockSizes[aSizeClass];
+        }
+        static constexpr std::size_t magazine_size(std::size_t aSizeClass)
+        {
+            return std::clamp<std::size_t>(16u * 1024u / block_size(aSizeClass), 8u, 128u);
+        }
+    private:
+        struct alignas(64) bin
+        {
+            mutable std::mutex mutex;
+            std::atomic<magazine*> full = nullptr;
+            std::atomic<link*> orphans = nullptr;
+            std::atomic<std::size_t> fullCount = 0u;
+            std::atomic<std::size_t> orphanCount = 0u;
+            std::vector<void*> spans;
+            char* carve = nullptr;
+            char* carveEnd = nullptr;
+            std::size_t capacity = 0u;
+        };
+        class thread_cache
+        {
+        private:
+            struct bin
+            {
+                link* loaded = nullptr;
+                std::size_t loadedCount = 0u;
+                link* previous = nullptr;
+                std::atomic<std::size_t> cached = 0u;
+            };
+        public:
+            thread_cache(size_class_pool& aPool) :
+                iPool{ aPool }
+            {
+                iPool.register_cache(*this);
+            }
+            ~thread_cache()
+            {
+                for (std::size_t sizeClass = 0u; sizeClass < size_class_count; ++sizeClass)
+                {
+                    auto& b = iBins[sizeClass];
+                    if (b.loaded != nullptr)
+                    {
+                        if (b.loadedCount == magazine_size(sizeClass))
+                            iPool.give_magazine(sizeClass, b.loaded);
+                        else
+                            iPool.give_orphans(sizeClass, b.loaded, b.loadedCount);
+                    }
+                    if (b.previous != nullptr)
+                        iPool.give_magazine(sizeClass, b.previous);
+                    b.loaded = nullptr;
+                    b.loadedCount = 0u;
+                    b.previous = nullptr;
+                    b.cached.store(0u, std::memory_order_relaxed);
+                }
+                iPool.unregister_cache(*this);
+                tRetired = true;
+            }
+        public:
+            void* allocate(std::size_t aSizeClass)
+            {
+                auto& b = iBins[aSizeClass];
+                if (b.loaded == nullptr)
+                {
+                    if (b.previous != nullptr)
+                    {
+                        b.loaded = b.previous;
+                        b.loadedCount = magazine_size(aSizeClass);
+                        b.previous = nullptr;
+                    }
+                    else
+                        b.loadedCount = iPool.take(aSizeClass, b.loaded);
+                }
+                link* result = b.loaded;
+                b.loaded = result->iNext;
+                --b.loadedCount;
+                publish(aSizeClass, b);
+                return result;
+            }
+            void deallocate(void* aBlock, std::size_t aSizeClass)
+            {
+                auto& b = iBins[aSizeClass];
+                if (b.loadedCount == magazine_size(aSizeClass))
+                {
+                    if (b.previous != nullptr)
+                        iPool.give_magazine(aSizeClass, b.previous);
+                    b.previous = b.loaded;
+                    b.loaded = nullptr;
+                    b.loadedCount = 0u;
+                }
+                link* block = static_cast<link*>(aBlock);
+                block->iNext = b.loaded;
+                b.loaded = block;
+                ++b.loadedCount;
+                publish(aSizeClass, b);
+            }
+            std::size_t cached(std::size_t aSizeClass) const
+            {
+                return iBins[aSizeClass].cached.load(std::memory_order_relaxed);
+            }
+        private:
+            static void publish(std::size_t aSizeClass, bin& aBin)
+            {
+                aBin.cached.store(aBin.loadedCount + (aBin.previous != nullptr ? magazine_size(aSizeClass) : 0u), std::memory_order_relaxed);
+            }
+        private:
+            size_class_pool& iPool;
+            std::array<bin, size_class_count> iBins;
+        };
+        // construction
+    private:
+        size_class_pool()
+        {
+        }
+    public:
+        ~size_class_pool()
+        {
+            for (auto& b : iBins)
+                for (auto span : b.spans)
+                    ::operator delete(span);
+        }
+        size_class_pool(const size_class_pool&) = delete;
+        size_class_pool& operator=(const size_class_pool&) = delete;
+    public:
+        static size_class_pool& instance()
+        {
+            static size_class_pool sInstance;
+            return sInstance;
+        }
+        // operations
+    public:
+        void* allocate(std::size_t aSize)
+        {
+            auto const sizeClass = size_class(aSize);
+            if (auto cache = local_cache())
+                return cache->allocate(sizeClass);
+            return allocate_direct(sizeClass);
+        }
+        void deallocate(void* aBlock, std::size_t aSize)
+        {
+            auto const sizeClass = size_class(aSize);
+            if (auto cache = local_cache())
+                cache->deallocate(aBlock, sizeClass);
+            else
+                give_orphans(sizeClass, static_cast<link*>(aBlock), 1u);
+        }
+    public:
+        size_class_statistics statistics(std::size_t aSizeClass) const
+        {
+            size_class_statistics result = {};
+            result.block_size = block_size(aSizeClass);
+            result.magazine_size = magazine_size(aSizeClass);
+            auto const& b = iBins[aSizeClass];
+            {
+                std::lock_guard<std::mutex> lock{ b.mutex };
+                result.spans = b.spans.size();
+                result.reserved = result.spans * span_size;
+                result.capacity = b.capacity - static_cast<std::size_t>(b.carveEnd - b.carve) / result.block_size;
+                result.depot = b.fullCount.load(std::memory_order_relaxed) * result.magazine_size + b.orphanCount.load(std::memory_order_relaxed);
+            }
+            {
+                std::lock_guard<std::mutex> lock{ iCachesMutex };
+                for (auto cache : iCaches)
+                    result.thread_cached += cache->cached(aSizeClass);
+            }
+            // counters are sampled while other threads continue so clamp rather than underflow
+            result.in_use = result.capacity - std::min(result.capacity, result.thread_cached + result.depot);
+            return result;
+        }
+        std::vector<size_class_statistics> statistics() const
+        {
+            std::vector<size_class_statistics> result;
+            for (std::size_t sizeClass = 0u; sizeClass < size_class_count; ++sizeClass)
+                if (auto const s = statistics(sizeClass); s.spans != 0u)
+                    result.push_back(s);
+            return result;
+        }
+        template <typename CharT, typename Traits>
+        void info(std::basic_ostream<CharT, Traits>& aOutput) const
+        {
+            for (auto const& s : statistics())
+                aOutput << s << std::endl;
+        }
+        // implementation
+    private:
+        thread_cache* local_cache()
+        {
+            if (tRetired)
+                return nullptr;
+            thread_local thread_cache tCache{ *this };
+            return &tCache;
+        }
+        void register_cache(thread_cache& aCache)
+        {
+            std::lock_guard<std::mutex> lock{ iCachesMutex };
+            iCaches.push_back(&aCache);
+        }
+        void unregister_cache(thread_cache& aCache)
+        {
+            std::lock_guard<std::mutex> lock{ iCachesMutex };
+            iCaches.erase(std::remove(iCaches.begin(), iCaches.end(), &aCache), iCaches.end());
+        }
+        // returns a chain of free blocks for a thread cache; the depot's stacks are only ever popped with the bin
+        // locked so a single popper races against lock-free pushers only, which cannot suffer ABA
+        std::size_t take(std::size_t aSizeClass, link*& aChain)
+        {
+            auto& b = iBins[aSizeClass];
+            std::size_t const magazineSize = magazine_size(aSizeClass);
+            std::lock_guard<std::mutex> lock{ b.mutex };
+            magazine* full = b.full.load(std::memory_order_acquire);
+            while (full != nullptr && !b.full.compare_exchange_weak(full, full->iNextMagazine, std::memory_order_acquire, std::memory_order_acquire))
+                ;
+            if (full != nullptr)
+            {
+                b.fullCount.fetch_sub(1u, std::memory_order_relaxed);
+                aChain = reinterpret_cast<link*>(full);
+                return magazineSize;
+            }
+            if (b.orphans.load(std::memory_order_relaxed) != nullptr)
+            {
+                link* orphans = b.orphans.exchange(nullptr, std::memory_order_acquire);
+                std::size_t count = 1u;
+                link* last = orphans;
+                while (count < magazineSize && last->iNext != nullptr)
+                {
+                    last = last->iNext;
+                    ++count;
+                }
+                link* remainder = last->iNext;
+                last->iNext = nullptr;
+                b.orphanCount.fetch_sub(count, std::memory_order_relaxed);
+                if (remainder != nullptr)
+                {
+                    link* remainderLast = remainder;
+                    while (remainderLast->iNext != nullptr)
+                        remainderLast = remainderLast->iNext;
+                    push_orphans(b, remainder, remainderLast);
+                }
+                aChain = orphans;
+                return count;
+            }
+            return carve(aSizeClass, b, magazineSize, aChain);
+        }
+        void* allocate_direct(std::size_t aSizeClass)
+        {
+            auto& b = iBins[aSizeClass];
+            std::lock_guard<std::mutex> lock{ b.mutex };
+            link* orphan = b.orphans.load(std::memory_order_acquire);
+            while (orphan != nullptr && !b.orphans.compare_exchange_weak(orphan, orphan->iNext, std::memory_order_acquire, std::memory_order_acquire))
+                ;
+            if (orphan != nullptr)
+            {
+                b.orphanCount.fetch_sub(1u, std::memory_order_relaxed);
+                return orphan;
+            }
+            link* result = nullptr;
+            carve(aSizeClass, b, 1u, result);
+            return result;
+        }
+        void give_magazine(std::size_t aSizeClass, link* aChain)
+        {
+            auto& b = iBins[aSizeClass];
+            magazine* m = reinterpret_cast<magazine*>(aChain);
+            m->iNextMagazine = b.full.load(std::memory_order_relaxed);
+            while (!b.full.compare_exchange_weak(m->iNextMagazine, m, std::memory_order_release, std::memory_order_relaxed))
+                ;
+            b.fullCount.fetch_add(1u, std::memory_order_relaxed);
+        }
+        void give_orphans(std::size_t aSizeClass, link* aChain, std::size_t aCount)
+        {
+            auto& b = iBins[aSizeClass];
+            link* last = aChain;
+            while (last->iNext != nullptr)
+                last = last->iNext;
+            b.orphanCount.fetch_add(aCount, std::memory_order_relaxed);
+            push_orphans(b, aChain, last);
+        }
+        static void push_orphans(bin& aBin, link* aFirst, link* aLast)
+        {
+            aLast->iNext = aBin.orphans.load(std::memory_order_relaxed);
+            while (!aBin.orphans.compare_exchange_weak(aLast->iNext, aFirst, std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+        static std::size_t carve(std::size_t aSizeClass, bin& aBin, std::size_t aCount, link*& aChain)
+        {
+            std::size_t const blockSize = block_size(aSizeClass);
+            link* first = nullptr;
+            link* last = nullptr;
+            for (std::size_t count = 0u; count < aCount; ++count)
+            {
+                if (aBin.carve == aBin.carveEnd)
+                {
+                    char* span = static_cast<char*>(::operator new(span_size));
+                    aBin.spans.push_back(span);
+                    aBin.carve = span;
+                    aBin.carveEnd = span + (span_size / blockSize) * blockSize;
+                    aBin.capacity += span_size / blockSize;
+                }
+                link* block = reinterpret_cast<link*>(aBin.carve);
+                aBin.carve += blockSize;
+                block->iNext = nullptr;
+                if (last != nullptr)
+                    last->iNext = block;
+                else
+                    first = block;
+                last = block;
+            }
+            aChain = first;
+            return aCount;
+        }
+    private:
+        std::array<bin, size_class_count> iBins;
+        mutable std::mutex iCachesMutex;
+        std::vector<thread_cache*> iCaches;
+        static inline thread_local bool tRetired = false;
+    };
+
+    template <typename T>
+    class size_class_allocator
+    {
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef T& reference;
+        typedef const T* const_pointer;
+        typedef const T& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::true_type is_always_equal;
+    private:
+        typedef std::allocator<T> backup_allocator_t;
+
+        // construction
+    public:
+        size_class_allocator() noexcept
+        {
+        }
+        size_class_allocator(const size_class_allocator&) noexcept
+        {
+        }
+        template <typename U>
+        size_class_allocator(const size_class_allocator<U>&) noexcept
+        {
+        }
+
+        // operations
+    public:
+        static pointer allocate(size_type aCount = 1)
+        {
+            if (pooled(aCount))
+                return static_cast<pointer>(size_class_pool::instance().allocate(sizeof(T) * aCount));
+            else
+                return backup_allocator_t{}.allocate(aCount);
+        }
+        static void deallocate(pointer aObject, size_type aCount = 1)
+        {
+            if (pooled(aCount))
+                size_class_pool::instance().deallocate(aObject, sizeof(T) * aCount);
+            else
+                backup_allocator_t{}.deallocate(aObject, aCount);
+        }
+
+        static size_class_statistics statistics()
+        {
+            return size_class_pool::instance().statistics(size_class_pool::size_class(sizeof(T)));
+        }
+
+        template <typename U>
+        struct rebind
+        {
+            typedef size_class_allocator<U> other;
+        };
+
+        bool operator==(const size_class_allocator&) const { return true; }
+        bool operator!=(const size_class_allocator&) const { return false; }
+
+        // implementation
+    private:
+        static constexpr bool pooled(size_type aCount)
+        {
+            return alignof(T) <= size_class_pool::alignment && aCount <= size_class_pool::max_block_size / sizeof(T);
+        }
+    };
+
+    template <typename T, typename U>
+    inline bool operator==(const size_class_allocator<T>&, const size_class_allocator<U>&)
+    {
+        return true;
+    }
+
+    template <typename T, typename U>
+    inline bool operator!=(const size_class_allocator<T>&, const size_class_allocator<U>&)
+    {
+        return false;
+    }
+}
@@ -134,6 +134,13 @@ namespace neolib
             iterator(typename vector_type::iterator aIter) : iType(VectorIterator), iArrayPtr(0), iVectorIter(aIter)
             {
             }
+            iterator& operator=(const iterator& aOther)
+            {
+                iType = aOther.iType;
+                iArrayPtr = aOther.iArrayPtr;
+                iVectorIter = aOther.iVectorIter;
+                return *this;
+            }
 
         public:
             iterator& operator++()
@@ -261,6 +268,13 @@ namespace neolib
             const_iterator(typename vector_type::iterator aIter) : iType(VectorIterator), iArrayPtr(0), iVectorIter(aIter)
             {
             }
+            const_iterator& operator=(const const_iterator& aOther)
+            {
+                iType = aOther.iType;
+                iArrayPtr = aOther.iArrayPtr;
+                iVectorIter = aOther.iVectorIter;
+                return *this;
+            }
 
         public:
             const_iterator& operator++()
@@ -726,20 +740,21 @@ namespace neolib
             if (using_array())
             {
                 auto pos = const_cast<pointer>(position.array_ptr());
-                const_iterator theEnd = end();
-                difference_type t = theEnd - position;
+                auto theEnd = const_cast<pointer>(end().array_ptr());
+                difference_type t = theEnd - pos;
                 if (t > 0)
                 {
+                    // existing elements are moved out of the way rather than copied
                     if (t > n)
                     {
-                        std::uninitialized_copy(theEnd - n, theEnd, const_cast<pointer>(theEnd.array_ptr()));
+                        std::uninitialized_move(theEnd - n, theEnd, theEnd);
                         iSize += n;
-                        std::copy_backward(position, theEnd - n, const_cast<pointer>(theEnd.array_ptr()));
+                        std::move_backward(pos, theEnd - n, theEnd);
                         std::copy(first, last, pos);
                     }
                     else
                     {
-                        detail::uninitialized_copy2(theEnd - t, theEnd, const_cast<pointer>((theEnd + (n - t)).array_ptr()), first + t, last, const_cast<pointer>(theEnd.array_ptr()));
+                        detail::uninitialized_copy2(std::make_move_iterator(theEnd - t), std::make_move_iterator(theEnd), theEnd + (n - t), first + t, last, theEnd);
                         iSize += n;
                         std::copy(first, first + t, pos);
                     }
@@ -0,0 +1,186 @@
+// archetype_storage.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <span>
+#include <neolib/core/mutex.hpp>
+#include <neolib/ecs/ecs_ids.hpp>
+
+namespace neolib::ecs
+{
+    class i_ecs;
+
+    // Type-erased operations on one component column; component<Data> supplies these for its value_type.
+    struct component_column_traits
+    {
+        component_id id;
+        std::size_t size;
+        std::size_t alignment;
+        void(*default_construct)(void* aDestination);
+        void(*move_construct)(void* aDestination, void* aSource);
+        void(*destroy)(void* aObject);
+        void(*free_handles)(void* aObject, i_ecs& aEcs); // nullptr if the data owns no handles
+    };
+
+    // Chunked storage used by ecs_flags::ArchetypeChunks: entities with the same set of components
+    // live together in one table whose rows are packed into fixed size chunks, each chunk holding one
+    // contiguous column per component (plus a column of entity ids). Structural changes (adding or
+    // removing an entity's component) move the entity's row to the table for its new component set;
+    // rows are kept dense by moving the table's last row into the hole. References to records are
+    // therefore only stable while mutex() is held, or while any component lock is held as i_ecs makes
+    // structural changes under i_ecs::component_mutexes(). Chunks are aligned to chunk_alignment() so
+    // the entity owning a record is found from the record's address without searching the tables.
+    class NEOLIB_EXPORT archetype_storage
+    {
+    public:
+        struct entity_not_found : std::logic_error { entity_not_found() : std::logic_error("neolib::ecs::archetype_storage::entity_not_found") {} };
+    public:
+        typedef std::vector<component_id> signature_t; // sorted
+        static constexpr std::size_t default_chunk_size = 16u * 1024u;
+        static constexpr std::size_t column_alignment = 64u;
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    public:
+        class table;
+    private:
+        struct chunk_location
+        {
+            const table* owner;
+            std::size_t chunk;
+        };
+        // keyed by the address of each chunk_alignment() sized block of a chunk
+        typedef std::unordered_map<std::uintptr_t, chunk_location> chunk_index_t;
+    public:
+        class NEOLIB_EXPORT table
+        {
+            friend class archetype_storage;
+        private:
+            struct chunk_deleter
+            {
+                std::align_val_t alignment;
+                void operator()(std::byte* aChunk) const
+                {
+                    ::operator delete(aChunk, alignment);
+                }
+            };
+            typedef std::unique_ptr<std::byte[], chunk_deleter> chunk_ptr;
+        public:
+            table(std::vector<const component_column_traits*> aColumns, archetype_storage& aStorage);
+            ~table();
+            table(const table&) = delete;
+            table& operator=(const table&) = delete;
+        public:
+            const signature_t& signature() const;
+            const std::vector<const component_column_traits*>& columns() const;
+            std::size_t column_index(const component_id& aComponentId) const;
+            bool contains(const component_id& aComponentId) const;
+        public:
+            std::size_t size() const;
+            bool empty() const;
+            std::size_t chunk_capacity() const;
+            std::size_t chunk_count() const;
+            std::size_t chunk_rows(std::size_t aChunk) const;
+            const entity_id* entities(std::size_t aChunk) const;
+            const void* column(std::size_t aChunk, std::size_t aColumn) const;
+            void* column(std::size_t aChunk, std::size_t aColumn);
+            entity_id entity(std::size_t aRow) const;
+            const void* record(std::size_t aRow, std::size_t aColumn) const;
+            void* record(std::size_t aRow, std::size_t aColumn);
+        private:
+            std::size_t layout(std::size_t aCapacity);
+            void push_chunk();
+            void pop_chunk();
+            std::size_t push(entity_id aEntity);
+            entity_id erase(std::size_t aRow);
+            entity_id& entity_slot(std::size_t aRow);
+        private:
+            archetype_storage& iStorage;
+            signature_t iSignature;
+            std::vector<const component_column_traits*> iColumns;
+            std::vector<std::size_t> iOffsets;
+            std::size_t iChunkBytes;
+            std::size_t iChunkCapacity;
+            std::vector<chunk_ptr> iChunks;
+            std::size_t iSize;
+        };
+        typedef std::vector<std::unique_ptr<table>> tables_t;
+    private:
+        struct location
+        {
+            table* owner;
+            std::size_t row;
+        };
+    public:
+        archetype_storage(std::size_t aChunkSize = default_chunk_size);
+        ~archetype_storage();
+    public:
+        neolib::recursive_spinlock& mutex() const;
+        std::size_t chunk_size() const;
+        std::size_t chunk_alignment() const;
+        const tables_t& tables() const;
+    public:
+        bool contains(entity_id aEntity) const;
+        const table* owner(entity_id aEntity) const;
+        const void* find(entity_id aEntity, const component_id& aComponentId) const;
+        void* find(entity_id aEntity, const component_id& aComponentId);
+        entity_id entity(const component_id& aComponentId, const void* aRecord) const;
+    public:
+        void* add(entity_id aEntity, const component_column_traits& aColumn);
+        void add(entity_id aEntity, std::span<const component_column_traits* const> aColumns);
+        void remove(entity_id aEntity, const component_id& aComponentId);
+        void remove(entity_id aEntity, i_ecs& aEcs);
+    private:
+        table& find_or_create_table(std::vector<const component_column_traits*> aColumns);
+        void relocate(entity_id aEntity, table& aDestination);
+        void erase_entity(entity_id aEntity, i_ecs* aEcs);
+        void erase_row(table& aOwner, std::size_t aRow);
+    private:
+        mutable neolib::recursive_spinlock iMutex;
+        std::size_t iChunkSize;
+        std::size_t iChunkAlignment;
+        chunk_index_t iChunkIndex;
+        tables_t iTables;
+        std::map<signature_t, table*> iTableIndex;
+        std::vector<location> iLocations;
+    };
+}
@@ -0,0 +1,225 @@
+// command_buffer.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <neolib/core/mutex.hpp>
+#include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/i_entity_archetype.hpp>
+#include <neolib/ecs/i_ecs.hpp>
+
+namespace neolib::ecs
+{
+    // Records structural changes (entity creation and destruction, adding and removing component records)
+    // so they can be applied in one batched pass by i_ecs::commit_commands() at the frame boundary. Each
+    // thread records into its own buffer (i_ecs::commands()) so recording never contends with other threads;
+    // the buffer's lock is only ever shared with the commit that drains it. Component payloads are kept in
+    // typed per-component queues which are sorted by entity and applied with a single reserve per component.
+    class NEOLIB_EXPORT command_buffer
+    {
+    public:
+        struct create_command
+        {
+            entity_id entity;
+            entity_archetype_id archetype;
+            const i_entity_archetype* archetypeToRegister;
+            uint32_t firstComponent;    // index into creation_components()
+            uint32_t componentCount;
+        };
+        struct destroy_command
+        {
+            entity_id entity;
+            bool notify;
+        };
+        class i_component_commands
+        {
+        public:
+            virtual ~i_component_commands() = default;
+        public:
+            virtual std::unique_ptr<i_component_commands> clone_empty() const = 0;
+            virtual bool empty() const = 0;
+            virtual void take(i_component_commands& aSource) = 0;
+            virtual void clear() = 0;
+            virtual void prepare(i_ecs& aEcs) = 0;
+            virtual void apply(i_ecs& aEcs) = 0;
+        };
+        template <typename ComponentData>
+        class component_commands : public i_component_commands
+        {
+        public:
+            typedef component_value_t<ComponentData> value_type;
+        public:
+            std::unique_ptr<i_component_commands> clone_empty() const override
+            {
+                return std::make_unique<component_commands>();
+            }
+            bool empty() const override
+            {
+                return iCommands.empty();
+            }
+            void take(i_component_commands& aSource) override
+            {
+                auto& source = static_cast<component_commands&>(aSource);
+                std::move(source.iCommands.begin(), source.iCommands.end(), std::back_inserter(iCommands));
+                source.clear();
+            }
+            void clear() override
+            {
+                iCommands.clear();
+            }
+            void prepare(i_ecs& aEcs) override
+            {
+                aEcs.component<ComponentData>();
+            }
+            void apply(i_ecs& aEcs) override
+            {
+                if (iCommands.empty())
+                    return;
+                auto& component = aEcs.component<ComponentData>();
+                // the stable sort keeps each entity's commands in recorded order and only the last one decides the outcome
+                std::stable_sort(iCommands.begin(), iCommands.end(), [](auto const& lhs, auto const& rhs) { return entity_index(lhs.first) < entity_index(rhs.first); });
+                iCommands.erase(iCommands.begin(), std::unique(iCommands.rbegin(), iCommands.rend(), [](auto const& lhs, auto const& rhs) { return lhs.first == rhs.first; }).base());
+                // drop commands for entities destroyed since they were recorded; a stale id could otherwise alias a reused index
+                std::erase_if(iCommands, [&](auto const& command) { return !aEcs.is_alive(command.first); });
+                auto const additions = static_cast<std::size_t>(std::count_if(iCommands.begin(), iCommands.end(), [](auto const& command) { return command.second.has_value(); }));
+                if (additions != 0u)
+                    component.reserve(additions, entity_index(iCommands.back().first));
+                for (auto& command : iCommands)
+                {
+                    if (command.second)
+                    {
+                        // commit_commands() has already added this column to a new entity's row so move the payload straight in
+                        void* const row = aEcs.chunked() ? find_row(aEcs, command.first) : nullptr;
+                        if (row != nullptr)
+                            *static_cast<value_type*>(row) = std::move(*command.second);
+                        else
+                            component.populate(command.first, std::move(*command.second));
+                    }
+                    else if (component.has_entity_record(command.first))
+                        component.destroy_entity_record(command.first);
+                }
+                clear();
+            }
+        public:
+            template <typename T>
+            void add(entity_id aEntity, T&& aComponentData)
+            {
+                iCommands.emplace_back(aEntity, std::forward<T>(aComponentData));
+            }
+            void remove(entity_id aEntity)
+            {
+                iCommands.emplace_back(aEntity, std::nullopt);
+            }
+        private:
+            static void* find_row(i_ecs& aEcs, entity_id aEntity)
+            {
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ aEcs.chunk_storage().mutex() };
+                return aEcs.chunk_storage().find(aEntity, ComponentData::meta::id());
+            }
+        private:
+            std::vector<std::pair<entity_id, std::optional<value_type>>> iCommands; // std::nullopt: remove
+        };
+        typedef std::unordered_map<component_id, std::unique_ptr<i_component_commands>, quick_uuid_hash> component_commands_t;
+    public:
+        command_buffer(i_ecs& aEcs);
+    public:
+        i_ecs& ecs() const;
+        neolib::recursive_spinlock& mutex() const;
+        bool empty() const;
+    public:
+        template <typename... ComponentData>
+        entity_id create_entity(const entity_archetype_id& aArchetypeId, ComponentData&&... aComponentData)
+        {
+            return record_creation(aArchetypeId, nullptr, std::forward<ComponentData>(aComponentData)...);
+        }
+        template <typename Archetype, typename... ComponentData>
+        entity_id create_entity(const Archetype& aArchetype, ComponentData&&... aComponentData)
+        {
+            return record_creation(aArchetype.id(), &aArchetype, std::forward<ComponentData>(aComponentData)...);
+        }
+        void destroy_entity(entity_id aEntity, bool aNotify = true);
+        template <typename ComponentData>
+        void add_component(entity_id aEntity, ComponentData&& aComponentData)
+        {
+            std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+            commands<ecs_data_type_t<ComponentData>>().add(aEntity, std::forward<ComponentData>(aComponentData));
+        }
+        template <typename ComponentData>
+        void remove_component(entity_id aEntity)
+        {
+            std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+            commands<ecs_data_type_t<ComponentData>>().remove(aEntity);
+        }
+    public:
+        void take(command_buffer& aSource);
+        void clear();
+        std::vector<create_command>& creations();
+        const std::vector<component_id>& creation_components() const;
+        std::vector<destroy_command>& destructions();
+        component_commands_t& component_commands_by_id();
+    private:
+        template <typename... ComponentData>
+        entity_id record_creation(const entity_archetype_id& aArchetypeId, const i_entity_archetype* aArchetype, ComponentData&&... aComponentData)
+        {
+            auto const entity = ecs().reserve_entity_id();
+            std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+            iCreations.push_back(create_command{ entity, aArchetypeId, aArchetype, static_cast<uint32_t>(iCreationComponents.size()), static_cast<uint32_t>(sizeof...(ComponentData)) });
+            (iCreationComponents.push_back(ecs_data_type_t<ComponentData>::meta::id()), ...);
+            (commands<ecs_data_type_t<ComponentData>>().add(entity, std::forward<ComponentData>(aComponentData)), ...);
+            return entity;
+        }
+        template <typename ComponentData>
+        component_commands<ComponentData>& commands()
+        {
+            auto& existing = iComponentCommands[ComponentData::meta::id()];
+            if (!existing)
+                existing = std::make_unique<component_commands<ComponentData>>();
+            return static_cast<component_commands<ComponentData>&>(*existing);
+        }
+    private:
+        i_ecs& iEcs;
+        mutable neolib::recursive_spinlock iMutex;
+        std::vector<create_command> iCreations;
+        std::vector<component_id> iCreationComponents;
+        std::vector<destroy_command> iDestructions;
+        component_commands_t iComponentCommands;
+    };
+}
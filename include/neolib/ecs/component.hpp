@@ -39,6 +39,7 @@
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <span>
 #include <neolib/core/intrusive_sort.hpp>
 #include <neolib/task/thread_pool.hpp>
 #include <neolib/ecs/ecs_ids.hpp>
@@ -212,6 +213,7 @@ namespace neolib::ecs
     public:
         using typename base_type::entity_record_not_found;
         using typename base_type::invalid_data;
+        struct not_supported_by_chunked_storage : std::logic_error { not_supported_by_chunked_storage() : std::logic_error("neolib::component::not_supported_by_chunked_storage") {} };
     public:
         typedef typename base_type::data_type data_type;
         typedef typename base_type::data_meta_type data_meta_type;
@@ -252,6 +254,8 @@ namespace neolib::ecs
     public:
         component(i_ecs& aEcs) : 
             base_type{ aEcs },
+            iChunkStorage{ aEcs.chunked() ? &aEcs.chunk_storage() : nullptr },
+            iRecordVersion{ 0u },
             iHaveSnapshot{ false },
             iUsingSnapshot{ 0u }
         {
@@ -260,6 +264,8 @@ namespace neolib::ecs
             base_type{ aOther },
             iEntities{ aOther.iEntities },
             iReverseIndices{ aOther.iReverseIndices },
+            iChunkStorage{ aOther.iChunkStorage },
+            iRecordVersion{ aOther.record_version() },
             iHaveSnapshot{ false },
             iUsingSnapshot{ 0u }
         {
@@ -286,9 +292,43 @@ namespace neolib::ecs
     public:
         using base_type::component_data;
         using base_type::operator[];
+    public:
+        // In ecs_flags::ArchetypeChunks mode records live in ecs().chunk_storage() and the sparse containers
+        // (component_data(), entities() and reverse_indices()) stay empty; iterate with i_ecs::for_each instead.
+        bool chunked() const
+        {
+            return iChunkStorage != nullptr;
+        }
+        const component_column_traits& column_traits() const override
+        {
+            static const component_column_traits sColumnTraits =
+            {
+                data_meta_type::id(),
+                sizeof(value_type),
+                alignof(value_type),
+                [](void* aDestination) { new (aDestination) value_type{}; },
+                [](void* aDestination, void* aSource) { new (aDestination) value_type{ std::move(*static_cast<value_type*>(aSource)) }; },
+                [](void* aObject) { static_cast<value_type*>(aObject)->~value_type(); },
+                data_meta_type::has_handles ? &free_column_handles : nullptr
+            };
+            return sColumnTraits;
+        }
+        uint32_t record_version() const override
+        {
+            return iRecordVersion;
+        }
+        void increment_record_version() override
+        {
+            ++iRecordVersion;
+        }
     public:
         entity_id entity(const value_type& aData) const
         {
+            if (chunked())
+            {
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                return iChunkStorage->entity(id(), &aData);
+            }
             const value_type* lhs = &aData;
             const value_type* rhs = &base_type::component_data()[0];
             auto index = lhs - rhs;
@@ -312,16 +352,36 @@ namespace neolib::ecs
         }
         reverse_index_t reverse_index_no_lock(entity_id aEntity) const
         {
-            if (reverse_indices().size() > aEntity)
-                return reverse_indices()[aEntity];
+            auto const index = entity_index(aEntity);
+            if (reverse_indices().size() > index)
+            {
+                // a stale id may share its index with a live entity so check the generation too
+                auto const reverseIndex = reverse_indices()[index];
+                if (reverseIndex != invalid && entities()[reverseIndex] == aEntity)
+                    return reverseIndex;
+            }
             return invalid;
         }
         bool has_entity_record_no_lock(entity_id aEntity) const override
         {
+            if (chunked())
+            {
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                return iChunkStorage->find(aEntity, id()) != nullptr;
+            }
             return reverse_index_no_lock(aEntity) != invalid;
         }
         const value_type& entity_record_no_lock(entity_id aEntity) const
         {
+            if (chunked())
+            {
+                // rows only move under ecs().component_mutexes() so the reference stays valid while this component is locked
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                auto record = to_const(*iChunkStorage).find(aEntity, id());
+                if (record == nullptr)
+                    throw entity_record_not_found();
+                return *static_cast<const value_type*>(record);
+            }
             auto reverseIndex = reverse_index_no_lock(aEntity);
             if (reverseIndex == invalid)
                 throw entity_record_not_found();
@@ -350,11 +410,26 @@ namespace neolib::ecs
         }
         value_type& entity_record(entity_id aEntity, bool aCreate = false)
         {
+            auto structuralLock = aCreate ? structural_lock() : std::unique_lock<neolib::i_lockable>{};
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             return entity_record_no_lock(aEntity, aCreate);
         }
         void destroy_entity_record(entity_id aEntity) override
         {
+            if (chunked())
+            {
+                // removing a column moves the entity's row and back-fills the hole with another row
+                auto structuralLock = structural_lock();
+                std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                auto record = iChunkStorage->find(aEntity, id());
+                if (record == nullptr)
+                    throw entity_record_not_found();
+                free_column_handles(record, ecs());
+                iChunkStorage->remove(aEntity, id());
+                increment_record_version();
+                return;
+            }
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             auto reverseIndex = reverse_index(aEntity);
             if (reverseIndex == invalid)
@@ -366,8 +441,9 @@ namespace neolib::ecs
             auto tailEntity = entities().back();
             std::swap(entities()[reverseIndex], entities().back());
             entities().pop_back();
-            reverse_indices()[tailEntity] = reverseIndex;
-            reverse_indices()[aEntity] = invalid;
+            reverse_indices()[entity_index(tailEntity)] = reverseIndex;
+            reverse_indices()[entity_index(aEntity)] = invalid;
+            increment_record_version();
             if (have_snapshot())
             {
                 auto ss = snapshot();
@@ -377,16 +453,19 @@ namespace neolib::ecs
         }
         value_type& populate(entity_id aEntity, const value_type& aData)
         {
+            auto structuralLock = structural_lock();
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             return do_populate(aEntity, aData);
         }
         value_type& populate(entity_id aEntity, value_type&& aData)
         {
+            auto structuralLock = structural_lock();
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             return do_populate(aEntity, aData);
         }
         const void* populate(entity_id aEntity, const void* aComponentData, std::size_t aComponentDataSize) override
         {
+            auto structuralLock = structural_lock();
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             if ((aComponentData == nullptr && !is_data_optional()) || aComponentDataSize != sizeof(data_type))
                 throw invalid_data();
@@ -395,6 +474,17 @@ namespace neolib::ecs
             else
                 return &do_populate(aEntity, value_type{}); // empty optional
         }
+        // Makes room for aCount more records, for entity indices up to aMaxIndex, ahead of a batch of populates.
+        void reserve(std::size_t aCount, entity_index_t aMaxIndex)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (chunked())
+                return;
+            base_type::component_data().reserve(base_type::component_data().size() + aCount);
+            entities().reserve(entities().size() + aCount);
+            if (reverse_indices().size() <= aMaxIndex)
+                reverse_indices().resize(aMaxIndex + 1, invalid);
+        }
     public:
         bool have_snapshot() const
         {
@@ -403,6 +493,8 @@ namespace neolib::ecs
         void take_snapshot()
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (chunked())
+                throw not_supported_by_chunked_storage();
             if (!iUsingSnapshot)
             {
                 if (iSnapshot == nullptr)
@@ -421,6 +513,8 @@ namespace neolib::ecs
         void sort(Compare aComparator)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (chunked())
+                throw not_supported_by_chunked_storage();
             neolib::intrusive_sort(base_type::component_data().begin(), base_type::component_data().end(),
                 [this](auto lhs, auto rhs) 
                 { 
@@ -431,9 +525,9 @@ namespace neolib::ecs
                     auto& rhsEntity = entities()[rhsIndex];
                     std::swap(lhsEntity, rhsEntity);
                     if (lhsEntity != invalid)
-                        reverse_indices()[lhsEntity] = lhsIndex;
+                        reverse_indices()[entity_index(lhsEntity)] = lhsIndex;
                     if (rhsEntity != invalid)
-                        reverse_indices()[rhsEntity] = rhsIndex;
+                        reverse_indices()[entity_index(rhsEntity)] = rhsIndex;
                 }, aComparator);
         }
     public:
@@ -441,6 +535,14 @@ namespace neolib::ecs
         void apply(const Callable& aCallable)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (chunked())
+            {
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                for (auto& chunk : chunks())
+                    for (auto& data : chunk)
+                        aCallable(*this, data);
+                return;
+            }
             for (auto& data : component_data())
                 aCallable(*this, data);
         }
@@ -448,12 +550,65 @@ namespace neolib::ecs
         void parallel_apply(const Callable& aCallable, std::size_t aMinimumParallelismCount = 0)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (chunked())
+            {
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                auto chunkData = chunks();
+                std::size_t count = 0u;
+                for (auto const& chunk : chunkData)
+                    count += chunk.size();
+                neolib::parallel_apply(ecs().thread_pool(), chunkData, [&](std::span<value_type>& aChunk) { for (auto& data : aChunk) aCallable(*this, data); },
+                    count < aMinimumParallelismCount ? chunkData.size() + 1u : 0u);
+                return;
+            }
             neolib::parallel_apply(ecs().thread_pool(), component_data(), [&](value_type& aData) { aCallable(*this, aData); }, aMinimumParallelismCount);
         }
     private:
+        // In ArchetypeChunks mode adding or removing a record moves rows of other components so it needs every
+        // component lock; that lock is always taken before this component's own lock as taking it while holding a
+        // single component lock inverts the order against another thread doing the same with a different component.
+        // For the same reason a caller holding a component lock (e.g. inside for_each or apply) must not populate
+        // or destroy records directly in that mode but defer the change with ecs().commands().
+        std::unique_lock<neolib::i_lockable> structural_lock() const
+        {
+            if (!chunked())
+                return {};
+            return std::unique_lock<neolib::i_lockable>{ ecs().component_mutexes() };
+        }
+        static void free_column_handles(void* aObject, i_ecs& aEcs)
+        {
+            if constexpr (data_meta_type::has_handles)
+                data_meta_type::free_handles(*static_cast<value_type*>(aObject), aEcs);
+        }
+        std::vector<std::span<value_type>> chunks() const
+        {
+            std::vector<std::span<value_type>> result;
+            for (auto const& table : iChunkStorage->tables())
+            {
+                auto const column = table->column_index(id());
+                if (column == archetype_storage::npos)
+                    continue;
+                for (std::size_t chunk = 0u; chunk < table->chunk_count(); ++chunk)
+                    result.emplace_back(static_cast<value_type*>(table->column(chunk, column)), table->chunk_rows(chunk));
+            }
+            return result;
+        }
         template <typename T>
         value_type& do_populate(entity_id aEntity, T&& aComponentData)
         {
+            if (chunked())
+            {
+                // adding a column moves the entity's row and back-fills the hole with another row
+                auto structuralLock = structural_lock();
+                std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+                if (has_entity_record(aEntity))
+                    return do_update(aEntity, aComponentData);
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ iChunkStorage->mutex() };
+                auto& record = *static_cast<value_type*>(iChunkStorage->add(aEntity, column_traits()));
+                increment_record_version();
+                record = std::forward<T>(aComponentData);
+                return record;
+            }
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             if (has_entity_record(aEntity))
                 return do_update(aEntity, aComponentData);
@@ -471,15 +626,17 @@ namespace neolib::ecs
             }
             try
             {
-                if (reverse_indices().size() <= aEntity)
-                    reverse_indices().resize(aEntity + 1, invalid);
-                reverse_indices()[aEntity] = reverseIndex;
+                auto const index = entity_index(aEntity);
+                if (reverse_indices().size() <= index)
+                    reverse_indices().resize(index + 1, invalid);
+                reverse_indices()[index] = reverseIndex;
             }
             catch (...)
             {
                 entities()[reverseIndex] = null_entity;
                 throw;
             }
+            increment_record_version();
             return base_type::component_data()[reverseIndex];
         }
         template <typename T>
@@ -493,6 +650,8 @@ namespace neolib::ecs
     private:
         component_data_entities_t iEntities;
         reverse_indices_t iReverseIndices;
+        archetype_storage* iChunkStorage;
+        std::atomic<uint32_t> iRecordVersion;
         mutable std::atomic<bool> iHaveSnapshot;
         mutable std::atomic<uint32_t> iUsingSnapshot;
         mutable snapshot_ptr iSnapshot;
@@ -36,6 +36,9 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <array>
+#include <limits>
+#include <memory>
 #include <neolib/core/mutex.hpp>
 #include <neolib/task/async_task.hpp>
 #include <neolib/task/timer.hpp>
@@ -43,11 +46,26 @@
 #include <neolib/ecs/i_ecs.hpp>
 #include <neolib/ecs/component.hpp>
 #include <neolib/ecs/system.hpp>
+#include <neolib/ecs/system_scheduler.hpp>
+#include <neolib/ecs/command_buffer.hpp>
 
 namespace neolib::ecs
 {
     class NEOLIB_EXPORT ecs : public neolib::object<i_ecs>
     {
+    private:
+        // generations live in pages that are never moved so is_alive() can read them without a lock; a freed index's
+        // slot also links it into the lock free stacks of retired and reusable indices (index 0 is never used so ends them);
+        // a reserved index is only committed (and its id alive) once the entity it was reserved for has been created
+        struct entity_slot
+        {
+            std::atomic<entity_generation_t> generation;
+            std::atomic<entity_index_t> nextFree;
+            std::atomic<bool> committed;
+        };
+        static constexpr std::size_t generation_page_size = std::size_t{ 1u } << 16u;
+        static constexpr std::size_t generation_page_count = (std::size_t{ std::numeric_limits<entity_index_t>::max() } + 1u) / generation_page_size;
+        typedef std::array<entity_slot, generation_page_size> generation_page;
     public:
         define_declared_event(SystemsPaused, systems_paused)
         define_declared_event(SystemsResumed, systems_resumed)
@@ -61,7 +79,11 @@ namespace neolib::ecs
         ~ecs();
     public:
         neolib::recursive_spinlock& mutex() const override;
+        neolib::i_lockable& component_mutexes() const override;
         neolib::thread_pool& thread_pool() const override;
+        archetype_storage& chunk_storage() const override;
+        system_scheduler& scheduler() const override;
+        command_buffer& commands() override;
     public:
         ecs_flags flags() const override;
         entity_id create_entity(const entity_archetype_id& aArchetypeId) override;
@@ -70,6 +92,7 @@ namespace neolib::ecs
         void destroy_entity(entity_id aEntityId, bool aNotify = true) override;
         void async_destroy_entity(entity_id aEntityId, bool aNotify = true) override;
         void commit_async_entity_destruction() override;
+        void commit_commands() override;
     public:
         bool run_threaded(const system_id& aSystemId) const override;
         bool all_systems_paused() const override;
@@ -104,7 +127,10 @@ namespace neolib::ecs
         i_system& system(system_id aSystemId) override;
     public:
         entity_id next_entity_id() override;
+        entity_id reserve_entity_id() override;
         void free_entity_id(entity_id aId) override;
+        bool is_alive(entity_id aEntity) const override;
+        void recycle_entity_ids() override;
     public:
         bool archetype_registered(const i_entity_archetype& aArchetype) const override;
         void register_archetype(const i_entity_archetype& aArchetype) override;
@@ -123,8 +149,14 @@ namespace neolib::ecs
     private:
         handle_id next_handle_id();
         void free_handle_id(handle_id aId);
+        void commit_entity_id(entity_id aId);
+        bool is_reserved(entity_id aEntity) const; // reserved or alive: not freed since it was handed out
+        const entity_slot* find_slot(entity_index_t aIndex) const;
+        entity_generation_t generation(entity_index_t aIndex) const;
+        entity_slot& slot(entity_index_t aIndex);
     public:
         using i_ecs::create_entity;
+        using i_ecs::async_create_entity;
     public:
         using i_ecs::populate;
         using i_ecs::populate_shared;
@@ -144,23 +176,32 @@ namespace neolib::ecs
     private:
         mutable neolib::recursive_spinlock iMutex;
         mutable std::optional<neolib::thread_pool> iThreadPool;
+        mutable archetype_storage iChunkStorage;
+        mutable std::optional<system_scheduler> iScheduler;
         ecs_flags iFlags;
         archetype_registry_t iArchetypeRegistry;
         component_factories_t iComponentFactories;
         mutable components_t iComponents;
         mutable std::vector<proxy_mutex<i_lockable>> iComponentMutexes;
+        mutable multi_mutex<std::vector<proxy_mutex<i_lockable>>> iAllComponentsMutex;
         shared_component_factories_t iSharedComponentFactories;
         mutable shared_components_t iSharedComponents;
         system_factories_t iSystemFactories;
         mutable systems_t iSystems;
         std::vector<std::function<void()>> iEntitiesToCreate;
         std::vector<std::pair<entity_id, bool>> iEntitiesToDestroy;
-        entity_id iNextEntityId;
-        std::vector<entity_id> iFreedEntityIds;
+        std::atomic<entity_index_t> iNextEntityIndex;
+        std::atomic<uint64_t> iFreedEntityIndices; // top index in the low half, bumped on every change against ABA in the high half
+        std::atomic<entity_index_t> iRetiredEntityIndices;
+        std::atomic<std::atomic<generation_page*>*> iGenerationPages;
         handle_id iNextHandleId;
         std::vector<handle_id> iFreedHandleIds;
         handles_t iHandles;
         neolib::callback_timer iSystemTimer;
+        uint64_t const iInstance;
+        std::shared_ptr<void> const iInstanceToken; // threads' cached command buffer entries expire with it
+        std::vector<std::unique_ptr<command_buffer>> iCommandBuffers;
+        command_buffer iPendingCommands;
         std::atomic<bool> iSystemsPaused;
     };
 }
@@ -48,6 +48,24 @@ namespace neolib::ecs
     typedef neolib::cookie id_t;
     constexpr id_t null_id = 0;
     typedef id_t handle_id;
-    typedef id_t entity_id;
+    // An entity id packs a generation into its high bits above a dense, recycled index (see i_ecs::is_alive).
+    typedef neolib::large_cookie entity_id;
+    typedef uint32_t entity_index_t;
+    typedef uint32_t entity_generation_t;
     constexpr entity_id null_entity = 0;
+
+    inline constexpr entity_index_t entity_index(entity_id aEntity)
+    {
+        return static_cast<entity_index_t>(aEntity);
+    }
+
+    inline constexpr entity_generation_t entity_generation(entity_id aEntity)
+    {
+        return static_cast<entity_generation_t>(aEntity >> 32u);
+    }
+
+    inline constexpr entity_id make_entity_id(entity_index_t aIndex, entity_generation_t aGeneration)
+    {
+        return (static_cast<entity_id>(aGeneration) << 32u) | aIndex;
+    }
 }
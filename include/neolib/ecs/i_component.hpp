@@ -40,6 +40,7 @@
 #include <neolib/core/i_mutex.hpp>
 #include <neolib/ecs/ecs_ids.hpp>
 #include <neolib/ecs/i_component_data.hpp>
+#include <neolib/ecs/archetype_storage.hpp>
 
 namespace neolib::ecs
 {
@@ -69,6 +70,9 @@ namespace neolib::ecs
         virtual bool has_entity_record_no_lock(entity_id aEntity) const = 0;
         virtual bool has_entity_record(entity_id aEntity) const = 0;
         virtual void destroy_entity_record(entity_id aEntity) = 0;
+        virtual const component_column_traits& column_traits() const = 0;
+        virtual uint32_t record_version() const = 0; // changes whenever a record is added or removed
+        virtual void increment_record_version() = 0;
     public:
         virtual const void* populate(entity_id aEntity, const void* aComponentData, std::size_t aComponentDataSize) = 0;
         template <typename ComponentData>
@@ -92,6 +96,9 @@ namespace neolib::ecs
     template <typename ComponentData>
     class component;
 
+    template <typename ComponentData>
+    using component_value_t = typename component<ecs_data_type_t<ComponentData>>::value_type;
+
     template <typename ComponentData>
     class shared_component;
 }
\ No newline at end of file
@@ -57,6 +57,8 @@ namespace neolib::ecs
         Turbo               = 0x0002,
         CreatePaused        = 0x0004,
         NoThreads           = 0x0008,
+        ArchetypeChunks     = 0x0010, // store components in per-archetype chunks (see archetype_storage) rather than sparse per-component arrays
+        ParallelSystems     = 0x0020, // run systems each frame as a dependency graph on a work stealing thread pool (see system_scheduler)
 
         Default             = PopulateEntityInfo | Turbo
     };
@@ -81,6 +83,9 @@ namespace neolib::ecs
         return aLhs = static_cast<ecs_flags>(static_cast<uint32_t>(aLhs) & static_cast<uint32_t>(aRhs));
     }
 
+    class system_scheduler;
+    class command_buffer;
+
     class i_ecs : public i_object
     {
     public:
@@ -113,7 +118,11 @@ namespace neolib::ecs
         typedef void* handle_t;
     public:
         virtual neolib::i_lockable& mutex() const = 0;
+        virtual neolib::i_lockable& component_mutexes() const = 0; // every component mutex at once; held for structural changes in ArchetypeChunks mode and taken before any single component mutex
         virtual neolib::thread_pool& thread_pool() const = 0; // todo: polymorphic threadpool
+        virtual archetype_storage& chunk_storage() const = 0;
+        virtual system_scheduler& scheduler() const = 0;
+        virtual command_buffer& commands() = 0; // the calling thread's buffer; applied by commit_commands()
     public:
         virtual ecs_flags flags() const = 0;
         virtual entity_id create_entity(const entity_archetype_id& aArchetypeId) = 0;
@@ -122,6 +131,7 @@ namespace neolib::ecs
         virtual void destroy_entity(entity_id aEntityId, bool aNotify = true) = 0;
         virtual void async_destroy_entity(entity_id aEntityId, bool aNotify = true) = 0;
         virtual void commit_async_entity_destruction() = 0;
+        virtual void commit_commands() = 0;
     public:
         virtual bool run_threaded(const system_id& aSystemId) const = 0;
         virtual bool all_systems_paused() const = 0;
@@ -156,7 +166,10 @@ namespace neolib::ecs
         virtual i_system& system(system_id aSystemId) = 0;
     public:
         virtual entity_id next_entity_id() = 0;
+        virtual entity_id reserve_entity_id() = 0; // thread safe; only reuses an index once recycle_entity_ids() has released it
         virtual void free_entity_id(entity_id aId) = 0;
+        virtual bool is_alive(entity_id aEntity) const = 0; // thread safe; false for a stale id even after its index is reused and for a reserved id until its creation is committed
+        virtual void recycle_entity_ids() = 0; // frame boundary: ids freed since the last call become reusable (with a new generation)
     public:
         virtual bool archetype_registered(const i_entity_archetype& aArchetype) const = 0;
         virtual void register_archetype(const i_entity_archetype& aArchetype) = 0;
@@ -182,6 +195,20 @@ namespace neolib::ecs
         void async_create_entity(entity_archetype_id aArchetypeId, ComponentData... aComponentData);
         template <typename Archetype, typename... ComponentData>
         void async_create_entity(const Archetype& aArchetype, ComponentData... aComponentData);
+    public:
+        bool chunked() const
+        {
+            return (flags() & ecs_flags::ArchetypeChunks) == ecs_flags::ArchetypeChunks;
+        }
+        template <typename... ComponentData, typename Callable>
+        void for_each(Callable&& aCallable);
+        template <typename... ComponentData, typename Callable>
+        void for_each_chunk(Callable&& aCallable);
+    private:
+        template <typename... ComponentData, typename Callable>
+        void visit_sparse(Callable&& aCallable);
+        template <typename... ComponentData, typename Callable>
+        void visit_chunks(Callable&& aCallable);
     public:
         template <typename ComponentData, typename... ComponentDataRest>
         void populate(entity_id aEntity, ComponentData&& aComponentData, ComponentDataRest&&... aComponentDataRest)
@@ -485,8 +512,23 @@ namespace neolib::ecs
     template <typename... ComponentData>
     inline entity_id i_ecs::create_entity(const entity_archetype_id& aArchetypeId, ComponentData&&... aComponentData)
     {
+        // in ArchetypeChunks mode take every component lock before any single one so concurrent creators cannot livelock
+        std::unique_lock<neolib::i_lockable> structuralLock{ component_mutexes(), std::defer_lock };
+        if (chunked())
+            structuralLock.lock();
         scoped_component_lock<std::decay_t<ComponentData>...> lock{ *this };
         auto newEntity = create_entity(aArchetypeId);
+        if constexpr (sizeof...(ComponentData) != 0)
+        {
+            if (chunked())
+            {
+                // add all the columns in one move rather than one move per populate
+                const component_column_traits* const columns[] = { &component<ecs_data_type_t<ComponentData>>().column_traits()... };
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ chunk_storage().mutex() };
+                chunk_storage().add(newEntity, columns);
+                (component<ecs_data_type_t<ComponentData>>().increment_record_version(), ...);
+            }
+        }
         populate(newEntity, std::forward<ComponentData>(aComponentData)...);
         archetype(aArchetypeId).populate_default_components(*this, newEntity);
         return newEntity;
@@ -521,4 +563,70 @@ namespace neolib::ecs
         };
         async_create_entity(std::function<void()>{ creator });
     }
+
+    // Calls aCallable(entity_id, ComponentData&...) for every entity that has all of the given components.
+    // Chunked storage streams each table's columns; sparse storage is driven by the first component's
+    // array with a reverse index lookup per entity for each of the others. aCallable must not add or remove
+    // component records; defer that with commands() (or async_create_entity/async_destroy_entity).
+    template <typename... ComponentData, typename Callable>
+    inline void i_ecs::for_each(Callable&& aCallable)
+    {
+        scoped_component_lock<ecs_data_type_t<ComponentData>...> lock{ *this };
+        if (chunked())
+            visit_chunks<ComponentData...>([&](std::size_t aCount, const entity_id* aEntities, auto*... aColumns)
+            {
+                for (std::size_t row = 0u; row < aCount; ++row)
+                    aCallable(aEntities[row], aColumns[row]...);
+            });
+        else
+            visit_sparse<ComponentData...>(aCallable);
+    }
+
+    // Calls aCallable(std::size_t aCount, const entity_id* aEntities, component_value_t<ComponentData>*... aColumns)
+    // once per chunk holding all of the given components; sparse storage calls it once per entity with aCount == 1.
+    template <typename... ComponentData, typename Callable>
+    inline void i_ecs::for_each_chunk(Callable&& aCallable)
+    {
+        scoped_component_lock<ecs_data_type_t<ComponentData>...> lock{ *this };
+        if (chunked())
+            visit_chunks<ComponentData...>(aCallable);
+        else
+            visit_sparse<ComponentData...>([&](entity_id aEntity, auto&... aData)
+            {
+                aCallable(std::size_t{ 1u }, &aEntity, &aData...);
+            });
+    }
+
+    template <typename... ComponentData, typename Callable>
+    inline void i_ecs::visit_sparse(Callable&& aCallable)
+    {
+        std::apply([&](auto& aDriver, auto&... aOthers)
+        {
+            for (std::size_t index = 0u; index < aDriver.entities().size(); ++index)
+            {
+                auto const entity = aDriver.entities()[index];
+                if (entity == null_entity || !(aOthers.has_entity_record_no_lock(entity) && ...))
+                    continue;
+                aCallable(entity, aDriver.component_data()[index], aOthers.entity_record_no_lock(entity)...);
+            }
+        }, std::forward_as_tuple(component<ecs_data_type_t<ComponentData>>()...));
+    }
+
+    template <typename... ComponentData, typename Callable>
+    inline void i_ecs::visit_chunks(Callable&& aCallable)
+    {
+        std::scoped_lock<neolib::recursive_spinlock> storageLock{ chunk_storage().mutex() };
+        [&]<std::size_t... Index>(std::index_sequence<Index...>)
+        {
+            for (auto const& table : chunk_storage().tables())
+            {
+                std::size_t const columns[] = { table->column_index(ecs_data_type_t<ComponentData>::meta::id())... };
+                if (std::find(std::begin(columns), std::end(columns), archetype_storage::npos) != std::end(columns))
+                    continue;
+                for (std::size_t chunk = 0u; chunk < table->chunk_count(); ++chunk)
+                    aCallable(table->chunk_rows(chunk), table->entities(chunk),
+                        static_cast<component_value_t<ComponentData>*>(table->column(chunk, columns[Index]))...);
+            }
+        }(std::index_sequence_for<ComponentData...>{});
+    }
 }
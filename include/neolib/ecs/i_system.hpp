@@ -62,6 +62,7 @@ namespace neolib::ecs
     public:
         virtual const neolib::i_set<component_id>& components() const = 0;
         virtual neolib::i_set<component_id>& components() = 0;
+        virtual bool writes(const component_id& aComponentId) const = 0;
     public:
         virtual const i_component& component(component_id aComponentId) const = 0;
         virtual const i_component& component(component_id aComponentId) = 0;
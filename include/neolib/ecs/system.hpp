@@ -37,6 +37,7 @@
 
 #include <neolib/neolib.hpp>
 #include <vector>
+#include <algorithm>
 #include <numeric>
 #include <chrono>
 #include <neolib/core/set.hpp>
@@ -100,12 +101,12 @@ namespace neolib::ecs
             (ecs().template component<ComponentData>(), ...);
         }
         system(const system& aOther) :
-            iEcs{ aOther.iEcs }, iComponents{ aOther.iComponents }, iPaused{ 0u }
+            iEcs{ aOther.iEcs }, iComponents{ aOther.iComponents }, iReadOnlyComponents{ aOther.iReadOnlyComponents }, iPaused{ 0u }
         {
             (ecs().template component<ComponentData>(), ...);
         }
         system(system&& aOther) :
-            iEcs{ aOther.iEcs }, iComponents{ std::move(aOther.iComponents) }, iPaused{ 0u }
+            iEcs{ aOther.iEcs }, iComponents{ std::move(aOther.iComponents) }, iReadOnlyComponents{ std::move(aOther.iReadOnlyComponents) }, iPaused{ 0u }
         {
             (ecs().template component<ComponentData>(), ...);
         }
@@ -134,6 +135,11 @@ namespace neolib::ecs
         {
             return iComponents;
         }
+        bool writes(const component_id& aComponentId) const override
+        {
+            return iComponents.find(aComponentId) != iComponents.end() &&
+                std::find(iReadOnlyComponents.begin(), iReadOnlyComponents.end(), aComponentId) == iReadOnlyComponents.end();
+        }
     public:
         const i_component& component(component_id aComponentId) const override
         {
@@ -239,6 +245,11 @@ namespace neolib::ecs
             return std::accumulate(iPerformanceMetrics[aMetricsIndex].updateTimes.begin(), iPerformanceMetrics[aMetricsIndex].updateTimes.end(), std::chrono::microseconds{}) / iPerformanceMetrics[aMetricsIndex].updateTimes.size();
         }
     protected:
+        template <typename... Data>
+        void declare_read_only()
+        {
+            (iReadOnlyComponents.push_back(Data::meta::id()), ...);
+        }
         bool have_thread() const
         {
             return iThread != nullptr;
@@ -290,6 +301,7 @@ namespace neolib::ecs
     private:
         i_ecs& iEcs;
         component_list iComponents;
+        std::vector<component_id> iReadOnlyComponents;
         std::atomic<uint32_t> iPaused = 0u;
         std::mutex iMutex;
         std::condition_variable iCondVar;
@@ -0,0 +1,131 @@
+// system_scheduler.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <exception>
+#include <neolib/task/thread_pool.hpp>
+#include <neolib/ecs/ecs_ids.hpp>
+
+namespace neolib::ecs
+{
+    class i_ecs;
+    class i_system;
+
+    // Runs one frame of systems for ecs_flags::ParallelSystems. The systems are ordered by id and an
+    // edge is added from an earlier system to a later one whenever they share a component that either
+    // of them writes (i_system::writes) or either of them declares no components (so may touch any);
+    // the resulting DAG is executed on a work stealing thread pool with each system started as soon as
+    // all of its predecessors finish (a system that cannot apply this frame just releases them). The
+    // DAG is cached and only rebuilt when the set of systems or their declared components change.
+    // The systems run on the ecs's own thread pool; start_frame() returns once the frame is under way
+    // so a caller such as the ecs's system timer need not wait for it, and finish_frame() collects it.
+    class NEOLIB_EXPORT system_scheduler
+    {
+    public:
+        struct system_timing
+        {
+            system_id id;
+            std::chrono::microseconds start;            // offset from the start of the frame
+            std::chrono::microseconds duration;
+            std::chrono::microseconds earliestFinish;   // longest chain of dependencies ending with this system
+            std::vector<system_id> predecessors;
+            bool critical;                              // on the frame's critical path
+        };
+        typedef std::vector<system_timing> timings_t;
+    private:
+        struct node
+        {
+            i_system* system = nullptr;
+            std::vector<std::size_t> predecessors;
+            std::vector<std::size_t> successors;
+            std::atomic<std::size_t> pending = 0u;
+            std::chrono::high_resolution_clock::time_point start;
+            std::chrono::high_resolution_clock::time_point end;
+        };
+        struct declaration
+        {
+            i_system* system = nullptr;
+            std::vector<std::pair<component_id, bool>> components; // and whether each is written
+            bool operator==(const declaration&) const = default;
+        };
+        typedef std::vector<declaration> declarations_t;
+    public:
+        system_scheduler(i_ecs& aEcs);
+        ~system_scheduler();
+    public:
+        i_ecs& ecs() const;
+        neolib::thread_pool& thread_pool() const;
+    public:
+        void run_frame(); // start_frame() then finish_frame()
+        bool start_frame(); // false if the previous frame is still running
+        bool frame_running() const;
+        void finish_frame(); // waits for the frame then records its timings; rethrows the first exception thrown by a system
+    public:
+        timings_t timings() const;
+        std::chrono::microseconds frame_time() const;
+        std::chrono::microseconds critical_path_time() const;
+        std::vector<system_id> critical_path() const;
+    private:
+        static bool conflict(const declaration& aFirst, const declaration& aSecond);
+        bool update_declarations();
+        void build_graph();
+        void dispatch(std::size_t aNode);
+        void execute(std::size_t aNode);
+        void update_timings(std::chrono::high_resolution_clock::time_point aFrameStart, std::chrono::high_resolution_clock::time_point aFrameEnd);
+    private:
+        i_ecs& iEcs;
+        declarations_t iDeclarations;
+        declarations_t iNextDeclarations;
+        std::vector<node> iNodes;
+        std::atomic<std::size_t> iRemaining;
+        bool iFrameStarted;
+        std::chrono::high_resolution_clock::time_point iFrameStart;
+        std::chrono::high_resolution_clock::time_point iFrameEnd;
+        std::mutex iFrameMutex;
+        std::condition_variable iFrameDone;
+        std::exception_ptr iException;
+        mutable std::mutex iTimingsMutex;
+        timings_t iTimings;
+        std::chrono::microseconds iFrameTime;
+        std::chrono::microseconds iCriticalPathTime;
+    };
+}
@@ -0,0 +1,292 @@
+// view.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <array>
+#include <vector>
+#include <tuple>
+#include <neolib/core/mutex.hpp>
+#include <neolib/task/event.hpp>
+#include <neolib/task/thread_pool.hpp>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/component.hpp>
+
+namespace neolib::ecs
+{
+    // A cached join over several components. The matching entity set is built by walking the smallest
+    // component's dense array and is then updated incrementally from entity_created/entity_destroyed;
+    // each component's record_version() catches any other structural change and triggers a rebuild.
+    // A pass takes one scoped_component_lock and probes records without any per-entity locking.
+    // In ecs_flags::ArchetypeChunks mode the chunk tables already group matching entities so passes
+    // stream them directly and no entity set is cached.
+    template <typename... Data>
+    class view
+    {
+        static_assert(sizeof...(Data) >= 1u && sizeof...(Data) <= 64u, "neolib::ecs::view: invalid component count");
+    public:
+        typedef std::vector<entity_id> entities_t;
+    private:
+        typedef uint64_t mask_t;
+        typedef std::array<uint32_t, sizeof...(Data)> versions_t;
+        static constexpr std::size_t invalid = ~std::size_t{};
+        static constexpr mask_t all = sizeof...(Data) == 64u ? ~mask_t{} : (mask_t{ 1u } << sizeof...(Data)) - 1u;
+    public:
+        view(i_ecs& aEcs) :
+            iEcs{ aEcs }, iStale{ true }
+        {
+            (ecs().template component<Data>(), ...);
+            iSink += ecs().entity_created([this](entity_id aEntity)
+            {
+                std::scoped_lock<neolib::recursive_spinlock> lock{ iEventsMutex };
+                iEvents.emplace_back(aEntity, true);
+            });
+            iSink += ecs().entity_destroyed([this](entity_id aEntity)
+            {
+                std::scoped_lock<neolib::recursive_spinlock> lock{ iEventsMutex };
+                iEvents.emplace_back(aEntity, false);
+            });
+        }
+        view(const view&) = delete;
+        view& operator=(const view&) = delete;
+    public:
+        i_ecs& ecs() const
+        {
+            return iEcs;
+        }
+        std::size_t size()
+        {
+            scoped_component_lock<Data...> lock{ ecs() };
+            if (ecs().chunked())
+            {
+                std::size_t result = 0u;
+                ecs().template for_each_chunk<Data...>([&](std::size_t aCount, const entity_id*, auto*...) { result += aCount; });
+                return result;
+            }
+            refresh();
+            return iEntities.size();
+        }
+        bool empty()
+        {
+            return size() == 0u;
+        }
+        void invalidate()
+        {
+            iStale = true;
+        }
+    public:
+        // Calls aCallable(entity_id, Data&...) for each matching entity.
+        template <typename Callable>
+        void each(Callable&& aCallable)
+        {
+            scoped_component_lock<Data...> lock{ ecs() };
+            if (ecs().chunked())
+            {
+                ecs().template for_each<Data...>(aCallable);
+                return;
+            }
+            refresh();
+            auto const components = std::forward_as_tuple(ecs().template component<Data>()...);
+            for (auto const entity : iEntities)
+                aCallable(entity, std::get<component<Data>&>(components).entity_record_no_lock(entity)...);
+        }
+        // As each() but the matching entities (chunks in ecs_flags::ArchetypeChunks mode) are split across
+        // ecs().thread_pool(); aCallable must be safe to call concurrently for different entities.
+        template <typename Callable>
+        void par_each(Callable&& aCallable, std::size_t aMinimumParallelismCount = 0u)
+        {
+            scoped_component_lock<Data...> lock{ ecs() };
+            if (ecs().chunked())
+            {
+                typedef std::tuple<std::size_t, const entity_id*, component_value_t<Data>*...> chunk_t;
+                std::vector<chunk_t> chunks;
+                std::size_t count = 0u;
+                ecs().template for_each_chunk<Data...>([&](std::size_t aCount, const entity_id* aEntities, component_value_t<Data>*... aColumns)
+                {
+                    chunks.emplace_back(aCount, aEntities, aColumns...);
+                    count += aCount;
+                });
+                neolib::parallel_apply(ecs().thread_pool(), chunks, [&](chunk_t& aChunk)
+                {
+                    std::apply([&](std::size_t aCount, const entity_id* aEntities, auto*... aColumns)
+                    {
+                        for (std::size_t row = 0u; row < aCount; ++row)
+                            aCallable(aEntities[row], aColumns[row]...);
+                    }, aChunk);
+                }, count < aMinimumParallelismCount ? chunks.size() + 1u : 0u);
+                return;
+            }
+            refresh();
+            auto const components = std::forward_as_tuple(ecs().template component<Data>()...);
+            neolib::parallel_apply(ecs().thread_pool(), iEntities, [&](entity_id& aEntity)
+            {
+                aCallable(aEntity, std::get<component<Data>&>(components).entity_record_no_lock(aEntity)...);
+            }, aMinimumParallelismCount);
+        }
+    private:
+        void refresh()
+        {
+            auto const versions = current_versions();
+            std::vector<std::pair<entity_id, bool>> events;
+            {
+                std::scoped_lock<neolib::recursive_spinlock> lock{ iEventsMutex };
+                std::swap(events, iEvents);
+            }
+            if (iStale)
+            {
+                rebuild(versions);
+                return;
+            }
+            if (events.empty() && versions == iVersions)
+                return;
+            // every record added or removed by a created or destroyed entity is accounted for; anything
+            // left over (a component populated or removed later on) means the cache can't be patched
+            versions_t expected = iVersions;
+            for (auto const& event : events)
+            {
+                auto const entity = event.first;
+                auto const mask = event.second ? current_mask(entity) : mask_of(entity);
+                for (std::size_t index = 0u; index < sizeof...(Data); ++index)
+                    if (mask & (mask_t{ 1u } << index))
+                        ++expected[index];
+                if (event.second)
+                {
+                    set_mask(entity, mask);
+                    if (mask == all && position_of(entity) == invalid)
+                        add(entity);
+                }
+                else
+                {
+                    set_mask(entity, 0u);
+                    if (position_of(entity) != invalid)
+                        remove(entity);
+                }
+            }
+            if (expected != versions)
+                rebuild(versions);
+            else
+                iVersions = versions;
+        }
+        void rebuild(const versions_t& aVersions)
+        {
+            iEntities.clear();
+            iPositions.clear();
+            iMasks.clear();
+            std::size_t index = 0u;
+            std::size_t smallest = invalid;
+            std::size_t smallestIndex = 0u;
+            auto mark = [&](auto& aComponent)
+            {
+                for (auto const entity : aComponent.entities())
+                    if (entity != null_entity)
+                        set_mask(entity, mask_of(entity) | (mask_t{ 1u } << index));
+                if (aComponent.entities().size() < smallest)
+                {
+                    smallest = aComponent.entities().size();
+                    smallestIndex = index;
+                }
+                ++index;
+            };
+            (mark(ecs().template component<Data>()), ...);
+            index = 0u;
+            auto collect = [&](auto& aComponent)
+            {
+                if (index++ != smallestIndex)
+                    return;
+                for (auto const entity : aComponent.entities())
+                    if (entity != null_entity && mask_of(entity) == all)
+                        add(entity);
+            };
+            (collect(ecs().template component<Data>()), ...);
+            iVersions = aVersions;
+            iStale = false;
+        }
+        versions_t current_versions() const
+        {
+            return versions_t{ ecs().template component<Data>().record_version()... };
+        }
+        mask_t current_mask(entity_id aEntity) const
+        {
+            mask_t result = 0u;
+            std::size_t index = 0u;
+            ((result |= ecs().template component<Data>().has_entity_record_no_lock(aEntity) ? (mask_t{ 1u } << index) : 0u, ++index), ...);
+            return result;
+        }
+        mask_t mask_of(entity_id aEntity) const
+        {
+            auto const index = entity_index(aEntity);
+            return index < iMasks.size() ? iMasks[index] : 0u;
+        }
+        void set_mask(entity_id aEntity, mask_t aMask)
+        {
+            auto const index = entity_index(aEntity);
+            if (iMasks.size() <= index)
+                iMasks.resize(index + 1u, 0u);
+            iMasks[index] = aMask;
+        }
+        std::size_t position_of(entity_id aEntity) const
+        {
+            auto const index = entity_index(aEntity);
+            return index < iPositions.size() ? iPositions[index] : invalid;
+        }
+        void add(entity_id aEntity)
+        {
+            auto const index = entity_index(aEntity);
+            if (iPositions.size() <= index)
+                iPositions.resize(index + 1u, invalid);
+            iPositions[index] = iEntities.size();
+            iEntities.push_back(aEntity);
+        }
+        void remove(entity_id aEntity)
+        {
+            auto const position = iPositions[entity_index(aEntity)];
+            iPositions[entity_index(iEntities.back())] = position;
+            iEntities[position] = iEntities.back();
+            iEntities.pop_back();
+            iPositions[entity_index(aEntity)] = invalid;
+        }
+    private:
+        i_ecs& iEcs;
+        entities_t iEntities;
+        std::vector<std::size_t> iPositions;
+        std::vector<mask_t> iMasks;
+        versions_t iVersions;
+        bool iStale;
+        neolib::recursive_spinlock iEventsMutex;
+        std::vector<std::pair<entity_id, bool>> iEvents;
+        sink iSink;
+    };
+}
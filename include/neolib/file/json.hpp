@@ -53,6 +53,7 @@
 #include <variant>
 #include <boost/functional/hash.hpp>
 #include <neolib/core/allocator.hpp>
+#include <neolib/core/arena_allocator.hpp>
 #include <neolib/core/quick_string.hpp>
 
 namespace neolib
@@ -146,8 +147,42 @@ namespace neolib
 
     namespace json_detail
     {
+        template <typename Alloc>
+        struct allocator_deleter
+        {
+            Alloc allocator;
+            void operator()(typename std::allocator_traits<Alloc>::value_type* aObject)
+            {
+                std::allocator_traits<Alloc>::destroy(allocator, aObject);
+                std::allocator_traits<Alloc>::deallocate(allocator, aObject, 1);
+            }
+        };
+
+        template <typename T, typename Alloc>
+        using allocated_unique_ptr = std::unique_ptr<T, allocator_deleter<typename std::allocator_traits<Alloc>::template rebind_alloc<T>>>;
+
+        template <typename T, typename Alloc, typename... Args>
+        inline allocated_unique_ptr<T, Alloc> allocate_unique(const Alloc& aAllocator, Args&&... aArguments)
+        {
+            typedef typename std::allocator_traits<Alloc>::template rebind_alloc<T> allocator_type;
+            allocator_type allocator{ aAllocator };
+            T* object = std::allocator_traits<allocator_type>::allocate(allocator, 1);
+            try
+            {
+                std::allocator_traits<allocator_type>::construct(allocator, object, std::forward<Args>(aArguments)...);
+            }
+            catch (...)
+            {
+                std::allocator_traits<allocator_type>::deallocate(allocator, object, 1);
+                throw;
+            }
+            return allocated_unique_ptr<T, Alloc>{ object, allocator_deleter<allocator_type>{ allocator } };
+        }
+
+        // The allocator is held as a base so that stateless allocators cost nothing; children inherit their
+        // parent's allocator so a whole tree allocates from wherever its root was created.
         template <typename T>
-        class basic_json_node
+        class basic_json_node : private T::value_allocator
         {
             typedef basic_json_node<T> self_type;
             template <json_syntax Syntax, typename Alloc , typename CharT, typename Traits, typename CharAlloc>
@@ -159,6 +194,7 @@ namespace neolib
             typedef typename json_value::value_allocator value_allocator;
         public:
             basic_json_node() : 
+                value_allocator{},
                 iParent{ nullptr },
                 iPrevious{ nullptr }, 
                 iNext{ nullptr },
@@ -166,7 +202,17 @@ namespace neolib
                 iLastChild{ nullptr }
             {
             }
+            basic_json_node(const value_allocator& aAllocator) :
+                value_allocator{ aAllocator },
+                iParent{ nullptr },
+                iPrevious{ nullptr },
+                iNext{ nullptr },
+                iFirstChild{ nullptr },
+                iLastChild{ nullptr }
+            {
+            }
             basic_json_node(json_value& aParent) :
+                value_allocator{ aParent.iNode.get_allocator() },
                 iParent{ &aParent },
                 iPrevious{ nullptr },
                 iNext{ nullptr },
@@ -188,6 +234,11 @@ namespace neolib
             {
                 return construct_child(allocate_child(), aParent, std::move(aValue));
             }
+        public:
+            const value_allocator& get_allocator() const
+            {
+                return *this;
+            }
         public:
             bool has_parent() const
             {
@@ -288,10 +339,9 @@ namespace neolib
                 deallocate_child(aAddress);
             }
         private:
-            static value_allocator& allocator()
+            value_allocator& allocator()
             {
-                static value_allocator sAllocator;
-                return sAllocator;
+                return *this;
             }
             json_value* iParent;
             json_value* iPrevious;
@@ -321,6 +371,7 @@ namespace neolib
             boost::hash<json_string>, 
             std::equal_to<json_string>, 
             typename std::allocator_traits<allocator_type>::template rebind_alloc<std::pair<const json_string, json_value*>>> dictionary_type;
+        typedef json_detail::allocated_unique_ptr<dictionary_type, allocator_type> dictionary_pointer;
     public:
         basic_json_object() :
             iContents{ nullptr }
@@ -380,7 +431,9 @@ namespace neolib
             if (existing != cache().end())
                 return *existing->second;
             auto& newChild = contents().emplace_back(value_type{});
-            newChild.set_name(aKey.to_std_string());
+            json_string name{ newChild.string_allocator() };
+            name.assign(aKey.to_std_string_view().data(), aKey.size());
+            newChild.set_name(std::move(name));
             cache().emplace(newChild.name(), &newChild);
             return newChild;
         }
@@ -400,7 +453,7 @@ namespace neolib
         {
             if (iLazyDictionary != nullptr)
                 return *iLazyDictionary;
-            iLazyDictionary = std::make_unique<dictionary_type>(); // todo: use allocator_type
+            iLazyDictionary = json_detail::allocate_unique<dictionary_type>(contents().get_allocator(), typename dictionary_type::allocator_type{ contents().get_allocator() });
             for (auto i = contents().begin(); i != contents().end(); ++i)
                 iLazyDictionary->emplace(i.value().name(), &i.value());
             return *iLazyDictionary;
@@ -411,7 +464,7 @@ namespace neolib
         }
     private:
         json_value* iContents;
-        mutable std::unique_ptr<dictionary_type> iLazyDictionary;
+        mutable dictionary_pointer iLazyDictionary;
     };
 
     template <typename T>
@@ -428,7 +481,8 @@ namespace neolib
         typedef typename json_value::json_string json_string;
     private:
         typedef typename json_value::value_allocator allocator_type;
-        typedef std::vector<json_value*> array_type;
+        typedef std::vector<json_value*, typename std::allocator_traits<allocator_type>::template rebind_alloc<json_value*>> array_type;
+        typedef json_detail::allocated_unique_ptr<array_type, allocator_type> array_pointer;
     public:
         basic_json_array() :
             iContents{ nullptr }
@@ -475,7 +529,7 @@ namespace neolib
         {
             if (iLazyArray != nullptr)
                 return *iLazyArray;
-            iLazyArray = std::make_unique<array_type>(); // todo: use allocator_type
+            iLazyArray = json_detail::allocate_unique<array_type>(contents().get_allocator(), typename array_type::allocator_type{ contents().get_allocator() });
             for (auto& e : contents())
                 iLazyArray->emplace_back(&e);
             return *iLazyArray;
@@ -486,7 +540,7 @@ namespace neolib
         }
     private:
         json_value* iContents;
-        mutable std::unique_ptr<array_type> iLazyArray;
+        mutable array_pointer iLazyArray;
     };
 
     template <typename T>
@@ -572,15 +626,34 @@ namespace neolib
             iNode{ aParent }, iValue{ aValue }, iDocumentSourceLocation{}
         {
             update_contents();
+            bind_strings();
         }
         basic_json_value(reference aParent, value_type&& aValue) :
             iNode{ aParent }, iValue{ std::move(aValue) }, iDocumentSourceLocation{}
         {
             update_contents();
+            bind_strings();
+        }
+        basic_json_value(const value_allocator& aAllocator) :
+            iNode{ aAllocator }, iValue{}, iDocumentSourceLocation{}
+        {
         }
     public:
         basic_json_value(const basic_json_value&) = delete;
         basic_json_value(basic_json_value&&) = delete;
+    public:
+        const value_allocator& get_allocator() const
+        {
+            return iNode.get_allocator();
+        }
+        // the allocator for this value's strings: the arena of the document the value belongs to for arena documents
+        character_allocator_type string_allocator() const
+        {
+            if constexpr (is_arena_allocator_v<allocator_type> && is_arena_allocator_v<character_allocator_type>)
+                return character_allocator_type{ get_allocator() };
+            else
+                return character_allocator_type{};
+        }
     public:
         template <typename T>
         std::enable_if_t<!std::is_arithmetic_v<T>, const T&> as() const
@@ -622,12 +695,14 @@ namespace neolib
         {
             iValue = aValue;
             update_contents();
+            bind_strings();
             return *this;
         }
         reference operator=(value_type&& aValue)
         {
             iValue = std::move(aValue);
             update_contents();
+            bind_strings();
             return *this;
         }
     public:
@@ -672,10 +747,17 @@ namespace neolib
         void set_name(const json_string& aName)
         {
             iName = aName;
+            bind_string(std::get<json_string>(iName));
+        }
+        void set_name(json_string&& aName)
+        {
+            iName = std::move(aName);
+            bind_string(std::get<json_string>(iName));
         }
         void set_name(const json_keyword& aName)
         {
             iName = aName;
+            bind_string(std::get<json_keyword>(iName).text);
         }
     public:
         bool is_root() const
@@ -809,8 +891,9 @@ namespace neolib
         }
         void clear()
         {
+            auto const allocator = iNode.get_allocator();
             iNode.~node_type();
-            new(&iNode) node_type();
+            new(&iNode) node_type(allocator);
         }
         template <typename... Args>
         reference emplace_back(Args&&... aArguments)
@@ -848,6 +931,28 @@ namespace neolib
             else if (type() == json_type::Array)
                 std::get<json_array>(iValue).set_contents(*this);
         }
+        void bind_strings()
+        {
+            if (type() == json_type::String)
+                bind_string(std::get<json_string>(iValue));
+            else if (type() == json_type::Keyword)
+                bind_string(std::get<json_keyword>(iValue).text);
+        }
+        // in arena documents a value's strings are allocated from the arena of the value's own node rather than from
+        // whichever arena is current on the thread; a string from anywhere else is copied into that arena
+        void bind_string(json_string& aString) const
+        {
+            if constexpr (is_arena_allocator_v<allocator_type> && is_arena_allocator_v<character_allocator_type>)
+            {
+                auto const allocator = string_allocator();
+                if (aString.get_allocator() != allocator)
+                {
+                    json_string bound{ allocator };
+                    bound.assign(aString.to_std_string_view().data(), aString.size());
+                    aString.swap(bound);
+                }
+            }
+        }
     private:
         node_type iNode;
         name_t iName;
@@ -891,7 +996,11 @@ namespace neolib
         class const_iterator;
         class iterator;
     private:
-        typedef std::basic_string<CharT, Traits, CharAlloc> string_type;
+        typedef std::basic_string<CharT, Traits> string_type;
+        static constexpr bool arena_mode = is_arena_allocator_v<allocator_type> || is_arena_allocator_v<character_allocator_type>;
+        // when every node and string lives in the arena the tree is abandoned, not destroyed, and freed in O(blocks)
+        static constexpr bool arena_owns_tree = is_arena_allocator_v<allocator_type> && is_arena_allocator_v<character_allocator_type>;
+        typedef std::conditional_t<arena_mode, monotonic_arena, std::monostate> arena_type;
         struct element
         {
             enum type_e
@@ -914,6 +1023,14 @@ namespace neolib
         basic_json(const std::string& aPath, bool aValidateUtf = false);
         template <typename Elem, typename ElemTraits>
         basic_json(std::basic_istream<Elem, ElemTraits>& aInput, bool aValidateUtf = false);
+        ~basic_json();
+    public:
+        // the document's arena (std::monostate for non-arena documents); values and their strings are allocated with
+        // their parent's allocator so always come from the arena of the document they belong to
+        const arena_type& arena() const
+        {
+            return iArena;
+        }
     public:
         void clear();
         bool read(const std::string& aPath, bool aValidateUtf = false);
@@ -949,6 +1066,18 @@ namespace neolib
     private:
         json_string& document();
         string_type to_error_text(const string_type& aExtraInfo = {}) const;
+        allocator_type allocator() const;
+        character_allocator_type string_allocator() const;
+        void release_arena();
+        // while the returned object is alive temporary strings created by this document's parser and writer come
+        // from its arena
+        auto arena_scope() const
+        {
+            if constexpr (arena_mode)
+                return monotonic_arena::scope{ iArena };
+            else
+                return std::monostate{};
+        }
     private:
         template <typename Elem, typename ElemTraits>
         bool do_read(std::basic_istream<Elem, ElemTraits>& aInput, bool aValidateUtf = false);
@@ -958,6 +1087,7 @@ namespace neolib
         json_value* buy_value(element& aCurrentElement, T&& aValue);
         void create_parse_error(const string_type& aExtraInfo = {}) const;
     private:
+        mutable arena_type iArena;
         json_encoding iEncoding;
         json_string iDocumentText;
         json_document_source_location iCursor;
@@ -1050,6 +1180,10 @@ namespace neolib
     typedef fast_fjson::json_bool fast_fjson_bool;
     typedef fast_fjson::json_null fast_fjson_null;
     typedef fast_fjson::json_keyword fast_fjson_keyword;
+
+    typedef basic_json<json_syntax::Standard, arena_allocator<json_type>, char, std::char_traits<char>, arena_allocator<char>> arena_json;
+    typedef basic_json<json_syntax::Relaxed, arena_allocator<json_type>, char, std::char_traits<char>, arena_allocator<char>> arena_rjson;
+    typedef basic_json<json_syntax::Functional, arena_allocator<json_type>, char, std::char_traits<char>, arena_allocator<char>> arena_fjson;
 }
 
 #include <neolib/file/json.inl>
@@ -0,0 +1,742 @@
+// json_stream.hpp
+/*
+ *  NoFussJSON v1.0
+ *
+ *  Copyright (c) 2018, 2020 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <variant>
+#include <istream>
+#include <neolib/file/json.hpp>
+
+namespace neolib
+{
+    enum class json_stream_event
+    {
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+        Key,
+        Value
+    };
+
+    // Streaming (SAX-style) parser driven by the same state tables as basic_json::do_parse(). Input is pushed in
+    // chunks of any size (parse state, including partial strings and escape sequences, carries across chunk
+    // boundaries) and events are delivered to a handler providing:
+    //     start_object(), end_object(), start_array(), end_array(), key(string_view_type const&) and value(scalar const&)
+    // Memory use is bounded by nesting depth and the longest single string, name, number or keyword; concatenated
+    // top level objects and arrays (e.g. JSON lines) are parsed as a sequence of documents.
+    template <json_syntax Syntax = json_syntax::Standard, typename CharT = char, typename Traits = std::char_traits<CharT>, typename CharAlloc = std::allocator<CharT>>
+    class basic_json_stream_parser
+    {
+        typedef basic_json_stream_parser<Syntax, CharT, Traits, CharAlloc> self_type;
+    public:
+        static constexpr json_syntax syntax = Syntax;
+        typedef CharT character_type;
+        typedef Traits character_traits_type;
+        typedef CharAlloc character_allocator_type;
+        typedef std::basic_string<CharT, Traits, CharAlloc> string_type;
+        typedef std::basic_string_view<CharT, Traits> string_view_type;
+        typedef std::variant<std::monostate, double, int64_t, uint64_t, int32_t, uint32_t> number_type;
+        struct scalar
+        {
+            json_type type; // String, Double, Int64, Uint64, Int, Uint, Bool, Null or Keyword
+            string_view_type text; // unescaped string contents, number text or keyword text
+            number_type number;
+        };
+    private:
+        typedef basic_json<Syntax, std::allocator<json_type>, CharT, Traits, CharAlloc> document_type;
+        static constexpr bool usePreviousState = (Syntax == json_syntax::Relaxed || Syntax == json_syntax::Functional);
+        enum element_type
+        {
+            Unknown,
+            String,
+            Number,
+            Keyword,
+            Name
+        };
+    public:
+        basic_json_stream_parser()
+        {
+            clear();
+        }
+    public:
+        void clear()
+        {
+            iState = json_detail::state::Value;
+            iCommentState = std::nullopt;
+            iSkipCharacter = false;
+            iPending = std::nullopt;
+            iFinishing = false;
+            iElement = Unknown;
+            iText.clear();
+            iQuote = character_type{};
+            iHaveName = false;
+            iContext.clear();
+            iUnicodeEscape.clear();
+            iUtf16HighSurrogate = std::nullopt;
+            iCursor.line = 1;
+            iCursor.column = 1;
+            iErrorText.clear();
+        }
+        template <typename Handler>
+        bool parse(string_view_type const& aChunk, Handler& aHandler)
+        {
+            if (has_error())
+                return false;
+            if (finished())
+                return fail("input after end of document");
+            if (aChunk.empty())
+                return true;
+            // each character is processed once its successor is known as comments need one character of lookahead
+            if (iPending && !process(*iPending, aChunk[0], aHandler))
+                return false;
+            auto const last = aChunk.size() - 1u;
+            for (std::size_t i = 0u; i < last; ++i)
+                if (!process(aChunk[i], aChunk[i + 1u], aHandler))
+                    return false;
+            iPending = aChunk[last];
+            return true;
+        }
+        template <typename Handler>
+        bool finish(Handler& aHandler)
+        {
+            if (has_error())
+                return false;
+            if (finished())
+                return true;
+            if (iPending && !process(*iPending, character_type{ '\n' }, aHandler))
+                return false;
+            iPending = std::nullopt;
+            iFinishing = true;
+            if (!process(character_type{ '\n' }, character_type{ '\0' }, aHandler) || !process(character_type{ '\0' }, character_type{ '\0' }, aHandler))
+                return false;
+            if (!finished())
+                return fail("unexpected end of input");
+            return true;
+        }
+        template <typename Handler>
+        bool parse(std::basic_istream<CharT, Traits>& aInput, Handler& aHandler, std::size_t aChunkSize = 65536u)
+        {
+            std::vector<character_type> buffer(aChunkSize);
+            while (aInput.read(buffer.data(), buffer.size()) || aInput.gcount() > 0)
+                if (!parse(string_view_type{ buffer.data(), static_cast<std::size_t>(aInput.gcount()) }, aHandler))
+                    return false;
+            return finish(aHandler);
+        }
+    public:
+        bool finished() const
+        {
+            return iState == json_detail::state::EndOfParse;
+        }
+        bool has_error() const
+        {
+            return !iErrorText.empty();
+        }
+        string_type const& error_text() const
+        {
+            return iErrorText;
+        }
+        json_document_source_location const& cursor() const
+        {
+            return iCursor;
+        }
+    private:
+        template <typename Handler>
+        bool process(character_type aCharacter, character_type aNextCharacter, Handler& aHandler)
+        {
+            if (iSkipCharacter)
+            {
+                // second character of a C-style comment terminator
+                iSkipCharacter = false;
+                increment_cursor(aCharacter);
+                return true;
+            }
+            json_detail::state nextState;
+            if constexpr (!usePreviousState)
+                nextState = json_detail::next_state<syntax>(iState, aCharacter);
+            else
+            {
+                auto const tempState = iCommentState ? *iCommentState : iState;
+                nextState = json_detail::next_state<syntax>(tempState, json_detail::state::Value, aCharacter, aNextCharacter);
+                if (nextState == json_detail::state::CppStyleComment || nextState == json_detail::state::CStyleComment)
+                {
+                    iCommentState = nextState;
+                    increment_cursor(aCharacter);
+                    return true;
+                }
+                iCommentState = std::nullopt;
+                if (tempState == json_detail::state::CStyleComment && nextState == json_detail::state::Ignore)
+                    iSkipCharacter = true;
+            }
+            if constexpr (Syntax == json_syntax::Functional)
+            {
+                if (nextState == json_detail::state::Error)
+                {
+                    switch (iState)
+                    {
+                    case json_detail::state::NumberInt:
+                    case json_detail::state::NumberFrac:
+                    case json_detail::state::NumberExpInt:
+                        switch (to_token(json_detail::sTokenTable<json_syntax::Functional>, aCharacter))
+                        {
+                        case json_detail::token::Character:
+                        case json_detail::token::HexDigit:
+                        case json_detail::token::EscapedOrHexDigit:
+                            iState = json_detail::state::Keyword;
+                            nextState = json_detail::state::Keyword;
+                            iElement = Keyword;
+                            break;
+                        default:
+                            break;
+                        }
+                    default:
+                        break;
+                    }
+                }
+            }
+            // a high surrogate escape must be followed straight away by a low surrogate escape
+            if (iUtf16HighSurrogate && nextState != json_detail::state::Escaping && nextState != json_detail::state::EscapingUnicode && nextState != json_detail::state::Escaped)
+                return fail("invalid surrogate pair");
+            switch (nextState)
+            {
+            case json_detail::state::Ignore:
+                increment_cursor(aCharacter);
+                return true;
+            case json_detail::state::Error:
+                return fail();
+            case json_detail::state::EndOfParse:
+                if (!iFinishing)
+                    return fail();
+                iState = nextState;
+                return true;
+            default:
+                if (iState == nextState)
+                {
+                    switch (iState)
+                    {
+                    case json_detail::state::String:
+                    case json_detail::state::Keyword:
+                    case json_detail::state::Name:
+                    case json_detail::state::NumberInt:
+                    case json_detail::state::NumberFrac:
+                    case json_detail::state::NumberExpInt:
+                        iText += aCharacter;
+                        // fall through
+                    default:
+                        increment_cursor(aCharacter);
+                        return true;
+                    case json_detail::state::Object:
+                    case json_detail::state::Array:
+                        break;
+                    }
+                }
+            }
+            switch (nextState)
+            {
+            case json_detail::state::Close:
+            case json_detail::state::Element:
+                switch (iElement)
+                {
+                case Unknown:
+                    break;
+                case String:
+                    if (!emit_value(aHandler, json_type::String, {}))
+                        return false;
+                    break;
+                case Name:
+                    if (context() == json_type::Object && !iHaveName)
+                        emit_key(aHandler);
+                    break;
+                case Number:
+                    {
+                        number_type number;
+                        try
+                        {
+                            if (iState == json_detail::state::NumberInt)
+                                std::visit([&number](auto&& arg)
+                                {
+                                    if constexpr (!std::is_same_v<std::decay_t<decltype(arg)>, std::monostate>)
+                                        number = arg;
+                                }, string_to_number(string_view_type{ iText }));
+                            else
+                                number = string_to_double(string_view_type{ iText });
+                        }
+                        catch (std::exception& e)
+                        {
+                            return fail(e.what());
+                        }
+                        if (!emit_value(aHandler, number_type_of(number), number))
+                            return false;
+                    }
+                    break;
+                case Keyword:
+                    {
+                        bool const isNull = text_is("null");
+                        if (isNull || text_is("true") || text_is("false"))
+                        {
+                            if (context() == json_type::Object && !iHaveName)
+                                return fail("bad object field name");
+                            if (!emit_value(aHandler, isNull ? json_type::Null : json_type::Bool, {}))
+                                return false;
+                        }
+                        else
+                        {
+                            if constexpr (syntax == json_syntax::StandardNoKeywords)
+                                return fail("keywords unavailable");
+                            if (context() == json_type::Object && !iHaveName)
+                            {
+                                emit_key(aHandler);
+                                iElement = Name;
+                            }
+                            else if (!emit_value(aHandler, json_type::Keyword, {}))
+                                return false;
+                        }
+                    }
+                    break;
+                default:
+                    break;
+                }
+                if (nextState == json_detail::state::Close)
+                {
+                    if (iContext.empty())
+                        return fail();
+                    auto const closed = iContext.back();
+                    iContext.pop_back();
+                    if (closed == json_type::Object)
+                        aHandler.end_object();
+                    else
+                        aHandler.end_array();
+                }
+                switch (context())
+                {
+                case json_type::Object:
+                    if constexpr (syntax == json_syntax::Standard)
+                    {
+                        if (!iHaveName)
+                        {
+                            if (nextState == json_detail::state::Close)
+                                nextState = json_detail::state::NeedObjectValueSeparator;
+                            else if (aCharacter == ',')
+                                nextState = json_detail::state::NeedObjectValue;
+                            else
+                                nextState = json_detail::state::NeedObjectValueSeparator;
+                        }
+                        else
+                            nextState = json_detail::state::NeedValue;
+                    }
+                    else
+                    {
+                        if (!iHaveName)
+                            nextState = json_detail::state::Object;
+                        else
+                            nextState = aCharacter != ':' ? json_detail::state::EndName : json_detail::state::NeedValue;
+                    }
+                    break;
+                case json_type::Array:
+                    if constexpr (syntax == json_syntax::Standard)
+                    {
+                        if (aCharacter == ',')
+                            nextState = json_detail::state::NeedValue;
+                        else
+                            nextState = json_detail::state::NeedValueSeparator;
+                    }
+                    else
+                        nextState = json_detail::state::Value;
+                    break;
+                default:
+                    if (nextState == json_detail::state::Close)
+                        nextState = json_detail::state::Value;
+                    break;
+                }
+                iElement = Unknown;
+                iText.clear();
+                break;
+            case json_detail::state::String:
+                iElement = String;
+                iText.clear();
+                iQuote = aCharacter;
+                break;
+            case json_detail::state::Name:
+                iElement = Name;
+                iText.clear();
+                iQuote = aCharacter;
+                break;
+            case json_detail::state::EndName:
+                if (!iHaveName)
+                    emit_key(aHandler);
+                break;
+            case json_detail::state::NumberIntNeedDigit:
+                iElement = Number;
+                iText.assign(1u, aCharacter);
+                break;
+            case json_detail::state::NumberInt:
+                if (iElement != Number)
+                {
+                    iElement = Number;
+                    iText.assign(1u, aCharacter);
+                }
+                else
+                    iText += aCharacter;
+                break;
+            case json_detail::state::NumberFracNeedDigit:
+            case json_detail::state::NumberFrac:
+            case json_detail::state::NumberExpSign:
+            case json_detail::state::NumberExpIntNeedDigit:
+            case json_detail::state::NumberExpInt:
+                iText += aCharacter;
+                break;
+            case json_detail::state::Array:
+                if (!start_composite(json_type::Array))
+                    return false;
+                aHandler.start_array();
+                nextState = json_detail::state::Value;
+                break;
+            case json_detail::state::Object:
+                if (!start_composite(json_type::Object))
+                    return false;
+                aHandler.start_object();
+                break;
+            case json_detail::state::Keyword:
+                iElement = Keyword;
+                iText.assign(1u, aCharacter);
+                break;
+            case json_detail::state::StringEnd:
+                if constexpr (syntax == json_syntax::Relaxed)
+                {
+                    // relaxed: support for three different quote characters
+                    if (aCharacter != iQuote)
+                    {
+                        iText += aCharacter;
+                        nextState = json_detail::state::String;
+                    }
+                }
+                break;
+            case json_detail::state::EscapingUnicode:
+                iUnicodeEscape.clear();
+                break;
+            case json_detail::state::Escaped:
+                if (iState == json_detail::state::Escaping)
+                {
+                    if (iUtf16HighSurrogate)
+                        return fail("invalid surrogate pair");
+                    switch (aCharacter)
+                    {
+                    case '\"':
+                        iText += character_type{ '\"' };
+                        break;
+                    case '\\':
+                        iText += character_type{ '\\' };
+                        break;
+                    case '/':
+                        iText += character_type{ '/' };
+                        break;
+                    case 'b':
+                        iText += character_type{ '\b' };
+                        break;
+                    case 'f':
+                        iText += character_type{ '\f' };
+                        break;
+                    case 'n':
+                        iText += character_type{ '\n' };
+                        break;
+                    case 'r':
+                        iText += character_type{ '\r' };
+                        break;
+                    case 't':
+                        iText += character_type{ '\t' };
+                        break;
+                    default:
+                        break;
+                    }
+                    nextState = iElement == String ? json_detail::state::String : json_detail::state::Name;
+                }
+                else if (iState == json_detail::state::EscapingUnicode)
+                {
+                    iUnicodeEscape += static_cast<char>(aCharacter);
+                    if (iUnicodeEscape.size() == 4u)
+                    {
+                        if (!append_escaped_unicode(static_cast<char16_t>(std::stoul(iUnicodeEscape, nullptr, 16))))
+                            return fail("invalid surrogate pair");
+                        nextState = iElement == String ? json_detail::state::String : json_detail::state::Name;
+                    }
+                    else
+                        nextState = json_detail::state::EscapingUnicode;
+                }
+                break;
+            default:
+                break;
+            }
+            iState = nextState;
+            increment_cursor(aCharacter);
+            return true;
+        }
+        json_type context() const
+        {
+            if (!iContext.empty())
+                return iContext.back();
+            return json_type::Unknown;
+        }
+        bool start_composite(json_type aType)
+        {
+            if (context() == json_type::Object && !iHaveName)
+                return fail("bad object field name");
+            iHaveName = false;
+            iContext.push_back(aType);
+            return true;
+        }
+        template <typename Handler>
+        void emit_key(Handler& aHandler)
+        {
+            iHaveName = true;
+            aHandler.key(string_view_type{ iText });
+        }
+        template <typename Handler>
+        bool emit_value(Handler& aHandler, json_type aType, number_type const& aNumber)
+        {
+            if (context() == json_type::Object)
+            {
+                if (!iHaveName)
+                    return fail("bad object field name");
+                iHaveName = false;
+            }
+            aHandler.value(scalar{ aType, string_view_type{ iText }, aNumber });
+            return true;
+        }
+        bool text_is(char const* aKeyword) const
+        {
+            std::size_t i = 0u;
+            for (; i < iText.size() && aKeyword[i] != '\0'; ++i)
+                if (iText[i] != static_cast<character_type>(aKeyword[i]))
+                    return false;
+            return i == iText.size() && aKeyword[i] == '\0';
+        }
+        static json_type number_type_of(number_type const& aNumber)
+        {
+            switch (aNumber.index())
+            {
+            case 1:
+                return json_type::Double;
+            case 2:
+                return json_type::Int64;
+            case 3:
+                return json_type::Uint64;
+            case 4:
+                return json_type::Int;
+            case 5:
+                return json_type::Uint;
+            default:
+                return json_type::Unknown;
+            }
+        }
+        // returns false for an unpaired surrogate
+        bool append_escaped_unicode(char16_t aCodeUnit)
+        {
+            if (utf16::is_high_surrogate(aCodeUnit))
+            {
+                if (iUtf16HighSurrogate)
+                    return false;
+                iUtf16HighSurrogate = aCodeUnit;
+                return true;
+            }
+            if (utf16::is_low_surrogate(aCodeUnit) != iUtf16HighSurrogate.has_value())
+                return false;
+            std::u16string utf16;
+            if (iUtf16HighSurrogate)
+                utf16 = { *iUtf16HighSurrogate, aCodeUnit };
+            else
+                utf16 = { aCodeUnit };
+            iUtf16HighSurrogate = std::nullopt;
+            switch (json_detail::default_encoding<CharT>::DEFAULT_ENCODING)
+            {
+            case json_encoding::Utf8:
+                {
+                    auto const utf8 = utf16_to_utf8(utf16);
+                    iText.append(utf8.begin(), utf8.end());
+                }
+                break;
+            case json_encoding::Utf16LE:
+            case json_encoding::Utf16BE:
+                iText.append(utf16.begin(), utf16.end());
+                break;
+            case json_encoding::Utf32LE:
+            case json_encoding::Utf32BE:
+                iText += static_cast<character_type>(utf8_to_utf32(utf16_to_utf8(utf16))[0]);
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+        void increment_cursor(character_type aCharacter)
+        {
+            if (aCharacter != '\n')
+                ++iCursor.column;
+            else
+            {
+                iCursor.column = 1;
+                ++iCursor.line;
+            }
+        }
+        bool fail(string_type const& aExtraInfo = {})
+        {
+            iState = json_detail::state::Error;
+            iErrorText = document_type::to_error_text(iCursor, aExtraInfo);
+            return false;
+        }
+    private:
+        json_detail::state iState;
+        std::optional<json_detail::state> iCommentState;
+        bool iSkipCharacter;
+        std::optional<character_type> iPending;
+        bool iFinishing;
+        element_type iElement;
+        string_type iText;
+        character_type iQuote;
+        bool iHaveName;
+        std::vector<json_type> iContext;
+        std::string iUnicodeEscape;
+        std::optional<char16_t> iUtf16HighSurrogate;
+        json_document_source_location iCursor;
+        string_type iErrorText;
+    };
+
+    // Pull interface over basic_json_stream_parser: the input stream is read one chunk at a time as events are consumed.
+    template <json_syntax Syntax = json_syntax::Standard, typename CharT = char, typename Traits = std::char_traits<CharT>, typename CharAlloc = std::allocator<CharT>>
+    class basic_json_stream_reader
+    {
+    public:
+        typedef basic_json_stream_parser<Syntax, CharT, Traits, CharAlloc> parser_type;
+        typedef typename parser_type::character_type character_type;
+        typedef typename parser_type::string_type string_type;
+        typedef typename parser_type::string_view_type string_view_type;
+        typedef typename parser_type::number_type number_type;
+        struct event
+        {
+            json_stream_event type;
+            json_type valueType; // for json_stream_event::Value
+            string_type text; // key or value text
+            number_type number;
+        };
+    private:
+        struct event_queue
+        {
+            std::vector<event> events;
+            std::size_t count = 0u;
+
+            event& push(json_stream_event aType)
+            {
+                if (count == events.size())
+                    events.emplace_back();
+                auto& e = events[count++];
+                e.type = aType;
+                e.valueType = json_type::Unknown;
+                e.text.clear();
+                e.number = number_type{};
+                return e;
+            }
+            void start_object() { push(json_stream_event::StartObject); }
+            void end_object() { push(json_stream_event::EndObject); }
+            void start_array() { push(json_stream_event::StartArray); }
+            void end_array() { push(json_stream_event::EndArray); }
+            void key(string_view_type const& aKey)
+            {
+                push(json_stream_event::Key).text = aKey;
+            }
+            void value(typename parser_type::scalar const& aValue)
+            {
+                auto& e = push(json_stream_event::Value);
+                e.valueType = aValue.type;
+                e.text = aValue.text;
+                e.number = aValue.number;
+            }
+        };
+    public:
+        basic_json_stream_reader(std::basic_istream<CharT, Traits>& aInput, std::size_t aChunkSize = 65536u) :
+            iInput{ aInput }, iBuffer(aChunkSize), iNextEvent{ 0u }, iEndOfInput{ false }
+        {
+        }
+    public:
+        // returns false at end of input; throws json_error if the input is malformed
+        bool next(event& aEvent)
+        {
+            while (iNextEvent == iEvents.count)
+            {
+                if (iEndOfInput)
+                    return false;
+                iNextEvent = 0u;
+                iEvents.count = 0u;
+                bool ok;
+                if (iInput.read(iBuffer.data(), iBuffer.size()) || iInput.gcount() > 0)
+                    ok = iParser.parse(string_view_type{ iBuffer.data(), static_cast<std::size_t>(iInput.gcount()) }, iEvents);
+                else
+                {
+                    iEndOfInput = true;
+                    ok = iParser.finish(iEvents);
+                }
+                if (!ok)
+                    throw json_error(iParser.error_text());
+            }
+            std::swap(aEvent, iEvents.events[iNextEvent++]);
+            return true;
+        }
+        parser_type const& parser() const
+        {
+            return iParser;
+        }
+    private:
+        std::basic_istream<CharT, Traits>& iInput;
+        std::vector<character_type> iBuffer;
+        parser_type iParser;
+        event_queue iEvents;
+        std::size_t iNextEvent;
+        bool iEndOfInput;
+    };
+
+    typedef basic_json_stream_parser<json_syntax::Standard> json_stream_parser;
+    typedef basic_json_stream_parser<json_syntax::Relaxed> rjson_stream_parser;
+    typedef basic_json_stream_parser<json_syntax::Functional> fjson_stream_parser;
+
+    typedef basic_json_stream_reader<json_syntax::Standard> json_stream_reader;
+    typedef basic_json_stream_reader<json_syntax::Relaxed> rjson_stream_reader;
+    typedef basic_json_stream_reader<json_syntax::Functional> fjson_stream_reader;
+}
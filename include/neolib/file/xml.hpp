@@ -47,7 +47,9 @@
 #include <string>
 #include <memory>
 #include <exception>
+#include <variant>
 #include <neolib/core/quick_string.hpp>
+#include <neolib/core/arena_allocator.hpp>
 #include <neolib/core/allocator.hpp>
 
 #define NEOLIB_XML_USE_POOL_ALLOCATOR
@@ -61,7 +63,9 @@ namespace neolib
         // types
         enum type_e { Document = 0x1, Element = 0x2, Text = 0x4, Comment = 0x8, Declaration = 0x10, Cdata = 0x20, Dtd = 0x40, All = 0xFF };
         typedef Alloc allocator_type;
-        typedef basic_quick_string<CharT> string;
+        // arena documents keep their strings in the arena too so that the whole tree can be abandoned at once
+        typedef std::conditional_t<is_arena_allocator_v<allocator_type>, typename std::allocator_traits<allocator_type>::template rebind_alloc<CharT>, std::allocator<CharT>> string_allocator_type;
+        typedef basic_quick_string<CharT, std::char_traits<CharT>, string_allocator_type> string;
         typedef xml_node<CharT, allocator_type> node;
         typedef node* node_ptr;
     private:
@@ -150,12 +154,28 @@ namespace neolib
 
     public:
         // construction
-        xml_node(type_e aType = Document) : iType(aType) {}
+        xml_node(type_e aType = Document, const allocator_type& aAllocator = allocator_type{}) : iType(aType), iContent(typename node_list::allocator_type{ aAllocator }) {}
         virtual ~xml_node() { clear(); }
 
     public:
         // operations
         type_e type() const { return iType; }
+        allocator_type get_allocator() const { return allocator_type{ iContent.get_allocator() }; }
+        string_allocator_type string_allocator() const { return string_allocator(get_allocator()); }
+        static string_allocator_type string_allocator(const allocator_type& aAllocator)
+        {
+            if constexpr (is_arena_allocator_v<allocator_type>)
+                return string_allocator_type{ aAllocator };
+            else
+                return string_allocator_type{};
+        }
+        // creates a node using this node's allocator, i.e. in the same arena for arena documents
+        template <typename Node, typename... Args>
+        Node* create(Args&&... aArguments) const
+        {
+            auto const allocator = get_allocator();
+            return new (allocator) Node(std::forward<Args>(aArguments)..., allocator);
+        }
         // access
         bool empty() const { return iContent.empty(); }
         const node& back() const { return *iContent.back(); }
@@ -198,6 +218,11 @@ namespace neolib
                 delete *i;
             iContent.clear();
         }
+        // forgets the content without destroying it; only for trees whose storage is released with their arena
+        void abandon()
+        {
+            new (&iContent) node_list{ iContent.get_allocator() };
+        }
 
     private:
         // implementation
@@ -219,6 +244,8 @@ namespace neolib
         // allocation
         static void* operator new(std::size_t) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_element>().allocate(1); }
         static void operator delete(void* ptr) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_element>().deallocate(static_cast<xml_element*>(ptr), 1); }
+        static void* operator new(std::size_t, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_element>(aAllocator).allocate(1); }
+        static void operator delete(void* ptr, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_element>(aAllocator).deallocate(static_cast<xml_element*>(ptr), 1); }
 
     public:
         // types
@@ -245,17 +272,20 @@ namespace neolib
 
     public:
         // construction
-        xml_element() : node(node::Element), iUseEmptyElementTag(true) {}
-        xml_element(const string& aName) : node(node::Element), iName(aName), iUseEmptyElementTag(true) {}
-        xml_element(const CharT* aName) : node(node::Element), iName(aName), iUseEmptyElementTag(true) {}
+        xml_element(const allocator_type& aAllocator = allocator_type{}) : 
+            node(node::Element, aAllocator), iName(node::string_allocator(aAllocator)), iAttributes(typename attribute_list::allocator_type{ aAllocator }), iText(node::string_allocator(aAllocator)), iUseEmptyElementTag(true) {}
+        xml_element(const string& aName, const allocator_type& aAllocator = allocator_type{}) : 
+            node(node::Element, aAllocator), iName(aName, node::string_allocator(aAllocator)), iAttributes(typename attribute_list::allocator_type{ aAllocator }), iText(node::string_allocator(aAllocator)), iUseEmptyElementTag(true) {}
+        xml_element(const CharT* aName, const allocator_type& aAllocator = allocator_type{}) : 
+            node(node::Element, aAllocator), iName(aName, node::string_allocator(aAllocator)), iAttributes(typename attribute_list::allocator_type{ aAllocator }), iText(node::string_allocator(aAllocator)), iUseEmptyElementTag(true) {}
 
     public:
         // operations
         const string& name() const { return iName; }
         using node::insert;
-        typename node::iterator insert(typename node::iterator aPosition, const CharT* aName) { return node::insert(aPosition, new xml_element(aName)); }
-        xml_element& append(const std::string& aName) { node::push_back(new xml_element(aName)); return static_cast<xml_element&>(node::back()); }
-        xml_element& append(const CharT* aName) { node::push_back(new xml_element(aName)); return static_cast<xml_element&>(node::back()); }
+        typename node::iterator insert(typename node::iterator aPosition, const CharT* aName) { return node::insert(aPosition, node::template create<xml_element>(aName)); }
+        xml_element& append(const std::string& aName) { node::push_back(node::template create<xml_element>(string{ aName.c_str(), aName.size() })); return static_cast<xml_element&>(node::back()); }
+        xml_element& append(const CharT* aName) { node::push_back(node::template create<xml_element>(aName)); return static_cast<xml_element&>(node::back()); }
         const attribute_list& attributes() const { return iAttributes; }
         bool has_attribute(const string& aAttributeName) const;
         const string& attribute_value(const string& aAttributeName) const;
@@ -287,15 +317,18 @@ namespace neolib
         // allocation
         static void* operator new(std::size_t) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_text>().allocate(1); }
         static void operator delete(void* ptr) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_text>().deallocate(static_cast<xml_text*>(ptr), 1); }
+        static void* operator new(std::size_t, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_text>(aAllocator).allocate(1); }
+        static void operator delete(void* ptr, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_text>(aAllocator).deallocate(static_cast<xml_text*>(ptr), 1); }
 
     public:
         // types
         typedef xml_node<CharT, Alloc> node;
+        typedef typename node::allocator_type allocator_type;
         typedef typename node::string string;
 
     public:
         // construction
-        xml_text(const string& aContent = string()) : node(node::Text), iContent(aContent) {}
+        xml_text(const string& aContent = string(), const allocator_type& aAllocator = allocator_type{}) : node(node::Text, aAllocator), iContent(aContent, node::string_allocator(aAllocator)) {}
 
     public:
         // operations
@@ -314,15 +347,18 @@ namespace neolib
         // allocation
         static void* operator new(std::size_t) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_comment>().allocate(1); }
         static void operator delete(void* ptr) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_comment>().deallocate(static_cast<xml_comment*>(ptr), 1); }
+        static void* operator new(std::size_t, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_comment>(aAllocator).allocate(1); }
+        static void operator delete(void* ptr, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_comment>(aAllocator).deallocate(static_cast<xml_comment*>(ptr), 1); }
 
     public:
         // types
         typedef xml_node<CharT, Alloc> node;
+        typedef typename node::allocator_type allocator_type;
         typedef typename node::string string;
 
     public:
         // construction
-        xml_comment(const string& aContent = string()) : node(node::Comment), iContent(aContent) {}
+        xml_comment(const string& aContent = string(), const allocator_type& aAllocator = allocator_type{}) : node(node::Comment, aAllocator), iContent(aContent, node::string_allocator(aAllocator)) {}
 
     public:
         // operations
@@ -341,15 +377,18 @@ namespace neolib
         // allocation
         static void* operator new(std::size_t) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_declaration>().allocate(1); }
         static void operator delete(void* ptr) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_declaration>().deallocate(static_cast<xml_declaration*>(ptr), 1); }
+        static void* operator new(std::size_t, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_declaration>(aAllocator).allocate(1); }
+        static void operator delete(void* ptr, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_declaration>(aAllocator).deallocate(static_cast<xml_declaration*>(ptr), 1); }
 
     public:
         // types
         typedef xml_node<CharT, Alloc> node;
+        typedef typename node::allocator_type allocator_type;
         typedef typename node::string string;
 
     public:
         // construction
-        xml_declaration(const string& aContent = string()) : node(node::Declaration), iContent(aContent) {}
+        xml_declaration(const string& aContent = string(), const allocator_type& aAllocator = allocator_type{}) : node(node::Declaration, aAllocator), iContent(aContent, node::string_allocator(aAllocator)) {}
 
     public:
         // operations
@@ -368,15 +407,18 @@ namespace neolib
         // allocation
         static void* operator new(std::size_t) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_cdata>().allocate(1); }
         static void operator delete(void* ptr) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_cdata>().deallocate(static_cast<xml_cdata*>(ptr), 1); }
+        static void* operator new(std::size_t, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_cdata>(aAllocator).allocate(1); }
+        static void operator delete(void* ptr, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_cdata>(aAllocator).deallocate(static_cast<xml_cdata*>(ptr), 1); }
 
     public:
         // types
         typedef xml_node<CharT, Alloc> node;
+        typedef typename node::allocator_type allocator_type;
         typedef typename node::string string;
 
     public:
         // construction
-        xml_cdata(const string& aContent = string()) : node(node::Cdata), iContent(aContent) {}
+        xml_cdata(const string& aContent = string(), const allocator_type& aAllocator = allocator_type{}) : node(node::Cdata, aAllocator), iContent(aContent, node::string_allocator(aAllocator)) {}
 
     public:
         // operations
@@ -395,15 +437,18 @@ namespace neolib
         // allocation
         static void* operator new(std::size_t) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_dtd>().allocate(1); }
         static void operator delete(void* ptr) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_dtd>().deallocate(static_cast<xml_dtd*>(ptr), 1); }
+        static void* operator new(std::size_t, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_dtd>(aAllocator).allocate(1); }
+        static void operator delete(void* ptr, const Alloc& aAllocator) { return typename std::allocator_traits<Alloc>::template rebind_alloc<xml_dtd>(aAllocator).deallocate(static_cast<xml_dtd*>(ptr), 1); }
 
     public:
         // types
         typedef xml_node<CharT, Alloc> node;
+        typedef typename node::allocator_type allocator_type;
         typedef typename node::string string;
 
     public:
         // construction
-        xml_dtd(const string& aContent = string()) : node(node::Dtd), iContent(aContent) {}
+        xml_dtd(const string& aContent = string(), const allocator_type& aAllocator = allocator_type{}) : node(node::Dtd, aAllocator), iContent(aContent, node::string_allocator(aAllocator)) {}
 
     public:
         // operations
@@ -432,8 +477,12 @@ namespace neolib
         typedef xml_declaration<CharT, allocator_type> declaration;
         typedef xml_cdata<CharT, allocator_type> cdata;
         typedef xml_dtd<CharT, allocator_type> dtd;
-        typedef std::pair<string, string> entity;
-        typedef std::list<entity, typename std::allocator_traits<allocator_type>::template rebind_alloc<entity>> entity_list;
+        static constexpr bool arena_mode = is_arena_allocator_v<allocator_type>;
+        typedef std::conditional_t<arena_mode, monotonic_arena, std::monostate> arena_type;
+        // entities outlive the arena being released by clear() so neither the list nor its strings come from it
+        typedef std::basic_string<CharT> entity_string;
+        typedef std::pair<entity_string, entity_string> entity;
+        typedef std::list<entity, std::conditional_t<arena_mode, std::allocator<entity>, typename std::allocator_traits<allocator_type>::template rebind_alloc<entity>>> entity_list;
 
         // exceptions
     public:
@@ -444,6 +493,7 @@ namespace neolib
     public:
         basic_xml(bool aStripWhitespace = false);
         basic_xml(const std::string& aPath, bool aStripWhitespace = false);
+        ~basic_xml();
 
         // operations
     public:
@@ -464,9 +514,25 @@ namespace neolib
         bool error() const { return iError; }
         void set_indent(CharT aIndentChar, std::size_t aIndentCount = 1);
         void set_strip_whitespace(bool aStripWhitespace);
+        // the document's arena (std::monostate for non-arena documents); nodes created through the tree are
+        // allocated with their parent's allocator so always come from the arena of the document they belong to
+        const arena_type& arena() const
+        {
+            return iArena;
+        }
 
         // implementation
     private:
+        allocator_type allocator() const;
+        // while the returned object is alive temporary strings created by this document's parser and writer come
+        // from its arena
+        auto arena_scope() const
+        {
+            if constexpr (arena_mode)
+                return monotonic_arena::scope{ iArena };
+            else
+                return std::monostate{};
+        }
         struct tag : std::pair<typename string::view_const_iterator, typename string::view_const_iterator>
         {
             typename node::type_e iType;
@@ -518,6 +584,7 @@ namespace neolib
 
         // attributes
     private:
+        mutable arena_type iArena;
         std::basic_ostream<CharT>& (&endl)(std::basic_ostream<CharT>&);
         mutable bool iError;
         node iDocument;
@@ -553,6 +620,8 @@ namespace neolib
     typedef basic_xml<char, pool_allocator<char> > xml;
     typedef basic_xml<wchar_t, pool_allocator<char> > wxml;
     #endif
+    typedef basic_xml<char, arena_allocator<char> > arena_xml;
+    typedef basic_xml<wchar_t, arena_allocator<wchar_t> > arena_wxml;
 }
 
 #include <neolib/file/xml.inl>
@@ -160,7 +160,7 @@ namespace neolib
         template <>
         struct parsing_bits<char>
         {
-            typedef std::string string;
+            typedef const char* string;
             typedef basic_character_map<char> character_map;
             static const character_map sNameDelimeter;
             static const character_map sNameBadDelimeter;
@@ -200,7 +200,7 @@ namespace neolib
         template <>
         struct parsing_bits<wchar_t>
         {
-            typedef std::wstring string;
+            typedef const wchar_t* string;
             typedef basic_character_map<wchar_t> character_map;
             static const character_map sNameDelimeter;
             static const character_map sNameBadDelimeter;
@@ -348,7 +348,7 @@ namespace neolib
         for (typename node::iterator i = begin(); i != end(); ++i)
             if (i->type() == node::Element && static_cast<xml_element<CharT, Alloc>&>(*i).name() == aName)
                 return i;
-        insert(end(), new xml_element<CharT, Alloc>(aName));
+        insert(end(), create<xml_element<CharT, Alloc>>(aName));
         typename node::iterator newNode = end();
         return --newNode;
     }
@@ -411,13 +411,13 @@ namespace neolib
     template <typename CharT, typename Alloc>
     void xml_element<CharT, Alloc>::set_attribute(const string& aAttributeName, const string& aAttributeValue)
     {
-        iAttributes[aAttributeName] = aAttributeValue;
+        iAttributes[string{ aAttributeName, node::string_allocator() }] = string{ aAttributeValue, node::string_allocator() };
     }
 
     template <typename CharT, typename Alloc>
     void xml_element<CharT, Alloc>::append_text(const string& aText)
     {
-        node::push_back(new xml_text<CharT, Alloc>(aText));
+        node::push_back(node::template create<xml_text<CharT, Alloc>>(aText));
     }
 
     template <typename CharT, typename Alloc>
@@ -442,7 +442,7 @@ namespace neolib
 
     template <typename CharT, typename Alloc>
     basic_xml<CharT, Alloc>::basic_xml(bool aStripWhitespace) : 
-        endl(std::endl), iError(false), iIndentChar(characters<CharT>::sTabChar), iIndentCount(1), iStripWhitespace(aStripWhitespace)
+        endl(std::endl), iError(false), iDocument(node::Document, allocator()), iDocumentText(node::string_allocator(allocator())), iIndentChar(characters<CharT>::sTabChar), iIndentCount(1), iStripWhitespace(aStripWhitespace)
     {
         for (std::size_t entityIndex = 0; entityIndex < predefined_entities<CharT>::PredefinedEntityCount; ++entityIndex)
             iEntities.push_back(predefined_entities<CharT>::sPredefinedEntities[entityIndex]);
@@ -450,7 +450,7 @@ namespace neolib
 
     template <typename CharT, typename Alloc>
     basic_xml<CharT, Alloc>::basic_xml(const std::string& aPath, bool aStripWhitespace) :
-        endl(std::endl), iError(false), iIndentChar(characters<CharT>::sTabChar), iIndentCount(1), iStripWhitespace(aStripWhitespace)
+        endl(std::endl), iError(false), iDocument(node::Document, allocator()), iDocumentText(node::string_allocator(allocator())), iIndentChar(characters<CharT>::sTabChar), iIndentCount(1), iStripWhitespace(aStripWhitespace)
     {
         for (std::size_t entityIndex = 0; entityIndex < predefined_entities<CharT>::PredefinedEntityCount; ++entityIndex)
             iEntities.push_back(predefined_entities<CharT>::sPredefinedEntities[entityIndex]);
@@ -460,12 +460,38 @@ namespace neolib
         read(input);
     }
 
+    template <typename CharT, typename Alloc>
+    basic_xml<CharT, Alloc>::~basic_xml()
+    {
+        if constexpr (arena_mode)
+            iDocument.abandon();
+    }
+
     template <typename CharT, typename Alloc>
     void basic_xml<CharT, Alloc>::clear()
     {
-        iDocument.clear();
-        iDocumentText.clear();
         iError = false;
+        if constexpr (arena_mode)
+        {
+            // every node and string lives in the arena so the tree is abandoned, not destroyed, and freed in O(blocks)
+            iDocument.abandon();
+            new (&iDocumentText) string{ iDocument.string_allocator() };
+            iArena.release();
+        }
+        else
+        {
+            iDocument.clear();
+            iDocumentText.clear();
+        }
+    }
+
+    template <typename CharT, typename Alloc>
+    typename basic_xml<CharT, Alloc>::allocator_type basic_xml<CharT, Alloc>::allocator() const
+    {
+        if constexpr (arena_mode)
+            return allocator_type{ iArena };
+        else
+            return allocator_type{};
     }
 
     template <typename CharT, typename Alloc>
@@ -496,7 +522,7 @@ namespace neolib
         for (typename node::iterator i = iDocument.begin(); i != iDocument.end(); ++i)
             if (i->type() == node::Element)
                 return static_cast<element&>(*i);
-        iDocument.push_back(new element());
+        iDocument.push_back(iDocument.template create<element>());
         return static_cast<element&>(iDocument.back());
     }
 
@@ -668,7 +694,7 @@ namespace neolib
                     {
                         if (contentToken.iHasEntities)
                             content = parse_entities(content);
-                        theElement.push_back(new text(content));
+                        theElement.push_back(theElement.template create<text>(content));
                     }
                     tag nextTag = next_tag(next, aDocumentEnd); 
                     if (nextTag.first > nextTag.second)
@@ -691,19 +717,19 @@ namespace neolib
                             theElement.set_use_empty_element_tag(false);
                             return nextTag.second+1;
                         }
-                        theElement.push_back(new element());
+                        theElement.push_back(theElement.template create<element>());
                         break;
                     case node::Comment:
-                        theElement.push_back(new comment());
+                        theElement.push_back(theElement.template create<comment>(string()));
                         break;
                     case node::Declaration:
-                        theElement.push_back(new declaration());
+                        theElement.push_back(theElement.template create<declaration>(string()));
                         break;
                     case node::Cdata:
-                        theElement.push_back(new cdata());
+                        theElement.push_back(theElement.template create<cdata>(string()));
                         break;
                     case node::Dtd:
-                        theElement.push_back(new dtd());
+                        theElement.push_back(theElement.template create<dtd>(string()));
                         break;
                     default:
                         break;
@@ -717,25 +743,25 @@ namespace neolib
             if (aNode.type() == node::Comment)
                 static_cast<comment&>(aNode).content() = string(aStartTag.first, aStartTag.second);
             else
-                aNode.push_back(new comment(string(aStartTag.first, aStartTag.second)));
+                aNode.push_back(aNode.template create<comment>(string(aStartTag.first, aStartTag.second)));
             return aStartTag.second + aStartTag.end_skip();
         case node::Declaration:
             if (aNode.type() == node::Declaration)
                 static_cast<declaration&>(aNode).content() = string(aStartTag.first, aStartTag.second);
             else
-                aNode.push_back(new declaration(string(aStartTag.first, aStartTag.second)));
+                aNode.push_back(aNode.template create<declaration>(string(aStartTag.first, aStartTag.second)));
             return aStartTag.second + aStartTag.end_skip();
         case node::Cdata:
             if (aNode.type() == node::Cdata)
                 static_cast<cdata&>(aNode).content() = string(aStartTag.first, aStartTag.second);
             else
-                aNode.push_back(new cdata(string(aStartTag.first, aStartTag.second)));
+                aNode.push_back(aNode.template create<cdata>(string(aStartTag.first, aStartTag.second)));
             return aStartTag.second + aStartTag.end_skip();
         case node::Dtd:
             if (aNode.type() == node::Dtd)
                 static_cast<dtd&>(aNode).content() = string(aStartTag.first, aStartTag.second);
             else
-                aNode.push_back(new dtd(string(aStartTag.first, aStartTag.second)));
+                aNode.push_back(aNode.template create<dtd>(string(aStartTag.first, aStartTag.second)));
             return aStartTag.second + aStartTag.end_skip();
         default:
             iError = true;
@@ -753,6 +779,8 @@ namespace neolib
         if (!aStream)
             return false;
 
+        [[maybe_unused]] auto const scope = arena_scope();
+
         typename std::basic_istream<CharT>::pos_type count = 0;
         aStream.seekg(0, std::ios::end);
         if (aStream)
@@ -798,6 +826,7 @@ namespace neolib
     bool basic_xml<CharT, Alloc>::write(std::basic_ostream<CharT>& aStream)
     {
         iError = false;
+        [[maybe_unused]] auto const scope = arena_scope();
         std::ostringstream buffer;
         node_writer theWriter(buffer);
         write_node(theWriter, iDocument, 0);
@@ -908,7 +937,7 @@ namespace neolib
     template <typename CharT, typename Alloc>
     typename basic_xml<CharT, Alloc>::node::iterator basic_xml<CharT, Alloc>::insert(node& aParent, typename node::iterator aPosition, const CharT* aName)
     {
-        return aParent.insert(aPosition, new element(aName));
+        return aParent.insert(aPosition, aParent.template create<element>(aName));
     }
 
     template <typename CharT, typename Alloc>
@@ -961,21 +990,21 @@ namespace neolib
                 string character;
                 struct converter
                 {
-                    static long string_to_integer(const typename basic_xml<char>::string& aString, int aBase)
+                    static long string_to_integer(const char* aString, int aBase)
                     {
-                        return strtol(aString.c_str(), 0, aBase);
+                        return strtol(aString, 0, aBase);
                     }
-                    static long string_to_integer(const typename basic_xml<wchar_t>::string& aString, int aBase)
+                    static long string_to_integer(const wchar_t* aString, int aBase)
                     {
-                        return wcstol(aString.c_str(), 0, aBase);
+                        return wcstol(aString, 0, aBase);
                     }
                 };
                 if (characterValue[0] != characters<CharT>::sHexChar)
-                    character += static_cast<CharT>(converter::string_to_integer(characterValue, 10));
+                    character += static_cast<CharT>(converter::string_to_integer(characterValue.c_str(), 10));
                 else
                 {
                     characterValue.erase(0, 1);
-                    character += static_cast<CharT>(converter::string_to_integer(characterValue, 16));
+                    character += static_cast<CharT>(converter::string_to_integer(characterValue.c_str(), 16));
                 }
                 newString.replace(pos, (endPos - pos) + 1, character);
                 ++pos;
@@ -987,13 +1016,13 @@ namespace neolib
                 {
                     string placeholder;
                     placeholder += characters<CharT>::sAmpersandChar;
-                    placeholder += i->first;
+                    placeholder += i->first.c_str();
                     placeholder += characters<CharT>::sSemicolonChar;
                     if (placeholder.size() != endPos - pos + 1)
                         continue;
                     if (std::equal(placeholder.cbegin(), placeholder.cend(), newString.cbegin() + pos))
                     {
-                        newString.replace(pos, placeholder.size(), i->second);
+                        newString.replace(pos, placeholder.size(), i->second.c_str(), i->second.size());
                         pos += i->second.size();
                         replaced = true;
                         break;
@@ -1014,10 +1043,10 @@ namespace neolib
         {
             string placeholder;
             placeholder += characters<CharT>::sAmpersandChar;
-            placeholder += i->first;
+            placeholder += i->first.c_str();
             placeholder += characters<CharT>::sSemicolonChar;
             typename string::size_type pos = 0;
-            while((pos = newString.find(i->second, pos)) != string::npos)
+            while((pos = newString.find(i->second.c_str(), pos, i->second.size())) != string::npos)
             {
                 newString.replace(pos, i->second.size(), placeholder);
                 pos += placeholder.size();
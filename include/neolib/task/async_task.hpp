@@ -36,22 +36,32 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
 #include <neolib/core/lifetime.hpp>
 #include <neolib/core/dirty_list.hpp>
 #include <neolib/task/i_thread.hpp>
 #include <neolib/task/task.hpp>
 #include <neolib/task/i_async_task.hpp>
 #include <neolib/task/i_timer_object.hpp>
+#include <neolib/task/timer_wheel.hpp>
 #include <neolib/plugin/plugin_event.hpp>
 
 namespace neolib
 {
     class async_task;
+    class timer_object;
 
     class NEOLIB_EXPORT timer_service : public i_timer_service
     {
+        friend class timer_object;
         // types
     public:
+        typedef std::chrono::steady_clock clock_type;
+        typedef std::chrono::milliseconds tick_duration;
         // construction
     public:
         timer_service(async_task& aTask, bool aMultiThreaded = false);
@@ -61,12 +71,21 @@ namespace neolib
         void* native_object() override;
         i_timer_object& create_timer_object() override;
         void remove_timer_object(i_timer_object& aObject) override;
+    public:
+        std::optional<clock_type::time_point> next_deadline() const;
+        // implementation
+    private:
+        void schedule(timer_object& aObject, const clock_type::time_point& aDeadline);
+        void unschedule(timer_object& aObject);
+        timer_wheel::tick_type to_tick(const clock_type::time_point& aTimePoint, bool aRoundUp) const;
         // attributes
     private:
         async_task& iTask;
         destroying_flag iTaskDestroying;
         mutable std::recursive_mutex iMutex;
-        std::vector<ref_ptr<i_timer_object>> iObjects;
+        clock_type::time_point const iEpoch;
+        timer_wheel iWheel;
+        std::unordered_map<i_timer_object const*, ref_ptr<i_timer_object>> iObjects;
     };
 
     enum class async_task_state
@@ -117,6 +136,8 @@ namespace neolib
         void halt() override;
         bool finished() const noexcept override;
         void wait() const noexcept override;
+        void wake() override;
+        void set_event_poll(std::function<bool()> aPoll) override;
         // implementation
     protected:
         // i_lifetime
@@ -127,6 +148,8 @@ namespace neolib
         bool do_work(yield_type aYieldType = yield_type::NoYield) override;
         void cancel() noexcept override;
         void idle() override;
+        // own
+        void wait_for_work();
         // attributes
     private:
         std::recursive_mutex iMutex;
@@ -135,5 +158,11 @@ namespace neolib
         std::unique_ptr<i_async_service> iIoService;
         message_queue_pointer iMessageQueue;
         std::atomic<async_task_state> iState;
+        std::atomic<std::thread::id> iRunThread;
+        std::mutex iWakeMutex;
+        std::condition_variable iWakeCondition;
+        std::atomic<bool> iWakeRequested;
+        std::atomic<bool> iWaiting;
+        std::function<bool()> iEventPoll;
     };
 }
@@ -48,6 +48,7 @@
 #include <neolib/core/reference_counted.hpp>
 #include <neolib/core/lifetime.hpp>
 #include <neolib/core/jar.hpp>
+#include <neolib/task/mpsc_queue.hpp>
 #include <neolib/task/i_event.hpp>
 
 namespace neolib
@@ -259,9 +260,10 @@ namespace neolib
         typedef event_callable<Args...> callable;
         typedef typename callable::concrete_callable concrete_callable;
         typedef std::tuple<Args...> argument_pack;
+        typedef std::shared_ptr<std::atomic<bool>> queued_flag;
     public:
-        event_callback(const i_event& aEvent, const ref_ptr<callable>& aCallable, Args... aArguments) :
-            iEvent{ &aEvent }, iCallable{ aCallable }, iArguments{ aArguments... }
+        event_callback(const i_event& aEvent, const ref_ptr<callable>& aCallable, queued_flag aQueued, Args... aArguments) :
+            iEvent{ &aEvent }, iCallable{ aCallable }, iQueued{ std::move(aQueued) }, iArguments{ aArguments... }
         {
         }
     public:
@@ -289,14 +291,19 @@ namespace neolib
             else
                 throw event_callable_expired();
         }
+        void unqueued() const noexcept override
+        {
+            if (iQueued)
+                iQueued->store(false, std::memory_order_release);
+        }
     private:
         const i_event* iEvent;
         weak_ref_ptr<callable> iCallable;
+        queued_flag iQueued;
         argument_pack iArguments;
     };
 
     class i_async_task;
-    class callback_timer;
 
     NEOLIB_EXPORT void unqueue_event(const i_event& aEvent);
 
@@ -319,6 +326,11 @@ namespace neolib
             callback_ptr callback;
         };
         typedef std::deque<event_list_entry> event_list_t;
+        static constexpr std::size_t kMaxIdlePending = 1024u;
+        struct pending_event : intrusive_mpsc_node
+        {
+            std::optional<event_list_entry> entry;
+        };
     public:
         static async_event_queue& instance();
         static async_event_queue& instance(i_async_task& aTask);
@@ -328,7 +340,7 @@ namespace neolib
         static async_event_queue& get_instance(i_async_task* aTask);
     public:
         bool exec();
-        transaction enqueue(callback_ptr aCallback, bool aStatelessHandler, const optional_transaction& aTransaction = {});
+        transaction enqueue(callback_ptr aCallback, const optional_transaction& aTransaction = {});
         void unqueue(const i_event& aEvent);
         void terminate();
     public:
@@ -340,22 +352,71 @@ namespace neolib
         bool terminated() const;
         transaction add(callback_ptr aCallback, const optional_transaction& aTransaction);
         void remove(const i_event& aEvent);
-        bool has(const i_event& aEvent) const;
+        void drain(event_list_t& aEvents);
+        void discard_pending();
+        bool poll();
         bool publish_events();
+        switchable_mutex& mutex() const;
+        static pending_event& allocate_pending();
+        static void recycle_pending(pending_event& aFirst, pending_event& aLast, std::size_t aCount);
+        static std::atomic<intrusive_mpsc_node*>& recycled_pending();
+        static std::atomic<std::size_t>& idle_pending();
+        static std::size_t free_pending(intrusive_mpsc_node* aList) noexcept;
     private:
         i_async_task& iTask;
-        std::unique_ptr<callback_timer> iTimer;
-        event_list_t iEvents;
+        intrusive_mpsc_queue<pending_event> iPending;
         std::atomic<bool> iTerminated;
         destroyed_flag iTaskDestroyed;
         std::atomic<uint32_t> iPublishNestingLevel;
         std::vector<std::unique_ptr<event_list_t>> iPublishCache;
-        transaction iNextTransaction;
+        std::atomic<transaction> iNextTransaction;
 #if !defined(NDEBUG) || defined(DEBUG_EVENTS)
         bool iDebug = false;
 #endif
     };
 
+    // Handlers called directly by a synchronous trigger are not pinned by a reference count; instead an event defers
+    // releasing the callable of a removed handler until none of its direct calls are in progress. The callables of an
+    // event destroyed by one of its own handlers are parked here until the outermost direct call on this thread returns.
+    class direct_call_guard
+    {
+    public:
+        direct_call_guard()
+        {
+            ++depth();
+        }
+        ~direct_call_guard()
+        {
+            if (--depth() == 0u && !orphans().empty())
+                release_orphans();
+        }
+    public:
+        static void orphan(i_reference_counted const& aCallable)
+        {
+            orphans().push_back(&aCallable);
+            aCallable.add_ref();
+        }
+    private:
+        static uint32_t& depth()
+        {
+            thread_local uint32_t tDepth = 0u;
+            return tDepth;
+        }
+        static std::vector<i_reference_counted const*>& orphans()
+        {
+            thread_local std::vector<i_reference_counted const*> tOrphans;
+            return tOrphans;
+        }
+        static void release_orphans()
+        {
+            // releasing may run arbitrary destructors (which may orphan more callables) so release a detached list
+            auto released = std::move(orphans());
+            orphans().clear();
+            for (auto orphan : released)
+                orphan->release();
+        }
+    };
+
     enum class event_trigger_type
     {
         Default,
@@ -386,6 +447,7 @@ namespace neolib
             ref_ptr<callback_callable> callable;
             bool handleInSameThreadAsEmitter;
             bool handlerIsStateless;
+            std::shared_ptr<std::atomic<bool>> statelessQueued;
             uint64_t triggerId = 0ull;
 
             handler(
@@ -400,7 +462,8 @@ namespace neolib
                 clientId{ clientId },
                 callable{ callable },
                 handleInSameThreadAsEmitter{ handleInSameThreadAsEmitter },
-                handlerIsStateless{ handlerIsStateless }
+                handlerIsStateless{ handlerIsStateless },
+                statelessQueued{ handlerIsStateless ? std::make_shared<std::atomic<bool>>(false) : nullptr }
             {}
 
             handler(handler const& aOther) = default;
@@ -441,6 +504,8 @@ namespace neolib
             uint64_t triggerId = 0ull;
             std::atomic<bool> handlersChanged = false;
             std::atomic<uint32_t> filterCount;
+            uint32_t directCalls = 0u;
+            std::vector<ref_ptr<callback_callable>> retiredCallables;
         };
         typedef std::optional<std::scoped_lock<switchable_mutex>> optional_lock;
     public:
@@ -452,7 +517,7 @@ namespace neolib
         {
             if (filtered())
                 async_event_queue::instance().filter_registry().uninstall_event_filter(*this);
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             if (is_controlled())
             {
                 control().reset();
@@ -474,28 +539,34 @@ namespace neolib
         }
         void remove_handler(cookie aHandlerId) override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
+            auto existing = instance().handlers.find(aHandlerId);
+            if (existing != instance().handlers.end())
+                retire(*existing);
             instance().handlers.remove(aHandlerId);
         }
         void handle_in_same_thread_as_emitter(cookie aHandlerId) override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             get_handler(aHandlerId).handleInSameThreadAsEmitter = true;
         }
         void handler_is_stateless(cookie aHandlerId) override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-            get_handler(aHandlerId).handlerIsStateless = true;
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
+            auto& handler = get_handler(aHandlerId);
+            handler.handlerIsStateless = true;
+            if (!handler.statelessQueued)
+                handler.statelessQueued = std::make_shared<std::atomic<bool>>(false);
         }
     public:
         void push_context() const override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             instance().contexts.emplace_back();
         }
         void pop_context() const override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             instance().contexts.pop_back();
         }
     public:
@@ -540,64 +611,28 @@ namespace neolib
                 return true;
             if (trigger_type() == event_trigger_type::SynchronousDontQueue)
                 unqueue();
-            optional_lock lock{ event_mutex() };
-            auto& handlers = instance().handlers;
-            if (handlers.empty() && !filtered())
+            optional_lock lock{ event_mutex(*this) };
+            auto& data = instance();
+            if (data.handlers.empty() && !filtered())
                 return true;
             destroyed_flag destroyed{ *this };
-            push_context();
+            data.contexts.emplace_back();
             if (filtered())
             {
+                // filters, like handlers, are called without the event's mutex held
+                lock.reset();
                 async_event_queue::instance().filter_registry().filter_event(*this);
                 if (destroyed)
                     return true;
-                if (instance().contexts.back().accepted)
-                {
-                    pop_context();
-                    return false;
-                }
-            }
-            if (handlers.empty())
-                return true;
-            scoped_flag sf{ instance().triggering };
-            if (!sf.saved())
-            {
-                instance().triggerId = 0ull;
-                for (auto& handler : handlers)
-                    handler.triggerId = 0ull;
-            }
-            auto triggerId = ++instance().triggerId;
-            optional_async_transaction transaction;
-            for (std::size_t handlerIndex = {}; handlerIndex < handlers.size();)
-            {
-                auto& handler = *std::next(handlers.begin(), handlerIndex++);
-                if (handler.triggerId < triggerId)
-                    handler.triggerId = triggerId;
-                else if (handler.triggerId == triggerId)
-                    continue;
-                try
-                {
-                    transaction = enqueue(lock, handler, false, transaction, aArguments...);
-                    if (destroyed)
-                        return true;
-                }
-                catch (...)
-                {
-                    pop_context();
-                    throw;
-                }
-                if (destroyed)
-                    return true;
-                if (instance().contexts.back().accepted)
+                lock.emplace(event_mutex(*this));
+                if (data.contexts.back().accepted || data.handlers.empty())
                 {
-                    pop_context();
-                    return false;
+                    bool const accepted = data.contexts.back().accepted;
+                    data.contexts.pop_back();
+                    return !accepted;
                 }
-                if (instance().handlersChanged.exchange(false))
-                    handlerIndex = {};
             }
-            pop_context();
-            return true;
+            return call_handlers(lock, destroyed, aArguments...);
         }
         void async_trigger(Args... aArguments) const
         {
@@ -605,7 +640,7 @@ namespace neolib
                 return;
             if (trigger_type() == event_trigger_type::AsynchronousDontQueue)
                 unqueue();
-            optional_lock lock{ event_mutex() };
+            optional_lock lock{ event_mutex(*this) };
             auto& handlers = instance().handlers;
             if (handlers.empty())
                 return;
@@ -621,12 +656,12 @@ namespace neolib
             optional_async_transaction transaction;
             for (std::size_t handlerIndex = {}; handlerIndex < handlers.size();)
             {
-                auto& handler = *std::next(handlers.begin(), handlerIndex++);
+                auto& handler = handlers.items().to_std_vector()[handlerIndex++];
                 if (handler.triggerId < triggerId)
                     handler.triggerId = triggerId;
                 else if (handler.triggerId == triggerId)
                     continue;
-                transaction = enqueue(lock, handler, true, transaction, aArguments...);
+                transaction = enqueue(handler, transaction, aArguments...);
                 if (destroyed)
                     return;
                 if (instance().handlersChanged.exchange(false))
@@ -635,17 +670,17 @@ namespace neolib
         }
         bool accepted() const override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             return !instance().contexts.empty() ? instance().contexts.back().accepted : false;
         }
         void accept() const override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             instance().contexts.back().accepted = true;
         }
         void ignore() const override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             instance().contexts.back().accepted = false;
         }
     public:
@@ -668,7 +703,7 @@ namespace neolib
     public:
         event_handle subscribe(const concrete_callable& aCallable, const void* aUniqueId = nullptr) const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             invalidate_handler_list();
             auto id = instance().handlers.emplace(async_event_queue::instance(), aUniqueId, make_ref<callback_callable>(aCallable));
             return event_handle{ control(), id };
@@ -699,7 +734,7 @@ namespace neolib
         }
         void unsubscribe(event_handle aHandle) const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             invalidate_handler_list();
             auto existing = find_handler(aHandle.id());
             if (existing != instance().handlers.end())
@@ -709,7 +744,7 @@ namespace neolib
         }
         void unsubscribe(const void* aClientId) const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             invalidate_handler_list();
             auto& handlers = instance().handlers;
             for (auto h = handlers.begin(); h != handlers.end();)
@@ -732,47 +767,129 @@ namespace neolib
         {
             if (!has_instance())
                 return false;
-            optional_lock lock{ event_mutex() };
+            optional_lock lock{ event_mutex(*this) };
             return !instance().handlers.empty();
         }
     private:
+        // calls (or, if they belong to another thread, queues) each handler once; handlers local to the emitting thread are 
+        // called directly without pinning their callables so nothing is allocated once the context stack has reached its 
+        // high water mark; the caller has pushed the context this pops
+        bool call_handlers(optional_lock& aLock, destroyed_flag const& aDestroyed, Args... aArguments) const
+        {
+            auto& data = instance();
+            auto& handlers = data.handlers.items().to_std_vector();
+            auto& emitterQueue = async_event_queue::instance();
+            bool const wasTriggering = data.triggering;
+            if (!wasTriggering)
+            {
+                data.triggering = true;
+                data.triggerId = 0ull;
+                for (auto& handler : handlers)
+                    handler.triggerId = 0ull;
+            }
+            auto const triggerId = ++data.triggerId;
+            auto const finish = [&](bool aResult)
+            {
+                data.contexts.pop_back();
+                data.triggering = wasTriggering;
+                return aResult;
+            };
+            optional_async_transaction transaction;
+            for (std::size_t handlerIndex = {}; handlerIndex < handlers.size();)
+            {
+                auto& handler = handlers[handlerIndex++];
+                if (handler.triggerId < triggerId)
+                    handler.triggerId = triggerId;
+                else if (handler.triggerId == triggerId)
+                    continue;
+                bool calling = false;
+                try
+                {
+                    if (handler.handleInSameThreadAsEmitter || (!handler.queueDestroyed && handler.queue == &emitterQueue))
+                    {
+                        auto& callable = *handler.callable;
+                        ++data.directCalls;
+                        calling = true;
+                        aLock.reset();
+                        {
+                            direct_call_guard guard;
+                            callable(aArguments...);
+                        }
+                        if (aDestroyed)
+                            return true;
+                        aLock.emplace(event_mutex(*this));
+                        calling = false;
+                        end_direct_call();
+                    }
+                    else
+                    {
+                        transaction = enqueue(handler, transaction, aArguments...);
+                        if (aDestroyed)
+                            return true;
+                    }
+                }
+                catch (...)
+                {
+                    if (!aDestroyed)
+                    {
+                        std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
+                        if (calling)
+                            end_direct_call();
+                        finish(false);
+                    }
+                    throw;
+                }
+                if (data.contexts.back().accepted)
+                    return finish(false);
+                if (data.handlersChanged.exchange(false))
+                    handlerIndex = {};
+            }
+            return finish(true);
+        }
+        void end_direct_call() const
+        {
+            auto& data = instance();
+            if (--data.directCalls == 0u && !data.retiredCallables.empty())
+                data.retiredCallables.clear();
+        }
+        // the callable of a handler removed whilst being called directly must outlive the call
+        void retire(handler const& aHandler) const
+        {
+            if (instance().directCalls != 0u)
+                instance().retiredCallables.push_back(aHandler.callable);
+        }
         typename handler_list_t::iterator erase_handler(typename handler_list_t::const_iterator aHandler) const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             auto& handlers = instance().handlers;
             auto callable = aHandler->callable;
+            retire(*aHandler);
             return handlers.erase(aHandler);
         }
         void invalidate_handler_list() const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             instance().handlersChanged = true;
             for (auto& context : instance().contexts)
                 context.handlersChanged = true;
         }
-        optional_async_transaction enqueue(optional_lock& aLock, handler& aHandler, bool aAsync, const optional_async_transaction& aAsyncTransaction, Args... aArguments) const
+        optional_async_transaction enqueue(handler& aHandler, const optional_async_transaction& aAsyncTransaction, Args... aArguments) const
         {
             optional_async_transaction transaction;
-            auto& emitterQueue = async_event_queue::instance();
-            if (!aAsync && (aHandler.handleInSameThreadAsEmitter || (!aHandler.queueDestroyed && aHandler.queue == &emitterQueue)))
-            {
-                auto callable = aHandler.callable;
-                bool wasLocked = !!aLock;
-                aLock.reset();
-                (*callable)(aArguments...);
-                if (wasLocked)
-                    aLock.emplace(event_mutex());
-            }
+            // a stateless handler needs at most one pending call however often the event is triggered
+            if (aHandler.statelessQueued && aHandler.statelessQueued->exchange(true, std::memory_order_acq_rel))
+                return transaction;
+            auto ecb = make_ref<callback>(*this, aHandler.callable, aHandler.statelessQueued, aArguments...);
+            if (aHandler.handleInSameThreadAsEmitter)
+                transaction = async_event_queue::instance().enqueue(ecb, aAsyncTransaction);
             else
             {
-                auto ecb = make_ref<callback>(*this, aHandler.callable, aArguments...);
-                if (aHandler.handleInSameThreadAsEmitter)
-                    transaction = emitterQueue.enqueue(ecb, aHandler.handlerIsStateless, aAsyncTransaction);
+                if (!aHandler.queueDestroyed)
+                    transaction = aHandler.queue->enqueue(ecb, aAsyncTransaction);
                 else
                 {
-                    if (!aHandler.queueDestroyed)
-                        transaction = aHandler.queue->enqueue(ecb, aHandler.handlerIsStateless, aAsyncTransaction);
-                    else if (!instance().ignoreErrors)
+                    ecb->unqueued();
+                    if (!instance().ignoreErrors)
                         throw event_queue_destroyed();
                 }
             }
@@ -780,13 +897,21 @@ namespace neolib
         }
         void unqueue() const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             unqueue_event(*this);
         }
         void clear()
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             unqueue_event(*this);
+            if (has_instance() && instance().directCalls != 0u)
+            {
+                // destroyed by one of its own handlers: the handler (and any retired callables) must outlive the call
+                for (auto& handler : instance().handlers)
+                    direct_call_guard::orphan(*handler.callable);
+                for (auto& callable : instance().retiredCallables)
+                    direct_call_guard::orphan(*callable);
+            }
             iInstanceDataPtr = nullptr;
             iInstanceData = std::nullopt;
         }
@@ -796,7 +921,7 @@ namespace neolib
         }
         i_event_control& control() const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             if (iControl == nullptr)
             {
                 iControl = new event_control{ iAlias };
@@ -812,20 +937,20 @@ namespace neolib
         {
             if (iInstanceDataPtr != nullptr)
                 return *iInstanceDataPtr;
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             iInstanceData.emplace();
             iInstanceDataPtr = &*iInstanceData;
             return *iInstanceDataPtr;
         }
         typename handler_list_t::iterator find_handler(cookie aHandlerId) const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             auto& handlers = instance().handlers;
             return handlers.find(aHandlerId);
         }
         handler& get_handler(cookie aHandlerId) const
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex(*this) };
             auto existing = find_handler(aHandlerId);
             if (existing != instance().handlers.end())
                 return *existing;
@@ -115,6 +115,10 @@ namespace neolib
         virtual void halt() = 0;
         virtual bool finished() const noexcept = 0;
         virtual void wait() const noexcept = 0;
+        // wakes the task if it is waiting for work; may be called from any thread
+        virtual void wake() = 0;
+        // installs the function polled for pending async events whenever the task does work
+        virtual void set_event_poll(std::function<bool()> aPoll) = 0;
     public:
         virtual void idle() = 0;
     public:
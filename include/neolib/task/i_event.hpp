@@ -36,6 +36,7 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <array>
 #include <neolib/core/mutex.hpp>
 #include <neolib/core/i_reference_counted.hpp>
 #include <neolib/core/jar.hpp>
@@ -48,27 +49,92 @@ namespace neolib
     struct event_queue_destroyed : std::logic_error { event_queue_destroyed() : std::logic_error{ "neolib::event_queue_destroyed" } {} };
     struct event_handler_not_found : std::logic_error { event_handler_not_found() : std::logic_error{ "neolib::event_handler_not_found" } {} };
 
+    class i_event;
+
+    // Events and event queues are guarded by mutexes selected from fixed size stripe pools (by object address) so
+    // that unrelated events do not serialize on one lock; the global mutex guards shared event system state only.
+    // Lock ordering: event stripe before global mutex and event stripe before queue stripe; a queue stripe is never
+    // held whilst acquiring an event stripe. Event stripes have no order with respect to each other so no event system
+    // mutex is held whilst calling out to user code (handlers and filters).
+    class event_mutex_pool
+    {
+    public:
+        static constexpr std::size_t kEventStripes = 64u;
+        static constexpr std::size_t kQueueStripes = 16u;
+    public:
+        static event_mutex_pool& instance()
+        {
+            static event_mutex_pool sInstance;
+            return sInstance;
+        }
+    public:
+        switchable_mutex& global() noexcept
+        {
+            return iGlobal;
+        }
+        switchable_mutex& event_stripe(void const* aEvent) noexcept
+        {
+            return iEventStripes[stripe<kEventStripes>(aEvent)];
+        }
+        switchable_mutex& queue_stripe(void const* aQueue) noexcept
+        {
+            return iQueueStripes[stripe<kQueueStripes>(aQueue)];
+        }
+    public:
+        void set_single_threaded()
+        {
+            apply([](switchable_mutex& aMutex) { aMutex.set_single_threaded(); });
+        }
+        void set_multi_threaded()
+        {
+            apply([](switchable_mutex& aMutex) { aMutex.set_multi_threaded_spinlock(); });
+        }
+    private:
+        template <std::size_t Stripes>
+        static std::size_t stripe(void const* aObject) noexcept
+        {
+            static_assert((Stripes & (Stripes - 1u)) == 0u, "stripe count must be a power of two");
+            auto const address = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(aObject));
+            return static_cast<std::size_t>((address * 0x9E3779B97F4A7C15ull) >> 32u) & (Stripes - 1u);
+        }
+        template <typename Policy>
+        void apply(Policy aPolicy)
+        {
+            aPolicy(iGlobal);
+            for (auto& m : iEventStripes)
+                aPolicy(m);
+            for (auto& m : iQueueStripes)
+                aPolicy(m);
+        }
+    private:
+        switchable_mutex iGlobal;
+        std::array<switchable_mutex, kEventStripes> iEventStripes;
+        std::array<switchable_mutex, kQueueStripes> iQueueStripes;
+    };
+
     inline switchable_mutex& event_mutex()
     {
-        static switchable_mutex sMutex;
-        return sMutex;
+        return event_mutex_pool::instance().global();
+    }
+
+    inline switchable_mutex& event_mutex(i_event const& aEvent)
+    {
+        return event_mutex_pool::instance().event_stripe(&aEvent);
     }
 
     namespace event_system
     {
         inline void set_single_threaded()
         {
-            event_mutex().set_single_threaded();
+            event_mutex_pool::instance().set_single_threaded();
         }
 
         inline void set_multi_threaded()
         {
-            event_mutex().set_multi_threaded_spinlock();
+            event_mutex_pool::instance().set_multi_threaded();
         }
     }
 
-    class i_event;
-
     class i_event_control
     {
     public:
@@ -154,6 +220,8 @@ namespace neolib
         virtual const void* identity() const = 0;
         virtual bool valid() const = 0;
         virtual void call() const = 0;
+        // called by the queue once the callback has left it (whether called or discarded)
+        virtual void unqueued() const noexcept = 0;
     };
 
     class i_event_filter
@@ -0,0 +1,113 @@
+// mpsc_queue.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstddef>
+#include <atomic>
+#include <type_traits>
+
+namespace neolib
+{
+    struct intrusive_mpsc_node
+    {
+        intrusive_mpsc_node* next = nullptr;
+    };
+
+    // Intrusive lock-free multi-producer single-consumer queue. Producers push onto a Treiber stack; the consumer
+    // detaches the whole stack in one exchange and restores FIFO order, so draining is batched and never blocks
+    // producers. Nodes are owned by the caller and must outlive their time in the queue.
+    template <typename Node>
+    class intrusive_mpsc_queue
+    {
+        static_assert(std::is_base_of_v<intrusive_mpsc_node, Node>, "neolib::intrusive_mpsc_queue: Node must derive from intrusive_mpsc_node");
+        // types
+    public:
+        typedef Node node_type;
+        // constants
+    private:
+        static constexpr std::size_t kCacheLineSize = 64u; // keeps the contended head off its neighbours' cache line
+        // construction
+    public:
+        intrusive_mpsc_queue() :
+            iHead{ nullptr }
+        {
+        }
+        intrusive_mpsc_queue(intrusive_mpsc_queue const&) = delete;
+        intrusive_mpsc_queue& operator=(intrusive_mpsc_queue const&) = delete;
+        // operations
+    public:
+        bool empty() const noexcept
+        {
+            return iHead.load(std::memory_order_acquire) == nullptr;
+        }
+        // any thread; returns true if the queue was empty
+        bool push(node_type& aNode) noexcept
+        {
+            auto head = iHead.load(std::memory_order_relaxed);
+            do
+            {
+                aNode.next = head;
+            } while (!iHead.compare_exchange_weak(head, &aNode, std::memory_order_release, std::memory_order_relaxed));
+            return head == nullptr;
+        }
+        // consumer thread only; returns the queued nodes in FIFO order linked through next
+        node_type* pop_all() noexcept
+        {
+            intrusive_mpsc_node* lifo = iHead.exchange(nullptr, std::memory_order_acquire);
+            intrusive_mpsc_node* fifo = nullptr;
+            while (lifo != nullptr)
+            {
+                auto next = lifo->next;
+                lifo->next = fifo;
+                fifo = lifo;
+                lifo = next;
+            }
+            return static_cast<node_type*>(fifo);
+        }
+        // visits queued nodes newest first; the caller must exclude a concurrent pop_all()
+        template <typename Visitor>
+        void for_each(Visitor aVisitor) const
+        {
+            for (auto n = iHead.load(std::memory_order_acquire); n != nullptr; n = n->next)
+                aVisitor(static_cast<node_type&>(*n));
+        }
+        // attributes
+    private:
+        alignas(kCacheLineSize) std::atomic<intrusive_mpsc_node*> iHead;
+    };
+}
@@ -0,0 +1,444 @@
+// pooled_task.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <neolib/task/i_task.hpp>
+
+namespace neolib
+{
+    class pooled_task_free_list;
+
+    // A recyclable task that stores small callables (and results) inline; obtained from (and returned to) a per-thread free list.
+    class pooled_task final : public i_task
+    {
+        friend class pooled_task_free_list;
+        template <typename>
+        friend class task_handle;
+        // constants
+    public:
+        static constexpr std::size_t kInlineCallableSize = 64;
+        static constexpr std::size_t kInlineResultSize = 32;
+        // types
+    public:
+        enum class state : uint32_t
+        {
+            Pending,
+            Completed,
+            Cancelled
+        };
+    private:
+        typedef void (*function_type)(pooled_task&);
+        template <typename T, std::size_t Size>
+        static constexpr bool fits_inline_v = sizeof(T) <= Size && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>;
+        // construction
+    private:
+        pooled_task(pooled_task_free_list& aFreeList) :
+            iFreeList{ aFreeList },
+            iNext{ nullptr },
+            iReferences{ 0u },
+            iState{ state::Pending },
+            iCancelled{ false },
+            iCallable{ nullptr },
+            iInvoke{ nullptr },
+            iDestroyCallable{ nullptr },
+            iResult{ nullptr },
+            iDestroyResult{ nullptr }
+        {
+        }
+        ~pooled_task()
+        {
+            reset();
+        }
+        // operations
+    public:
+        const std::string& name() const override
+        {
+            static const std::string sName = "neolib::pooled_task";
+            return sName;
+        }
+        // implementation
+    public:
+        void run(yield_type) override
+        {
+            bool const invoke = !iCancelled.load(std::memory_order_acquire);
+            if (invoke)
+            {
+                try
+                {
+                    iInvoke(*this);
+                }
+                catch (...)
+                {
+                    iException = std::current_exception();
+                }
+            }
+            iDestroyCallable(*this);
+            iDestroyCallable = nullptr;
+            iState.store(invoke ? state::Completed : state::Cancelled, std::memory_order_release);
+            iState.notify_all();
+            release();
+        }
+        bool do_work(yield_type) override
+        {
+            return false;
+        }
+        void cancel() override
+        {
+            iCancelled.store(true, std::memory_order_release);
+        }
+        bool cancelled() const override
+        {
+            // a pool that skips a cancelled task abandons it instead to release the pool's reference
+            return iCancelled.load(std::memory_order_acquire);
+        }
+    public:
+        template <typename Callable>
+        void emplace(Callable&& aCallable)
+        {
+            typedef std::decay_t<Callable> callable_type;
+            typedef std::invoke_result_t<callable_type&> result_type;
+            if constexpr (fits_inline_v<callable_type, kInlineCallableSize>)
+            {
+                iCallable = new (iCallableStorage) callable_type{ std::forward<Callable>(aCallable) };
+                iDestroyCallable = [](pooled_task& aTask) { static_cast<callable_type*>(aTask.iCallable)->~callable_type(); };
+            }
+            else
+            {
+                iCallable = new callable_type{ std::forward<Callable>(aCallable) };
+                iDestroyCallable = [](pooled_task& aTask) { delete static_cast<callable_type*>(aTask.iCallable); };
+            }
+            iInvoke = [](pooled_task& aTask)
+            {
+                auto& callable = *static_cast<callable_type*>(aTask.iCallable);
+                if constexpr (std::is_void_v<result_type>)
+                    callable();
+                else if constexpr (fits_inline_v<result_type, kInlineResultSize>)
+                {
+                    aTask.iResult = new (aTask.iResultStorage) result_type{ callable() };
+                    aTask.iDestroyResult = [](pooled_task& aTask) { static_cast<result_type*>(aTask.iResult)->~result_type(); };
+                }
+                else
+                {
+                    aTask.iResult = new result_type{ callable() };
+                    aTask.iDestroyResult = [](pooled_task& aTask) { delete static_cast<result_type*>(aTask.iResult); };
+                }
+            };
+        }
+        state status() const noexcept
+        {
+            return iState.load(std::memory_order_acquire);
+        }
+        void wait() const noexcept
+        {
+            iState.wait(state::Pending, std::memory_order_acquire);
+        }
+        // completes the task without invoking it (the pool cannot or will no longer run it) and releases the pool's reference;
+        // a handle's get() then rethrows aReason or, if there is no reason, throws task_cancelled
+        void abandon(std::exception_ptr aReason = {}) noexcept
+        {
+            if (iDestroyCallable != nullptr)
+                iDestroyCallable(*this);
+            iDestroyCallable = nullptr;
+            iException = aReason;
+            iState.store(aReason ? state::Completed : state::Cancelled, std::memory_order_release);
+            iState.notify_all();
+            release();
+        }
+        void add_ref() noexcept
+        {
+            iReferences.fetch_add(1u, std::memory_order_relaxed);
+        }
+        void release() noexcept;
+    private:
+        void reset() noexcept
+        {
+            if (iDestroyCallable != nullptr)
+                iDestroyCallable(*this);
+            if (iDestroyResult != nullptr)
+                iDestroyResult(*this);
+            iCallable = nullptr;
+            iInvoke = nullptr;
+            iDestroyCallable = nullptr;
+            iResult = nullptr;
+            iDestroyResult = nullptr;
+            iException = nullptr;
+            iCancelled.store(false, std::memory_order_relaxed);
+            iState.store(state::Pending, std::memory_order_relaxed);
+        }
+        // attributes
+    private:
+        pooled_task_free_list& iFreeList;
+        pooled_task* iNext;
+        std::atomic<uint32_t> iReferences;
+        std::atomic<state> iState;
+        std::atomic<bool> iCancelled;
+        void* iCallable;
+        function_type iInvoke;
+        function_type iDestroyCallable;
+        void* iResult;
+        function_type iDestroyResult;
+        std::exception_ptr iException;
+        alignas(std::max_align_t) std::byte iCallableStorage[kInlineCallableSize];
+        alignas(std::max_align_t) std::byte iResultStorage[kInlineResultSize];
+    };
+
+    // Tasks are recycled to the free list of the thread that acquired them; tasks released on other threads (or during thread
+    // exit) are pushed onto a lock-free remote list which the owning thread reclaims in one go when its local list runs dry.
+    class pooled_task_free_list
+    {
+        friend class pooled_task;
+        // constants
+    public:
+        static constexpr std::size_t kMaxLocalFree = 1024;
+        // types
+    private:
+        struct thread_owner
+        {
+            pooled_task_free_list* list = new pooled_task_free_list{};
+            ~thread_owner()
+            {
+                retired() = true;
+                list->orphan();
+            }
+        };
+        // construction
+    private:
+        pooled_task_free_list() :
+            iLocal{ nullptr }, iLocalCount{ 0u }, iRemote{ nullptr }, iReferences{ 1u }
+        {
+        }
+        ~pooled_task_free_list()
+        {
+            destroy(iLocal);
+            destroy(iRemote.exchange(nullptr, std::memory_order_acquire));
+        }
+        // operations
+    public:
+        static pooled_task_free_list& current()
+        {
+            thread_local thread_owner tOwner;
+            return *tOwner.list;
+        }
+        // returns a task with one reference for the pool and one for the caller's handle
+        pooled_task& acquire()
+        {
+            if (iLocal == nullptr)
+                adopt_remote();
+            pooled_task* result = iLocal;
+            if (result != nullptr)
+            {
+                iLocal = result->iNext;
+                --iLocalCount;
+            }
+            else
+                result = new pooled_task{ *this };
+            result->iNext = nullptr;
+            result->iReferences.store(2u, std::memory_order_relaxed);
+            iReferences.fetch_add(1u, std::memory_order_relaxed);
+            return *result;
+        }
+    private:
+        // set once this thread's free list has been orphaned; being trivially destructible it can still be read by tasks
+        // released later during thread exit (e.g. from another thread_local's destructor) when current() is gone
+        static bool& retired() noexcept
+        {
+            thread_local bool tRetired = false;
+            return tRetired;
+        }
+        // takes over the tasks released on other threads, keeping at most kMaxLocalFree of them
+        void adopt_remote() noexcept
+        {
+            iLocal = iRemote.exchange(nullptr, std::memory_order_acquire);
+            iLocalCount = 0u;
+            for (auto task = iLocal; task != nullptr; task = task->iNext)
+                if (++iLocalCount == kMaxLocalFree)
+                {
+                    destroy(std::exchange(task->iNext, nullptr));
+                    break;
+                }
+        }
+        void recycle(pooled_task& aTask) noexcept
+        {
+            aTask.reset();
+            if (!retired() && this == &current())
+            {
+                if (iLocalCount < kMaxLocalFree)
+                {
+                    aTask.iNext = iLocal;
+                    iLocal = &aTask;
+                    ++iLocalCount;
+                }
+                else
+                    delete &aTask;
+            }
+            else
+            {
+                aTask.iNext = iRemote.load(std::memory_order_relaxed);
+                while (!iRemote.compare_exchange_weak(aTask.iNext, &aTask, std::memory_order_release, std::memory_order_relaxed));
+            }
+            release_reference();
+        }
+        void orphan() noexcept
+        {
+            destroy(iLocal);
+            iLocal = nullptr;
+            destroy(iRemote.exchange(nullptr, std::memory_order_acquire));
+            release_reference();
+        }
+        void release_reference() noexcept
+        {
+            if (iReferences.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+                delete this;
+        }
+        static void destroy(pooled_task* aList) noexcept
+        {
+            while (aList != nullptr)
+            {
+                auto next = aList->iNext;
+                delete aList;
+                aList = next;
+            }
+        }
+        // attributes
+    private:
+        pooled_task* iLocal;
+        std::size_t iLocalCount;
+        std::atomic<pooled_task*> iRemote;
+        std::atomic<std::size_t> iReferences;
+    };
+
+    inline void pooled_task::release() noexcept
+    {
+        if (iReferences.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+            iFreeList.recycle(*this);
+    }
+
+    // A lightweight completion handle for a pooled_task; unlike std::future it requires no separate shared state.
+    template <typename T>
+    class task_handle
+    {
+        // exceptions
+    public:
+        struct no_task : std::logic_error { no_task() : std::logic_error("neolib::task_handle::no_task") {} };
+        struct task_cancelled : std::runtime_error { task_cancelled() : std::runtime_error("neolib::task_handle::task_cancelled") {} };
+        // types
+    public:
+        typedef T result_type;
+        // construction
+    public:
+        task_handle() noexcept :
+            iTask{ nullptr }
+        {
+        }
+        explicit task_handle(pooled_task& aTask) noexcept :
+            iTask{ &aTask }
+        {
+        }
+        task_handle(task_handle&& aOther) noexcept :
+            iTask{ std::exchange(aOther.iTask, nullptr) }
+        {
+        }
+        task_handle(task_handle const&) = delete;
+        ~task_handle()
+        {
+            reset();
+        }
+    public:
+        task_handle& operator=(task_handle&& aOther) noexcept
+        {
+            if (&aOther != this)
+            {
+                reset();
+                iTask = std::exchange(aOther.iTask, nullptr);
+            }
+            return *this;
+        }
+        task_handle& operator=(task_handle const&) = delete;
+        // operations
+    public:
+        bool valid() const noexcept
+        {
+            return iTask != nullptr;
+        }
+        bool ready() const
+        {
+            return task().status() != pooled_task::state::Pending;
+        }
+        void wait() const
+        {
+            task().wait();
+        }
+        void cancel()
+        {
+            task().cancel();
+        }
+        T get()
+        {
+            wait();
+            if (task().iException)
+                std::rethrow_exception(task().iException);
+            if (task().status() == pooled_task::state::Cancelled)
+                throw task_cancelled();
+            if constexpr (!std::is_void_v<T>)
+                return std::move(*static_cast<T*>(task().iResult));
+        }
+        void reset() noexcept
+        {
+            if (iTask != nullptr)
+                std::exchange(iTask, nullptr)->release();
+        }
+        // implementation
+    private:
+        pooled_task& task() const
+        {
+            if (iTask == nullptr)
+                throw no_task();
+            return *iTask;
+        }
+        // attributes
+    private:
+        pooled_task* iTask;
+    };
+}
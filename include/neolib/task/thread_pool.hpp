@@ -41,26 +41,61 @@
 #include <deque>
 #include <future>
 #include <mutex>
+#include <condition_variable>
+#include <boost/lockfree/queue.hpp>
 #include <neolib/task/i_thread.hpp>
 #include <neolib/task/task.hpp>
+#include <neolib/task/pooled_task.hpp>
 
 namespace neolib
 {
     class thread_pool_thread;
+    class work_stealing_thread_pool_thread;
+
+    // SharedQueueLock honours the full int32 priority and runs equal priority tasks in FIFO order.
+    // WorkStealing has one band per priority from -8 to 8 (priorities beyond that range share the outermost bands, see
+    // priority_band()) and services higher bands first. Within a band, tasks submitted from outside the pool are 
+    // dequeued in FIFO order; tasks a worker submits itself go on its own deque, which it works LIFO and thieves FIFO.
+    enum class thread_pool_scheduling
+    {
+        SharedQueueLock,    // per-thread queues guarded by the pool mutex
+        WorkStealing        // per-thread Chase-Lev work stealing deques, one per priority band
+    };
 
     class NEOLIB_EXPORT thread_pool
     {
         friend class thread_pool_thread;
+        friend class work_stealing_thread_pool_thread;
     public:
         typedef std::shared_ptr<i_task> task_pointer;
+        static constexpr int32_t kMaxBandedPriority = 8;
+        static constexpr std::size_t kPriorityBands = kMaxBandedPriority * 2u + 1u;
     public:
         struct no_threads : std::logic_error { no_threads() : std::logic_error("neolib::thread_pool::no_threads") {} };
         struct task_not_found : std::logic_error { task_not_found() : std::logic_error("neolib::thread_pool::task_not_found") {} };
     private:
+        // a queued task is either a heap allocated owning task_pointer or, if the task pointer is non-owning, the (tagged) task itself
+        class queued_task
+        {
+        public:
+            queued_task() = default;
+            queued_task(task_pointer aTask);
+        public:
+            explicit operator bool() const;
+            i_task& operator*() const;
+            void release();
+            void discard();
+        private:
+            std::uintptr_t iValue = 0u;
+        };
         typedef std::vector<std::unique_ptr<i_thread>> thread_list;
+        typedef std::vector<work_stealing_thread_pool_thread*> work_stealing_thread_list;
     public:
-        thread_pool();
+        thread_pool(thread_pool_scheduling aScheduling = thread_pool_scheduling::SharedQueueLock);
         ~thread_pool();
+    public:
+        thread_pool_scheduling scheduling() const;
+        static std::size_t priority_band(int32_t aPriority);
     public:
         void reserve(std::size_t aMaxThreads);
         std::size_t active_threads() const;
@@ -75,6 +110,8 @@ namespace neolib
         std::pair<std::future<void>, task_pointer> run(std::function<void()> aFunction, int32_t aPriority = 0);
         template <typename T>
         std::pair<std::future<T>, task_pointer> run(std::function<T()> aFunction, int32_t aPriority = 0);
+        template <typename Callable>
+        task_handle<std::invoke_result_t<std::decay_t<Callable>&>> submit(Callable&& aCallable, int32_t aPriority = 0);
     public:
         bool idle() const;
         void update_idle();
@@ -82,14 +119,24 @@ namespace neolib
         void wait() const;
         bool stopped() const;
         void stop();
+        bool in() const; // called from one of this pool's threads
     public:
         static thread_pool& default_thread_pool();
         std::recursive_mutex& mutex() const;
     private:
+        bool start_task(task_pointer aTask, int32_t aPriority);
         void steal_work(thread_pool_thread& aIdleThread);
         void thread_gone_idle();
         void thread_gone_busy();
+        void enqueue(task_pointer aTask, int32_t aPriority);
+        void discard_injected_tasks();
+        queued_task dequeue(work_stealing_thread_pool_thread& aThread);
+        void discard(queued_task aTask, std::size_t aBand);
+        void task_completed();
+        void wake_one();
+        void wait_for_work(std::atomic<bool> const& aStopped);
     private:
+        thread_pool_scheduling const iScheduling;
         mutable std::recursive_mutex iMutex;
         std::atomic<bool> iIdle;
         std::atomic<bool> iStopped;
@@ -97,6 +144,16 @@ namespace neolib
         thread_list iThreads;
         mutable std::mutex iWaitMutex;
         mutable std::condition_variable iWaitConditionVariable;
+        // work stealing scheduling
+        std::atomic<work_stealing_thread_list*> iWorkStealingThreads;
+        std::vector<std::unique_ptr<work_stealing_thread_list>> iWorkStealingThreadLists;
+        std::unique_ptr<boost::lockfree::queue<queued_task>> iInjectionQueues[kPriorityBands];
+        std::atomic<std::size_t> iQueuedTasks[kPriorityBands]; // lets idle workers skip empty bands without visiting every queue
+        std::atomic<std::size_t> iPendingTasks;
+        std::atomic<std::size_t> iSleepingThreads;
+        std::size_t iWakeups;
+        std::mutex iSleepMutex;
+        std::condition_variable iSleepConditionVariable;
     };
 
     template <typename T>
@@ -109,12 +166,39 @@ namespace neolib
         return std::make_pair(newTask->get_future(), newTask);
     }
 
+    template <typename Callable>
+    inline task_handle<std::invoke_result_t<std::decay_t<Callable>&>> thread_pool::submit(Callable&& aCallable, int32_t aPriority)
+    {
+        auto& newTask = pooled_task_free_list::current().acquire();
+        task_handle<std::invoke_result_t<std::decay_t<Callable>&>> result{ newTask };
+        try
+        {
+            newTask.emplace(std::forward<Callable>(aCallable));
+        }
+        catch (...)
+        {
+            newTask.release();
+            throw;
+        }
+        try
+        {
+            if (!start_task(task_pointer{ task_pointer{}, &newTask }, aPriority))
+                newTask.abandon();
+        }
+        catch (...)
+        {
+            newTask.abandon(std::current_exception());
+        }
+        return result;
+    }
+
     template <typename Container>
     inline void parallel_apply(thread_pool& aThreadPool, Container& aContainer, std::function<void(typename Container::value_type& aElement)> aFunction, std::size_t aMinimumParallelismCount = 0)
     {
         if (aThreadPool.stopped())
             return;
-        if (aContainer.size() < aMinimumParallelismCount)
+        // a pool task waiting for its own pool to go idle would wait forever so run nested work inline
+        if (aContainer.size() < aMinimumParallelismCount || aThreadPool.in())
         {
             for (auto& e : aContainer)
                 aFunction(e);
@@ -41,13 +41,17 @@
 #include <chrono>
 #include <neolib/task/i_async_task.hpp>
 #include <neolib/task/i_timer_object.hpp>
+#include <neolib/task/timer_wheel.hpp>
 
 namespace neolib
 {
-    class NEOLIB_EXPORT timer_object : public lifetime<reference_counted<i_timer_object>>
+    class timer_service;
+
+    class NEOLIB_EXPORT timer_object : public lifetime<reference_counted<i_timer_object>>, private timer_wheel::node
     {
+        friend class timer_service;
     public:
-        timer_object(i_timer_service& aService);
+        timer_object(timer_service& aService);
         ~timer_object();
     public:
         void expires_at(const std::chrono::steady_clock::time_point& aDeadline) override;
@@ -56,11 +60,13 @@ namespace neolib
         void cancel() override;
     public:
         bool poll() override;
+    private:
+        void notify_subscribers();
     public:
         bool debug() const override;
         void set_debug(bool aDebug) override;
     private:
-        i_timer_service& iService;
+        timer_service& iService;
         std::optional<std::chrono::steady_clock::time_point> iExpiryTime;
         mutable std::recursive_mutex iSubscribersMutex;
         std::set<ref_ptr<i_timer_subscriber>> iSubscribers;
@@ -0,0 +1,271 @@
+// timer_wheel.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <optional>
+#include <algorithm>
+
+namespace neolib
+{
+    // Hierarchical timing wheel: kLevels levels of kSlots slots each with an occupancy bitmap per level so that insertion, 
+    // removal and finding the next expiry are all O(1). Nodes are intrusive; expired nodes are moved to a due list.
+    class timer_wheel
+    {
+        // types
+    public:
+        typedef uint64_t tick_type;
+        // constants
+    public:
+        static constexpr std::size_t kSlotBits = 6;
+        static constexpr std::size_t kSlots = std::size_t{ 1u } << kSlotBits;
+        static constexpr std::size_t kLevels = 6;
+        static constexpr tick_type kRange = tick_type{ 1u } << (kSlotBits * kLevels);
+    private:
+        static constexpr uint8_t kOverflowLevel = static_cast<uint8_t>(kLevels);
+        static constexpr uint8_t kDueLevel = static_cast<uint8_t>(kLevels + 1u);
+        // types
+    public:
+        class node
+        {
+            friend class timer_wheel;
+        public:
+            node() :
+                iPrevious{ nullptr }, iNext{ nullptr }, iTick{ 0u }, iLevel{ 0u }, iSlot{ 0u }, iScheduled{ false }
+            {
+            }
+            node(node const&) = delete;
+            node& operator=(node const&) = delete;
+        public:
+            bool scheduled() const noexcept
+            {
+                return iScheduled;
+            }
+            tick_type tick() const noexcept
+            {
+                return iTick;
+            }
+        private:
+            node* iPrevious;
+            node* iNext;
+            tick_type iTick;
+            uint8_t iLevel;
+            uint8_t iSlot;
+            bool iScheduled;
+        };
+        // construction
+    public:
+        timer_wheel(tick_type aNow = 0u) :
+            iNow{ aNow }, iSize{ 0u }, iOccupied{}, iSlots{}, iOverflow{ nullptr }, iDue{ nullptr }, iDueCount{ 0u }
+        {
+        }
+        timer_wheel(timer_wheel const&) = delete;
+        timer_wheel& operator=(timer_wheel const&) = delete;
+        // operations
+    public:
+        tick_type now() const noexcept
+        {
+            return iNow;
+        }
+        std::size_t size() const noexcept
+        {
+            return iSize;
+        }
+        bool empty() const noexcept
+        {
+            return iSize == 0u;
+        }
+        std::size_t due_count() const noexcept
+        {
+            return iDueCount;
+        }
+        void insert(node& aNode, tick_type aTick) noexcept
+        {
+            if (aNode.iScheduled)
+                remove(aNode);
+            aNode.iTick = aTick;
+            aNode.iScheduled = true;
+            ++iSize;
+            place(aNode);
+        }
+        void remove(node& aNode) noexcept
+        {
+            if (!aNode.iScheduled)
+                return;
+            unlink(aNode);
+            aNode.iScheduled = false;
+            --iSize;
+        }
+        // the earliest tick at which the wheel needs servicing: exact for imminent expiries, a lower bound otherwise
+        std::optional<tick_type> next_expiry() const noexcept
+        {
+            if (iDue != nullptr)
+                return iNow;
+            if (auto next = next_slot())
+                return next->tick;
+            return {};
+        }
+        // moves all nodes expiring at or before aTick to the due list, cascading nodes from higher levels as needed
+        void advance(tick_type aTick) noexcept
+        {
+            while (auto next = next_slot())
+            {
+                if (next->tick > aTick)
+                    break;
+                iNow = std::max(iNow, next->tick);
+                node* list = nullptr;
+                if (next->level == kOverflowLevel)
+                    list = std::exchange(iOverflow, nullptr);
+                else
+                {
+                    list = std::exchange(iSlots[next->level][next->slot], nullptr);
+                    iOccupied[next->level] &= ~(uint64_t{ 1u } << next->slot);
+                }
+                while (list != nullptr)
+                {
+                    node& n = *list;
+                    list = n.iNext;
+                    place(n);
+                }
+            }
+            iNow = std::max(iNow, aTick);
+        }
+        node* pop_due() noexcept
+        {
+            if (iDue == nullptr)
+                return nullptr;
+            node& result = *iDue;
+            remove(result);
+            return &result;
+        }
+        // implementation
+    private:
+        struct slot_position
+        {
+            std::size_t level;
+            std::size_t slot;
+            tick_type tick;
+        };
+        std::optional<slot_position> next_slot() const noexcept
+        {
+            // nodes on a lower level always expire before nodes on a higher level
+            for (std::size_t level = 0u; level < kLevels; ++level)
+            {
+                auto const occupied = iOccupied[level];
+                if (occupied == 0u)
+                    continue;
+                auto const shift = kSlotBits * level;
+                auto const current = static_cast<std::size_t>((iNow >> shift) & (kSlots - 1u));
+                auto const ahead = occupied & (~uint64_t{ 0u } << current);
+                if (ahead == 0u)
+                    continue;
+                auto const slot = static_cast<std::size_t>(std::countr_zero(ahead));
+                auto const blockMask = (tick_type{ 1u } << (shift + kSlotBits)) - 1u;
+                return slot_position{ level, slot, (iNow & ~blockMask) | (static_cast<tick_type>(slot) << shift) };
+            }
+            // nodes beyond the current top level block are re-placed when the next block is reached
+            if (iOverflow != nullptr)
+                return slot_position{ kOverflowLevel, 0u, (iNow | (kRange - 1u)) + 1u };
+            return {};
+        }
+        void place(node& aNode) noexcept
+        {
+            node** headPtr = nullptr;
+            if (aNode.iTick <= iNow)
+            {
+                aNode.iLevel = kDueLevel;
+                headPtr = &iDue;
+                ++iDueCount;
+            }
+            else if (((aNode.iTick ^ iNow) >> (kSlotBits * kLevels)) != 0u)
+            {
+                aNode.iLevel = kOverflowLevel;
+                headPtr = &iOverflow;
+            }
+            else
+                headPtr = &slot_for(aNode);
+            node*& head = *headPtr;
+            aNode.iPrevious = nullptr;
+            aNode.iNext = head;
+            if (head != nullptr)
+                head->iPrevious = &aNode;
+            head = &aNode;
+        }
+        node*& slot_for(node& aNode) noexcept
+        {
+            auto const tick = aNode.iTick;
+            auto const level = static_cast<std::size_t>(63 - std::countl_zero(iNow ^ tick)) / kSlotBits;
+            auto const slot = static_cast<std::size_t>((tick >> (kSlotBits * level)) & (kSlots - 1u));
+            aNode.iLevel = static_cast<uint8_t>(level);
+            aNode.iSlot = static_cast<uint8_t>(slot);
+            iOccupied[level] |= (uint64_t{ 1u } << slot);
+            return iSlots[level][slot];
+        }
+        void unlink(node& aNode) noexcept
+        {
+            if (aNode.iPrevious != nullptr)
+                aNode.iPrevious->iNext = aNode.iNext;
+            else if (aNode.iLevel == kDueLevel)
+                iDue = aNode.iNext;
+            else if (aNode.iLevel == kOverflowLevel)
+                iOverflow = aNode.iNext;
+            else
+            {
+                iSlots[aNode.iLevel][aNode.iSlot] = aNode.iNext;
+                if (aNode.iNext == nullptr)
+                    iOccupied[aNode.iLevel] &= ~(uint64_t{ 1u } << aNode.iSlot);
+            }
+            if (aNode.iNext != nullptr)
+                aNode.iNext->iPrevious = aNode.iPrevious;
+            if (aNode.iLevel == kDueLevel)
+                --iDueCount;
+            aNode.iPrevious = nullptr;
+            aNode.iNext = nullptr;
+        }
+        // attributes
+    private:
+        tick_type iNow;
+        std::size_t iSize;
+        std::array<uint64_t, kLevels> iOccupied;
+        std::array<std::array<node*, kSlots>, kLevels> iSlots;
+        node* iOverflow;
+        node* iDue;
+        std::size_t iDueCount;
+    };
+}
@@ -0,0 +1,184 @@
+// work_stealing_deque.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <type_traits>
+
+namespace neolib
+{
+    // Chase-Lev work stealing deque (using the C11 memory model formulation of Le, Pop, Cohen and Zappa Nardelli).
+    // The owning thread pushes and pops (LIFO) at the bottom; any other thread may steal (FIFO) from the top.
+    template <typename T>
+    class work_stealing_deque
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "neolib::work_stealing_deque: T must be trivially copyable");
+        // types
+    public:
+        typedef T value_type;
+        typedef std::int64_t index_type;
+    private:
+        class buffer
+        {
+        public:
+            buffer(index_type aCapacity) :
+                iCapacity{ aCapacity }, iMask{ aCapacity - 1 }, iItems{ std::make_unique<std::atomic<value_type>[]>(static_cast<std::size_t>(aCapacity)) }
+            {
+            }
+        public:
+            index_type capacity() const noexcept
+            {
+                return iCapacity;
+            }
+            value_type get(index_type aIndex) const noexcept
+            {
+                return iItems[aIndex & iMask].load(std::memory_order_relaxed);
+            }
+            void put(index_type aIndex, value_type aValue) noexcept
+            {
+                iItems[aIndex & iMask].store(aValue, std::memory_order_relaxed);
+            }
+            std::unique_ptr<buffer> grow(index_type aBottom, index_type aTop) const
+            {
+                auto result = std::make_unique<buffer>(iCapacity * 2);
+                for (index_type i = aTop; i != aBottom; ++i)
+                    result->put(i, get(i));
+                return result;
+            }
+        private:
+            index_type const iCapacity;
+            index_type const iMask;
+            std::unique_ptr<std::atomic<value_type>[]> iItems;
+        };
+        // constants
+    public:
+        static constexpr index_type kDefaultCapacity = 256;
+    private:
+        static constexpr std::size_t kCacheLineSize = 64u; // keeps the owner's and the thieves' indices apart
+        // construction
+    public:
+        work_stealing_deque(index_type aInitialCapacity = kDefaultCapacity) :
+            iTop{ 0 }, iBottom{ 0 }
+        {
+            index_type capacity = 1;
+            while (capacity < aInitialCapacity)
+                capacity <<= 1;
+            iBuffers.push_back(std::make_unique<buffer>(capacity));
+            iBuffer.store(iBuffers.back().get(), std::memory_order_relaxed);
+        }
+        work_stealing_deque(work_stealing_deque const&) = delete;
+        work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+        // operations
+    public:
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+        std::size_t size() const noexcept
+        {
+            auto const b = iBottom.load(std::memory_order_relaxed);
+            auto const t = iTop.load(std::memory_order_relaxed);
+            return static_cast<std::size_t>(b >= t ? b - t : 0);
+        }
+        // owner thread only
+        void push(value_type aValue)
+        {
+            auto const b = iBottom.load(std::memory_order_relaxed);
+            auto const t = iTop.load(std::memory_order_acquire);
+            auto* a = iBuffer.load(std::memory_order_relaxed);
+            if (b - t > a->capacity() - 1)
+            {
+                // old buffers are retired rather than freed as thieves may still be reading from them
+                iBuffers.push_back(a->grow(b, t));
+                a = iBuffers.back().get();
+                iBuffer.store(a, std::memory_order_release);
+            }
+            a->put(b, aValue);
+            std::atomic_thread_fence(std::memory_order_release);
+            iBottom.store(b + 1, std::memory_order_relaxed);
+        }
+        // owner thread only
+        std::optional<value_type> pop() noexcept
+        {
+            auto const b = iBottom.load(std::memory_order_relaxed) - 1;
+            auto* a = iBuffer.load(std::memory_order_relaxed);
+            iBottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = iTop.load(std::memory_order_relaxed);
+            std::optional<value_type> result;
+            if (t <= b)
+            {
+                result = a->get(b);
+                if (t == b)
+                {
+                    // last item: race against thieves
+                    if (!iTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        result = std::nullopt;
+                    iBottom.store(b + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+                iBottom.store(b + 1, std::memory_order_relaxed);
+            return result;
+        }
+        // any thread
+        std::optional<value_type> steal() noexcept
+        {
+            auto t = iTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto const b = iBottom.load(std::memory_order_acquire);
+            if (t < b)
+            {
+                auto* a = iBuffer.load(std::memory_order_acquire);
+                auto const result = a->get(t);
+                if (!iTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return {};
+                return result;
+            }
+            return {};
+        }
+        // attributes
+    private:
+        alignas(kCacheLineSize) std::atomic<index_type> iTop;
+        alignas(kCacheLineSize) std::atomic<index_type> iBottom;
+        alignas(kCacheLineSize) std::atomic<buffer*> iBuffer;
+        std::vector<std::unique_ptr<buffer>> iBuffers;
+    };
+}
@@ -0,0 +1,427 @@
+// archetype_storage.cpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <bit>
+#include <neolib/ecs/archetype_storage.hpp>
+
+namespace neolib::ecs
+{
+    namespace
+    {
+        inline std::size_t align_up(std::size_t aOffset, std::size_t aAlignment)
+        {
+            return (aOffset + aAlignment - 1u) / aAlignment * aAlignment;
+        }
+    }
+
+    archetype_storage::table::table(std::vector<const component_column_traits*> aColumns, archetype_storage& aStorage) :
+        iStorage{ aStorage }, iColumns{ std::move(aColumns) }, iChunkBytes{ 0u }, iChunkCapacity{ 0u }, iSize{ 0u }
+    {
+        auto const chunkSize = aStorage.chunk_size();
+        std::sort(iColumns.begin(), iColumns.end(), [](auto lhs, auto rhs) { return lhs->id < rhs->id; });
+        std::size_t rowBytes = sizeof(entity_id);
+        for (auto column : iColumns)
+        {
+            iSignature.push_back(column->id);
+            rowBytes += column->size;
+        }
+        iOffsets.resize(iColumns.size());
+        iChunkCapacity = std::max<std::size_t>(chunkSize / rowBytes, 1u);
+        while (iChunkCapacity > 1u && layout(iChunkCapacity) > chunkSize)
+            --iChunkCapacity;
+        // a chunk too big for one block (a single row larger than the chunk size) spans several
+        iChunkBytes = align_up(std::max(layout(iChunkCapacity), chunkSize), aStorage.chunk_alignment());
+    }
+
+    archetype_storage::table::~table()
+    {
+        for (std::size_t row = 0u; row < iSize; ++row)
+            for (std::size_t column = 0u; column < iColumns.size(); ++column)
+                iColumns[column]->destroy(record(row, column));
+    }
+
+    const archetype_storage::signature_t& archetype_storage::table::signature() const
+    {
+        return iSignature;
+    }
+
+    const std::vector<const component_column_traits*>& archetype_storage::table::columns() const
+    {
+        return iColumns;
+    }
+
+    std::size_t archetype_storage::table::column_index(const component_id& aComponentId) const
+    {
+        auto existing = std::lower_bound(iSignature.begin(), iSignature.end(), aComponentId);
+        if (existing != iSignature.end() && *existing == aComponentId)
+            return static_cast<std::size_t>(existing - iSignature.begin());
+        return npos;
+    }
+
+    bool archetype_storage::table::contains(const component_id& aComponentId) const
+    {
+        return column_index(aComponentId) != npos;
+    }
+
+    std::size_t archetype_storage::table::size() const
+    {
+        return iSize;
+    }
+
+    bool archetype_storage::table::empty() const
+    {
+        return iSize == 0u;
+    }
+
+    std::size_t archetype_storage::table::chunk_capacity() const
+    {
+        return iChunkCapacity;
+    }
+
+    std::size_t archetype_storage::table::chunk_count() const
+    {
+        return iChunks.size();
+    }
+
+    std::size_t archetype_storage::table::chunk_rows(std::size_t aChunk) const
+    {
+        return std::min(iChunkCapacity, iSize - aChunk * iChunkCapacity);
+    }
+
+    const entity_id* archetype_storage::table::entities(std::size_t aChunk) const
+    {
+        return reinterpret_cast<const entity_id*>(iChunks[aChunk].get());
+    }
+
+    entity_id& archetype_storage::table::entity_slot(std::size_t aRow)
+    {
+        return reinterpret_cast<entity_id*>(iChunks[aRow / iChunkCapacity].get())[aRow % iChunkCapacity];
+    }
+
+    const void* archetype_storage::table::column(std::size_t aChunk, std::size_t aColumn) const
+    {
+        return iChunks[aChunk].get() + iOffsets[aColumn];
+    }
+
+    void* archetype_storage::table::column(std::size_t aChunk, std::size_t aColumn)
+    {
+        return iChunks[aChunk].get() + iOffsets[aColumn];
+    }
+
+    entity_id archetype_storage::table::entity(std::size_t aRow) const
+    {
+        return entities(aRow / iChunkCapacity)[aRow % iChunkCapacity];
+    }
+
+    const void* archetype_storage::table::record(std::size_t aRow, std::size_t aColumn) const
+    {
+        return static_cast<const std::byte*>(column(aRow / iChunkCapacity, aColumn)) + (aRow % iChunkCapacity) * iColumns[aColumn]->size;
+    }
+
+    void* archetype_storage::table::record(std::size_t aRow, std::size_t aColumn)
+    {
+        return const_cast<void*>(to_const(*this).record(aRow, aColumn));
+    }
+
+    std::size_t archetype_storage::table::layout(std::size_t aCapacity)
+    {
+        std::size_t offset = sizeof(entity_id) * aCapacity;
+        for (std::size_t column = 0u; column < iColumns.size(); ++column)
+        {
+            offset = align_up(offset, std::max(iColumns[column]->alignment, column_alignment));
+            iOffsets[column] = offset;
+            offset += iColumns[column]->size * aCapacity;
+        }
+        return offset;
+    }
+
+    void archetype_storage::table::push_chunk()
+    {
+        std::align_val_t const alignment{ iStorage.chunk_alignment() };
+        iChunks.emplace_back(static_cast<std::byte*>(::operator new(iChunkBytes, alignment)), chunk_deleter{ alignment });
+        try
+        {
+            auto const base = reinterpret_cast<std::uintptr_t>(iChunks.back().get());
+            for (std::size_t block = 0u; block < iChunkBytes; block += iStorage.chunk_alignment())
+                iStorage.iChunkIndex.emplace(base + block, chunk_location{ this, iChunks.size() - 1u });
+        }
+        catch (...)
+        {
+            pop_chunk();
+            throw;
+        }
+    }
+
+    void archetype_storage::table::pop_chunk()
+    {
+        auto const base = reinterpret_cast<std::uintptr_t>(iChunks.back().get());
+        for (std::size_t block = 0u; block < iChunkBytes; block += iStorage.chunk_alignment())
+            iStorage.iChunkIndex.erase(base + block);
+        iChunks.pop_back();
+    }
+
+    // Appends a row with uninitialized columns; the caller constructs them.
+    std::size_t archetype_storage::table::push(entity_id aEntity)
+    {
+        if (iSize == iChunks.size() * iChunkCapacity)
+            push_chunk();
+        auto const row = iSize++;
+        entity_slot(row) = aEntity;
+        return row;
+    }
+
+    // Destroys a row and fills the hole with the last row; returns the entity whose row moved (or null_entity).
+    entity_id archetype_storage::table::erase(std::size_t aRow)
+    {
+        auto const last = iSize - 1u;
+        entity_id moved = null_entity;
+        for (std::size_t column = 0u; column < iColumns.size(); ++column)
+        {
+            auto const& traits = *iColumns[column];
+            traits.destroy(record(aRow, column));
+            if (aRow != last)
+            {
+                traits.move_construct(record(aRow, column), record(last, column));
+                traits.destroy(record(last, column));
+            }
+        }
+        if (aRow != last)
+        {
+            moved = entity(last);
+            entity_slot(aRow) = moved;
+        }
+        --iSize;
+        if (iChunks.size() * iChunkCapacity - iSize >= iChunkCapacity)
+            pop_chunk();
+        return moved;
+    }
+
+    archetype_storage::archetype_storage(std::size_t aChunkSize) :
+        iChunkSize{ aChunkSize }, iChunkAlignment{ std::bit_ceil(std::max(aChunkSize, column_alignment)) }
+    {
+    }
+
+    archetype_storage::~archetype_storage()
+    {
+    }
+
+    neolib::recursive_spinlock& archetype_storage::mutex() const
+    {
+        return iMutex;
+    }
+
+    std::size_t archetype_storage::chunk_size() const
+    {
+        return iChunkSize;
+    }
+
+    std::size_t archetype_storage::chunk_alignment() const
+    {
+        return iChunkAlignment;
+    }
+
+    const archetype_storage::tables_t& archetype_storage::tables() const
+    {
+        return iTables;
+    }
+
+    bool archetype_storage::contains(entity_id aEntity) const
+    {
+        return owner(aEntity) != nullptr;
+    }
+
+    const archetype_storage::table* archetype_storage::owner(entity_id aEntity) const
+    {
+        auto const index = entity_index(aEntity);
+        if (index < iLocations.size())
+        {
+            auto const& location = iLocations[index];
+            // a stale id may share its index with a live entity so check the generation too
+            if (location.owner != nullptr && location.owner->entity(location.row) == aEntity)
+                return location.owner;
+        }
+        return nullptr;
+    }
+
+    const void* archetype_storage::find(entity_id aEntity, const component_id& aComponentId) const
+    {
+        auto const existingOwner = owner(aEntity);
+        if (existingOwner == nullptr)
+            return nullptr;
+        auto const column = existingOwner->column_index(aComponentId);
+        if (column == npos)
+            return nullptr;
+        return existingOwner->record(iLocations[entity_index(aEntity)].row, column);
+    }
+
+    void* archetype_storage::find(entity_id aEntity, const component_id& aComponentId)
+    {
+        return const_cast<void*>(to_const(*this).find(aEntity, aComponentId));
+    }
+
+    entity_id archetype_storage::entity(const component_id& aComponentId, const void* aRecord) const
+    {
+        auto const record = reinterpret_cast<std::uintptr_t>(aRecord);
+        auto const existing = iChunkIndex.find(record & ~(iChunkAlignment - 1u));
+        if (existing != iChunkIndex.end())
+        {
+            auto const& [owner, chunk] = existing->second;
+            auto const column = owner->column_index(aComponentId);
+            if (column != npos)
+            {
+                auto const recordSize = owner->columns()[column]->size;
+                auto const first = reinterpret_cast<std::uintptr_t>(owner->column(chunk, column));
+                if (first <= record && record < first + owner->chunk_rows(chunk) * recordSize)
+                    return owner->entities(chunk)[(record - first) / recordSize];
+            }
+        }
+        throw entity_not_found();
+    }
+
+    void* archetype_storage::add(entity_id aEntity, const component_column_traits& aColumn)
+    {
+        auto const column = &aColumn;
+        add(aEntity, std::span<const component_column_traits* const>{ &column, 1u });
+        return find(aEntity, aColumn.id);
+    }
+
+    void archetype_storage::add(entity_id aEntity, std::span<const component_column_traits* const> aColumns)
+    {
+        std::vector<const component_column_traits*> columns;
+        if (auto existingOwner = owner(aEntity))
+            columns = existingOwner->columns();
+        auto const existingColumnCount = columns.size();
+        for (auto column : aColumns)
+            if (std::none_of(columns.begin(), columns.end(), [&](auto c) { return c->id == column->id; }))
+                columns.push_back(column);
+        if (existingColumnCount != 0u && columns.size() == existingColumnCount)
+            return;
+        relocate(aEntity, find_or_create_table(std::move(columns)));
+    }
+
+    void archetype_storage::remove(entity_id aEntity, const component_id& aComponentId)
+    {
+        auto existingOwner = owner(aEntity);
+        if (existingOwner == nullptr || !existingOwner->contains(aComponentId))
+            throw entity_not_found();
+        std::vector<const component_column_traits*> columns;
+        for (auto column : existingOwner->columns())
+            if (column->id != aComponentId)
+                columns.push_back(column);
+        if (columns.empty())
+            erase_entity(aEntity, nullptr);
+        else
+            relocate(aEntity, find_or_create_table(std::move(columns)));
+    }
+
+    void archetype_storage::remove(entity_id aEntity, i_ecs& aEcs)
+    {
+        if (!contains(aEntity))
+            throw entity_not_found();
+        erase_entity(aEntity, &aEcs);
+    }
+
+    archetype_storage::table& archetype_storage::find_or_create_table(std::vector<const component_column_traits*> aColumns)
+    {
+        signature_t signature;
+        for (auto column : aColumns)
+            signature.push_back(column->id);
+        std::sort(signature.begin(), signature.end());
+        auto existing = iTableIndex.find(signature);
+        if (existing != iTableIndex.end())
+            return *existing->second;
+        iTables.push_back(std::make_unique<table>(std::move(aColumns), *this));
+        iTableIndex.emplace(std::move(signature), iTables.back().get());
+        return *iTables.back();
+    }
+
+    // Moves an entity's row (if any) to aDestination: shared columns are move constructed, new ones default constructed.
+    void archetype_storage::relocate(entity_id aEntity, table& aDestination)
+    {
+        auto const index = entity_index(aEntity);
+        if (iLocations.size() <= index)
+            iLocations.resize(index + 1u);
+        auto const source = iLocations[index].owner;
+        auto const sourceRow = iLocations[index].row;
+        auto const row = aDestination.push(aEntity);
+        std::size_t constructed = 0u;
+        try
+        {
+            for (; constructed < aDestination.columns().size(); ++constructed)
+            {
+                auto const& traits = *aDestination.columns()[constructed];
+                auto const sourceColumn = source != nullptr ? source->column_index(traits.id) : npos;
+                if (sourceColumn != npos)
+                    traits.move_construct(aDestination.record(row, constructed), source->record(sourceRow, sourceColumn));
+                else
+                    traits.default_construct(aDestination.record(row, constructed));
+            }
+        }
+        catch (...)
+        {
+            while (constructed-- > 0u)
+                aDestination.columns()[constructed]->destroy(aDestination.record(row, constructed));
+            --aDestination.iSize;
+            if (aDestination.iChunks.size() * aDestination.iChunkCapacity - aDestination.iSize >= aDestination.iChunkCapacity)
+                aDestination.pop_chunk();
+            throw;
+        }
+        if (source != nullptr)
+            erase_row(*source, sourceRow);
+        iLocations[index] = location{ &aDestination, row };
+    }
+
+    void archetype_storage::erase_entity(entity_id aEntity, i_ecs* aEcs)
+    {
+        auto const index = entity_index(aEntity);
+        auto& source = *iLocations[index].owner;
+        auto const row = iLocations[index].row;
+        if (aEcs != nullptr)
+            for (std::size_t column = 0u; column < source.columns().size(); ++column)
+                if (source.columns()[column]->free_handles != nullptr)
+                    source.columns()[column]->free_handles(source.record(row, column), *aEcs);
+        erase_row(source, row);
+        iLocations[index] = location{};
+    }
+
+    void archetype_storage::erase_row(table& aOwner, std::size_t aRow)
+    {
+        auto const moved = aOwner.erase(aRow);
+        if (moved != null_entity)
+            iLocations[entity_index(moved)].row = aRow;
+    }
+}
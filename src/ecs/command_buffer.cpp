@@ -0,0 +1,128 @@
+// command_buffer.cpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <neolib/neolib.hpp>
+#include <neolib/ecs/command_buffer.hpp>
+
+namespace neolib::ecs
+{
+    command_buffer::command_buffer(i_ecs& aEcs) :
+        iEcs{ aEcs }
+    {
+    }
+
+    i_ecs& command_buffer::ecs() const
+    {
+        return iEcs;
+    }
+
+    neolib::recursive_spinlock& command_buffer::mutex() const
+    {
+        return iMutex;
+    }
+
+    bool command_buffer::empty() const
+    {
+        std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+        if (!iCreations.empty() || !iDestructions.empty())
+            return false;
+        for (auto const& commands : iComponentCommands)
+            if (!commands.second->empty())
+                return false;
+        return true;
+    }
+
+    void command_buffer::destroy_entity(entity_id aEntity, bool aNotify)
+    {
+        std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+        iDestructions.push_back(destroy_command{ aEntity, aNotify });
+    }
+
+    void command_buffer::take(command_buffer& aSource)
+    {
+        std::scoped_lock<neolib::recursive_spinlock, neolib::recursive_spinlock> lock{ mutex(), aSource.mutex() };
+        auto const componentOffset = static_cast<uint32_t>(iCreationComponents.size());
+        for (auto const& creation : aSource.iCreations)
+        {
+            iCreations.push_back(creation);
+            iCreations.back().firstComponent += componentOffset;
+        }
+        iCreationComponents.insert(iCreationComponents.end(), aSource.iCreationComponents.begin(), aSource.iCreationComponents.end());
+        iDestructions.insert(iDestructions.end(), aSource.iDestructions.begin(), aSource.iDestructions.end());
+        for (auto& commands : aSource.iComponentCommands)
+        {
+            if (commands.second->empty())
+                continue;
+            auto& existing = iComponentCommands[commands.first];
+            if (!existing)
+                existing = commands.second->clone_empty();
+            existing->take(*commands.second);
+        }
+        // clear rather than swap so the source keeps its capacity for the next frame
+        aSource.iCreations.clear();
+        aSource.iCreationComponents.clear();
+        aSource.iDestructions.clear();
+    }
+
+    void command_buffer::clear()
+    {
+        std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+        iCreations.clear();
+        iCreationComponents.clear();
+        iDestructions.clear();
+        for (auto& commands : iComponentCommands)
+            commands.second->clear();
+    }
+
+    std::vector<command_buffer::create_command>& command_buffer::creations()
+    {
+        return iCreations;
+    }
+
+    const std::vector<component_id>& command_buffer::creation_components() const
+    {
+        return iCreationComponents;
+    }
+
+    std::vector<command_buffer::destroy_command>& command_buffer::destructions()
+    {
+        return iDestructions;
+    }
+
+    command_buffer::component_commands_t& command_buffer::component_commands_by_id()
+    {
+        return iComponentCommands;
+    }
+}
@@ -42,6 +42,20 @@
 
 namespace neolib::ecs
 {
+    namespace
+    {
+        std::atomic<uint64_t> sNextInstance;
+
+        // an entry outlives its ecs if the thread does; it is only dropped once its token has expired
+        struct thread_command_buffer
+        {
+            uint64_t instance;
+            std::weak_ptr<void> token;
+            command_buffer* buffer;
+        };
+        thread_local std::vector<thread_command_buffer> tCommandBuffers;
+    }
+
     const ecs::archetype_registry_t& ecs::archetypes() const
     {
         return iArchetypeRegistry;
@@ -199,37 +213,160 @@ namespace neolib::ecs
 
     entity_id ecs::next_entity_id()
     {
-        if (!iFreedEntityIds.empty())
+        auto const id = reserve_entity_id();
+        commit_entity_id(id);
+        return id;
+    }
+
+    entity_id ecs::reserve_entity_id()
+    {
+        auto freed = iFreedEntityIndices.load(std::memory_order_acquire);
+        while (static_cast<entity_index_t>(freed) != 0u)
         {
-            auto nextId = iFreedEntityIds.back();
-            iFreedEntityIds.pop_back();
-            return nextId;
+            auto const index = static_cast<entity_index_t>(freed);
+            // a stale link is harmless: the tag will have changed so the exchange fails
+            auto const next = slot(index).nextFree.load(std::memory_order_relaxed);
+            if (iFreedEntityIndices.compare_exchange_weak(freed, ((freed >> 32u) + 1u) << 32u | next, std::memory_order_acquire))
+                return make_entity_id(index, generation(index));
         }
-        if (++iNextEntityId == null_entity)
+        auto const index = ++iNextEntityIndex;
+        if (index == 0u)
             throw entity_ids_exhausted();
-        return iNextEntityId;
+        return make_entity_id(index, 0u);
     }
 
     void ecs::free_entity_id(entity_id aId)
     {
-        iFreedEntityIds.push_back(aId);
+        auto const index = entity_index(aId);
+        if (index == 0u || index > iNextEntityIndex.load(std::memory_order_acquire))
+            return;
+        // bump the generation now so stale ids die immediately but hold the index back until recycle_entity_ids();
+        // only the caller that bumps it retires the index so racing frees of one id cannot retire it twice
+        auto& entry = slot(index);
+        auto generation = entity_generation(aId);
+        if (!entry.generation.compare_exchange_strong(generation, generation + 1u, std::memory_order_acq_rel))
+            return;
+        entry.committed.store(false, std::memory_order_release);
+        auto retired = iRetiredEntityIndices.load(std::memory_order_relaxed);
+        do
+            entry.nextFree.store(retired, std::memory_order_relaxed);
+        while (!iRetiredEntityIndices.compare_exchange_weak(retired, index, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    bool ecs::is_alive(entity_id aEntity) const
+    {
+        auto const index = entity_index(aEntity);
+        if (index == 0u || index > iNextEntityIndex.load(std::memory_order_acquire))
+            return false;
+        auto const entry = find_slot(index);
+        // a free clears the committed flag after bumping the generation so reading the flag first cannot pass a stale id
+        return entry != nullptr && entry->committed.load(std::memory_order_acquire) &&
+            entity_generation(aEntity) == entry->generation.load(std::memory_order_acquire);
+    }
+
+    void ecs::commit_entity_id(entity_id aId)
+    {
+        slot(entity_index(aId)).committed.store(true, std::memory_order_release);
+    }
+
+    bool ecs::is_reserved(entity_id aEntity) const
+    {
+        auto const index = entity_index(aEntity);
+        if (index == 0u || index > iNextEntityIndex.load(std::memory_order_acquire))
+            return false;
+        return entity_generation(aEntity) == generation(index);
+    }
+
+    void ecs::recycle_entity_ids()
+    {
+        // take the whole retired stack then splice it onto the reusable one in a single exchange
+        auto const first = iRetiredEntityIndices.exchange(0u, std::memory_order_acquire);
+        if (first == 0u)
+            return;
+        auto last = first;
+        while (auto const next = slot(last).nextFree.load(std::memory_order_relaxed))
+            last = next;
+        auto& lastEntry = slot(last);
+        auto freed = iFreedEntityIndices.load(std::memory_order_relaxed);
+        do
+            lastEntry.nextFree.store(static_cast<entity_index_t>(freed), std::memory_order_relaxed);
+        while (!iFreedEntityIndices.compare_exchange_weak(freed, ((freed >> 32u) + 1u) << 32u | first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    const ecs::entity_slot* ecs::find_slot(entity_index_t aIndex) const
+    {
+        auto const pages = iGenerationPages.load(std::memory_order_acquire);
+        if (pages == nullptr)
+            return nullptr;
+        auto const page = pages[aIndex / generation_page_size].load(std::memory_order_acquire);
+        if (page == nullptr)
+            return nullptr;
+        return &(*page)[aIndex % generation_page_size];
+    }
+
+    entity_generation_t ecs::generation(entity_index_t aIndex) const
+    {
+        auto const entry = find_slot(aIndex);
+        if (entry == nullptr)
+            return 0u;
+        return entry->generation.load(std::memory_order_acquire);
+    }
+
+    ecs::entity_slot& ecs::slot(entity_index_t aIndex)
+    {
+        auto pages = iGenerationPages.load(std::memory_order_acquire);
+        if (pages == nullptr)
+        {
+            auto const newPages = new std::atomic<generation_page*>[generation_page_count]{};
+            if (iGenerationPages.compare_exchange_strong(pages, newPages, std::memory_order_acq_rel))
+                pages = newPages;
+            else
+                delete[] newPages;
+        }
+        auto& pageSlot = pages[aIndex / generation_page_size];
+        auto page = pageSlot.load(std::memory_order_acquire);
+        if (page == nullptr)
+        {
+            auto const newPage = new generation_page{};
+            if (pageSlot.compare_exchange_strong(page, newPage, std::memory_order_acq_rel))
+                page = newPage;
+            else
+                delete newPage;
+        }
+        return (*page)[aIndex % generation_page_size];
     }
 
     ecs::ecs(ecs_flags aCreationFlags) :
-        iFlags{ aCreationFlags }, iNextEntityId { null_entity }, iNextHandleId{ null_id },
+        iFlags{ aCreationFlags }, iAllComponentsMutex{ iComponentMutexes }, iNextEntityIndex{ 0u }, iFreedEntityIndices{ 0u }, iRetiredEntityIndices{ 0u }, iGenerationPages{ nullptr }, iNextHandleId{ null_id },
         iSystemTimer
         {
             service<i_async_task>(),
             [this](neolib::callback_timer& aTimer)
             {
                 aTimer.again();
-                for (auto& system : systems())
-                    if (system.second->can_apply())
-                        system.second->apply();
+                bool const parallelSystems = (flags() & ecs_flags::ParallelSystems) == ecs_flags::ParallelSystems;
+                if (parallelSystems)
+                {
+                    // the frame runs on the thread pool; rather than block this thread until it ends check back next tick
+                    if (scheduler().frame_running())
+                        return;
+                    scheduler().finish_frame();
+                }
+                else
+                    for (auto& system : systems())
+                        if (system.second->can_apply())
+                            system.second->apply();
                 commit_async_entity_destruction();
                 commit_async_entity_creation();
+                commit_commands();
+                recycle_entity_ids();
+                if (parallelSystems)
+                    scheduler().start_frame();
             }, std::chrono::milliseconds{1}, true
         },
+        iInstance{ ++sNextInstance },
+        iInstanceToken{ std::make_shared<uint64_t>(iInstance) },
+        iPendingCommands{ *this },
         iSystemsPaused{ (flags() & ecs_flags::CreatePaused) == ecs_flags::CreatePaused }
     {
         if ((flags() & ecs_flags::PopulateEntityInfo) == ecs_flags::PopulateEntityInfo)
@@ -243,10 +380,18 @@ namespace neolib::ecs
 
     ecs::~ecs()
     {
+        iSystemTimer.cancel();
+        iScheduler.reset(); // waits for a frame still running on the thread pool
         if (iThreadPool)
             iThreadPool->stop();
         for (auto& system : systems())
             system.second->terminate();
+        if (auto const pages = iGenerationPages.load())
+        {
+            for (std::size_t page = 0u; page < generation_page_count; ++page)
+                delete pages[page].load();
+            delete[] pages;
+        }
     }
 
     neolib::recursive_spinlock& ecs::mutex() const
@@ -254,14 +399,44 @@ namespace neolib::ecs
         return iMutex;
     }
 
+    neolib::i_lockable& ecs::component_mutexes() const
+    {
+        return iAllComponentsMutex;
+    }
+
     neolib::thread_pool& ecs::thread_pool() const
     {
         std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
         if (!iThreadPool)
-            iThreadPool.emplace();
+            iThreadPool.emplace(thread_pool_scheduling::WorkStealing);
         return *iThreadPool;
     }
 
+    archetype_storage& ecs::chunk_storage() const
+    {
+        return iChunkStorage;
+    }
+
+    system_scheduler& ecs::scheduler() const
+    {
+        std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+        if (!iScheduler)
+            iScheduler.emplace(const_cast<ecs&>(*this));
+        return *iScheduler;
+    }
+
+    command_buffer& ecs::commands()
+    {
+        for (auto const& cached : tCommandBuffers)
+            if (cached.instance == iInstance)
+                return *cached.buffer;
+        std::erase_if(tCommandBuffers, [](auto const& cached) { return cached.token.expired(); });
+        std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+        auto& buffer = *iCommandBuffers.emplace_back(std::make_unique<command_buffer>(*this));
+        tCommandBuffers.push_back(thread_command_buffer{ iInstance, iInstanceToken, &buffer });
+        return buffer;
+    }
+
     ecs_flags ecs::flags() const
     {
         return iFlags;
@@ -271,7 +446,7 @@ namespace neolib::ecs
     {
         auto entityId = next_entity_id();
         if ((flags() & ecs_flags::PopulateEntityInfo) == ecs_flags::PopulateEntityInfo)
-            component<entity_info>().populate(entityId, entity_info{ aArchetypeId, system<time>().world_time() });
+            component<entity_info>().populate(entityId, entity_info{ aArchetypeId, system<time>().world_time(), false });
         EntityCreated.trigger(entityId);
         return entityId;
     }
@@ -286,7 +461,7 @@ namespace neolib::ecs
     {
         if (iEntitiesToCreate.empty())
             return;
-        scoped_multi_lock<decltype(iComponentMutexes)> lock{ iComponentMutexes };
+        std::scoped_lock<neolib::i_lockable> lock{ component_mutexes() };
         while (!iEntitiesToCreate.empty())
         {
             auto next = iEntitiesToCreate.back();
@@ -299,7 +474,18 @@ namespace neolib::ecs
     {
         if (aNotify)
             EntityDestroyed.trigger(aEntityId);
-        scoped_multi_lock<decltype(iComponentMutexes)> lock{ iComponentMutexes };
+        std::scoped_lock<neolib::i_lockable> lock{ component_mutexes() };
+        if (chunked())
+        {
+            // drop the whole row at once rather than moving the entity table to table for each component
+            std::scoped_lock<neolib::recursive_spinlock> storageLock{ chunk_storage().mutex() };
+            if (chunk_storage().contains(aEntityId))
+            {
+                for (auto const& componentId : chunk_storage().owner(aEntityId)->signature())
+                    component(componentId).increment_record_version();
+                chunk_storage().remove(aEntityId, *this);
+            }
+        }
         for (auto& component : iComponents)
             if (component.second->has_entity_record(aEntityId))
                 component.second->destroy_entity_record(aEntityId);
@@ -317,7 +503,7 @@ namespace neolib::ecs
     {
         if (iEntitiesToDestroy.empty())
             return;
-        scoped_multi_lock<decltype(iComponentMutexes)> lock{ iComponentMutexes };
+        std::scoped_lock<neolib::i_lockable> lock{ component_mutexes() };
         while (!iEntitiesToDestroy.empty())
         {
             auto next = iEntitiesToDestroy.back();
@@ -326,9 +512,81 @@ namespace neolib::ecs
         }
     }
 
+    void ecs::commit_commands()
+    {
+        {
+            std::scoped_lock<neolib::recursive_spinlock> lock{ mutex() };
+            for (auto& buffer : iCommandBuffers)
+                iPendingCommands.take(*buffer);
+        }
+        if (iPendingCommands.empty())
+            return;
+
+        auto& creations = iPendingCommands.creations();
+        auto& destructions = iPendingCommands.destructions();
+        // an entity reserved by a command buffer can be destroyed before its creation is committed
+        std::erase_if(creations, [&](auto const& creation) { return !is_reserved(creation.entity); });
+        std::sort(creations.begin(), creations.end(), [](auto const& lhs, auto const& rhs) { return entity_index(lhs.entity) < entity_index(rhs.entity); });
+        for (auto const& creation : creations)
+            if (creation.archetypeToRegister != nullptr && !archetype_registered(*creation.archetypeToRegister))
+                register_archetype(*creation.archetypeToRegister);
+        bool const populateEntityInfo = (flags() & ecs_flags::PopulateEntityInfo) == ecs_flags::PopulateEntityInfo;
+        auto const worldTime = populateEntityInfo && !creations.empty() ? system<time>().world_time() : step_time{};
+        // instantiate everything up front as instantiating a component adds to the set of component mutexes
+        for (auto& commands : iPendingCommands.component_commands_by_id())
+            commands.second->prepare(*this);
+
+        std::scoped_lock<neolib::i_lockable> lock{ component_mutexes() };
+        for (auto const& creation : creations)
+            commit_entity_id(creation.entity);
+        if (!creations.empty())
+        {
+            if (chunked())
+            {
+                // place each new entity straight into its final table rather than moving it once per component
+                std::vector<const component_column_traits*> columns;
+                std::scoped_lock<neolib::recursive_spinlock> storageLock{ chunk_storage().mutex() };
+                for (auto const& creation : creations)
+                {
+                    columns.clear();
+                    if (populateEntityInfo)
+                        columns.push_back(&component<entity_info>().column_traits());
+                    for (uint32_t index = 0u; index < creation.componentCount; ++index)
+                        columns.push_back(&component(iPendingCommands.creation_components()[creation.firstComponent + index]).column_traits());
+                    chunk_storage().add(creation.entity, columns);
+                    for (auto column : columns)
+                        component(column->id).increment_record_version();
+                    if (populateEntityInfo)
+                        *static_cast<entity_info*>(chunk_storage().find(creation.entity, entity_info::meta::id())) = entity_info{ creation.archetype, worldTime, false };
+                }
+            }
+            else if (populateEntityInfo)
+            {
+                auto& entityInfos = component<entity_info>();
+                entityInfos.reserve(creations.size(), entity_index(creations.back().entity));
+                for (auto const& creation : creations)
+                    entityInfos.populate(creation.entity, entity_info{ creation.archetype, worldTime, false });
+            }
+        }
+        for (auto& commands : iPendingCommands.component_commands_by_id())
+            commands.second->apply(*this);
+        for (auto const& creation : creations)
+        {
+            archetype(creation.archetype).populate_default_components(*this, creation.entity);
+            EntityCreated.trigger(creation.entity);
+        }
+        std::sort(destructions.begin(), destructions.end(), [](auto const& lhs, auto const& rhs) { return lhs.entity < rhs.entity; });
+        destructions.erase(std::unique(destructions.begin(), destructions.end(), [](auto const& lhs, auto const& rhs) { return lhs.entity == rhs.entity; }), destructions.end());
+        for (auto const& destruction : destructions)
+            if (is_alive(destruction.entity))
+                destroy_entity(destruction.entity, destruction.notify);
+        iPendingCommands.clear();
+    }
+
     bool ecs::run_threaded(const system_id& aSystemId) const
     {
-        return (flags() & ecs_flags::NoThreads) != ecs_flags::NoThreads;
+        return (flags() & ecs_flags::NoThreads) != ecs_flags::NoThreads &&
+            (flags() & ecs_flags::ParallelSystems) != ecs_flags::ParallelSystems;
     }
 
     bool ecs::all_systems_paused() const
@@ -0,0 +1,273 @@
+// system_scheduler.cpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <utility>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/system_scheduler.hpp>
+
+namespace neolib::ecs
+{
+    system_scheduler::system_scheduler(i_ecs& aEcs) :
+        iEcs{ aEcs }, iRemaining{ 0u }, iFrameStarted{ false }, iFrameTime{ 0 }, iCriticalPathTime{ 0 }
+    {
+    }
+
+    system_scheduler::~system_scheduler()
+    {
+        if (iFrameStarted)
+        {
+            std::unique_lock<std::mutex> lock{ iFrameMutex };
+            iFrameDone.wait(lock, [&]() { return iRemaining == 0u; });
+        }
+    }
+
+    i_ecs& system_scheduler::ecs() const
+    {
+        return iEcs;
+    }
+
+    neolib::thread_pool& system_scheduler::thread_pool() const
+    {
+        return ecs().thread_pool();
+    }
+
+    void system_scheduler::run_frame()
+    {
+        start_frame();
+        finish_frame();
+    }
+
+    bool system_scheduler::start_frame()
+    {
+        if (frame_running())
+            return false;
+        if (iFrameStarted)
+            finish_frame();
+        if (update_declarations())
+            build_graph();
+        for (auto& node : iNodes)
+            node.pending = node.predecessors.size();
+
+        iFrameStart = std::chrono::high_resolution_clock::now();
+        iFrameEnd = iFrameStart;
+        iException = nullptr;
+        iFrameStarted = true;
+        iRemaining = iNodes.size();
+        for (std::size_t index = 0u; index < iNodes.size(); ++index)
+            if (iNodes[index].predecessors.empty())
+                dispatch(index);
+        return true;
+    }
+
+    bool system_scheduler::frame_running() const
+    {
+        return iRemaining != 0u;
+    }
+
+    void system_scheduler::finish_frame()
+    {
+        if (!iFrameStarted)
+            return;
+        {
+            std::unique_lock<std::mutex> lock{ iFrameMutex };
+            iFrameDone.wait(lock, [&]() { return iRemaining == 0u; });
+        }
+        iFrameStarted = false;
+        update_timings(iFrameStart, iFrameEnd);
+        if (iException)
+            std::rethrow_exception(std::exchange(iException, nullptr));
+    }
+
+    system_scheduler::timings_t system_scheduler::timings() const
+    {
+        std::scoped_lock<std::mutex> lock{ iTimingsMutex };
+        return iTimings;
+    }
+
+    std::chrono::microseconds system_scheduler::frame_time() const
+    {
+        std::scoped_lock<std::mutex> lock{ iTimingsMutex };
+        return iFrameTime;
+    }
+
+    std::chrono::microseconds system_scheduler::critical_path_time() const
+    {
+        std::scoped_lock<std::mutex> lock{ iTimingsMutex };
+        return iCriticalPathTime;
+    }
+
+    std::vector<system_id> system_scheduler::critical_path() const
+    {
+        std::scoped_lock<std::mutex> lock{ iTimingsMutex };
+        std::vector<system_id> result;
+        for (auto const& timing : iTimings)
+            if (timing.critical)
+                result.push_back(timing.id);
+        return result;
+    }
+
+    bool system_scheduler::conflict(const declaration& aFirst, const declaration& aSecond)
+    {
+        if (aFirst.components.empty() || aSecond.components.empty())
+            return true;
+        // both lists are in component id order
+        auto first = aFirst.components.begin();
+        auto second = aSecond.components.begin();
+        while (first != aFirst.components.end() && second != aSecond.components.end())
+        {
+            if (first->first < second->first)
+                ++first;
+            else if (second->first < first->first)
+                ++second;
+            else if (first->second || second->second)
+                return true;
+            else
+            {
+                ++first;
+                ++second;
+            }
+        }
+        return false;
+    }
+
+    // gathers the systems and their declared components into storage kept from the previous frame; returns true if
+    // they differ from the ones the graph was built from
+    bool system_scheduler::update_declarations()
+    {
+        iNextDeclarations.resize(ecs().systems().size());
+        auto next = iNextDeclarations.begin();
+        for (auto& system : ecs().systems())
+        {
+            next->system = &*system.second;
+            next->components.clear();
+            for (auto const& componentId : system.second->components())
+                next->components.emplace_back(componentId, system.second->writes(componentId));
+            ++next;
+        }
+        std::sort(iNextDeclarations.begin(), iNextDeclarations.end(), [](auto const& lhs, auto const& rhs) { return lhs.system->id() < rhs.system->id(); });
+        if (iNextDeclarations == iDeclarations)
+            return false;
+        std::swap(iNextDeclarations, iDeclarations);
+        return true;
+    }
+
+    void system_scheduler::build_graph()
+    {
+        iNodes = std::vector<node>(iDeclarations.size());
+        for (std::size_t later = 0u; later < iDeclarations.size(); ++later)
+        {
+            iNodes[later].system = iDeclarations[later].system;
+            for (std::size_t earlier = 0u; earlier < later; ++earlier)
+                if (conflict(iDeclarations[earlier], iDeclarations[later]))
+                {
+                    iNodes[earlier].successors.push_back(later);
+                    iNodes[later].predecessors.push_back(earlier);
+                }
+        }
+    }
+
+    void system_scheduler::dispatch(std::size_t aNode)
+    {
+        if (thread_pool().stopped())
+            execute(aNode);
+        else
+            thread_pool().submit([this, aNode]() { execute(aNode); });
+    }
+
+    void system_scheduler::execute(std::size_t aNode)
+    {
+        auto& node = iNodes[aNode];
+        node.start = std::chrono::high_resolution_clock::now();
+        try
+        {
+            if (node.system->can_apply())
+                node.system->apply();
+        }
+        catch (...)
+        {
+            std::scoped_lock<std::mutex> lock{ iFrameMutex };
+            if (!iException)
+                iException = std::current_exception();
+        }
+        node.end = std::chrono::high_resolution_clock::now();
+        for (auto successor : node.successors)
+            if (--iNodes[successor].pending == 0u)
+                dispatch(successor);
+        std::scoped_lock<std::mutex> lock{ iFrameMutex };
+        if (iRemaining == 1u)
+            iFrameEnd = std::chrono::high_resolution_clock::now();
+        if (--iRemaining == 0u)
+            iFrameDone.notify_one();
+    }
+
+    void system_scheduler::update_timings(std::chrono::high_resolution_clock::time_point aFrameStart, std::chrono::high_resolution_clock::time_point aFrameEnd)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        timings_t timings(iNodes.size());
+        std::vector<std::size_t> criticalPredecessor(iNodes.size(), iNodes.size());
+        std::size_t last = iNodes.size();
+        // nodes are already in topological order (edges only run from earlier to later systems)
+        for (std::size_t index = 0u; index < iNodes.size(); ++index)
+        {
+            auto const& node = iNodes[index];
+            auto& timing = timings[index];
+            timing.id = node.system->id();
+            timing.start = duration_cast<microseconds>(node.start - aFrameStart);
+            timing.duration = duration_cast<microseconds>(node.end - node.start);
+            timing.earliestFinish = timing.duration;
+            for (auto predecessor : node.predecessors)
+            {
+                timing.predecessors.push_back(iNodes[predecessor].system->id());
+                if (timings[predecessor].earliestFinish + timing.duration > timing.earliestFinish)
+                {
+                    timing.earliestFinish = timings[predecessor].earliestFinish + timing.duration;
+                    criticalPredecessor[index] = predecessor;
+                }
+            }
+            if (last == iNodes.size() || timing.earliestFinish > timings[last].earliestFinish)
+                last = index;
+        }
+        for (auto index = last; index != iNodes.size(); index = criticalPredecessor[index])
+            timings[index].critical = true;
+
+        std::scoped_lock<std::mutex> lock{ iTimingsMutex };
+        iTimings = std::move(timings);
+        iFrameTime = duration_cast<microseconds>(aFrameEnd - aFrameStart);
+        iCriticalPathTime = last != iNodes.size() ? iTimings[last].earliestFinish : microseconds{ 0 };
+    }
+}
@@ -44,6 +44,7 @@ namespace neolib::ecs
     time::time(ecs::i_ecs& aEcs) :
         system{ aEcs }
     {
+        declare_read_only<entity_life_span>();
         if (!ecs().shared_component_registered<clock>())
         {
             ecs().register_shared_component<clock>();
@@ -71,23 +72,15 @@ namespace neolib::ecs
 
         auto waitDuration = std::numeric_limits<i64>::max();
 
+        ecs().for_each<entity_life_span, entity_info>([&](entity_id aEntity, entity_life_span const& aLifeSpan, entity_info const& aInfo)
         {
-            scoped_component_lock<entity_info, entity_life_span> lock{ ecs() };
-            auto const& infos = ecs().component<entity_info>();
-            auto const& lifeSpans = ecs().component<entity_life_span>();
-
-            for (auto entity : lifeSpans.entities())
-            {
-                auto const& info = infos.entity_record(entity);
-                if (info.destroyed)
-                    continue;
-                auto const& lifeSpan = lifeSpans.entity_record(entity);
-                auto const age = world_time() - info.creationTime;
-                waitDuration = std::min(waitDuration, lifeSpan.lifeSpan - age);
-                if (age > lifeSpan.lifeSpan)
-                    ecs().async_destroy_entity(entity, false);
-            }
-        }
+            if (aInfo.destroyed)
+                return;
+            auto const age = world_time() - aInfo.creationTime;
+            waitDuration = std::min(waitDuration, aLifeSpan.lifeSpan - age);
+            if (age > aLifeSpan.lifeSpan)
+                ecs().async_destroy_entity(aEntity, false);
+        });
 
         if (have_thread() && get_thread().in())
             wait_for(std::max(1.0, from_step_time(waitDuration)));
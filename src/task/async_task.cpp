@@ -57,6 +57,9 @@ namespace neolib
     public:
         bool poll(bool aProcessEvents = true, std::size_t aMaximumPollCount = kDefaultPollCount) override;
         void* native_object() override;
+    public:
+        void wait(const std::optional<std::chrono::steady_clock::time_point>& aDeadline);
+        void wake();
         // attributes
     private:
         async_task& iTask;
@@ -94,9 +97,27 @@ namespace neolib
         return &iNativeIoService;
     }
 
+    void io_service::wait(const std::optional<std::chrono::steady_clock::time_point>& aDeadline)
+    {
+        // the work guard keeps run_one*() blocking until a handler (including a wake) is ready or the deadline passes; it
+        // only lives for the wait so that anyone running native_object() to completion still returns once it runs out of work
+        auto const workGuard = boost::asio::make_work_guard(iNativeIoService);
+        iNativeIoService.restart();
+        if (aDeadline)
+            iNativeIoService.run_one_until(*aDeadline);
+        else
+            iNativeIoService.run_one();
+    }
+
+    void io_service::wake()
+    {
+        boost::asio::post(iNativeIoService, []() {});
+    }
+
     timer_service::timer_service(async_task& aTask, bool aMultiThreaded) :
         iTask{ aTask },
-        iTaskDestroying{ aTask }
+        iTaskDestroying{ aTask },
+        iEpoch{ clock_type::now() }
     {
     }
 
@@ -112,32 +133,27 @@ namespace neolib
             if (aProcessEvents)
                 didSomeThisIteration = (iTask.pump_messages() || didSomeThisIteration);
 
-            typedef std::vector<std::pair<decltype(iObjects)::value_type, destroyed_flag>> work_list_t;
-            thread_local std::vector<std::unique_ptr<work_list_t>> workListStack;
-            thread_local std::size_t stack;
-            scoped_counter<std::size_t> stackCounter{ stack };
-            if (workListStack.size() < stack)
-                workListStack.push_back(std::make_unique<work_list_t>());
-            work_list_t& workList = *workListStack[stack - 1];
-
             std::unique_lock lock{ iMutex };
-            iObjects.erase(std::remove_if(iObjects.begin(), iObjects.end(), [](auto const& o) { return o == nullptr; }), iObjects.end());
-            std::transform(iObjects.begin(), iObjects.end(), std::back_inserter(workList), [](auto const& s) { return std::make_pair(s, destroyed_flag{ *s }); });
-            lock.unlock();
-            for (auto const& o : workList)
+            if (!iWheel.empty())
             {
-                if (!o.second.is_alive())
-                    continue;
-                auto& object = *o.first;
-                if (object.poll())
+                iWheel.advance(to_tick(clock_type::now(), false));
+                for (auto due = iWheel.due_count(); due > 0u; --due)
                 {
+                    auto* expired = iWheel.pop_due();
+                    if (expired == nullptr)
+                        break;
+                    auto& object = static_cast<timer_object&>(*expired);
+                    object.iExpiryTime = std::nullopt;
+                    ref_ptr<i_timer_object> objectRef{ object };
+                    lock.unlock();
+                    object.notify_subscribers();
+                    lock.lock();
                     didSomeThisIteration = true;
                     if (aMaximumPollCount != 0 && --iterationsLeft == 0)
                         break;
                 }
             }
-            lock.lock();
-            workList.clear();
+            lock.unlock();
             if (!didSomeThisIteration)
                 break;
             didSome = true;
@@ -154,30 +170,71 @@ namespace neolib
     {
         if (iTaskDestroying)
             throw task_destroying();
+        auto newObject = make_ref<timer_object>(*this);
         std::unique_lock lock{ iMutex };
-        iObjects.push_back(make_ref<timer_object>(*this));
-        return *iObjects.back();
+        return *iObjects.emplace(newObject.ptr(), newObject).first->second;
     }
 
     void timer_service::remove_timer_object(i_timer_object& aObject)
+    {
+        ref_ptr<i_timer_object> existingRef;
+        {
+            std::unique_lock lock{ iMutex };
+            auto existing = iObjects.find(&aObject);
+            if (existing != iObjects.end())
+            {
+                unschedule(static_cast<timer_object&>(aObject));
+                existingRef = std::move(existing->second);
+                iObjects.erase(existing);
+            }
+        }
+    }
+
+    std::optional<timer_service::clock_type::time_point> timer_service::next_deadline() const
     {
         std::unique_lock lock{ iMutex };
-        auto existing = std::find_if(iObjects.begin(), iObjects.end(), [&aObject](auto&& o) { return o == &aObject; });
-        if (existing != iObjects.end())
+        auto const next = iWheel.next_expiry();
+        if (!next)
+            return {};
+        return iEpoch + tick_duration{ *next };
+    }
+
+    void timer_service::schedule(timer_object& aObject, const clock_type::time_point& aDeadline)
+    {
         {
-            auto existingRef = std::move(*existing);
-            iObjects.erase(existing);
+            std::unique_lock lock{ iMutex };
+            aObject.iExpiryTime = aDeadline;
+            iWheel.insert(aObject, to_tick(aDeadline, true));
         }
+        iTask.wake();
+    }
+
+    void timer_service::unschedule(timer_object& aObject)
+    {
+        std::unique_lock lock{ iMutex };
+        aObject.iExpiryTime = std::nullopt;
+        iWheel.remove(aObject);
+    }
+
+    timer_wheel::tick_type timer_service::to_tick(const clock_type::time_point& aTimePoint, bool aRoundUp) const
+    {
+        if (aTimePoint <= iEpoch)
+            return 0u;
+        auto const elapsed = aTimePoint - iEpoch;
+        auto ticks = std::chrono::duration_cast<tick_duration>(elapsed);
+        if (aRoundUp && ticks < elapsed)
+            ++ticks;
+        return static_cast<timer_wheel::tick_type>(ticks.count());
     }
 
     async_task::async_task(const std::string& aName) :
-        task{ aName }, iThread{ nullptr }, iState{ async_task_state::Init }
+        task{ aName }, iThread{ nullptr }, iState{ async_task_state::Init }, iWakeRequested{ false }, iWaiting{ false }
     {
         Destroying.ignore_errors();
     }
 
     async_task::async_task(i_thread& aThread, const std::string& aName) :
-        task{ aName }, iThread{ &aThread }, iState{ async_task_state::Init }
+        task{ aName }, iThread{ &aThread }, iState{ async_task_state::Init }, iWakeRequested{ false }, iWaiting{ false }
     {
         Destroying.ignore_errors();
     }
@@ -221,7 +278,10 @@ namespace neolib
     i_async_service& async_task::io_service()
     {
         if (iIoService == nullptr)
+        {
+            std::scoped_lock lock{ iWakeMutex };
             iIoService = std::make_unique<neolib::io_service>(*this);
+        }
         return *iIoService;
     }
 
@@ -231,6 +291,8 @@ namespace neolib
             return false;
         bool didSome = false;
         didSome = (pump_messages() || didSome);
+        if (iEventPoll)
+            didSome = (iEventPoll() || didSome);
         if (iTimerService)
             didSome = (iTimerService->poll() || didSome);
         if (iIoService)
@@ -240,7 +302,7 @@ namespace neolib
             if (aYieldIfNoWork == yield_type::Yield)
                 thread::yield();
             else if (aYieldIfNoWork == yield_type::Sleep)
-                thread::sleep(std::chrono::milliseconds{ 1 });
+                wait_for_work();
         }
         return didSome;
     }
@@ -306,6 +368,7 @@ namespace neolib
     void async_task::halt()
     {
         iState = async_task_state::Halted;
+        wake();
     }
 
     bool async_task::finished() const noexcept
@@ -343,8 +406,32 @@ namespace neolib
         }
     }
 
+    void async_task::wake()
+    {
+        if (std::this_thread::get_id() == iRunThread.load(std::memory_order_relaxed))
+            return;
+        // the request and the waiting flag are both seq_cst so either we see the task waiting or it sees our request
+        iWakeRequested.store(true);
+        if (!iWaiting.load())
+            return;
+        neolib::io_service* ioService = nullptr;
+        {
+            std::scoped_lock lock{ iWakeMutex };
+            ioService = static_cast<neolib::io_service*>(iIoService.get());
+        }
+        if (ioService != nullptr)
+            ioService->wake();
+        iWakeCondition.notify_one();
+    }
+
+    void async_task::set_event_poll(std::function<bool()> aPoll)
+    {
+        iEventPoll = std::move(aPoll);
+    }
+
     void async_task::run(yield_type aYieldType)
     {
+        iRunThread = std::this_thread::get_id();
         iState = async_task_state::Running;
         while (!finished() && !cancelled())
             do_work(aYieldType);
@@ -357,6 +444,13 @@ namespace neolib
         base_type::cancel();
         if (!running())
             iState = async_task_state::Finished;
+        try
+        {
+            wake();
+        }
+        catch (...)
+        {
+        }
     }
 
     void async_task::idle()
@@ -364,4 +458,35 @@ namespace neolib
         if (have_message_queue())
             message_queue().idle();
     }
+
+    void async_task::wait_for_work()
+    {
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        if (iTimerService)
+            deadline = iTimerService->next_deadline();
+        if (have_message_queue())
+        {
+            // a native message queue can't be waited on together with our wake condition so keep polling it
+            auto const messagePoll = std::chrono::steady_clock::now() + std::chrono::milliseconds{ 1 };
+            deadline = deadline ? std::min(*deadline, messagePoll) : messagePoll;
+        }
+        iWaiting = true;
+        std::unique_lock lock{ iWakeMutex };
+        auto const woken = [this]() { return iWakeRequested || halted() || finished() || cancelled(); };
+        if (iIoService)
+        {
+            if (!woken())
+            {
+                lock.unlock();
+                static_cast<neolib::io_service&>(*iIoService).wait(deadline);
+                lock.lock();
+            }
+        }
+        else if (deadline)
+            iWakeCondition.wait_until(lock, *deadline, woken);
+        else
+            iWakeCondition.wait(lock, woken);
+        iWaiting = false;
+        iWakeRequested = false;
+    }
 } // namespace neolib
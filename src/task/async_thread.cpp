@@ -54,6 +54,9 @@ namespace neolib
             iEventQueue->queue.terminate();
         iTask.wait();
         cancel();
+        // the task may outlive us (e.g. if declared before us) so it must not try to abort this thread when it is destroyed
+        if (iTask.joined() && &iTask.thread() == this)
+            iTask.detach();
     }
 
     void async_thread::exec_preamble()
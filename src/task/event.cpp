@@ -36,7 +36,6 @@
 #include <neolib/neolib.hpp>
 #include <neolib/core/scoped.hpp>
 #include <neolib/task/i_async_task.hpp>
-#include <neolib/task/timer.hpp>
 #include <neolib/task/event.hpp>
 
 namespace neolib
@@ -83,31 +82,21 @@ namespace neolib
 
     async_event_queue::async_event_queue(i_async_task& aTask) :
         iTask{ aTask },
-        iTimer
-        {
-            new callback_timer{
-                aTask,
-                [this](neolib::callback_timer& aTimer)
-                {
-                    if (terminated())
-                        return;
-                    publish_events();
-                    if (!iEvents.empty() && !aTimer.waiting())
-                        aTimer.again();
-                }, std::chrono::milliseconds{1}, false}
-        },
         iTerminated { false },
         iTaskDestroyed{ aTask },
         iPublishNestingLevel{ 0u },
         iNextTransaction{ 0ull }
     {
         sQueueList.add(*this);
+        iTask.set_event_poll([this]() { return poll(); });
     }
 
     async_event_queue::~async_event_queue()
     {
         sQueueList.remove(*this);
         terminate();
+        if (iTaskDestroyed.is_alive())
+            iTask.set_event_poll({});
     }
 
     async_event_queue& async_event_queue::get_instance(i_async_task* aTask)
@@ -132,74 +121,135 @@ namespace neolib
         return publish_events();
     }
 
-    async_event_queue::transaction async_event_queue::enqueue(callback_ptr aCallback, bool aStatelessHandler, const optional_transaction& aTransaction)
+    async_event_queue::transaction async_event_queue::enqueue(callback_ptr aCallback, const optional_transaction& aTransaction)
     {
-        if (aStatelessHandler)
-        {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-            for (auto& e : iEvents)
-            {
-                if (!e.callback->valid())
-                    continue;
-                if (*e.callback == *aCallback)
-                    return {};
-            }
-        }
         return add(std::move(aCallback), aTransaction);
     }
 
     void async_event_queue::terminate()
     {
-        std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-        if (!iTerminated)
-        {
-            iTerminated = true;
-            iTimer = nullptr;
-            iEvents.clear();
-        }
+        std::scoped_lock<switchable_mutex> lock{ mutex() };
+        iTerminated = true;
+        discard_pending();
     }
 
     class event_filter_registry : public i_event_filter_registry
     {
+    private:
+        struct filter_call
+        {
+            const i_event* event;
+            i_event_filter* filter;
+            std::thread::id thread;
+        };
     public:
         void install_event_filter(i_event_filter& aFilter, const i_event& aEvent) override
         {
+            std::scoped_lock<switchable_mutex> eventLock{ event_mutex(aEvent) };
             std::scoped_lock<switchable_mutex> lock{ event_mutex() };
             aEvent.filter_added();
             iFilters.emplace(&aEvent, &aFilter);
         }
         void uninstall_event_filter(i_event_filter& aFilter, const i_event& aEvent) override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-            aEvent.filter_removed();
-            for (auto f = iFilters.equal_range(&aEvent).first; f != iFilters.equal_range(&aEvent).second; ++f)
-                if (f->second == &aFilter)
-                {
-                    iFilters.erase(f);
-                    return;
-                }
+            {
+                std::scoped_lock<switchable_mutex> eventLock{ event_mutex(aEvent) };
+                std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+                for (auto f = iFilters.equal_range(&aEvent).first; f != iFilters.equal_range(&aEvent).second; ++f)
+                    if (f->second == &aFilter)
+                    {
+                        aEvent.filter_removed();
+                        iFilters.erase(f);
+                        break;
+                    }
+            }
+            wait_for_calls(aEvent, &aFilter);
         }
         void uninstall_event_filter(const i_event& aEvent) override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-            aEvent.filters_removed();
-            iFilters.erase(iFilters.equal_range(&aEvent).first, iFilters.equal_range(&aEvent).second);
+            {
+                std::scoped_lock<switchable_mutex> eventLock{ event_mutex(aEvent) };
+                std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+                aEvent.filters_removed();
+                iFilters.erase(iFilters.equal_range(&aEvent).first, iFilters.equal_range(&aEvent).second);
+            }
+            wait_for_calls(aEvent, nullptr);
         }
     public:
         void pre_filter_event(const i_event& aEvent) const override
         {
-            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-            for (auto f = iFilters.equal_range(&aEvent).first; f != iFilters.equal_range(&aEvent).second; ++f)
-                f->second->pre_filter_event(*f->first);
+            call_filters(aEvent, &i_event_filter::pre_filter_event);
         }
         void filter_event(const i_event& aEvent) const override
+        {
+            call_filters(aEvent, &i_event_filter::filter_event);
+        }
+    private:
+        // filters are called, like handlers, with no event system mutex held: a filter may trigger or accept other events
+        // and event stripes have no order with respect to each other; a filter is only called whilst it is installed and 
+        // uninstalling it waits for its calls in progress on other threads to return
+        void call_filters(const i_event& aEvent, void (i_event_filter::*aMethod)(const i_event&)) const
+        {
+            for (auto f : filters(aEvent))
+            {
+                {
+                    std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+                    if (!installed(aEvent, *f))
+                        continue;
+                    iCalls.push_back(filter_call{ &aEvent, f, std::this_thread::get_id() });
+                }
+                try
+                {
+                    (f->*aMethod)(aEvent);
+                }
+                catch (...)
+                {
+                    call_returned(aEvent, *f);
+                    throw;
+                }
+                call_returned(aEvent, *f);
+            }
+        }
+        void call_returned(const i_event& aEvent, i_event_filter& aFilter) const
         {
             std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            auto const self = std::this_thread::get_id();
+            iCalls.erase(std::find_if(iCalls.begin(), iCalls.end(), [&](filter_call const& aCall)
+                { return aCall.event == &aEvent && aCall.filter == &aFilter && aCall.thread == self; }));
+        }
+        std::vector<i_event_filter*> filters(const i_event& aEvent) const
+        {
+            std::scoped_lock<switchable_mutex> eventLock{ event_mutex(aEvent) };
+            std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+            std::vector<i_event_filter*> result;
             for (auto f = iFilters.equal_range(&aEvent).first; f != iFilters.equal_range(&aEvent).second; ++f)
-                f->second->filter_event(*f->first);
+                result.push_back(f->second);
+            return result;
+        }
+        bool installed(const i_event& aEvent, i_event_filter& aFilter) const
+        {
+            for (auto f = iFilters.equal_range(&aEvent).first; f != iFilters.equal_range(&aEvent).second; ++f)
+                if (f->second == &aFilter)
+                    return true;
+            return false;
+        }
+        void wait_for_calls(const i_event& aEvent, i_event_filter const* aFilter) const
+        {
+            auto const self = std::this_thread::get_id();
+            for (;;)
+            {
+                {
+                    std::scoped_lock<switchable_mutex> lock{ event_mutex() };
+                    if (std::none_of(iCalls.begin(), iCalls.end(), [&](filter_call const& aCall)
+                        { return aCall.event == &aEvent && (aFilter == nullptr || aCall.filter == aFilter) && aCall.thread != self; }))
+                        return;
+                }
+                std::this_thread::yield();
+            }
         }
     private:
         std::unordered_multimap<const i_event*, i_event_filter*> iFilters;
+        mutable std::vector<filter_call> iCalls;
     };
 
     i_event_filter_registry& async_event_queue::filter_registry()
@@ -221,8 +271,8 @@ namespace neolib
     {
 #if !defined(NDEBUG) || defined(DEBUG_EVENTS)
         iDebug = aDebug;
-        if (iTimer)
-            iTimer->set_debug(aDebug);
+#else
+        (void)aDebug;
 #endif
     }
 
@@ -238,36 +288,155 @@ namespace neolib
 
     async_event_queue::transaction async_event_queue::add(callback_ptr aCallback, const optional_transaction& aTransaction)
     {
-        std::scoped_lock<switchable_mutex> lock{ event_mutex() };
         if (terminated())
+        {
+            aCallback->unqueued();
             return {};
-        iEvents.push_back(event_list_entry{ aTransaction == std::nullopt ? ++iNextTransaction : *aTransaction, aCallback->event(), std::move(aCallback) });
-        if (iTimer && !iTimer->waiting())
-            iTimer->again();
-        return iEvents.back().transaction;
+        }
+        auto const transaction = aTransaction == std::nullopt ? ++iNextTransaction : *aTransaction;
+        auto& newEvent = allocate_pending();
+        newEvent.entry.emplace(event_list_entry{ transaction, aCallback->event(), std::move(aCallback) });
+        // only the first event of a batch needs to wake the consumer; the rest are picked up by the same poll
+        // a task that is being destroyed must not be woken: it may be mid-destruction (possibly on this very thread)
+        if (iPending.push(newEvent) && iTaskDestroyed.is_alive())
+            iTask.wake();
+        return transaction;
     }
 
     void async_event_queue::remove(const i_event& aEvent)
     {
-        std::scoped_lock<switchable_mutex> lock{ event_mutex() };
-        for (auto e = iEvents.begin(); e != iEvents.end();)
+        std::scoped_lock<switchable_mutex> lock{ mutex() };
+        iPending.for_each([&](pending_event& aPending)
+        {
+            auto& callback = aPending.entry->callback;
+            if (callback == nullptr || &callback->event() != &aEvent)
+                return;
+            callback->unqueued();
+            callback = nullptr;
+        });
+    }
+
+    void async_event_queue::drain(event_list_t& aEvents)
+    {
+        pending_event* pending;
+        {
+            // excludes remove() walking the nodes while they are recycled
+            std::scoped_lock<switchable_mutex> lock{ mutex() };
+            pending = iPending.pop_all();
+        }
+        if (pending == nullptr)
+            return;
+        auto last = pending;
+        std::size_t count = 0u;
+        for (auto p = pending; p != nullptr; p = static_cast<pending_event*>(p->next))
         {
-            if (e->callback != nullptr && &e->callback->event() == &aEvent)
-                e = iEvents.erase(e);
-            else
-                ++e;
+            if (p->entry->callback != nullptr)
+                p->entry->callback->unqueued();
+            aEvents.push_back(std::move(*p->entry));
+            p->entry = std::nullopt;
+            last = p;
+            ++count;
         }
+        recycle_pending(*pending, *last, count);
     }
 
-    bool async_event_queue::has(const i_event& aEvent) const
+    // Pending event nodes are recycled: producers take the whole shared list in one exchange (so there is no ABA) and
+    // keep it in a thread local cache; the consumer returns each drained batch with one CAS. The number of idle nodes 
+    // (shared list and thread local caches together) is bounded so that a burst of events does not pin its nodes forever.
+    async_event_queue::pending_event& async_event_queue::allocate_pending()
     {
-        return std::find_if(iEvents.begin(), iEvents.end(), [&aEvent](auto const& e) { return &e.callback->event() == &aEvent; }) != iEvents.end();
+        struct cache
+        {
+            intrusive_mpsc_node* head = nullptr;
+            ~cache()
+            {
+                idle_pending().fetch_sub(free_pending(head), std::memory_order_relaxed);
+            }
+        };
+        thread_local cache tCache;
+        if (tCache.head == nullptr)
+            tCache.head = recycled_pending().exchange(nullptr, std::memory_order_acquire);
+        if (tCache.head == nullptr)
+            return *new pending_event{};
+        idle_pending().fetch_sub(1u, std::memory_order_relaxed);
+        auto node = static_cast<pending_event*>(tCache.head);
+        tCache.head = node->next;
+        node->next = nullptr;
+        return *node;
+    }
+
+    void async_event_queue::recycle_pending(pending_event& aFirst, pending_event& aLast, std::size_t aCount)
+    {
+        auto& idle = idle_pending();
+        if (idle.load(std::memory_order_relaxed) + aCount > kMaxIdlePending)
+        {
+            aLast.next = nullptr;
+            free_pending(&aFirst);
+            return;
+        }
+        idle.fetch_add(aCount, std::memory_order_relaxed);
+        auto& recycled = recycled_pending();
+        auto head = recycled.load(std::memory_order_relaxed);
+        do
+        {
+            aLast.next = head;
+        } while (!recycled.compare_exchange_weak(head, &aFirst, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::atomic<intrusive_mpsc_node*>& async_event_queue::recycled_pending()
+    {
+        struct list
+        {
+            std::atomic<intrusive_mpsc_node*> head = nullptr;
+            ~list()
+            {
+                free_pending(head.exchange(nullptr));
+            }
+        };
+        static list sRecycled;
+        return sRecycled.head;
+    }
+
+    std::atomic<std::size_t>& async_event_queue::idle_pending()
+    {
+        static std::atomic<std::size_t> sIdle = 0u;
+        return sIdle;
+    }
+
+    std::size_t async_event_queue::free_pending(intrusive_mpsc_node* aList) noexcept
+    {
+        std::size_t freed = 0u;
+        while (aList != nullptr)
+        {
+            auto next = aList->next;
+            delete static_cast<pending_event*>(aList);
+            aList = next;
+            ++freed;
+        }
+        return freed;
+    }
+
+    void async_event_queue::discard_pending()
+    {
+        event_list_t discarded;
+        drain(discarded);
+    }
+
+    switchable_mutex& async_event_queue::mutex() const
+    {
+        return event_mutex_pool::instance().queue_stripe(this);
+    }
+
+    bool async_event_queue::poll()
+    {
+        if (terminated() || iPending.empty())
+            return false;
+        return publish_events();
     }
 
     bool async_event_queue::publish_events()
     {
         bool didSome = false;
-        std::optional<std::scoped_lock<switchable_mutex>> lock{ event_mutex() };
         scoped_counter<std::atomic<uint32_t>> sc{ iPublishNestingLevel };
         if (iPublishNestingLevel > iPublishCache.size())
         {
@@ -276,13 +445,30 @@ namespace neolib
         }
         auto& currentContext = *iPublishCache[iPublishNestingLevel - 1u];
         currentContext.clear();
-        currentContext.swap(iEvents);
+        drain(currentContext);
         optional_transaction currentTransaction;
+        std::optional<std::scoped_lock<switchable_mutex>> lock;
         for (auto e = currentContext.begin(); !terminated() && e != currentContext.end(); ++e)
         {
             lock.reset();
-            lock.emplace(event_mutex());
-            if (e->destroyed || e->callback == nullptr)
+            if (e->callback == nullptr)
+                continue;
+            // the event may already be destroyed so only its address is used (to select its mutex) until the destroyed flag is checked
+            auto& eventMutex = event_mutex(e->callback->event());
+            auto const relock = [&]()
+            {
+                while (!eventMutex.try_lock())
+                {
+                    if (terminated())
+                        return false;
+                    std::this_thread::sleep_for(std::chrono::microseconds{ 0 });
+                }
+                lock.emplace(eventMutex);
+                eventMutex.unlock();
+                return true;
+            };
+            lock.emplace(eventMutex);
+            if (e->destroyed)
                 continue;
             auto const& ec = *e->callback;
             if (!ec.valid())
@@ -295,20 +481,24 @@ namespace neolib
             if (!ec.event().accepted())
             {
                 if (ec.event().filtered())
+                {
+                    // filters, like handlers, are called without the event's mutex held
+                    lock.reset();
                     filter_registry().filter_event(ec.event());
+                    if (!relock())
+                        return didSome;
+                    if (e->destroyed)
+                        continue;
+                }
                 if (!ec.event().accepted())
                 {
                     didSome = true;
                     lock.reset();
                     ec.call();
-                    while (!event_mutex().try_lock())
-                    {
-                        if (terminated())
-                            return didSome;
-                        std::this_thread::sleep_for(std::chrono::microseconds{ 0 });
-                    }
-                    lock.emplace(event_mutex());
-                    event_mutex().unlock();
+                    if (!relock())
+                        return didSome;
+                    if (e->destroyed)
+                        continue;
                 }
             }
             if (std::next(e) == currentContext.end() || std::next(e)->transaction != *currentTransaction)
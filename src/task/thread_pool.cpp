@@ -34,30 +34,48 @@
 */
 
 #include <neolib/neolib.hpp>
+#include <algorithm>
 #include <condition_variable>
+#include <new>
 #include <neolib/core/scoped.hpp>
 #include <neolib/core/lifetime.hpp>
 #include <neolib/task/thread.hpp>
 #include <neolib/task/thread_pool.hpp>
+#include <neolib/task/work_stealing_deque.hpp>
 
 namespace neolib
 {
+    namespace
+    {
+        // a queued pooled task holds a reference on behalf of the pool which must be given back if the task will never run
+        void abandon(i_task& aTask)
+        {
+            if (auto pooledTask = dynamic_cast<pooled_task*>(&aTask))
+                pooledTask->abandon();
+        }
+    }
+
     class thread_pool_thread : public thread
     {
     public:
         typedef std::shared_ptr<i_task> task_pointer;
         typedef std::pair<task_pointer, int32_t> task_queue_entry;
-        typedef std::deque<task_queue_entry> task_queue;
+        // kept in ascending priority order so the next task is at the back; unlike a deque a vector keeps its capacity so
+        // queueing a (non-owning) task does not allocate once the queue has grown to its working size
+        typedef std::vector<task_queue_entry> task_queue;
+        static constexpr std::size_t kInitialQueueCapacity = 64;
     public:
         struct no_active_task : std::logic_error { no_active_task() : std::logic_error("neolib::thread_pool_thread::no_active_task") {} };
         struct already_active : std::logic_error { already_active() : std::logic_error("neolib::thread_pool_thread::already_active") {} };
     public:
         thread_pool_thread(thread_pool& aThreadPool) : thread{ "neolib::thread_pool_thread" }, iThreadPool{ aThreadPool }, iPoolMutex{ aThreadPool.mutex() }, iStopped{ false }
         {
+            iWaitingTasks.reserve(kInitialQueueCapacity);
             start();
         }
         ~thread_pool_thread()
         {
+            discard_tasks();
         }
     public:
         virtual void exec(yield_type aYieldType = yield_type::NoYield)
@@ -71,6 +89,8 @@ namespace neolib
                     return;
                 if (!iActiveTask->cancelled())
                     iActiveTask->run(aYieldType);
+                else
+                    abandon(*iActiveTask);
                 std::scoped_lock<std::recursive_mutex> lk2(iPoolMutex);
                 release();
                 next_task();
@@ -88,27 +108,32 @@ namespace neolib
             std::scoped_lock<std::mutex> lk2(iCondVarMutex);
             return iActiveTask == nullptr && iWaitingTasks.empty();
         }
-        void add(task_pointer aTask, int32_t aPriority)
+        bool add(task_pointer aTask, int32_t aPriority)
         {
             std::scoped_lock<std::recursive_mutex> lk(iPoolMutex);
-            auto where = std::upper_bound(iWaitingTasks.begin(), iWaitingTasks.end(), task_queue_entry{ task_pointer{}, aPriority },
+            if (iStopped)
+                return false;
+            // equal priority tasks run in FIFO order so a new task goes in front of (i.e. after) those already queued
+            auto where = std::lower_bound(iWaitingTasks.begin(), iWaitingTasks.end(), task_queue_entry{ task_pointer{}, aPriority },
                 [](const task_queue_entry& aLeft, const task_queue_entry& aRight)
             {
-                return aLeft.second > aRight.second;
+                return aLeft.second < aRight.second;
             });
-            iWaitingTasks.emplace(where, aTask, aPriority);
+            iWaitingTasks.emplace(where, std::move(aTask), aPriority);
             if (!active())
                 next_task();
+            return true;
         }
         bool steal_work(thread_pool_thread& aIdleThread)
         {
             std::unique_lock<std::recursive_mutex> lk(iPoolMutex);
             if (!iWaitingTasks.empty())
             {
-                auto newTask = iWaitingTasks.front();
-                iWaitingTasks.pop_front();
-                aIdleThread.add(newTask.first, newTask.second);
-                return true;
+                auto newTask = std::move(iWaitingTasks.back());
+                iWaitingTasks.pop_back();
+                if (aIdleThread.add(newTask.first, newTask.second))
+                    return true;
+                iWaitingTasks.push_back(std::move(newTask));
             }
             return false;
         }
@@ -122,9 +147,24 @@ namespace neolib
                 }
                 iConditionVariable.notify_one();
                 wait();
+                discard_tasks();
             }
         }
     private:
+        void discard_tasks()
+        {
+            std::scoped_lock<std::recursive_mutex> lk(iPoolMutex);
+            task_pointer unstartedTask;
+            {
+                std::scoped_lock<std::mutex> lk2(iCondVarMutex);
+                unstartedTask = std::move(iActiveTask);
+            }
+            if (unstartedTask != nullptr)
+                abandon(*unstartedTask);
+            for (auto& waitingTask : iWaitingTasks)
+                abandon(*waitingTask.first);
+            iWaitingTasks.clear();
+        }
         void next_task()
         {
             std::unique_lock<std::recursive_mutex> lk(iPoolMutex);
@@ -136,8 +176,8 @@ namespace neolib
             {
                 {
                     std::scoped_lock<std::mutex> lk2(iCondVarMutex);
-                    iActiveTask = iWaitingTasks.front().first;
-                    iWaitingTasks.pop_front();
+                    iActiveTask = std::move(iWaitingTasks.back().first);
+                    iWaitingTasks.pop_back();
                 }
                 iConditionVariable.notify_one();
                 iThreadPool.thread_gone_busy();
@@ -166,24 +206,212 @@ namespace neolib
         std::atomic<bool> iStopped;
     };
 
-    thread_pool::thread_pool() : iIdle{ true }, iStopped { false }, iMaxThreads{ 0 }
+    class work_stealing_thread_pool_thread : public thread
+    {
+    public:
+        typedef thread_pool::task_pointer task_pointer;
+        typedef thread_pool::queued_task queued_task;
+        typedef work_stealing_deque<queued_task> task_deque;
+    public:
+        work_stealing_thread_pool_thread(thread_pool& aThreadPool, std::size_t aIndex) : 
+            thread{ "neolib::work_stealing_thread_pool_thread" }, iThreadPool{ aThreadPool }, iIndex{ aIndex }, iActive{ false }, iStopped{ false }
+        {
+            start();
+        }
+        ~work_stealing_thread_pool_thread()
+        {
+            discard_tasks();
+        }
+    public:
+        static work_stealing_thread_pool_thread*& current()
+        {
+            thread_local work_stealing_thread_pool_thread* tCurrent = nullptr;
+            return tCurrent;
+        }
+        virtual void exec(yield_type aYieldType = yield_type::NoYield)
+        {
+            current() = this;
+            while (!iStopped)
+            {
+                auto task = iThreadPool.dequeue(*this);
+                if (!task)
+                {
+                    iThreadPool.wait_for_work(iStopped);
+                    continue;
+                }
+                iActive.store(true, std::memory_order_relaxed);
+                if (!(*task).cancelled())
+                    (*task).run(aYieldType);
+                else
+                    abandon(*task);
+                task.release();
+                iActive.store(false, std::memory_order_relaxed);
+                iThreadPool.task_completed();
+            }
+        }
+    public:
+        thread_pool& pool() const
+        {
+            return iThreadPool;
+        }
+        std::size_t index() const
+        {
+            return iIndex;
+        }
+        bool active() const
+        {
+            return iActive.load(std::memory_order_relaxed);
+        }
+        // owner thread only
+        void push(std::size_t aBand, queued_task aTask)
+        {
+            iDeques[aBand].push(aTask);
+        }
+        // owner thread only; takes the newest task
+        queued_task pop(std::size_t aBand)
+        {
+            return iDeques[aBand].pop().value_or(queued_task{ nullptr });
+        }
+        // any thread; takes the oldest task
+        queued_task steal(std::size_t aBand)
+        {
+            return iDeques[aBand].steal().value_or(queued_task{ nullptr });
+        }
+        void stop()
+        {
+            if (!iStopped)
+            {
+                {
+                    std::scoped_lock<std::mutex> lk(iThreadPool.iSleepMutex);
+                    iStopped = true;
+                }
+                iThreadPool.iSleepConditionVariable.notify_all();
+                wait();
+                discard_tasks();
+            }
+        }
+    private:
+        // only once the owning thread has finished
+        void discard_tasks()
+        {
+            for (std::size_t band = 0; band < thread_pool::kPriorityBands; ++band)
+                while (!iDeques[band].empty())
+                    if (auto task = steal(band))
+                        iThreadPool.discard(task, band);
+        }
+    private:
+        thread_pool& iThreadPool;
+        std::size_t const iIndex;
+        task_deque iDeques[thread_pool::kPriorityBands];
+        std::atomic<bool> iActive;
+        std::atomic<bool> iStopped;
+    };
+
+    thread_pool::queued_task::queued_task(task_pointer aTask) :
+        iValue{ 0u }
+    {
+        if (aTask == nullptr)
+            return;
+        if (aTask.use_count() == 0)
+            iValue = reinterpret_cast<std::uintptr_t>(aTask.get()) | 1u; // non-owning: no need to allocate a holder
+        else
+            iValue = reinterpret_cast<std::uintptr_t>(new task_pointer{ std::move(aTask) });
+    }
+
+    thread_pool::queued_task::operator bool() const
+    {
+        return iValue != 0u;
+    }
+
+    i_task& thread_pool::queued_task::operator*() const
+    {
+        if ((iValue & 1u) != 0u)
+            return *reinterpret_cast<i_task*>(iValue & ~static_cast<std::uintptr_t>(1u));
+        return **reinterpret_cast<task_pointer*>(iValue);
+    }
+
+    void thread_pool::queued_task::release()
+    {
+        if (iValue != 0u && (iValue & 1u) == 0u)
+            delete reinterpret_cast<task_pointer*>(iValue);
+        iValue = 0u;
+    }
+
+    void thread_pool::queued_task::discard()
+    {
+        if (iValue != 0u)
+            abandon(**this);
+        release();
+    }
+
+    thread_pool::thread_pool(thread_pool_scheduling aScheduling) : 
+        iScheduling{ aScheduling }, 
+        iIdle{ true }, 
+        iStopped { false }, 
+        iMaxThreads{ 0 }, 
+        iWorkStealingThreads{ nullptr }, 
+        iPendingTasks{ 0 }, 
+        iSleepingThreads{ 0 }, 
+        iWakeups{ 0 }
     {
+        for (auto& queued : iQueuedTasks)
+            queued = 0;
+        if (iScheduling == thread_pool_scheduling::WorkStealing)
+        {
+            for (auto& queue : iInjectionQueues)
+                queue = std::make_unique<boost::lockfree::queue<queued_task>>(1024);
+            iWorkStealingThreadLists.push_back(std::make_unique<work_stealing_thread_list>());
+            iWorkStealingThreads.store(iWorkStealingThreadLists.back().get());
+        }
         reserve(std::thread::hardware_concurrency());
     }
 
     thread_pool::~thread_pool()
     {
         wait();
-        for (auto& t : iThreads)
-            static_cast<thread_pool_thread&>(*t).stop();
+        if (iScheduling == thread_pool_scheduling::SharedQueueLock)
+            for (auto& t : iThreads)
+                static_cast<thread_pool_thread&>(*t).stop();
+        else
+        {
+            for (auto& t : iThreads)
+                static_cast<work_stealing_thread_pool_thread&>(*t).stop();
+            discard_injected_tasks();
+        }
+    }
+
+    thread_pool_scheduling thread_pool::scheduling() const
+    {
+        return iScheduling;
+    }
+
+    std::size_t thread_pool::priority_band(int32_t aPriority)
+    {
+        // band 0 (priority kMaxBandedPriority and above) is serviced first
+        return static_cast<std::size_t>(kMaxBandedPriority - std::clamp(aPriority, -kMaxBandedPriority, kMaxBandedPriority));
     }
 
     void thread_pool::reserve(std::size_t aMaxThreads)
     {
         std::scoped_lock<std::recursive_mutex> lk(iMutex);
         iMaxThreads = aMaxThreads;
-        while (iThreads.size() < iMaxThreads)
-            iThreads.push_back(std::make_unique<thread_pool_thread>(*this));
+        if (iScheduling == thread_pool_scheduling::SharedQueueLock)
+        {
+            while (iThreads.size() < iMaxThreads)
+                iThreads.push_back(std::make_unique<thread_pool_thread>(*this));
+        }
+        else if (iThreads.size() < iMaxThreads)
+        {
+            // thieves iterate the published thread list without locking so publish a new list rather than modifying the existing one
+            auto newThreads = std::make_unique<work_stealing_thread_list>(*iWorkStealingThreads.load());
+            while (iThreads.size() < iMaxThreads)
+            {
+                iThreads.push_back(std::make_unique<work_stealing_thread_pool_thread>(*this, iThreads.size()));
+                newThreads->push_back(&static_cast<work_stealing_thread_pool_thread&>(*iThreads.back()));
+            }
+            iWorkStealingThreadLists.push_back(std::move(newThreads));
+            iWorkStealingThreads.store(iWorkStealingThreadLists.back().get(), std::memory_order_release);
+        }
     }
 
     std::size_t thread_pool::active_threads() const
@@ -191,7 +419,8 @@ namespace neolib
         std::scoped_lock<std::recursive_mutex> lk(iMutex);
         std::size_t result = 0;
         for (auto& t : iThreads)
-            if (static_cast<thread_pool_thread&>(*t).active())
+            if (iScheduling == thread_pool_scheduling::SharedQueueLock ? 
+                static_cast<thread_pool_thread&>(*t).active() : static_cast<work_stealing_thread_pool_thread&>(*t).active())
                 ++result;
         return result;
     }
@@ -207,7 +436,7 @@ namespace neolib
         std::scoped_lock<std::recursive_mutex> lk(iMutex);
         std::size_t result = 0;
         for (auto& t : iThreads)
-            if (!static_cast<thread_pool_thread&>(*t).finished())
+            if (!t->finished())
                 ++result;
         return result;
     }
@@ -224,21 +453,7 @@ namespace neolib
 
     void thread_pool::start(task_pointer aTask, int32_t aPriority)
     {
-        if (stopped())
-            return;
-        std::scoped_lock<std::recursive_mutex> lk(iMutex);
-        if (iThreads.empty())
-            throw no_threads();
-        for (auto& t : iThreads)
-        {
-            auto& tpt = static_cast<thread_pool_thread&>(*t);
-            if (!tpt.active())
-            {
-                tpt.add(aTask, aPriority);
-                return;
-            }
-        }
-        static_cast<thread_pool_thread&>(*iThreads[0]).add(aTask, aPriority);
+        start_task(std::move(aTask), aPriority);
     }
 
     bool thread_pool::try_start(i_task& aTask, int32_t aPriority)
@@ -272,11 +487,15 @@ namespace neolib
 
     bool thread_pool::idle() const
     {
+        if (iScheduling == thread_pool_scheduling::WorkStealing)
+            return iPendingTasks.load(std::memory_order_acquire) == 0;
         return iIdle;
     }
 
     void thread_pool::update_idle()
     {
+        if (iScheduling == thread_pool_scheduling::WorkStealing)
+            return;
         std::scoped_lock<std::recursive_mutex> lk1(iMutex);
         std::optional<std::unique_lock<std::mutex>> lk2;
         for (auto& t : iThreads)
@@ -310,22 +529,48 @@ namespace neolib
         return iStopped;
     }
 
+    bool thread_pool::in() const
+    {
+        if (iScheduling == thread_pool_scheduling::WorkStealing)
+        {
+            auto* current = work_stealing_thread_pool_thread::current();
+            return current != nullptr && &current->pool() == this;
+        }
+        std::scoped_lock<std::recursive_mutex> lk(iMutex);
+        for (auto const& t : iThreads)
+            if (static_cast<thread&>(*t).in())
+                return true;
+        return false;
+    }
+
     void thread_pool::stop()
     {
         if (!stopped())
         {
-            for (auto& t : iThreads)
-            {
-                static_cast<thread_pool_thread&>(*t).stop();
-            }
+            // refuse new work before draining so nothing can be queued behind the drain
             {
                 std::unique_lock<std::mutex> lk(iWaitMutex);
                 iStopped = true;
             }
-            iWaitConditionVariable.notify_one();
+            iWaitConditionVariable.notify_all();
+            for (auto& t : iThreads)
+            {
+                if (iScheduling == thread_pool_scheduling::SharedQueueLock)
+                    static_cast<thread_pool_thread&>(*t).stop();
+                else
+                    static_cast<work_stealing_thread_pool_thread&>(*t).stop();
+            }
+            if (iScheduling == thread_pool_scheduling::WorkStealing)
+                discard_injected_tasks();
         }
     }
 
+    void thread_pool::discard_injected_tasks()
+    {
+        for (std::size_t band = 0; band < kPriorityBands; ++band)
+            iInjectionQueues[band]->consume_all([this, band](queued_task aTask) { discard(aTask, band); });
+    }
+
     thread_pool& thread_pool::default_thread_pool()
     {
         static thread_pool sDefaultThreadPool;
@@ -337,6 +582,27 @@ namespace neolib
         return iMutex;
     }
 
+    bool thread_pool::start_task(task_pointer aTask, int32_t aPriority)
+    {
+        if (stopped())
+            return false;
+        if (iScheduling == thread_pool_scheduling::WorkStealing)
+        {
+            enqueue(std::move(aTask), aPriority);
+            return true;
+        }
+        std::scoped_lock<std::recursive_mutex> lk(iMutex);
+        if (iThreads.empty())
+            throw no_threads();
+        for (auto& t : iThreads)
+        {
+            auto& tpt = static_cast<thread_pool_thread&>(*t);
+            if (!tpt.active())
+                return tpt.add(std::move(aTask), aPriority);
+        }
+        return static_cast<thread_pool_thread&>(*iThreads[0]).add(std::move(aTask), aPriority);
+    }
+
     void thread_pool::steal_work(thread_pool_thread& aIdleThread)
     {
         std::scoped_lock<std::recursive_mutex> lk(iMutex);
@@ -362,4 +628,111 @@ namespace neolib
     {
         update_idle();
     }
+
+    void thread_pool::enqueue(task_pointer aTask, int32_t aPriority)
+    {
+        auto const band = priority_band(aPriority);
+        queued_task newTask{ std::move(aTask) };
+        // the counts go up before the push as a worker may take the task as soon as it is pushed; both pushes can
+        // allocate so the counts come back down if the push fails
+        iPendingTasks.fetch_add(1, std::memory_order_acq_rel);
+        iQueuedTasks[band].fetch_add(1, std::memory_order_relaxed);
+        auto* current = work_stealing_thread_pool_thread::current();
+        bool const local = current != nullptr && &current->pool() == this;
+        try
+        {
+            if (local)
+                current->push(band, newTask);
+            else if (!iInjectionQueues[band]->push(newTask))
+                throw std::bad_alloc();
+        }
+        catch (...)
+        {
+            iQueuedTasks[band].fetch_sub(1, std::memory_order_relaxed);
+            newTask.release();
+            task_completed();
+            throw;
+        }
+        if (!local)
+        {
+            // stop() may have drained the injection queues between start_task's check and the push so drain them
+            // again; its own queue is only discarded once this worker has stopped so a worker's push needs no check
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (stopped())
+            {
+                discard_injected_tasks();
+                return;
+            }
+        }
+        wake_one();
+    }
+
+    thread_pool::queued_task thread_pool::dequeue(work_stealing_thread_pool_thread& aThread)
+    {
+        auto const& threads = *iWorkStealingThreads.load(std::memory_order_acquire);
+        auto const threadCount = threads.size();
+        for (std::size_t band = 0; band < kPriorityBands; ++band)
+        {
+            if (iQueuedTasks[band].load(std::memory_order_relaxed) == 0)
+                continue;
+            auto task = aThread.pop(band);
+            // a failed pop may still have written to its argument
+            if (!task && !iInjectionQueues[band]->pop(task))
+                task = queued_task{ nullptr };
+            for (std::size_t i = 1; !task && i < threadCount; ++i)
+                task = threads[(aThread.index() + i) % threadCount]->steal(band);
+            if (task)
+            {
+                iQueuedTasks[band].fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return queued_task{ nullptr };
+    }
+
+    void thread_pool::discard(queued_task aTask, std::size_t aBand)
+    {
+        iQueuedTasks[aBand].fetch_sub(1, std::memory_order_relaxed);
+        aTask.discard();
+        task_completed();
+    }
+
+    void thread_pool::task_completed()
+    {
+        if (iPendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            {
+                std::scoped_lock<std::mutex> lk(iWaitMutex);
+            }
+            iWaitConditionVariable.notify_all();
+        }
+    }
+
+    void thread_pool::wake_one()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (iSleepingThreads.load(std::memory_order_relaxed) != 0)
+        {
+            {
+                std::scoped_lock<std::mutex> lk(iSleepMutex);
+                ++iWakeups;
+            }
+            iSleepConditionVariable.notify_one();
+        }
+    }
+
+    void thread_pool::wait_for_work(std::atomic<bool> const& aStopped)
+    {
+        std::unique_lock<std::mutex> lk(iSleepMutex);
+        iSleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool haveWork = false;
+        for (auto const& queued : iQueuedTasks)
+            haveWork = haveWork || queued.load(std::memory_order_relaxed) != 0;
+        if (!haveWork)
+            iSleepConditionVariable.wait(lk, [&]() { return iWakeups != 0 || aStopped; });
+        if (iWakeups != 0)
+            --iWakeups;
+        iSleepingThreads.fetch_sub(1, std::memory_order_relaxed);
+    }
 }
@@ -94,6 +94,8 @@ namespace neolib
     {
         cancel();
         unsubscribe();
+        if (iTimerObject && !iTaskDestroying && !iTaskDestroyed)
+            iTask.timer_service().remove_timer_object(*iTimerObject);
     }
 
     i_async_task& timer::owner_task() const
@@ -34,11 +34,12 @@
  */
 
 #include <neolib/neolib.hpp>
+#include <neolib/task/async_task.hpp>
 #include <neolib/task/timer_object.hpp>
 
 namespace neolib
 {
-    timer_object::timer_object(i_timer_service& aService) : 
+    timer_object::timer_object(timer_service& aService) : 
         iService{ aService }
     {
     }
@@ -49,6 +50,7 @@ namespace neolib
         if (iDebug)
             std::cerr << "timer_object::~timer_object()" << std::endl;
 #endif
+        iService.unschedule(*this);
         std::unique_lock lock{ iSubscribersMutex };
         for (auto& s : iSubscribers)
             s->detach();
@@ -60,7 +62,7 @@ namespace neolib
         if (iDebug)
             std::cerr << "timer_object::expires_at(...)" << std::endl;
 #endif
-        iExpiryTime = aDeadline;
+        iService.schedule(*this, aDeadline);
     }
 
     void timer_object::async_wait(i_timer_subscriber& aSubscriber)
@@ -93,7 +95,7 @@ namespace neolib
         if (iDebug)
             std::cerr << "timer_object::cancel()" << std::endl;
 #endif
-        iExpiryTime = std::nullopt;
+        iService.unschedule(*this);
     }
 
     bool timer_object::poll()
@@ -102,10 +104,18 @@ namespace neolib
         if (iDebug)
             std::cerr << "timer_object::poll()" << std::endl;
 #endif
-        if (!iExpiryTime || std::chrono::steady_clock::now() < *iExpiryTime)
-            return false;
-        iExpiryTime = std::nullopt;
+        {
+            std::unique_lock lock{ iService.iMutex };
+            if (!iExpiryTime || std::chrono::steady_clock::now() < *iExpiryTime)
+                return false;
+            iService.unschedule(*this);
+        }
+        notify_subscribers();
+        return true;
+    }
 
+    void timer_object::notify_subscribers()
+    {
         typedef std::vector<std::pair<decltype(iSubscribers)::value_type, destroyed_flag>> work_list_t;
         thread_local std::vector<std::unique_ptr<work_list_t>> workListStack;
         thread_local std::size_t stack;
@@ -126,7 +136,6 @@ namespace neolib
         }
         lock.lock();
         workList.clear();
-        return true;
     }
 
     bool timer_object::debug() const
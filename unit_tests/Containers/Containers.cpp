@@ -1,5 +1,19 @@
 #include <iostream>
 #include <string>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <set>
+#include <shared_mutex>
+#include <neolib/core/segmented_array.hpp>
+#include <neolib/core/persistent_segmented_array.hpp>
+#include <neolib/core/indexitor.hpp>
+#include <neolib/core/segmented_indexitor.hpp>
+#include <neolib/core/allocator.hpp>
+#include <neolib/core/size_class_allocator.hpp>
 #include <neolib/core/optional.hpp>
 #include <neolib/core/tree.hpp>
 #include <neolib/core/jar.hpp>
@@ -17,11 +31,547 @@ struct foo : i_foo
 };
 
 template class neolib::basic_jar<foo>;
+template class neolib::basic_generational_jar<foo>;
 
 template class neolib::segmented_tree<std::string, 64, std::allocator<std::string>>;
 
+template class neolib::segmented_array<int, 64, neolib::size_class_allocator<int>>;
+
+template class neolib::segmented_array<int, 64, std::allocator<int>, neolib::array_btree<std::allocator<int>>>;
+
+template class neolib::persistent_segmented_array<int>;
+
+// the lazily built address index lives out of line so it doesn't bloat every segmented_tree node
+static_assert(sizeof(neolib::segmented_array<int, 64>) <= sizeof(neolib::array_tree<std::allocator<int>>) + 4 * sizeof(void*));
+
+template class neolib::segmented_indexitor<int, double>;
+
+void test_size_class_allocator()
+{
+    neolib::segmented_array<int, 64, neolib::size_class_allocator<int>> sa;
+    for (int i = 0; i < 10000; ++i)
+        sa.push_back(i);
+    for (int i = 0; i < 10000; ++i)
+        assert(sa[i] == i);
+    sa.erase(sa.begin() + 100, sa.begin() + 9000);
+    assert(sa.size() == 1100 && sa[100] == 9000);
+
+    // blocks allocated on one thread and freed on another
+    typedef neolib::size_class_allocator<std::array<char, 48>> allocator;
+    std::vector<allocator::pointer> blocks;
+    std::thread producer{ [&]() { for (int i = 0; i < 100000; ++i) blocks.push_back(allocator::allocate()); } };
+    producer.join();
+    std::vector<std::thread> consumers;
+    for (std::size_t t = 0; t < 4; ++t)
+        consumers.emplace_back([&, t]() { for (std::size_t i = t; i < blocks.size(); i += 4) allocator::deallocate(blocks[i]); });
+    for (auto& c : consumers)
+        c.join();
+    assert(allocator::statistics().in_use == 0);
+
+    // non-omega neo_pool_allocator shares the same pool
+    typedef neolib::neo_pool_allocator<std::array<char, 200>> neo_allocator;
+    auto const inUse = neo_allocator::statistics().in_use;
+    auto const neoBlock = neo_allocator::allocate();
+    assert(neo_allocator::statistics().in_use == inUse + 1 && neo_allocator::statistics().block_size >= 200);
+    neo_allocator::deallocate(neoBlock);
+    assert(neo_allocator::statistics().in_use == inUse);
+
+    std::cout << "Size class pool:-" << std::endl;
+    neolib::size_class_pool::instance().info(std::cout);
+    std::cout << std::endl;
+}
+
+template <typename SegmentedArray>
+void test_segmented_array_against_vector()
+{
+    std::mt19937 rng{ 42 };
+    SegmentedArray sa;
+    std::vector<int> v;
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::size_t const position = v.empty() ? 0 : rng() % (v.size() + 1);
+        if (v.size() < 10 || rng() % 3 != 0)
+        {
+            std::vector<int> values(1 + rng() % (rng() % 8 == 0 ? 200 : 4), i);
+            sa.insert(sa.begin() + position, values.begin(), values.end());
+            v.insert(v.begin() + position, values.begin(), values.end());
+        }
+        else
+        {
+            std::size_t const count = std::min<std::size_t>(v.size() - std::min(position, v.size() - 1), 1 + rng() % (rng() % 8 == 0 ? 300 : 4));
+            sa.erase(sa.begin() + std::min(position, v.size() - 1), sa.begin() + std::min(position, v.size() - 1) + count);
+            v.erase(v.begin() + std::min(position, v.size() - 1), v.begin() + std::min(position, v.size() - 1) + count);
+        }
+        assert(sa.size() == v.size());
+        if (!v.empty())
+        {
+            [[maybe_unused]] std::size_t const index = rng() % v.size();
+            assert(sa[index] == v[index]);
+        }
+    }
+    assert(std::equal(sa.begin(), sa.end(), v.begin(), v.end()));
+    assert(std::equal(sa.rbegin(), sa.rend(), v.rbegin(), v.rend()));
+}
+
+#ifdef BENCHMARK_CONTAINERS
+// red-black tree versus B+ tree segment indexes at sizes where the difference shows; only meaningful in an optimized
+// build (test_segmented_array_against_vector() and test_segmented_array_bulk_operations() check correctness)
+template <typename SegmentedArray>
+void benchmark_segmented_array(const char* aName, std::size_t aSize)
+{
+    typedef std::chrono::steady_clock clock;
+    auto const elapsed = [](clock::time_point aStart) { return std::chrono::duration<double, std::milli>(clock::now() - aStart).count(); };
+    SegmentedArray sa;
+    for (std::size_t i = 0; i < aSize; ++i)
+        sa.push_back(static_cast<int>(i));
+    std::mt19937 rng{ 42 };
+    long long sum = 0;
+    auto start = clock::now();
+    for (std::size_t i = 0; i < 200000; ++i)
+        sum += sa[rng() % sa.size()];
+    double const randomIndex = elapsed(start);
+    start = clock::now();
+    for (std::size_t i = 0; i < 20000; ++i)
+        sa.insert(sa.begin() + rng() % sa.size(), static_cast<int>(i));
+    double const insertInMiddle = elapsed(start);
+    start = clock::now();
+    for (auto const& e : sa)
+        sum += e;
+    double const sequentialScan = elapsed(start);
+    std::cout << aName << " (" << aSize << " elements): random index " << randomIndex << " ms, insert in middle " << insertInMiddle <<
+        " ms, sequential scan " << sequentialScan << " ms [" << sum << "]" << std::endl;
+}
+#endif
+
+template <typename SegmentedArray>
+void test_segmented_array_bulk_operations()
+{
+    std::mt19937 rng{ 7 };
+    SegmentedArray sa;
+    std::vector<int> v;
+    for (int i = 0; i < 500; ++i)
+    {
+        std::size_t const position = v.empty() ? 0 : rng() % (v.size() + 1);
+        switch (rng() % 4)
+        {
+        case 0:
+            {
+                std::size_t const count = rng() % 300;
+                sa.insert(sa.begin() + position, count, i);
+                v.insert(v.begin() + position, count, i);
+            }
+            break;
+        case 1:
+            {
+                SegmentedArray other;
+                for (std::size_t j = rng() % 1000; j > 0; --j)
+                    other.push_back(-i);
+                v.insert(v.begin() + position, other.size(), -i);
+                sa.splice(sa.begin() + position, other);
+                assert(other.empty() && other.begin() == other.end());
+            }
+            break;
+        case 2:
+            {
+                auto tail = sa.split(sa.begin() + position);
+                assert(std::equal(tail.begin(), tail.end(), v.begin() + position, v.end()));
+                tail.erase(tail.begin(), tail.begin() + std::min<std::size_t>(tail.size(), rng() % 200));
+                v.erase(v.begin() + position, v.begin() + position + (v.size() - position - tail.size()));
+                sa.splice(sa.end(), tail);
+            }
+            break;
+        case 3:
+            {
+                std::size_t const count = std::min<std::size_t>(v.size() - position, rng() % 2000);
+                sa.erase(sa.begin() + position, sa.begin() + position + count);
+                v.erase(v.begin() + position, v.begin() + position + count);
+            }
+            break;
+        }
+        assert(sa.size() == v.size());
+        for (std::size_t j = 0; j < 10 && !v.empty(); ++j)
+        {
+            [[maybe_unused]] std::size_t const index = rng() % v.size();
+            assert(sa[index] == v[index]);
+            assert(static_cast<std::size_t>(sa.citer(sa[index]) - sa.cbegin()) == index);
+        }
+    }
+    assert(std::equal(sa.begin(), sa.end(), v.begin(), v.end()));
+    assert(std::equal(sa.rbegin(), sa.rend(), v.rbegin(), v.rend()));
+}
+
+// the first citer() builds the address index, possibly on several reader threads at once
+void test_segmented_array_concurrent_lookup()
+{
+    neolib::segmented_array<int, 64> sa;
+    for (int i = 0; i < 100000; ++i)
+        sa.push_back(i);
+    auto const& csa = sa;
+    std::atomic<bool> ok = true;
+    std::vector<std::thread> readers;
+    for (std::size_t t = 0; t < 4; ++t)
+        readers.emplace_back([&, t]()
+        {
+            for (std::size_t i = t; i < csa.size(); i += 97)
+                if (static_cast<std::size_t>(csa.citer(csa[i]) - csa.cbegin()) != i)
+                    ok = false;
+        });
+    for (auto& r : readers)
+        r.join();
+    assert(ok);
+    sa.erase(sa.begin(), sa.begin() + 1000);
+    assert(sa.citer(sa[5000]) - sa.cbegin() == 5000);
+}
+
+#ifdef BENCHMARK_CONTAINERS
+template <typename SegmentedArray>
+void benchmark_segmented_array_bulk(const char* aName, std::size_t aSize)
+{
+    typedef std::chrono::steady_clock clock;
+    auto const elapsed = [](clock::time_point aStart) { return std::chrono::duration<double, std::milli>(clock::now() - aStart).count(); };
+    SegmentedArray sa;
+    sa.insert(sa.end(), aSize, 0);
+    std::vector<int> const run(100000, 1);
+    std::mt19937 rng{ 42 };
+    auto start = clock::now();
+    for (std::size_t i = 0; i < 100; ++i)
+        sa.insert(sa.begin() + rng() % sa.size(), run.begin(), run.end());
+    double const paste = elapsed(start);
+    start = clock::now();
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        auto const position = rng() % (sa.size() - run.size());
+        sa.erase(sa.begin() + position, sa.begin() + position + run.size());
+    }
+    double const erase = elapsed(start);
+    start = clock::now();
+    for (std::size_t i = 0; i < 20; ++i)
+    {
+        auto tail = sa.split(sa.begin() + rng() % sa.size());
+        sa.splice(sa.begin() + rng() % (sa.size() + 1), tail);
+    }
+    double const splitSplice = elapsed(start);
+    std::cout << aName << " (" << aSize << " elements): paste 100 x 100k " << paste << " ms, delete 100 x 100k " << erase <<
+        " ms, split and splice 20 times " << splitSplice << " ms" << std::endl;
+}
+#endif
+
+void test_segmented_tree_splice()
+{
+    neolib::tree<std::string> tree;
+    auto a = tree.insert(tree.send(), "A");
+    auto b = tree.insert(tree.send(), "B");
+    for (int i = 0; i < 200; ++i)
+        tree.push_back(a, "a" + std::to_string(i));
+    auto a0 = std::next(a.begin(), 0);
+    tree.push_back(a0, "a0.x");
+    tree.push_back(a0, "a0.y");
+    assert(tree.size() == 204);
+    [[maybe_unused]] auto moved = tree.splice(b.end(), a0);
+    assert(tree.size() == 204 && *moved == "a0" && moved.descendent_count() == 2);
+    assert(tree.sbegin().descendent_count() == 199 && std::next(tree.sbegin()).descendent_count() == 3);
+    assert(*moved.begin() == "a0.x" && *moved.begin().parent() == "a0");
+    // a sibling of the subtree as the destination
+    auto a150 = std::next(tree.sbegin().begin(), 150);
+    tree.splice(a150.end(), tree.sbegin().begin());
+    assert(tree.sbegin().descendent_count() == 199 && tree.sbegin().begin().descendent_count() == 0);
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        auto const sb = std::next(tree.sbegin());
+        tree.splice(sb.begin().end(), sb);
+    }
+    catch (neolib::tree<std::string>::invalid_splice const&)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    tree.erase(tree.begin());
+    assert(tree.size() == 4);
+    neolib::tree<std::string> copy{ tree };
+    assert(copy.size() == 4 && *copy.begin().begin().begin().parent() == "a0");
+}
+
+void test_btree_segmented_array()
+{
+    test_segmented_array_bulk_operations<neolib::segmented_array<int, 8>>();
+    test_segmented_array_bulk_operations<neolib::btree_segmented_array<int, 8>>();
+    test_segmented_array_bulk_operations<neolib::segmented_array<int, 8, std::allocator<int>, neolib::array_btree<std::allocator<int>, 4>>>();
+    test_segmented_tree_splice();
+
+    test_segmented_array_against_vector<neolib::segmented_array<int, 8>>();
+    test_segmented_array_against_vector<neolib::btree_segmented_array<int, 8>>();
+    test_segmented_array_against_vector<neolib::segmented_array<int, 8, std::allocator<int>, neolib::array_btree<std::allocator<int>, 4>>>();
+
+#ifdef BENCHMARK_CONTAINERS
+    std::cout << "segmented_array benchmarks:-" << std::endl;
+    for (std::size_t size : { 100000u, 4000000u })
+    {
+        benchmark_segmented_array<neolib::segmented_array<int>>("red-black tree", size);
+        benchmark_segmented_array<neolib::btree_segmented_array<int>>("B+ tree", size);
+    }
+    benchmark_segmented_array_bulk<neolib::segmented_array<int>>("red-black tree", 4000000u);
+    benchmark_segmented_array_bulk<neolib::btree_segmented_array<int>>("B+ tree", 4000000u);
+    std::cout << std::endl;
+#endif
+}
+
+void test_persistent_segmented_array()
+{
+    typedef neolib::persistent_segmented_array<int, 8, std::allocator<int>, 4> array_type;
+    std::mt19937 rng{ 42 };
+    array_type pa;
+    std::vector<int> v;
+    std::vector<std::pair<array_type::snapshot_type, std::vector<int>>> snapshots;
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::size_t const position = v.empty() ? 0 : rng() % (v.size() + 1);
+        if (v.size() < 10 || rng() % 3 != 0)
+        {
+            std::vector<int> values(1 + rng() % (rng() % 8 == 0 ? 200 : 4), i);
+            pa.insert(pa.begin() + position, values.begin(), values.end());
+            v.insert(v.begin() + position, values.begin(), values.end());
+        }
+        else
+        {
+            std::size_t const first = std::min(position, v.size() - 1);
+            std::size_t const count = std::min<std::size_t>(v.size() - first, 1 + rng() % (rng() % 8 == 0 ? 300 : 4));
+            pa.erase(pa.begin() + first, pa.begin() + first + count);
+            v.erase(v.begin() + first, v.begin() + first + count);
+        }
+        if (!v.empty())
+        {
+            std::size_t const index = rng() % v.size();
+            pa[index] = -i;
+            v[index] = -i;
+        }
+        if (i % 100 == 0)
+            snapshots.emplace_back(pa.snapshot(), v);
+    }
+    assert(std::equal(pa.begin(), pa.end(), v.begin(), v.end()));
+    for ([[maybe_unused]] auto const& s : snapshots)
+        assert(std::equal(s.first.begin(), s.first.end(), s.second.begin(), s.second.end()));
+
+    // a reader iterates a snapshot without locking while the owner edits
+    neolib::persistent_segmented_array<int> live(1000000, 1);
+    auto const snapshot = live.snapshot();
+    long long sum = 0;
+    std::thread reader{ [&]() { for (auto e : snapshot) sum += e; } };
+    for (int i = 0; i < 10000; ++i)
+    {
+        live.insert(live.begin() + rng() % live.size(), 2);
+        live.erase(live.begin() + rng() % live.size());
+    }
+    reader.join();
+    assert(sum == 1000000 && snapshot.size() == 1000000);
+}
+
+template <typename ForeignIndex>
+void test_segmented_indexitor_against_indexitor()
+{
+    typedef neolib::indexitor<int, ForeignIndex> reference_type;
+    typedef neolib::segmented_indexitor<int, ForeignIndex, 8> segmented_type;
+    typedef typename segmented_type::skip_type skip_type;
+    std::mt19937 rng{ 42 };
+    reference_type r;
+    segmented_type s;
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::size_t const position = r.empty() ? 0 : rng() % (r.size() + 1);
+        ForeignIndex const extent = static_cast<ForeignIndex>(rng() % 4 == 0 ? 0 : 1 + rng() % 20);
+        skip_type const skip{ static_cast<ForeignIndex>(rng() % 3), static_cast<ForeignIndex>(rng() % 3) };
+        if (r.size() < 50 || rng() % 3 != 0)
+        {
+            r.insert(r.begin() + position, typename reference_type::value_type{ i, extent }, skip);
+            s.insert(s.begin() + position, typename segmented_type::value_type{ i, extent }, skip);
+        }
+        else if (rng() % 2 == 0)
+        {
+            std::size_t const first = std::min(position, r.size() - 1);
+            std::size_t const count = std::min<std::size_t>(r.size() - first, 1 + rng() % (rng() % 8 == 0 ? 30 : 3));
+            r.erase(r.begin() + first, r.begin() + first + count);
+            s.erase(s.begin() + first, s.begin() + first + count);
+        }
+        else
+        {
+            // a run of adjacent edits
+            std::size_t const first = std::min(position, r.size() - 1);
+            for (std::size_t j = first; j < std::min(first + 5, r.size()); ++j)
+            {
+                ForeignIndex const newExtent = static_cast<ForeignIndex>(rng() % 20);
+                r.update_foreign_index(r.begin() + j, newExtent, skip);
+                s.update_foreign_index(s.begin() + j, newExtent, skip);
+            }
+        }
+        assert(r.size() == s.size());
+        assert(r.foreign_index(r.end()) == s.foreign_index(s.end()));
+        for (int j = 0; j < 4; ++j)
+        {
+            ForeignIndex const x = static_cast<ForeignIndex>(rng() % (static_cast<std::size_t>(r.foreign_index(r.end())) + 2));
+            [[maybe_unused]] auto const rf = r.find_by_foreign_index(x);
+            [[maybe_unused]] auto const sf = s.find_by_foreign_index(x);
+            assert(rf.first - r.begin() == sf.first - s.begin());
+            assert(rf.second == sf.second);
+            assert(sf.first == s.end() || sf.first->first == rf.first->first);
+        }
+        if (!r.empty())
+        {
+            [[maybe_unused]] std::size_t const index = rng() % r.size();
+            assert(r.foreign_index(r.begin() + index) == s.foreign_index(s.begin() + index));
+            assert(s.index(s.begin() + index) == index);
+        }
+    }
+    assert(std::equal(r.begin(), r.end(), s.begin(), s.end()));
+    segmented_type copy{ s };
+    for (std::size_t i = 0; i < s.size(); ++i)
+        assert(copy.foreign_index(copy.begin() + i) == s.foreign_index(s.begin() + i));
+}
+
+#ifdef BENCHMARK_CONTAINERS
+// glyph lookup by x position as a text editor does it
+template <typename Indexitor>
+void benchmark_indexitor(const char* aName, std::size_t aSize)
+{
+    Indexitor glyphs;
+    for (std::size_t i = 0; i < aSize; ++i)
+        glyphs.push_back(typename Indexitor::value_type{ static_cast<int>(i), 7.0 + (i % 5) });
+    std::mt19937 rng{ 42 };
+    double const width = glyphs.foreign_index(glyphs.end());
+    std::size_t total = 0;
+    auto const start = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < 1000000u; ++i)
+        total += glyphs.find_by_foreign_index(std::uniform_real_distribution<double>{ 0.0, width }(rng)).first->first;
+    auto const end = std::chrono::high_resolution_clock::now();
+    std::cout << aName << ": 1000000 find_by_foreign_index over " << aSize << " entries: " 
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms (" << total % 10 << ")" << std::endl;
+}
+#endif
+
+void test_segmented_indexitor()
+{
+    test_segmented_indexitor_against_indexitor<int>();
+    test_segmented_indexitor_against_indexitor<double>();
+    test_segmented_indexitor_against_indexitor<long long>();
+#ifdef BENCHMARK_CONTAINERS
+    benchmark_indexitor<neolib::indexitor<int, double>>("indexitor", 1000000u);
+    benchmark_indexitor<neolib::segmented_indexitor<int, double>>("segmented_indexitor", 1000000u);
+    std::cout << std::endl;
+#endif
+}
+
+void test_generational_jar()
+{
+    neolib::generational_jar<int> jar;
+    std::vector<neolib::cookie> cookies;
+    for (int i = 0; i < 1000; ++i)
+        cookies.push_back(jar.emplace(i));
+    for (int i = 0; i < 1000; i += 2)
+        jar.remove(cookies[i]);
+    for (int i = 0; i < 1000; ++i)
+    {
+        assert(jar.contains(cookies[i]) == (i % 2 == 1));
+        assert(i % 2 == 0 || jar[cookies[i]] == i);
+    }
+    // recycled slots get a new generation so stale cookies stay invalid
+    std::vector<neolib::cookie> recycled;
+    for (int i = 0; i < 500; ++i)
+        recycled.push_back(jar.emplace(1000 + i));
+    for (int i = 0; i < 1000; i += 2)
+    {
+        assert(!jar.contains(cookies[i]));
+        assert(jar.find(cookies[i]) == jar.end());
+        [[maybe_unused]] bool threw = false;
+        try { (void)jar[cookies[i]]; } catch (neolib::cookie_invalid const&) { threw = true; }
+        assert(threw);
+    }
+    for (int i = 0; i < 500; ++i)
+        assert(jar[recycled[i]] == 1000 + i);
+    // single pass compaction keeps the survivors in order
+    std::vector<int> expected;
+    for (auto const& item : jar)
+        if (item % 3 != 0)
+            expected.push_back(item);
+    [[maybe_unused]] std::size_t const removed = jar.erase_if([](int aItem) { return aItem % 3 == 0; });
+    assert(removed + expected.size() == 1000u);
+    assert(std::equal(jar.begin(), jar.end(), expected.begin(), expected.end()));
+    for (int i = 1; i < 1000; i += 2)
+        assert(jar.contains(cookies[i]) == (i % 3 != 0) && (i % 3 == 0 || jar[cookies[i]] == i));
+    for ([[maybe_unused]] auto const& item : jar)
+        assert(jar[jar.item_cookie(item)] == item);
+    // a slot whose generations are exhausted is retired so no stale cookie ever becomes valid again; churn runs
+    // a small retiring jar out of cookies after every generation of its 2047 slots has been used
+    neolib::basic_generational_jar<int, neolib::vector<int>, neolib::small_cookie, neolib::null_mutex, 5u, true> smallJar;
+    std::set<neolib::small_cookie> issued;
+    std::vector<neolib::small_cookie> stale;
+    [[maybe_unused]] bool exhausted = false;
+    for (int i = 0; i < 200000; ++i)
+    {
+        neolib::small_cookie cookie;
+        try
+        {
+            cookie = smallJar.emplace(i);
+        }
+        catch (neolib::cookies_exhausted const&)
+        {
+            exhausted = true;
+            break;
+        }
+        assert(cookie != neolib::small_cookie{} && cookie != neolib::invalid_cookie<neolib::small_cookie>);
+        assert(issued.insert(cookie).second);
+        for ([[maybe_unused]] auto const staleCookie : stale)
+            assert(!smallJar.contains(staleCookie));
+        smallJar.remove(cookie);
+        if (i % 1000 == 0)
+            stale.push_back(cookie);
+    }
+    assert(exhausted && issued.size() == 2047u * 31u);
+    [[maybe_unused]] bool threw = false;
+    try { smallJar.emplace(0); } catch (neolib::cookies_exhausted const&) { threw = true; }
+    assert(threw);
+    // small jars wrap by default so churn never exhausts them; reusing the oldest free slot keeps a stale cookie
+    // invalid until its slot has cycled through every generation, each cycle waiting behind the minimum free queue
+    neolib::small_generational_jar<int> wrappingJar;
+    auto const staleCookie = wrappingJar.emplace(-1);
+    wrappingJar.remove(staleCookie);
+    for (int i = 0; i < 200000; ++i)
+    {
+        auto const cookie = wrappingJar.emplace(i);
+        assert(i >= static_cast<int>((neolib::default_minimum_free_slots_v + 1u) * 30u) || (cookie != staleCookie && !wrappingJar.contains(staleCookie)));
+        wrappingJar.remove(cookie);
+    }
+    // readers validate cookies under a shared lock while a writer churns
+    neolib::generational_jar<int, std::shared_mutex> sharedJar;
+    std::vector<neolib::cookie> sharedCookies;
+    for (int i = 0; i < 1000; ++i)
+        sharedCookies.push_back(sharedJar.emplace(i));
+    std::atomic<bool> done = false;
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r)
+        readers.emplace_back([&]()
+        {
+            while (!done)
+                for (int i = 0; i < 1000; ++i)
+                    sharedJar.visit(sharedCookies[i], [&]([[maybe_unused]] int aItem) { assert(aItem == i); });
+        });
+    for (int pass = 0; pass < 100; ++pass)
+    {
+        auto const cookie = sharedJar.emplace(-1);
+        sharedJar.remove(cookie);
+    }
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+}
+
 int main()
 {
+    test_size_class_allocator();
+    test_btree_segmented_array();
+    test_segmented_array_concurrent_lookup();
+    test_persistent_segmented_array();
+    test_segmented_indexitor();
+    test_generational_jar();
+
     neolib::optional<foo> of = {};
 
     neolib::optional<bool> o1 = true;
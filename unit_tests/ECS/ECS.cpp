@@ -0,0 +1,670 @@
+#include <iostream>
+#include <vector>
+#include <set>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cassert>
+#include <neolib/task/async_task.hpp>
+#include <neolib/ecs/ecs.hpp>
+#include <neolib/ecs/entity_archetype.hpp>
+#include <neolib/ecs/view.hpp>
+#include <neolib/ecs/command_buffer.hpp>
+
+namespace test
+{
+    using neolib::ecs::component_data_field_type;
+
+    template <typename Derived, uint32_t Id, component_data_field_type FieldType>
+    struct meta : neolib::ecs::i_component_data::meta
+    {
+        static const neolib::uuid& id()
+        {
+            static const neolib::uuid sId = { Id, 0x4a1e, 0x4c3d, 0x9b2f, { 0x1, 0x2, 0x3, 0x4, 0x5, 0x6 } };
+            return sId;
+        }
+        static const neolib::i_string& name()
+        {
+            static const neolib::string sName = "Test";
+            return sName;
+        }
+        static uint32_t field_count()
+        {
+            return 1;
+        }
+        static component_data_field_type field_type(uint32_t)
+        {
+            return FieldType;
+        }
+        static const neolib::i_string& field_name(uint32_t)
+        {
+            static const neolib::string sFieldName = "Value";
+            return sFieldName;
+        }
+    };
+
+    struct position
+    {
+        neolib::vec3f value;
+        struct meta : test::meta<position, 0x1, component_data_field_type::Vec3f> {};
+    };
+
+    struct velocity
+    {
+        neolib::vec3f value;
+        struct meta : test::meta<velocity, 0x2, component_data_field_type::Vec3f> {};
+    };
+
+    struct mass
+    {
+        float value;
+        struct meta : test::meta<mass, 0x3, component_data_field_type::Float32> {};
+    };
+
+    neolib::ecs::entity_archetype const movingArchetype{ "Moving", { position::meta::id(), velocity::meta::id() } };
+    neolib::ecs::entity_archetype const bodyArchetype{ "Body", { position::meta::id(), velocity::meta::id(), mass::meta::id() } };
+
+    neolib::ecs::ecs_flags const sparse = neolib::ecs::ecs_flags::NoThreads | neolib::ecs::ecs_flags::CreatePaused;
+    neolib::ecs::ecs_flags const chunked = sparse | neolib::ecs::ecs_flags::ArchetypeChunks;
+    neolib::ecs::ecs_flags const parallel = neolib::ecs::ecs_flags::NoThreads | neolib::ecs::ecs_flags::ParallelSystems;
+
+    template <typename... ReadOnly>
+    struct reads {};
+
+    template <uint32_t Id, typename Reads, typename... Data>
+    class sleeper;
+
+    template <uint32_t Id, typename... ReadOnly, typename... Data>
+    class sleeper<Id, reads<ReadOnly...>, Data...> : public neolib::ecs::system<Data...>
+    {
+    public:
+        static constexpr std::chrono::milliseconds duration{ 20 };
+    public:
+        sleeper(neolib::ecs::i_ecs& aEcs) :
+            neolib::ecs::system<Data...>{ aEcs }
+        {
+            this->template declare_read_only<ReadOnly...>();
+        }
+    public:
+        const neolib::ecs::system_id& id() const override
+        {
+            return meta::id();
+        }
+        const neolib::i_string& name() const override
+        {
+            return meta::name();
+        }
+        bool apply() override
+        {
+            std::this_thread::sleep_for(duration);
+            ++applied;
+            return true;
+        }
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { Id, 0x5b2f, 0x4d4e, 0xac30, { 0x1, 0x2, 0x3, 0x4, 0x5, 0x6 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Sleeper";
+                return sName;
+            }
+        };
+    public:
+        std::atomic<std::size_t> applied = 0u;
+    };
+
+    // integrator -> damper, integrator -> observer, weigher -> observer
+    typedef sleeper<0x10, reads<velocity>, position, velocity> integrator;
+    typedef sleeper<0x11, reads<>, velocity> damper;
+    typedef sleeper<0x12, reads<>, mass> weigher;
+    typedef sleeper<0x13, reads<position, mass>, position, mass> observer;
+    typedef sleeper<0x14, reads<>> opaque;
+}
+
+void test_storage(neolib::ecs::ecs_flags aFlags)
+{
+    neolib::ecs::ecs ecs{ aFlags };
+    std::vector<neolib::ecs::entity_id> entities;
+    for (int i = 0; i < 3000; ++i)
+    {
+        auto const f = static_cast<float>(i);
+        if (i % 3 == 0)
+            entities.push_back(ecs.create_entity(test::bodyArchetype, test::position{ { f, 0.0f, 0.0f } }, test::velocity{ { 1.0f, f, 0.0f } }, test::mass{ f }));
+        else
+            entities.push_back(ecs.create_entity(test::movingArchetype, test::position{ { f, 0.0f, 0.0f } }, test::velocity{ { 1.0f, f, 0.0f } }));
+    }
+    // adding a component moves the entity between tables in chunked mode
+    for (std::size_t i = 1; i < entities.size(); i += 3)
+        ecs.populate(entities[i], test::mass{ -1.0f });
+    // removing rows keeps the tables dense
+    for (std::size_t i = 0; i < entities.size(); i += 5)
+        ecs.destroy_entity(entities[i]);
+    ecs.component<test::mass>().destroy_entity_record(entities[4]);
+
+    std::size_t moving = 0;
+    ecs.for_each<test::position, test::velocity>([&]([[maybe_unused]] neolib::ecs::entity_id aEntity, test::position& aPosition, test::velocity& aVelocity)
+    {
+        assert(aPosition.value.x == aVelocity.value.y);
+        assert(ecs.component<test::position>().entity(ecs.component<test::position>().entity_record(aEntity)) == aEntity);
+        aPosition.value += aVelocity.value;
+        ++moving;
+    });
+    assert(moving == 2400);
+    std::size_t massive = 0;
+    ecs.for_each_chunk<test::mass, test::position>([&](std::size_t aCount, [[maybe_unused]] const neolib::ecs::entity_id* aEntities, [[maybe_unused]] test::mass* aMass, [[maybe_unused]] test::position* aPosition)
+    {
+        for (std::size_t row = 0; row < aCount; ++row)
+        {
+            assert(aMass[row].value == -1.0f || aMass[row].value + 1.0f == aPosition[row].value.x);
+            assert(ecs.component<test::mass>().has_entity_record(aEntities[row]));
+        }
+        massive += aCount;
+    });
+    assert(massive == 1599);
+    std::size_t applied = 0;
+    ecs.component<test::velocity>().apply([&](auto&, test::velocity&) { ++applied; });
+    assert(applied == moving);
+    for (std::size_t i = 0; i < entities.size(); ++i)
+        assert(ecs.component<test::position>().has_entity_record(entities[i]) == (i % 5 != 0));
+    assert(!ecs.component<test::mass>().has_entity_record(entities[4]));
+    assert(ecs.component<test::position>().entity_record(entities[1]).value.x == 2.0f);
+    if (ecs.chunked())
+    {
+        std::size_t rows = 0;
+        for (auto const& table : ecs.chunk_storage().tables())
+        {
+            rows += table->size();
+            assert(table->chunk_count() == (table->size() + table->chunk_capacity() - 1) / table->chunk_capacity());
+            // the last record of each chunk's columns maps back to its entity via the chunk index
+            for (std::size_t chunk = 0; chunk < table->chunk_count(); ++chunk)
+                for (std::size_t column = 0; column < table->columns().size(); ++column)
+                {
+                    [[maybe_unused]] auto const last = table->chunk_rows(chunk) - 1;
+                    [[maybe_unused]] auto const record = static_cast<const std::byte*>(table->column(chunk, column)) + last * table->columns()[column]->size;
+                    assert(ecs.chunk_storage().entity(table->columns()[column]->id, record) == table->entities(chunk)[last]);
+                }
+        }
+        assert(rows == 2400);
+    }
+}
+
+void test_view(neolib::ecs::ecs_flags aFlags)
+{
+    neolib::ecs::ecs ecs{ aFlags };
+    neolib::ecs::view<test::position, test::mass> bodies{ ecs };
+    assert(bodies.empty());
+    std::vector<neolib::ecs::entity_id> entities;
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto const f = static_cast<float>(i);
+        if (i % 2 == 0)
+            entities.push_back(ecs.create_entity(test::bodyArchetype, test::position{ { f, 0.0f, 0.0f } }, test::velocity{}, test::mass{ f }));
+        else
+            entities.push_back(ecs.create_entity(test::movingArchetype, test::position{ { f, 0.0f, 0.0f } }, test::velocity{}));
+    }
+    assert(bodies.size() == 500);
+    // incremental: entity_created/entity_destroyed account for every record change
+    for (int i = 0; i < 100; ++i)
+        ecs.destroy_entity(entities[i]);
+    ecs.create_entity(test::bodyArchetype, test::position{}, test::velocity{}, test::mass{ 0.0f });
+    assert(bodies.size() == 451);
+    // records added to or removed from existing entities are picked up by a rebuild
+    ecs.populate(entities[101], test::mass{ 101.0f });
+    ecs.component<test::mass>().destroy_entity_record(entities[102]);
+    ecs.destroy_entity(entities[104], false);
+    assert(bodies.size() == 450);
+    std::size_t count = 0;
+    bodies.each([&]([[maybe_unused]] neolib::ecs::entity_id aEntity, test::position& aPosition, [[maybe_unused]] test::mass& aMass)
+    {
+        assert(aPosition.value.x == aMass.value);
+        assert(ecs.component<test::mass>().has_entity_record(aEntity));
+        aPosition.value.y = 1.0f;
+        ++count;
+    });
+    assert(count == 450);
+    std::atomic<std::size_t> parallelCount = 0;
+    bodies.par_each([&](neolib::ecs::entity_id, [[maybe_unused]] test::position& aPosition, test::mass&)
+    {
+        assert(aPosition.value.y == 1.0f);
+        ++parallelCount;
+    });
+    assert(parallelCount == 450);
+}
+
+void test_commands(neolib::ecs::ecs_flags aFlags)
+{
+    neolib::ecs::ecs ecs{ aFlags };
+    auto const existing = ecs.create_entity(test::movingArchetype, test::position{}, test::velocity{});
+    auto const reordered = ecs.create_entity(test::movingArchetype, test::position{}, test::velocity{});
+    std::size_t created = 0;
+    std::size_t destroyed = 0;
+    neolib::sink sink;
+    sink += ecs.entity_created([&]([[maybe_unused]] neolib::ecs::entity_id aEntity)
+    {
+        // payloads are in place before the notification
+        assert(ecs.component<test::position>().has_entity_record(aEntity));
+        ++created;
+    });
+    sink += ecs.entity_destroyed([&](neolib::ecs::entity_id) { ++destroyed; });
+
+    std::size_t const threadCount = 4;
+    std::size_t const perThread = 2500;
+    std::vector<std::vector<neolib::ecs::entity_id>> spawned(threadCount);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t)
+        threads.emplace_back([&, t]()
+        {
+            auto& commands = ecs.commands();
+            for (std::size_t i = 0; i < perThread; ++i)
+            {
+                auto const entity = commands.create_entity(test::movingArchetype, test::position{ { static_cast<float>(i), 0.0f, 0.0f } }, test::velocity{ { 1.0f, 0.0f, 0.0f } });
+                spawned[t].push_back(entity);
+                if (i % 5 == 0)
+                    commands.add_component(entity, test::mass{ static_cast<float>(i) });
+                if (i % 7 == 0)
+                    commands.remove_component<test::velocity>(entity);
+                if (i % 10 == 0)
+                    commands.destroy_entity(entity);
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+    ecs.commands().add_component(existing, test::mass{ -1.0f });
+    ecs.commands().destroy_entity(existing);
+    ecs.commands().destroy_entity(existing);
+    // one entity's commands apply in the order they were recorded
+    ecs.commands().remove_component<test::velocity>(reordered);
+    ecs.commands().add_component(reordered, test::velocity{ { 2.0f, 0.0f, 0.0f } });
+    ecs.commands().add_component(reordered, test::mass{ 1.0f });
+    ecs.commands().remove_component<test::mass>(reordered);
+    assert(created == 0);
+
+    ecs.commit_commands();
+    assert(created == threadCount * perThread);
+    assert(destroyed == threadCount * perThread / 10 + 1);
+    assert(!ecs.component<test::position>().has_entity_record(existing));
+    assert(ecs.component<test::velocity>().entity_record(reordered).value.x == 2.0f);
+    assert(!ecs.component<test::mass>().has_entity_record(reordered));
+    for (auto const& entities : spawned)
+        for (std::size_t i = 0; i < entities.size(); ++i)
+        {
+            [[maybe_unused]] auto const entity = entities[i];
+            bool const alive = i % 10 != 0;
+            assert(ecs.component<test::position>().has_entity_record(entity) == alive);
+            assert(ecs.component<test::velocity>().has_entity_record(entity) == (alive && i % 7 != 0));
+            assert(ecs.component<test::mass>().has_entity_record(entity) == (alive && i % 5 == 0));
+            if (alive)
+            {
+                assert(ecs.component<test::position>().entity_record(entity).value.x == static_cast<float>(i));
+                assert(ecs.component<neolib::ecs::entity_info>().entity_record(entity).archetypeId == test::movingArchetype.id());
+            }
+        }
+    // nothing left to apply
+    ecs.commit_commands();
+    assert(created == threadCount * perThread);
+}
+
+void test_dead_entity_commands(neolib::ecs::ecs_flags aFlags)
+{
+    // commands for an entity destroyed before the commit are dropped, even once its index has been reused
+    neolib::ecs::ecs ecs{ aFlags };
+    auto const pending = ecs.commands().create_entity(test::movingArchetype, test::position{}, test::velocity{});
+    auto const doomed = ecs.create_entity(test::movingArchetype, test::position{});
+    // a reserved id is not alive until its creation is committed
+    assert(!ecs.is_alive(pending) && ecs.is_alive(doomed));
+    ecs.commands().add_component(doomed, test::mass{ 1.0f });
+    ecs.commands().remove_component<test::position>(doomed);
+    ecs.commands().destroy_entity(doomed);
+    ecs.destroy_entity(pending);
+    ecs.destroy_entity(doomed);
+    ecs.recycle_entity_ids();
+    [[maybe_unused]] auto const reused = ecs.create_entity(test::movingArchetype, test::position{ { 5.0f, 0.0f, 0.0f } });
+    assert(neolib::ecs::entity_index(reused) == neolib::ecs::entity_index(pending) || neolib::ecs::entity_index(reused) == neolib::ecs::entity_index(doomed));
+    std::size_t notifications = 0;
+    neolib::sink sink;
+    sink += ecs.entity_created([&](neolib::ecs::entity_id) { ++notifications; });
+    sink += ecs.entity_destroyed([&](neolib::ecs::entity_id) { ++notifications; });
+    ecs.commit_commands();
+    assert(notifications == 0);
+    assert(!ecs.is_alive(pending) && !ecs.is_alive(doomed) && ecs.is_alive(reused));
+    assert(!ecs.component<test::position>().has_entity_record(pending) && !ecs.component<test::velocity>().has_entity_record(pending));
+    assert(ecs.component<test::position>().entity_record(reused).value.x == 5.0f);
+    assert(!ecs.component<test::mass>().has_entity_record(reused));
+}
+
+void test_generations(neolib::ecs::ecs_flags aFlags)
+{
+    neolib::ecs::ecs ecs{ aFlags };
+    auto const first = ecs.create_entity(test::movingArchetype, test::position{ { 1.0f, 0.0f, 0.0f } });
+    assert(ecs.is_alive(first) && neolib::ecs::entity_generation(first) == 0u);
+    assert(!ecs.is_alive(neolib::ecs::null_entity));
+    ecs.destroy_entity(first);
+    ecs.destroy_entity(first); // stale: no double free
+    assert(!ecs.is_alive(first));
+    // freed indices are held back until the frame boundary
+    [[maybe_unused]] auto const second = ecs.create_entity(test::movingArchetype, test::position{});
+    assert(neolib::ecs::entity_index(second) != neolib::ecs::entity_index(first));
+    ecs.recycle_entity_ids();
+    [[maybe_unused]] auto const third = ecs.create_entity(test::movingArchetype, test::position{ { 3.0f, 0.0f, 0.0f } });
+    assert(neolib::ecs::entity_index(third) == neolib::ecs::entity_index(first));
+    assert(neolib::ecs::entity_generation(third) == 1u && third != first);
+    assert(ecs.is_alive(third) && !ecs.is_alive(first));
+    // a stale id does not alias the entity now using its index
+    assert(!ecs.component<test::position>().has_entity_record(first));
+    assert(ecs.component<test::position>().entity_record(third).value.x == 3.0f);
+
+    // churn: storage is sized by live indices, not by the number of entities ever created
+    std::vector<neolib::ecs::entity_id> entities;
+    for (std::size_t frame = 0; frame < 1000; ++frame)
+    {
+        for (std::size_t i = 0; i < 100; ++i)
+            entities.push_back(ecs.create_entity(test::movingArchetype, test::position{}, test::velocity{}));
+        for (auto entity : entities)
+            ecs.destroy_entity(entity);
+        for ([[maybe_unused]] auto entity : entities)
+            assert(!ecs.is_alive(entity));
+        entities.clear();
+        ecs.recycle_entity_ids();
+    }
+    assert(ecs.is_alive(second) && ecs.is_alive(third));
+    [[maybe_unused]] auto const latest = ecs.create_entity(test::movingArchetype, test::position{});
+    assert(neolib::ecs::entity_index(latest) <= 203u && neolib::ecs::entity_generation(latest) > 0u);
+    if (!ecs.chunked())
+        assert(ecs.component<test::position>().reverse_indices().size() <= 204u);
+
+    // threads reserving at once share out the recycled indices without handing any out twice
+    for (std::size_t i = 0; i < 1000; ++i)
+        entities.push_back(ecs.reserve_entity_id());
+    for (auto entity : entities)
+        ecs.free_entity_id(entity);
+    ecs.recycle_entity_ids();
+    std::size_t const threadCount = 4;
+    std::vector<std::vector<neolib::ecs::entity_id>> reserved(threadCount);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t)
+        threads.emplace_back([&, t]()
+        {
+            for (std::size_t i = 0; i < entities.size() / threadCount + 10; ++i)
+                reserved[t].push_back(ecs.reserve_entity_id());
+        });
+    for (auto& thread : threads)
+        thread.join();
+    std::set<neolib::ecs::entity_index_t> indices;
+    for (auto const& ids : reserved)
+        for (auto id : ids)
+            indices.insert(neolib::ecs::entity_index(id));
+    assert(indices.size() == entities.size() + threadCount * 10);
+    for ([[maybe_unused]] auto entity : entities)
+        assert(indices.count(neolib::ecs::entity_index(entity)) == 1u);
+}
+
+void test_command_churn(neolib::ecs::ecs_flags aFlags)
+{
+    // entities made through command buffers reuse recycled indices too
+    neolib::ecs::ecs ecs{ aFlags };
+    std::vector<neolib::ecs::entity_id> entities;
+    for (std::size_t frame = 0; frame < 200; ++frame)
+    {
+        for (std::size_t i = 0; i < 1000; ++i)
+            entities.push_back(ecs.commands().create_entity(test::movingArchetype, test::position{}, test::velocity{}));
+        ecs.commit_commands();
+        for (auto entity : entities)
+            ecs.commands().destroy_entity(entity);
+        ecs.commit_commands();
+        for ([[maybe_unused]] auto entity : entities)
+            assert(!ecs.is_alive(entity));
+        entities.clear();
+        ecs.recycle_entity_ids();
+    }
+    [[maybe_unused]] auto const latest = ecs.commands().create_entity(test::movingArchetype, test::position{});
+    assert(!ecs.is_alive(latest));
+    ecs.commit_commands();
+    assert(ecs.is_alive(latest));
+    assert(neolib::ecs::entity_index(latest) <= 1000u && neolib::ecs::entity_generation(latest) > 0u);
+    assert(ecs.component<test::position>().has_entity_record(latest));
+    if (!ecs.chunked())
+        assert(ecs.component<test::position>().reverse_indices().size() <= 1001u);
+}
+
+void test_structural_locking()
+{
+    // in chunked mode adding or removing a column moves whole rows so a reader holding only the position lock must not see its rows move
+    neolib::ecs::ecs ecs{ test::chunked };
+    std::vector<neolib::ecs::entity_id> entities;
+    for (int i = 0; i < 1000; ++i)
+        entities.push_back(ecs.create_entity(test::movingArchetype, test::position{ { static_cast<float>(i), 0.0f, 0.0f } }, test::velocity{}));
+    std::atomic<bool> done = false;
+    std::thread writer{ [&]()
+    {
+        for (int pass = 0; pass < 20; ++pass)
+        {
+            for (std::size_t i = pass % 2; i < entities.size(); i += 2)
+                ecs.populate(entities[i], test::mass{ 1.0f });
+            for (std::size_t i = pass % 2; i < entities.size(); i += 2)
+                ecs.component<test::mass>().destroy_entity_record(entities[i]);
+        }
+        done = true;
+    } };
+    std::size_t reads = 0;
+    while (!done || reads == 0)
+    {
+        {
+            neolib::ecs::scoped_component_lock<test::position> lock{ ecs };
+            auto& positions = ecs.component<test::position>();
+            for (std::size_t i = 0; i < entities.size(); i += 97)
+            {
+                [[maybe_unused]] auto const& record = positions.entity_record_no_lock(entities[i]);
+                std::this_thread::yield();
+                assert(&record == &positions.entity_record_no_lock(entities[i]));
+                assert(record.value.x == static_cast<float>(i));
+            }
+            ++reads;
+        }
+        std::this_thread::yield();
+    }
+    writer.join();
+    // structural changes to different components from different threads take every component lock before their own
+    // so they serialize rather than each holding one component lock while waiting for the other's
+    std::thread massWriter{ [&]()
+    {
+        for (int pass = 0; pass < 20; ++pass)
+            for (auto entity : entities)
+            {
+                ecs.populate(entity, test::mass{ 1.0f });
+                ecs.component<test::mass>().destroy_entity_record(entity);
+            }
+    } };
+    std::thread velocityWriter{ [&]()
+    {
+        for (int pass = 0; pass < 20; ++pass)
+            for (auto entity : entities)
+            {
+                ecs.component<test::velocity>().destroy_entity_record(entity);
+                ecs.populate(entity, test::velocity{});
+            }
+    } };
+    massWriter.join();
+    velocityWriter.join();
+    for ([[maybe_unused]] auto entity : entities)
+        assert(ecs.component<test::velocity>().has_entity_record(entity) && !ecs.component<test::mass>().has_entity_record(entity));
+}
+
+#ifdef BENCHMARK_ECS
+// Spawning from several threads via async_create_entity versus per-thread command buffers.
+double benchmark_spawn(neolib::ecs::ecs_flags aFlags, std::size_t aEntityCount, bool aCommandBuffers)
+{
+    neolib::ecs::ecs ecs{ aFlags };
+    std::size_t const threadCount = 4;
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t)
+        threads.emplace_back([&]()
+        {
+            for (std::size_t i = 0; i < aEntityCount / threadCount; ++i)
+                if (aCommandBuffers)
+                    ecs.commands().create_entity(test::movingArchetype, test::position{}, test::velocity{});
+                else
+                    ecs.async_create_entity(test::movingArchetype, test::position{}, test::velocity{});
+        });
+    for (auto& thread : threads)
+        thread.join();
+    if (aCommandBuffers)
+        ecs.commit_commands();
+    else
+        ecs.commit_async_entity_creation();
+    auto const end = std::chrono::steady_clock::now();
+    assert(ecs.component<test::position>().component_data().size() == aEntityCount || ecs.chunked());
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+#endif
+
+void test_scheduler()
+{
+    neolib::ecs::ecs ecs{ test::parallel };
+    // the sleepers model blocking systems so enough threads are needed to overlap them even on a single core
+    ecs.scheduler().thread_pool().reserve(4);
+    [[maybe_unused]] auto& integrator = ecs.system<test::integrator>();
+    [[maybe_unused]] auto& damper = ecs.system<test::damper>();
+    auto& weigher = ecs.system<test::weigher>();
+    [[maybe_unused]] auto& observer = ecs.system<test::observer>();
+    assert(integrator.writes(test::position::meta::id()) && !integrator.writes(test::velocity::meta::id()));
+    assert(!observer.writes(test::position::meta::id()) && !observer.writes(test::mass::meta::id()));
+    assert(!ecs.run_threaded(integrator.id()));
+
+    std::size_t const frames = 5;
+    for (std::size_t frame = 0; frame < frames; ++frame)
+    {
+        ecs.scheduler().run_frame();
+        auto const timings = ecs.scheduler().timings();
+        assert(timings.size() == 4);
+        [[maybe_unused]] auto const& integratorTiming = timings[0];
+        [[maybe_unused]] auto const& damperTiming = timings[1];
+        [[maybe_unused]] auto const& weigherTiming = timings[2];
+        [[maybe_unused]] auto const& observerTiming = timings[3];
+        assert(integratorTiming.id == integrator.id() && observerTiming.id == observer.id());
+        assert(integratorTiming.predecessors.empty() && weigherTiming.predecessors.empty());
+        assert(damperTiming.predecessors.size() == 1 && observerTiming.predecessors.size() == 2);
+        // dependants never start before their predecessors finish
+        assert(damperTiming.start >= integratorTiming.start + integratorTiming.duration);
+        assert(observerTiming.start >= integratorTiming.start + integratorTiming.duration);
+        assert(observerTiming.start >= weigherTiming.start + weigherTiming.duration);
+        auto const criticalPath = ecs.scheduler().critical_path();
+        assert(criticalPath.size() == 2);
+        assert(ecs.scheduler().critical_path_time() >= 2 * test::integrator::duration);
+        assert(ecs.scheduler().frame_time() >= ecs.scheduler().critical_path_time());
+        std::cout << "frame " << frame << ": " << ecs.scheduler().frame_time().count() << " us (critical path " <<
+            ecs.scheduler().critical_path_time().count() << " us, serial " << 4 * std::chrono::microseconds{ test::integrator::duration }.count() << " us)" << std::endl;
+    }
+    assert(integrator.applied == frames && damper.applied == frames && weigher.applied == frames && observer.applied == frames);
+    assert(ecs.scheduler().frame_time() < 4 * test::integrator::duration);
+
+    // changing a system's declared components rebuilds the graph
+    weigher.components().insert(test::velocity::meta::id());
+    ecs.scheduler().run_frame();
+    assert(ecs.scheduler().timings()[2].predecessors.size() == 2);
+    assert(ecs.scheduler().timings()[3].predecessors.size() == 2);
+
+    // a system declaring no components may touch any so runs after all of the others
+    [[maybe_unused]] auto& opaque = ecs.system<test::opaque>();
+    ecs.scheduler().run_frame();
+    [[maybe_unused]] auto const timings = ecs.scheduler().timings();
+    assert(timings.size() == 5 && timings[4].id == opaque.id() && timings[4].predecessors.size() == 4);
+    assert(timings[4].start >= timings[3].start + timings[3].duration);
+    assert(opaque.applied == 1u);
+
+    // the systems run on the ecs's thread pool and starting a frame does not wait for it
+    assert(&ecs.scheduler().thread_pool() == &ecs.thread_pool());
+    assert(ecs.scheduler().start_frame());
+    assert(ecs.scheduler().frame_running() && !ecs.scheduler().start_frame());
+    ecs.scheduler().finish_frame();
+    assert(!ecs.scheduler().frame_running() && opaque.applied == 2u);
+
+    // a system sharing the pool can still parallel_apply on it
+    std::vector<int> values(1000, 1);
+    ecs.thread_pool().run([&]() { neolib::parallel_apply(ecs.thread_pool(), values, [](int& aValue) { ++aValue; }); }).first.wait();
+    assert(std::all_of(values.begin(), values.end(), [](int aValue) { return aValue == 2; }));
+}
+
+#ifdef BENCHMARK_ECS
+// Iteration over sparse storage (reverse index lookups) versus archetype chunks; only meaningful in an optimized build.
+double benchmark(neolib::ecs::ecs_flags aFlags, std::size_t aEntityCount, std::size_t aIterations, bool aByChunk)
+{
+    neolib::ecs::ecs ecs{ aFlags };
+    std::mt19937 rng{ 42u };
+    std::vector<neolib::ecs::entity_id> entities;
+    for (std::size_t i = 0; i < aEntityCount; ++i)
+        entities.push_back(ecs.create_entity(test::movingArchetype, test::position{ { static_cast<float>(i), 0.0f, 0.0f } }));
+    // churn: components arrive in a different order to the entities, as they do in a running simulation
+    std::shuffle(entities.begin(), entities.end(), rng);
+    for (auto entity : entities)
+        ecs.populate(entity, test::velocity{ { 1.0f, 2.0f, 3.0f } });
+    for (std::size_t i = 0; i < entities.size(); i += 4)
+        ecs.populate(entities[i], test::mass{ 1.0f });
+
+    auto const start = std::chrono::steady_clock::now();
+    for (std::size_t iteration = 0; iteration < aIterations; ++iteration)
+    {
+        if (aByChunk)
+            ecs.for_each_chunk<test::position, test::velocity>([](std::size_t aCount, const neolib::ecs::entity_id*, test::position* aPosition, test::velocity* aVelocity)
+            {
+                for (std::size_t row = 0; row < aCount; ++row)
+                    aPosition[row].value += aVelocity[row].value * 0.01f;
+            });
+        else
+            ecs.for_each<test::position, test::velocity>([](neolib::ecs::entity_id, test::position& aPosition, test::velocity& aVelocity)
+            {
+                aPosition.value += aVelocity.value * 0.01f;
+            });
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+#endif
+
+template<> neolib::i_async_task& neolib::services::start_service<neolib::i_async_task>()
+{
+    static neolib::async_task sMainTask{ "ECS" };
+    return sMainTask;
+}
+
+int main()
+{
+    neolib::services::allocate_service_provider();
+    neolib::async_event_queue::instance(neolib::service<neolib::i_async_task>());
+
+    test_storage(test::sparse);
+    test_storage(test::chunked);
+    test_view(test::sparse);
+    test_view(test::chunked);
+    test_commands(test::sparse | neolib::ecs::ecs_flags::PopulateEntityInfo);
+    test_commands(test::chunked | neolib::ecs::ecs_flags::PopulateEntityInfo);
+    test_dead_entity_commands(test::sparse);
+    test_dead_entity_commands(test::chunked);
+    test_generations(test::sparse);
+    test_generations(test::chunked);
+    test_command_churn(test::sparse);
+    test_command_churn(test::chunked);
+    test_structural_locking();
+    test_scheduler();
+
+#ifdef BENCHMARK_ECS
+    std::size_t const entityCount = 200000;
+    std::size_t const iterations = 100;
+    std::cout << "position += velocity, " << entityCount << " entities x " << iterations << " iterations" << std::endl;
+    std::cout << "sparse (reverse index lookups):  " << benchmark(test::sparse, entityCount, iterations, false) << " ms" << std::endl;
+    std::cout << "archetype chunks (for_each):     " << benchmark(test::chunked, entityCount, iterations, false) << " ms" << std::endl;
+    std::cout << "archetype chunks (for_each_chunk): " << benchmark(test::chunked, entityCount, iterations, true) << " ms" << std::endl;
+
+    std::size_t const spawnCount = 100000;
+    std::cout << "spawn " << spawnCount << " entities from 4 threads" << std::endl;
+    std::cout << "async_create_entity:             " << benchmark_spawn(test::sparse | neolib::ecs::ecs_flags::PopulateEntityInfo, spawnCount, false) << " ms" << std::endl;
+    std::cout << "command buffers:                 " << benchmark_spawn(test::sparse | neolib::ecs::ecs_flags::PopulateEntityInfo, spawnCount, true) << " ms" << std::endl;
+    std::cout << "command buffers (chunked):       " << benchmark_spawn(test::chunked | neolib::ecs::ecs_flags::PopulateEntityInfo, spawnCount, true) << " ms" << std::endl;
+#endif
+}
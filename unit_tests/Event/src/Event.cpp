@@ -1,3 +1,6 @@
+#include <thread>
+#include <algorithm>
+#include <cassert>
 #include <neolib/task/event.hpp>
 #include <neolib/task/async_thread.hpp>
 
@@ -48,6 +51,90 @@ public:
 	}
 };
 
+void test_cross_thread(neolib::i_task& aMainTask)
+{
+	int const kTriggers = 10000;
+	counter c;
+	int received = 0;
+	int statelessCalls = 0;
+	neolib::sink s;
+	s += c.new_integer([&](int) { ++received; });
+	s += !c.new_integer([&](int) { ++statelessCalls; });
+	std::thread producer{ [&]()
+	{
+		neolib::async_task producerTask;
+		neolib::async_thread producerThread{ producerTask, "neolib::event producer", true };
+		c.count(kTriggers);
+	} };
+	while (received < kTriggers)
+		aMainTask.do_work(neolib::yield_type::Sleep);
+	producer.join();
+	assert(statelessCalls >= 1 && statelessCalls <= kTriggers);
+
+	// a stateless handler is queued at most once until it has been called
+	statelessCalls = 0;
+	for (int i = 0; i < 100; ++i)
+		c.new_integer.async_trigger(i);
+	while (aMainTask.do_work())
+		;
+	assert(statelessCalls == 1);
+	c.new_integer.async_trigger(0);
+	while (aMainTask.do_work())
+		;
+	assert(statelessCalls == 2);
+}
+
+class triggering_filter : public neolib::i_event_filter
+{
+public:
+	triggering_filter(neolib::event<int> const& aOther) : iOther{ aOther }
+	{
+	}
+public:
+	void pre_filter_event(const neolib::i_event&) override
+	{
+	}
+	void filter_event(const neolib::i_event&) override
+	{
+		thread_local bool tFiltering = false;
+		if (tFiltering)
+			return;
+		tFiltering = true;
+		iOther.trigger(0);
+		tFiltering = false;
+	}
+private:
+	neolib::event<int> const& iOther;
+};
+
+void test_cross_triggering_filters()
+{
+	// filters that trigger each other's events from two threads must not deadlock on the events' mutex stripes
+	int const kTriggers = 10000;
+	neolib::event<int> events[8];
+	auto& a = events[0];
+	auto& b = *std::find_if(std::begin(events) + 1, std::end(events), [&](neolib::event<int> const& e)
+		{ return &neolib::event_mutex(e) != &neolib::event_mutex(a); });
+	triggering_filter filterA{ b };
+	triggering_filter filterB{ a };
+	auto& registry = neolib::async_event_queue::instance().filter_registry();
+	registry.install_event_filter(filterA, a);
+	registry.install_event_filter(filterB, b);
+	auto const trigger = [&](neolib::event<int> const& aEvent, char const* aName)
+	{
+		neolib::async_task task;
+		neolib::async_thread thread{ task, aName, true };
+		for (int i = 0; i < kTriggers; ++i)
+			aEvent.trigger(i);
+	};
+	std::thread first{ trigger, std::cref(a), "neolib::event filter A" };
+	std::thread second{ trigger, std::cref(b), "neolib::event filter B" };
+	first.join();
+	second.join();
+	registry.uninstall_event_filter(filterA, a);
+	registry.uninstall_event_filter(filterB, b);
+}
+
 int main()
 {
 	neolib::async_task mainTask;
@@ -70,4 +157,7 @@ int main()
 		}
 		c.count(10); // should only print "not in sink"
 	}
+
+	test_cross_thread(mainTask);
+	test_cross_triggering_filters();
 }
\ No newline at end of file
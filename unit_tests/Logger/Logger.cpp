@@ -1,5 +1,7 @@
 #include <thread>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <neolib/app/ostream_logger.hpp>
 
 namespace neolog = neolib::logger;
@@ -19,6 +21,11 @@ const neolog::category Blue{ category::Blue };
 const neolog::category Black{ category::Black };
 const neolog::category White{ category::White };
 
+int unexpected_evaluation()
+{
+    throw std::logic_error("deferred log argument evaluated for a filtered message");
+}
+
 void output_log_messages(neolog::i_logger& logger0, neolog::i_logger& logger1)
 {
     for (int i = 0; i < 1000; ++i)
@@ -30,11 +37,147 @@ void output_log_messages(neolog::i_logger& logger0, neolog::i_logger& logger1)
         logger0 << White << neolog::severity::Info << "[tid: " << std::this_thread::get_id() << "] [" << std::hex << "0x" << i << "] (White) Info message 3" << neolog::endl;
 
         logger1 << neolog::severity::Info << "LOGGER1 MESSAGE" << neolog::flush;
+
+        deferred_log_category(logger0, neolog::severity::Info, category::Red, "[{}] (Red) Deferred info message {} {}", i, "4", 4.5);
+        deferred_log_category(logger0, neolog::severity::Info, category::White, "(White) Deferred info message {}", unexpected_evaluation());
+        deferred_log(logger1, neolog::severity::Debug, "LOGGER1 DEFERRED DEBUG MESSAGE {}", unexpected_evaluation());
     }
 }
 
+void test_alternating_loggers()
+{
+    // one thread alternating between loggers of the same instance (as happens with copy_to) keeps a buffer for each
+    std::ostringstream stream0;
+    std::ostringstream stream1;
+    {
+        neolog::ostream_logger<2> logger0{ stream0 };
+        neolog::ostream_logger<2> logger1{ stream1 };
+        for (int i = 0; i < 5000; ++i)
+        {
+            logger0 << neolog::severity::Info << "A" << i << neolog::endl;
+            logger1 << neolog::severity::Info << "B" << i << neolog::endl;
+        }
+    }
+    std::istringstream lines0{ stream0.str() };
+    std::istringstream lines1{ stream1.str() };
+    std::string line;
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (!std::getline(lines0, line) || line != "A" + std::to_string(i))
+            throw std::logic_error("test_alternating_loggers: logger0 lost or reordered a message");
+        if (!std::getline(lines1, line) || line != "B" + std::to_string(i))
+            throw std::logic_error("test_alternating_loggers: logger1 lost or reordered a message");
+    }
+}
+
+void test_would_log_with_copies()
+{
+    // a message filtered by a logger is still logged if one of its copies would log it, otherwise its arguments are not evaluated
+    std::ostringstream stream0;
+    std::ostringstream stream1;
+    {
+        neolog::ostream_logger<3> logger0{ stream0 };
+        neolog::ostream_logger<3> logger1{ stream1 };
+        logger0.set_filter_severity(neolog::severity::Info);
+        logger1.set_filter_severity(neolog::severity::Warning);
+        logger0.copy_to(logger1);
+        if (logger0.would_log(neolog::severity::Debug, neolog::category_id{}))
+            throw std::logic_error("test_would_log_with_copies: would_log true for a message no logger accepts");
+        deferred_log(logger0, neolog::severity::Debug, "filtered {}", unexpected_evaluation());
+        logger1.set_filter_severity(neolog::severity::Debug);
+        if (!logger0.would_log(neolog::severity::Debug, neolog::category_id{}))
+            throw std::logic_error("test_would_log_with_copies: would_log false for a message a copy accepts");
+        deferred_log(logger0, neolog::severity::Debug, "copied {}", 42);
+        logger0.cancel_copy_to(logger1);
+    }
+    if (!stream0.str().empty() || stream1.str() != "copied 42\n")
+        throw std::logic_error("test_would_log_with_copies: unexpected output");
+}
+
+void test_formatter_caller_context()
+{
+    // the formatter runs on the thread that logged the message and sees that message's line id
+    std::ostringstream stream;
+    std::thread::id clientThread;
+    bool wrongThread = false;
+    {
+        neolog::ostream_logger<4> logger{ stream };
+        logger.create_logging_thread();
+        neolog::formatter formatter{ [&](neolog::i_logger const& aLogger, neolib::i_string const& aUnformattedMessage, neolib::i_string& aFormattedMessage)
+        {
+            if (std::this_thread::get_id() != clientThread)
+                wrongThread = true;
+            aFormattedMessage = std::to_string(aLogger.line_id()) + ":" + std::string{ aUnformattedMessage.to_std_string_view() };
+        } };
+        logger.set_formatter(formatter);
+        std::thread client{ [&]()
+        {
+            clientThread = std::this_thread::get_id();
+            for (int i = 0; i < 3; ++i)
+                logger << neolog::severity::Info << "M" << i << neolog::endl;
+            deferred_log(logger, neolog::severity::Info, "D{}", 3);
+        } };
+        client.join();
+        logger.wait();
+    }
+    if (wrongThread)
+        throw std::logic_error("test_formatter_caller_context: formatter not called on the client thread");
+    auto const first = neolog::DefaultInitialLineId;
+    std::ostringstream expected;
+    for (int i = 0; i < 4; ++i)
+        expected << (first + i) << ":" << (i < 3 ? "M" : "D") << i << "\n";
+    if (stream.str() != expected.str())
+        throw std::logic_error("test_formatter_caller_context: unexpected output");
+}
+
+void log_round_trip_messages(neolog::i_logger& aLogger)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        deferred_log(aLogger, neolog::severity::Info, "[{}] ints {} {} {}, {{braces}}", i, static_cast<int8_t>(-8), 16u, -64ll);
+        deferred_log(aLogger, neolog::severity::Warning, "reals {} {}, char {}, bool {}", 1.5f, -0.25, 'x', i == 1);
+        aLogger << neolog::severity::Info << "text " << i << neolog::endl;
+        deferred_log(aLogger, neolog::severity::Error, "strings '{}' '{}' '{}' {}", std::string{ "std" }, std::string_view{ "view" }, "literal", category::Blue);
+    }
+}
+
+void test_binary_round_trip()
+{
+    // binary output decoded without the format sites (as another process would) matches text output
+    std::ostringstream text;
+    std::ostringstream binary;
+    {
+        neolog::ostream_logger<5> textLogger{ text };
+        log_round_trip_messages(textLogger);
+    }
+    {
+        neolog::ostream_logger<6> binaryLogger{ binary };
+        binaryLogger.set_binary_output(true);
+        log_round_trip_messages(binaryLogger);
+    }
+    std::string const records = binary.str();
+    std::string decoded;
+    neolog::deferred_log_decoder decoder;
+    // feed the records in small pieces to exercise partial records
+    std::size_t pending = 0u;
+    for (std::size_t end = 0u; end < records.size();)
+    {
+        end = std::min(end + 7u, records.size());
+        pending += decoder.decode(std::string_view{ records }.substr(pending, end - pending), decoded);
+    }
+    if (pending != records.size() || decoded != text.str())
+        throw std::logic_error("test_binary_round_trip: decoded binary output differs from text output");
+    if (text.str().find("[1] ints -8 16 -64, {braces}\nreals 1.5 -0.25, char x, bool true\ntext 1\nstrings 'std' 'view' 'literal' 2\n") == std::string::npos)
+        throw std::logic_error("test_binary_round_trip: unexpected text output");
+}
+
 int main()
 {
+    test_alternating_loggers();
+    test_would_log_with_copies();
+    test_formatter_caller_context();
+    test_binary_round_trip();
+
     try
     {
         neolog::ostream_logger<0> logger0{ std::cout };
@@ -1,8 +1,11 @@
 ﻿#include <neolib/neolib.hpp>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <limits>
 #include <numeric>
 #include <neolib/file/json.hpp>
+#include <neolib/file/json_stream.hpp>
 #include <chrono>
 
 #ifdef COMPARE_NOFUSSJSON_WITH_RAPIDJSON
@@ -12,6 +15,85 @@
 using namespace rapidjson;
 #endif
 
+template <typename Parser>
+struct stream_event_recorder
+{
+    std::string events;
+    void start_object() { events += "{ "; }
+    void end_object() { events += "} "; }
+    void start_array() { events += "[ "; }
+    void end_array() { events += "] "; }
+    void key(std::string_view const& aKey) { events += "key:"; events += aKey; events += ' '; }
+    void value(typename Parser::scalar const& aValue) { events += neolib::to_string(aValue.type); events += ':'; events += aValue.text; events += ' '; }
+};
+
+template <typename Parser>
+std::string stream_events(std::string const& aInput, std::size_t aChunkSize)
+{
+    Parser parser;
+    stream_event_recorder<Parser> recorder;
+    for (std::size_t i = 0; i < aInput.size() && parser.parse(std::string_view{ aInput }.substr(i, aChunkSize), recorder); i += aChunkSize)
+        ;
+    if (!parser.has_error())
+        parser.finish(recorder);
+    if (parser.has_error())
+        recorder.events += "error: " + parser.error_text();
+    return recorder.events;
+}
+
+// every chunk size is tried so that strings, escapes, numbers, keywords and comments straddle chunk boundaries
+template <typename Parser>
+void test_stream_events(std::string const& aInput, std::string const& aExpectedEvents)
+{
+    for (std::size_t chunkSize = 1; chunkSize <= aInput.size(); ++chunkSize)
+    {
+        auto const events = stream_events<Parser>(aInput, chunkSize);
+        if (events != aExpectedEvents)
+        {
+            std::cerr << "JSON stream events (chunk size " << chunkSize << "):\n" << events << "\nexpected:\n" << aExpectedEvents << std::endl;
+            throw std::logic_error("JSON stream test failed");
+        }
+    }
+}
+
+#ifdef BENCHMARK_JSON_STRUCTURAL_SCANNING
+// The same DOM parse with and without bulk skipping of string bodies and whitespace runs: string-heavy documents gain
+// the most while for object-heavy documents DOM node creation and per-token state transitions (which bulk skipping 
+// can't remove) dominate.
+void benchmark_structural_scanning()
+{
+    std::string strings = "[";
+    for (int i = 0; i < 16384; ++i)
+        strings += (i ? ",\n\"" : "\"") + std::string(240, static_cast<char>('a' + i % 26)) + "\"";
+    strings += "]";
+    std::string objects = "[";
+    for (int i = 0; i < 100000; ++i)
+        objects += (i ? ",\n" : "") + std::string{ "{\"id\": " } + std::to_string(i) + ", \"name\": \"n" + std::to_string(i) + "\", \"ok\": true}";
+    objects += "]";
+    auto const best_of = [](const std::string& aText, bool aScanning)
+    {
+        neolib::json_detail::use_structural_scanning() = aScanning;
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < 5; ++run)
+        {
+            std::istringstream input{ aText };
+            auto const start = std::chrono::steady_clock::now();
+            neolib::json json{ input };
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        neolib::json_detail::use_structural_scanning() = true;
+        return best;
+    };
+    for (auto const& document : { std::make_pair("strings", &strings), std::make_pair("objects", &objects) })
+    {
+        auto const& text = *document.second;
+        auto const scanning = best_of(text, true);
+        auto const stepping = best_of(text, false);
+        std::cout << "JSON " << document.first << ": " << text.size() / (1024.0 * 1024.0) << " MiB, structural scanning " << scanning << 
+            " ms, without " << stepping << " ms (" << stepping / scanning << "x)" << std::endl;
+    }
+}
+#endif
 
 int main(int argc, char** argv)
 {
@@ -210,6 +292,127 @@ int main(int argc, char** argv)
         std::cout << std::endl;
         std::cout << "----FJSON ends-----------------------" << std::endl;
 
+        std::cout << "----Arena JSON-output---------------------" << std::endl;
+        std::istringstream arenaStream(RJSON_test);
+        neolib::arena_rjson arenaJson{ arenaStream };
+        auto const& arena = arenaJson.arena();
+        auto const parsedBytes = arena.allocated();
+        // the whole tree comes from a single block rather than an allocation per node and string
+        if (arena.blocks() != 1u || parsedBytes == 0u || parsedBytes > arena.reserved())
+            throw std::logic_error("arena JSON: tree not allocated from the document's arena");
+        std::ostringstream arenaOutput;
+        std::ostringstream heapOutput;
+        arenaJson.write(arenaOutput);
+        rjson.write(heapOutput);
+        if (arenaOutput.str() != heapOutput.str())
+            throw std::logic_error("arena JSON: tree differs from the one parsed without an arena");
+        // values and strings added to the tree come from the document's arena whichever arena (if any) is current
+        arenaJson.root().as<neolib::arena_rjson::json_object>()["arena"] = neolib::arena_rjson::json_string{ "added to the tree from the document's arena" };
+        if (arena.allocated() <= parsedBytes)
+            throw std::logic_error("arena JSON: value added to the tree not allocated from the document's arena");
+        auto const addedBytes = arena.allocated();
+        {
+            neolib::monotonic_arena otherArena;
+            {
+                neolib::monotonic_arena::scope otherScope{ otherArena };
+                arenaJson.root().as<neolib::arena_rjson::json_object>()["other"] = neolib::arena_rjson::json_string{ std::string(64, 'x').c_str() };
+            }
+            if (otherArena.allocated() != 0u || arena.allocated() <= addedBytes)
+                throw std::logic_error("arena JSON: value added within another arena's scope not allocated from the document's arena");
+        }
+        arenaJson.write(std::cout);
+        std::cout << std::endl;
+        if (arenaJson.croot().as<neolib::arena_rjson::json_object>().at("arena").text() != "added to the tree from the document's arena" ||
+            arenaJson.croot().as<neolib::arena_rjson::json_object>().at("other").text().to_std_string_view() != std::string(64, 'x'))
+            throw std::logic_error("arena JSON: added value lost");
+        arenaJson.clear();
+        // clearing the document gives back every block at once
+        if (arena.blocks() != 0u || arena.reserved() != 0u || arena.allocated() != 0u)
+            throw std::logic_error("arena JSON: arena not released by clear()");
+        {
+            // a document constructed within another arena's scope still keeps its text in its own arena
+            neolib::monotonic_arena otherArena;
+            neolib::monotonic_arena::scope otherScope{ otherArena };
+            std::istringstream scopedStream(RJSON_test);
+            neolib::arena_rjson scopedJson{ scopedStream };
+            if (otherArena.allocated() != 0u || scopedJson.arena().allocated() == 0u)
+                throw std::logic_error("arena JSON: document constructed within another arena's scope not allocated from its own arena");
+        }
+        std::cout << "----Arena JSON ends-----------------------" << std::endl;
+
+        {
+            // line and column are worked out lazily so check them after strings compacted in place and comments
+            std::istringstream positionStream{ "{\n  \"a\": \"x\\ny\\nz\",\n  /* one\ntwo */ \"b\": [ \"\\u03A9\\t\",\n    42 ]\n}" };
+            neolib::rjson positionJson{ positionStream };
+            auto const& object = positionJson.croot().as<neolib::rjson::json_object>();
+            auto const& b = object.at("b");
+            if (object.at("a").document_source_location().line != 2u || b.document_source_location().line != 4u ||
+                b.document_source_location().column != 13u || b.last_child()->document_source_location().line != 5u)
+                throw std::logic_error("JSON: wrong value source location");
+            std::istringstream errorStream{ "[1,\n\"\\u03A9\",\n\"x\\ny\" err]" };
+            neolib::json errorJson;
+            if (errorJson.read(errorStream) || errorJson.error_text() != "failed to parse JSON text, line 3, col 8")
+                throw std::logic_error("JSON: wrong parse error location: " + errorJson.error_text());
+        }
+
+        const std::string JSON_lines_test =
+        {
+            "{ \"id\": 1, \"name\": \"tab\\ttab\", \"tags\": [\"a\", \"b\"] }\n"
+            "{ \"id\": 2, \"name\": \"Omega: \\u03A9\", \"score\": -42.42e-2, \"ok\": true, \"extra\": null }\n"
+            "{ \"id\": 3, \"nested\": { \"clef\": \"\\uD834\\uDD1E\" } }\n"
+        };
+        std::cout << "----JSON stream-input---------------------" << std::endl;
+        std::cout << JSON_lines_test;
+        std::cout << "----JSON stream-events--------------------" << std::endl;
+        test_stream_events<neolib::json_stream_parser>(JSON_lines_test,
+            "{ key:id Int:1 key:name String:tab\ttab key:tags [ String:a String:b ] } "
+            "{ key:id Int:2 key:name String:Omega: \u03A9 key:score Double:-42.42e-2 key:ok Bool:true key:extra Null:null } "
+            "{ key:id Int:3 key:nested { key:clef String:\U0001D11E } } ");
+        test_stream_events<neolib::json_stream_parser>("[1, 4294967295, 18446744073709551615, -1, 0.5, \"\\\"q\\\\\"]",
+            "[ Int:1 Uint:4294967295 Uint64:18446744073709551615 Int:-1 Double:0.5 String:\"q\\ ] ");
+        test_stream_events<neolib::json_stream_parser>("[1, 2", "[ Int:1 Int:2 error: line 2, col 1");
+        test_stream_events<neolib::json_stream_parser>("[1,]", "[ Int:1 error: line 1, col 4");
+        test_stream_events<neolib::json_stream_parser>("{ \"a\": \"\\uZOOL\" }", "{ key:a error: line 1, col 11");
+        test_stream_events<neolib::json_stream_parser>("[\"\\uD834x\"]", "[ error: (invalid surrogate pair) line 1, col 9");
+        test_stream_events<neolib::json_stream_parser>("[\"\\uDD1E\"]", "[ error: (invalid surrogate pair) line 1, col 8");
+        test_stream_events<neolib::json_stream_parser>("[\"\\uD834\\n\"]", "[ error: (invalid surrogate pair) line 1, col 10");
+        test_stream_events<neolib::json_stream_parser>("[\"\\uD834\\u0041\"]", "[ error: (invalid surrogate pair) line 1, col 14");
+        test_stream_events<neolib::json_stream_parser>("[\"\\uD834\"]", "[ error: (invalid surrogate pair) line 1, col 9");
+        test_stream_events<neolib::rjson_stream_parser>(RJSON_test,
+            "{ key:buy [ Keyword:milk Keyword:eggs Keyword:butter String:dog bones ] "
+            "key:quotey String:foo key:quotey String:foo key:quotey String:foo key:quotey String:foo "
+            "key:tasks [ { key:name Keyword:exercise key:completed Bool:false } { key:name Keyword:eat key:completed Bool:true } ] "
+            "key:another key String:another value } ");
+        test_stream_events<neolib::fjson_stream_parser>(FJSON_test, "{ key:default_size [ Keyword:800spx Keyword:800spx ] } ");
+        std::istringstream rjsonStreamInput(RJSON_test);
+        neolib::rjson_stream_reader rjsonStreamReader{ rjsonStreamInput, 16 };
+        neolib::rjson_stream_reader::event rjsonEvent;
+        std::vector<neolib::json_stream_event> rjsonEvents;
+        while (rjsonStreamReader.next(rjsonEvent))
+            rjsonEvents.push_back(rjsonEvent.type);
+        if (rjsonEvents.size() != 34 || rjsonEvents.front() != neolib::json_stream_event::StartObject || rjsonEvents.back() != neolib::json_stream_event::EndObject)
+            throw std::logic_error("RJSON stream reader test failed");
+        std::istringstream malformedStreamInput("{ \"a\": [1, 2 }");
+        neolib::json_stream_reader malformedStreamReader{ malformedStreamInput, 4 };
+        neolib::json_stream_reader::event malformedStreamEvent;
+        bool malformedStreamThrew = false;
+        try
+        {
+            while (malformedStreamReader.next(malformedStreamEvent))
+                ;
+        }
+        catch (neolib::json_error const&)
+        {
+            malformedStreamThrew = true;
+        }
+        if (!malformedStreamThrew)
+            throw std::logic_error("JSON stream reader accepted malformed input");
+        std::cout << "----JSON stream ends----------------------" << std::endl;
+
+#ifdef BENCHMARK_JSON_STRUCTURAL_SCANNING
+        benchmark_structural_scanning();
+#endif
+
         std::cout << "------ code ------" << std::endl;
         neolib::json json;
         json.root() = neolib::json_object{};
@@ -0,0 +1,473 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <string>
+#include <random>
+#include <functional>
+#include <cmath>
+#include <cassert>
+#include <neolib/core/simd.hpp>
+#include <neolib/core/numerical.hpp>
+#include <neolib/core/numerical_soa.hpp>
+
+namespace
+{
+    // batch sizes covering empty, single, every tail of the two/four wide kernels and a few full iterations
+    std::size_t constexpr maxBatch = 17u;
+
+    std::mt19937_64 sGenerator{ 42u };
+
+    template <typename T>
+    T random_value()
+    {
+        return std::uniform_real_distribution<T>{ static_cast<T>(-10.0), static_cast<T>(10.0) }(sGenerator);
+    }
+
+    template <typename T>
+    std::vector<T> random_values(std::size_t aCount)
+    {
+        std::vector<T> result(aCount);
+        for (auto& value : result)
+            value = random_value<T>();
+        return result;
+    }
+
+    // scalar reference: column-major, each element accumulated as ((m0 * x + m1 * y) + m2 * z) + m3 * w
+    template <typename T>
+    T reference_row(T const* aMatrix, std::size_t aRow, T aX, T aY, T aZ, T aW)
+    {
+        return ((aMatrix[aRow] * aX + aMatrix[4u + aRow] * aY) + aMatrix[8u + aRow] * aZ) + aMatrix[12u + aRow] * aW;
+    }
+
+    // results not computed in the element type may differ from the reference in the last place
+    template <typename T>
+    bool close(T aLeft, T aRight, bool aExact)
+    {
+        if (aExact)
+            return aLeft == aRight;
+        T const tolerance = std::is_same_v<T, float> ? static_cast<T>(1e-4) : static_cast<T>(1e-12);
+        return std::abs(aLeft - aRight) <= tolerance * std::max(static_cast<T>(1.0), std::max(std::abs(aLeft), std::abs(aRight)));
+    }
+
+    template <typename T>
+    void check(const std::vector<T>& aResult, const std::vector<T>& aExpected, bool aExact, const std::string& aWhat)
+    {
+        assert(aResult.size() == aExpected.size());
+        for (std::size_t i = 0u; i < aResult.size(); ++i)
+            if (!close(aResult[i], aExpected[i], aExact))
+            {
+                std::cerr << aWhat << ": element " << i << " is " << aResult[i] << ", expected " << aExpected[i] << std::endl;
+                assert(false);
+            }
+    }
+
+    struct kernels
+    {
+        std::string name;
+        bool exact;
+        std::function<void(double const*, double const*, double*)> mul;
+        std::function<void(double const*, double const*, double*)> transform4d;
+        std::function<void(double const*, double const*, double*, std::size_t, std::size_t)> transform3d;
+        std::vector<std::size_t> transform3dStrides;
+        std::function<void(double const*, double const*, double*, std::size_t, std::size_t)> transformAabb;
+        std::vector<std::size_t> transformAabbStrides;
+        std::function<void(float const*, float const*, float*, std::size_t)> transform4f;
+    };
+
+    std::vector<kernels> available_kernels()
+    {
+        std::vector<kernels> result;
+        result.push_back(kernels{ "scalar", true,
+            neolib::fake_simd_mat44_mul, neolib::fake_simd_mat44_transform_4d,
+            neolib::fake_simd_mat44_transform_3d, { 3u, 4u, 7u },
+            neolib::fake_simd_mat44_transform_aabb, { 6u, 8u },
+            neolib::fake_simd_mat44f_transform_4f });
+#if defined(USE_EMM) || defined(USE_EMM_DYNAMIC)
+        // there is no SSE2 box kernel; the scalar one is used
+        result.push_back(kernels{ "SSE2", true,
+            neolib::emm_simd_mat44_mul, neolib::emm_simd_mat44_transform_4d,
+            neolib::emm_simd_mat44_transform_3d, { 3u, 4u, 7u },
+            neolib::fake_simd_mat44_transform_aabb, { 6u, 8u },
+            neolib::emm_simd_mat44f_transform_4f });
+#endif
+#if defined(USE_AVX) || defined(USE_AVX_DYNAMIC)
+        if (neolib::avx2_supported())
+            result.push_back(kernels{ "AVX2", true,
+                neolib::avx2_simd_mat44_mul, neolib::avx2_simd_mat44_transform_4d,
+                neolib::avx2_simd_mat44_transform_3d, { 3u, 4u, 7u },
+                neolib::avx2_simd_mat44_transform_aabb, { 6u, 8u },
+                neolib::avx2_simd_mat44f_transform_4f });
+        else
+            std::cout << "AVX2 not supported: skipping AVX2 matrix kernels" << std::endl;
+        // AVX-512 has point, box and single precision kernels for the packed strides only; the 4x4 product and single vector
+        // transform stay on AVX2
+        if (neolib::avx512_supported())
+            result.push_back(kernels{ "AVX-512", true,
+                neolib::avx2_simd_mat44_mul, neolib::avx2_simd_mat44_transform_4d,
+                [](double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t)
+                {
+                    neolib::avx512_simd_mat44_transform_3d(aMatrix, aInput, aOutput, aCount);
+                }, { 3u },
+                [](double const* aMatrix, double const* aInput, double* aOutput, std::size_t aCount, std::size_t)
+                {
+                    neolib::avx512_simd_mat44_transform_aabb(aMatrix, aInput, aOutput, aCount);
+                }, { 6u },
+                neolib::avx512_simd_mat44f_transform_4f });
+        else
+            std::cout << "AVX-512 not supported: skipping AVX-512 matrix kernels" << std::endl;
+#endif
+        return result;
+    }
+}
+
+void test_mat44_kernels()
+{
+    for (auto const& k : available_kernels())
+    {
+        std::cout << "checking " << k.name << " matrix kernels" << std::endl;
+        for (int pass = 0; pass < 100; ++pass)
+        {
+            auto const left = random_values<double>(16u);
+            auto const right = random_values<double>(16u);
+            std::vector<double> expected(16u);
+            for (std::size_t column = 0u; column < 4u; ++column)
+                for (std::size_t row = 0u; row < 4u; ++row)
+                    expected[column * 4u + row] = reference_row(left.data(), row, right[column * 4u], right[column * 4u + 1u], right[column * 4u + 2u], right[column * 4u + 3u]);
+            std::vector<double> product(16u);
+            k.mul(left.data(), right.data(), product.data());
+            check(product, expected, true, k.name + " mat44 multiply");
+            // the result may alias an operand
+            auto inPlace = right;
+            k.mul(left.data(), inPlace.data(), inPlace.data());
+            check(inPlace, expected, true, k.name + " mat44 multiply in place");
+
+            auto const vector = random_values<double>(4u);
+            std::vector<double> transformed(4u);
+            std::vector<double> expectedVector(4u);
+            for (std::size_t row = 0u; row < 4u; ++row)
+                expectedVector[row] = reference_row(left.data(), row, vector[0u], vector[1u], vector[2u], vector[3u]);
+            k.transform4d(left.data(), vector.data(), transformed.data());
+            check(transformed, expectedVector, true, k.name + " mat44 vec4 transform");
+        }
+        auto const matrix = random_values<double>(16u);
+        auto const matrixf = random_values<float>(16u);
+        for (std::size_t count = 0u; count <= maxBatch; ++count)
+        {
+            for (auto const stride : k.transform3dStrides)
+            {
+                // elements past each point and past the batch must be left alone; the sentinel tail catches overruns
+                auto const input = random_values<double>(count * stride + stride);
+                auto expected = input;
+                for (std::size_t i = 0u; i < count; ++i)
+                    for (std::size_t row = 0u; row < 3u; ++row)
+                        expected[i * stride + row] = reference_row(matrix.data(), row, input[i * stride], input[i * stride + 1u], input[i * stride + 2u], 1.0);
+                auto output = input;
+                k.transform3d(matrix.data(), input.data(), output.data(), count, stride);
+                check(output, expected, k.exact, k.name + " point transform (count " + std::to_string(count) + ", stride " + std::to_string(stride) + ")");
+                auto inPlace = input;
+                k.transform3d(matrix.data(), inPlace.data(), inPlace.data(), count, stride);
+                check(inPlace, expected, k.exact, k.name + " point transform in place");
+            }
+            for (auto const stride : k.transformAabbStrides)
+            {
+                auto input = random_values<double>(count * stride + stride);
+                for (std::size_t i = 0u; i < count; ++i)
+                    for (std::size_t axis = 0u; axis < 3u; ++axis)
+                        if (input[i * stride + axis] > input[i * stride + 3u + axis])
+                            std::swap(input[i * stride + axis], input[i * stride + 3u + axis]);
+                // the bounds of the eight transformed corners
+                auto expected = input;
+                for (std::size_t i = 0u; i < count; ++i)
+                    for (std::size_t row = 0u; row < 3u; ++row)
+                    {
+                        double low = std::numeric_limits<double>::infinity();
+                        double high = -std::numeric_limits<double>::infinity();
+                        for (std::size_t corner = 0u; corner < 8u; ++corner)
+                        {
+                            double const x = input[i * stride + ((corner & 1u) ? 3u : 0u)];
+                            double const y = input[i * stride + ((corner & 2u) ? 4u : 1u)];
+                            double const z = input[i * stride + ((corner & 4u) ? 5u : 2u)];
+                            double const value = reference_row(matrix.data(), row, x, y, z, 1.0);
+                            low = std::min(low, value);
+                            high = std::max(high, value);
+                        }
+                        expected[i * stride + row] = low;
+                        expected[i * stride + 3u + row] = high;
+                    }
+                auto output = input;
+                k.transformAabb(matrix.data(), input.data(), output.data(), count, stride);
+                check(output, expected, true, k.name + " aabb transform (count " + std::to_string(count) + ", stride " + std::to_string(stride) + ")");
+                auto inPlace = input;
+                k.transformAabb(matrix.data(), inPlace.data(), inPlace.data(), count, stride);
+                check(inPlace, expected, true, k.name + " aabb transform in place");
+            }
+            auto const inputf = random_values<float>(count * 4u + 4u);
+            auto expectedf = inputf;
+            for (std::size_t i = 0u; i < count; ++i)
+                for (std::size_t row = 0u; row < 4u; ++row)
+                    expectedf[i * 4u + row] = reference_row(matrixf.data(), row, inputf[i * 4u], inputf[i * 4u + 1u], inputf[i * 4u + 2u], inputf[i * 4u + 3u]);
+            auto outputf = inputf;
+            k.transform4f(matrixf.data(), inputf.data(), outputf.data(), count);
+            check(outputf, expectedf, k.exact, k.name + " vec4f transform (count " + std::to_string(count) + ")");
+            auto inPlacef = inputf;
+            k.transform4f(matrixf.data(), inPlacef.data(), inPlacef.data(), count);
+            check(inPlacef, expectedf, k.exact, k.name + " vec4f transform in place");
+        }
+    }
+}
+
+void test_mat44_dispatch()
+{
+    using namespace neolib::math;
+    mat44 left;
+    mat44 right;
+    mat44f leftf;
+    for (uint32_t column = 0u; column < 4u; ++column)
+        for (uint32_t row = 0u; row < 4u; ++row)
+        {
+            left[column][row] = random_value<double>();
+            right[column][row] = random_value<double>();
+            leftf[column][row] = random_value<float>();
+        }
+    [[maybe_unused]] auto const product = left * right;
+    for (uint32_t column = 0u; column < 4u; ++column)
+        for (uint32_t row = 0u; row < 4u; ++row)
+            assert(product[column][row] == reference_row(left.data(), row, right[column][0u], right[column][1u], right[column][2u], right[column][3u]));
+    vec4 const v4{ random_value<double>(), random_value<double>(), random_value<double>(), random_value<double>() };
+    [[maybe_unused]] auto const transformed4 = left * v4;
+    for (uint32_t row = 0u; row < 4u; ++row)
+        assert(transformed4[row] == reference_row(left.data(), row, v4[0u], v4[1u], v4[2u], v4[3u]));
+    for (std::size_t count = 0u; count <= maxBatch; ++count)
+    {
+        std::vector<vec3> points(count);
+        for (auto& p : points)
+            p = vec3{ random_value<double>(), random_value<double>(), random_value<double>() };
+        auto const transformed = left * points;
+        assert(transformed.size() == count);
+        for (std::size_t i = 0u; i < count; ++i)
+            for (uint32_t row = 0u; row < 3u; ++row)
+                assert(close(transformed[i][row], reference_row(left.data(), row, points[i][0u], points[i][1u], points[i][2u], 1.0), true));
+        std::vector<vec4f> vectors(count);
+        for (auto& v : vectors)
+            v = vec4f{ random_value<float>(), random_value<float>(), random_value<float>(), random_value<float>() };
+        auto const transformedf = leftf * vectors;
+        assert(transformedf.size() == count);
+        for (std::size_t i = 0u; i < count; ++i)
+            for (uint32_t row = 0u; row < 4u; ++row)
+                assert(close(transformedf[i][row], reference_row(leftf.data(), row, vectors[i][0u], vectors[i][1u], vectors[i][2u], vectors[i][3u]), true));
+        std::vector<aabb> boxes(count);
+        for (auto& box : boxes)
+        {
+            vec3 const a{ random_value<double>(), random_value<double>(), random_value<double>() };
+            vec3 const b{ random_value<double>(), random_value<double>(), random_value<double>() };
+            box = aabb{ a.min(b), a.max(b) };
+        }
+        auto const transformedBoxes = aabb_transform(boxes, left);
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+            assert(transformedBoxes[i] == aabb_transform(boxes[i], left));
+            for (uint32_t row = 0u; row < 3u; ++row)
+                for (uint32_t corner = 0u; corner < 8u; ++corner)
+                {
+                    [[maybe_unused]] double const value = reference_row(left.data(), row,
+                        (corner & 1u) ? boxes[i].max.x : boxes[i].min.x, (corner & 2u) ? boxes[i].max.y : boxes[i].min.y, (corner & 4u) ? boxes[i].max.z : boxes[i].min.z, 1.0);
+                    assert(transformedBoxes[i].min[row] <= value && value <= transformedBoxes[i].max[row]);
+                }
+        }
+    }
+}
+
+namespace
+{
+    // sizes covering empty, single, the scalar tail of one AVX2 register and several registers plus a tail
+    std::array<std::size_t, 5> constexpr soaSizes = { 0u, 1u, 3u, 7u, 17u };
+
+    template <typename T, uint32_t Size>
+    std::vector<neolib::math::basic_vector<T, Size, neolib::math::column_vector>> random_vectors(std::size_t aCount)
+    {
+        std::vector<neolib::math::basic_vector<T, Size, neolib::math::column_vector>> result(aCount);
+        for (auto& v : result)
+            for (uint32_t component = 0u; component < Size; ++component)
+                v[component] = random_value<T>();
+        return result;
+    }
+
+    template <typename T, uint32_t Size>
+    void check_vectors(const neolib::math::basic_vector_soa<T, Size>& aResult, const std::vector<neolib::math::basic_vector<T, Size, neolib::math::column_vector>>& aExpected, bool aExact, const std::string& aWhat)
+    {
+        assert(aResult.size() == aExpected.size());
+        for (std::size_t i = 0u; i < aExpected.size(); ++i)
+            for (uint32_t component = 0u; component < Size; ++component)
+                if (!close(aResult[i][component], aExpected[i][component], aExact))
+                {
+                    std::cerr << aWhat << ": vector " << i << " component " << component << " is " << aResult[i][component] << ", expected " << aExpected[i][component] << std::endl;
+                    assert(false);
+                }
+    }
+}
+
+// the structure-of-arrays operations must agree with the array-of-structs basic_vector operations they replace
+template <typename T>
+void test_soa_against_aos()
+{
+    using namespace neolib::math;
+    typedef basic_vector<T, 2u, column_vector> vec2_type;
+    typedef basic_vector<T, 3u, column_vector> vec3_type;
+    // double and float basic_vector arithmetic is done in the element type apart from lerp and the mat44f transform (which work
+    // in double) and the Bezier curve (which uses std::pow)
+    bool constexpr isDouble = std::is_same_v<T, double>;
+    bool constexpr exactTransform = isDouble;
+    basic_matrix<T, 4u, 4u> transformation;
+    for (uint32_t column = 0u; column < 4u; ++column)
+        for (uint32_t row = 0u; row < 4u; ++row)
+            transformation[column][row] = column == 3u && row == 3u ? static_cast<T>(1.0) : random_value<T>();
+    for (auto const count : soaSizes)
+    {
+        std::string const what = std::string{ isDouble ? "double" : "float" } + " SoA (count " + std::to_string(count) + ") ";
+        auto const left = random_vectors<T, 3u>(count);
+        auto const right = random_vectors<T, 3u>(count);
+        basic_vector_soa<T, 3u> const leftSoa{ left };
+        basic_vector_soa<T, 3u> const rightSoa{ right };
+        assert(leftSoa.size() == count && leftSoa.to_aos() == left);
+
+        // (mat44f * vec3f goes through simd_fma_4d whose AVX version needs an AVX enabled build so its arithmetic is spelled out)
+        std::vector<vec3_type> expected;
+        for (auto const& v : left)
+        {
+            if constexpr (isDouble)
+                expected.push_back(transformation * v);
+            else
+            {
+                mat44 const m = transformation.template as<scalar>();
+                expected.push_back(vec3_type{
+                    static_cast<T>(reference_row<scalar>(m.data(), 0u, v[0u], v[1u], v[2u], 1.0)),
+                    static_cast<T>(reference_row<scalar>(m.data(), 1u, v[0u], v[1u], v[2u], 1.0)),
+                    static_cast<T>(reference_row<scalar>(m.data(), 2u, v[0u], v[1u], v[2u], 1.0)) });
+            }
+        }
+        check_vectors(transformation * leftSoa, expected, exactTransform, what + "transform");
+        auto inPlace = leftSoa;
+        batch_transform(transformation, inPlace, inPlace);
+        check_vectors(inPlace, expected, exactTransform, what + "transform in place");
+
+        auto const dots = dot(leftSoa, rightSoa);
+        assert(dots.size() == count);
+        for (std::size_t i = 0u; i < count; ++i)
+            assert(close(dots[i], left[i].dot(right[i]), true));
+
+        expected.clear();
+        for (std::size_t i = 0u; i < count; ++i)
+            expected.push_back(left[i].cross(right[i]));
+        check_vectors(cross(leftSoa, rightSoa), expected, true, what + "cross");
+
+        expected.clear();
+        for (auto const& v : left)
+            expected.push_back(v.normalized());
+        check_vectors(normalized(leftSoa), expected, true, what + "normalized");
+        auto normalizedInPlace = leftSoa;
+        normalize(normalizedInPlace);
+        check_vectors(normalizedInPlace, expected, true, what + "normalize");
+
+        T const amount = static_cast<T>(0.375);
+        expected.clear();
+        for (std::size_t i = 0u; i < count; ++i)
+            expected.push_back(lerp(left[i], right[i], amount));
+        check_vectors(lerp(leftSoa, rightSoa, amount), expected, isDouble, what + "lerp");
+
+        vec2_type const p0{ random_value<T>(), random_value<T>() };
+        vec2_type const p1{ random_value<T>(), random_value<T>() };
+        vec2_type const p2{ random_value<T>(), random_value<T>() };
+        vec2_type const p3{ random_value<T>(), random_value<T>() };
+        std::vector<T> parameters(count);
+        for (std::size_t i = 0u; i < count; ++i)
+            parameters[i] = static_cast<T>(i) / static_cast<T>(count);
+        std::vector<vec2_type> expectedCurve;
+        for (auto const t : parameters)
+            expectedCurve.push_back(bezier_cubic(p0.template as<scalar>(), p1.template as<scalar>(), p2.template as<scalar>(), p3.template as<scalar>(), static_cast<scalar>(t)).template as<T>());
+        check_vectors(bezier_cubic(p0, p1, p2, p3, parameters), expectedCurve, false, what + "bezier_cubic");
+
+        vertices leftVertices;
+        for (auto const& v : left)
+            leftVertices.push_back(v.template as<scalar>());
+        [[maybe_unused]] mat44 const transformationAsScalar = transformation.template as<scalar>();
+        assert(to_aabb(leftSoa) == to_aabb(leftVertices));
+        assert(to_aabb(leftSoa, transformationAsScalar) == to_aabb(leftVertices, transformationAsScalar));
+        std::vector<vec2_type> left2d;
+        for (auto const& v : left)
+            left2d.push_back(vec2_type{ v[0u], v[1u] });
+        assert(to_aabb_2d(basic_vector_soa<T, 2u>{ left2d }) == to_aabb_2d(leftVertices));
+    }
+}
+
+// the AVX2 structure-of-arrays kernels must produce exactly what the scalar kernels do, over every head and tail split
+template <typename T>
+void test_soa_kernels()
+{
+#if defined(NEOLIB_AVX2_TARGET)
+    using namespace neolib::math::detail;
+    if (!neolib::avx2_supported())
+    {
+        std::cout << "AVX2 not supported: skipping AVX2 SoA kernels" << std::endl;
+        return;
+    }
+    std::size_t constexpr count = 17u;
+    auto const matrix = random_values<T>(16u);
+    std::array<std::vector<T>, 3> left = { random_values<T>(count), random_values<T>(count), random_values<T>(count) };
+    std::array<std::vector<T>, 3> right = { random_values<T>(count), random_values<T>(count), random_values<T>(count) };
+    std::array<T const*, 3> const leftData = { left[0u].data(), left[1u].data(), left[2u].data() };
+    std::array<T const*, 3> const rightData = { right[0u].data(), right[1u].data(), right[2u].data() };
+    auto const run = [&](auto aKernel, std::size_t aBegin, std::size_t aEnd)
+    {
+        std::array<std::vector<T>, 3> output = { random_values<T>(count), random_values<T>(count), random_values<T>(count) };
+        std::vector<T> scalarOutput = random_values<T>(count);
+        std::array<T*, 3> const outputData = { output[0u].data(), output[1u].data(), output[2u].data() };
+        aKernel(outputData, scalarOutput.data(), aBegin, aEnd);
+        return std::make_pair(output, scalarOutput);
+    };
+    for (std::size_t begin = 0u; begin <= count; ++begin)
+        for (std::size_t end = begin; end <= count; ++end)
+        {
+            auto const compare = [&](auto aScalar, auto aSimd)
+            {
+                std::mt19937_64 const state = sGenerator;
+                auto const expected = run(aScalar, begin, end);
+                sGenerator = state;
+                auto const result = run(aSimd, begin, end);
+                assert(result == expected);
+            };
+            compare([&](auto aOutput, T*, std::size_t aBegin, std::size_t aEnd) { fake_soa_transform_3(matrix.data(), leftData, aOutput, aBegin, aEnd); },
+                [&](auto aOutput, T*, std::size_t aBegin, std::size_t aEnd) { avx2_soa_transform_3(matrix.data(), leftData, aOutput, aBegin, aEnd); });
+            compare([&](auto, T* aOutput, std::size_t aBegin, std::size_t aEnd) { fake_soa_dot<T, 3u>(leftData, rightData, aOutput, aBegin, aEnd); },
+                [&](auto, T* aOutput, std::size_t aBegin, std::size_t aEnd) { avx2_soa_dot<T, 3u>(leftData, rightData, aOutput, aBegin, aEnd); });
+            compare([&](auto aOutput, T*, std::size_t aBegin, std::size_t aEnd) { fake_soa_cross(leftData, rightData, aOutput, aBegin, aEnd); },
+                [&](auto aOutput, T*, std::size_t aBegin, std::size_t aEnd) { avx2_soa_cross(leftData, rightData, aOutput, aBegin, aEnd); });
+            compare([&](auto aOutput, T*, std::size_t aBegin, std::size_t aEnd) { fake_soa_normalize<T, 3u>(leftData, aOutput, aBegin, aEnd); },
+                [&](auto aOutput, T*, std::size_t aBegin, std::size_t aEnd) { avx2_soa_normalize<T, 3u>(leftData, aOutput, aBegin, aEnd); });
+            compare([&](auto, T* aOutput, std::size_t aBegin, std::size_t aEnd) { fake_soa_lerp(leftData[0u], rightData[0u], static_cast<T>(0.375), aOutput, aBegin, aEnd); },
+                [&](auto, T* aOutput, std::size_t aBegin, std::size_t aEnd) { avx2_soa_lerp(leftData[0u], rightData[0u], static_cast<T>(0.375), aOutput, aBegin, aEnd); });
+            compare([&](auto, T* aOutput, std::size_t aBegin, std::size_t aEnd) { fake_soa_bezier_cubic(matrix[0u], matrix[1u], matrix[2u], matrix[3u], leftData[0u], aOutput, aBegin, aEnd); },
+                [&](auto, T* aOutput, std::size_t aBegin, std::size_t aEnd) { avx2_soa_bezier_cubic(matrix[0u], matrix[1u], matrix[2u], matrix[3u], leftData[0u], aOutput, aBegin, aEnd); });
+            if (begin < end)
+            {
+                T expectedMin = left[0u][begin];
+                T expectedMax = expectedMin;
+                fake_soa_min_max(leftData[0u], expectedMin, expectedMax, begin + 1u, end);
+                T min = left[0u][begin];
+                T max = min;
+                avx2_soa_min_max(leftData[0u], min, max, begin + 1u, end);
+                assert(min == expectedMin && max == expectedMax);
+            }
+        }
+#endif
+}
+
+int main()
+{
+    test_mat44_kernels();
+    test_mat44_dispatch();
+    test_soa_against_aos<double>();
+    test_soa_against_aos<float>();
+    test_soa_kernels<double>();
+    test_soa_kernels<float>();
+    std::cout << "numerical tests passed" << std::endl;
+}
@@ -0,0 +1,265 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <bit>
+#include <neolib/core/simd.hpp>
+#include <neolib/core/random.hpp>
+
+namespace
+{
+    // reference xoshiro256** (one stream) to check the lanes against
+    struct reference_xoshiro256ss
+    {
+        uint64_t s[4];
+        uint64_t operator()()
+        {
+            uint64_t const result = std::rotl(s[1] * 5u, 7) * 9u;
+            uint64_t const t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = std::rotl(s[3], 45);
+            return result;
+        }
+    };
+}
+
+void test_xoshiro256ss_kernels()
+{
+    std::size_t constexpr lanes = neolib::simd_xoshiro256ss_lanes;
+    std::array<uint64_t, lanes * 4u> state;
+    std::mt19937_64 seeder{ 42u };
+    for (auto& word : state)
+        word = seeder();
+    auto const initialState = state;
+    auto fakeState = state;
+    std::vector<uint64_t> simdOutput(lanes * 1000u);
+    std::vector<uint64_t> fakeOutput(lanes * 1000u);
+    neolib::simd_xoshiro256ss(state.data(), simdOutput.data(), 1000u);
+    neolib::fake_simd_xoshiro256ss(fakeState.data(), fakeOutput.data(), 1000u);
+    assert(simdOutput == fakeOutput);
+    assert(state == fakeState);
+    for (std::size_t lane = 0u; lane < lanes; ++lane)
+    {
+        [[maybe_unused]] reference_xoshiro256ss reference;
+        for (std::size_t word = 0u; word < 4u; ++word)
+            reference.s[word] = initialState[word * lanes + lane];
+        for (std::size_t step = 0u; step < 1000u; ++step)
+            assert(reference() == fakeOutput[step * lanes + lane]);
+    }
+}
+
+void test_engine_sequence()
+{
+    neolib::simd_xoshiro256ss_engine engine1{ 12345u };
+    neolib::simd_xoshiro256ss_engine engine2{ 12345u };
+    std::vector<uint64_t> bulk(1003u);
+    engine1.fill(std::span<uint64_t>{ bulk.data(), 5u });
+    engine1.fill(std::span<uint64_t>{ bulk.data() + 5u, 998u });
+    for ([[maybe_unused]] auto const& value : bulk)
+        assert(engine2() == value);
+    for (int i = 0; i < 1000; ++i)
+        assert(engine1() == engine2());
+    engine1.seed(1u);
+    engine2.seed(2u);
+    assert(engine1() != engine2());
+    // odd-sized 32-bit fills carry the unused lower half to the next fill
+    engine1.seed(3u);
+    engine2.seed(3u);
+    std::vector<uint32_t> halves(1003u);
+    engine1.fill(std::span<uint32_t>{ halves.data(), 5u });
+    engine1.fill(std::span<uint32_t>{ halves.data() + 5u, 1u });
+    engine1.fill(std::span<uint32_t>{ halves.data() + 6u, 997u });
+    for (std::size_t i = 0u; i < halves.size(); i += 2u)
+    {
+        [[maybe_unused]] auto const value = engine2();
+        assert(halves[i] == static_cast<uint32_t>(value >> 32));
+        assert(i + 1u == halves.size() || halves[i + 1u] == static_cast<uint32_t>(value));
+    }
+}
+
+void test_statistics()
+{
+    neolib::simd_xoshiro256ss_engine engine{ 777u };
+    std::size_t constexpr count = 1u << 22;
+
+    // bit balance
+    std::vector<uint64_t> raw(count);
+    engine.fill(raw);
+    std::array<std::size_t, 64> ones = {};
+    for (auto const& value : raw)
+        for (std::size_t bit = 0u; bit < 64u; ++bit)
+            ones[bit] += (value >> bit) & 1u;
+    for ([[maybe_unused]] auto const& n : ones)
+        assert(std::abs(static_cast<double>(n) - count / 2.0) < 6.0 * std::sqrt(count / 4.0));
+
+    // chi-squared of bounded integers with a bound that is not a power of two
+    uint32_t constexpr buckets = 1000u;
+    std::vector<uint32_t> bounded(count);
+    engine.fill_bounded(bounded, buckets);
+    std::vector<std::size_t> histogram(buckets);
+    for (auto const& value : bounded)
+    {
+        assert(value < buckets);
+        ++histogram[value];
+    }
+    double const expected = static_cast<double>(count) / buckets;
+    double chiSquared = 0.0;
+    for (auto const& n : histogram)
+        chiSquared += (n - expected) * (n - expected) / expected;
+    // mean (buckets - 1), standard deviation sqrt(2 * (buckets - 1))
+    std::cout << "bounded chi-squared (999 degrees of freedom): " << chiSquared << std::endl;
+    assert(std::abs(chiSquared - (buckets - 1u)) < 6.0 * std::sqrt(2.0 * (buckets - 1u)));
+
+    // uniform doubles: range, mean, variance and lag-1 serial correlation
+    std::vector<double> uniform(count);
+    engine.fill_uniform(uniform);
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    double sumLag = 0.0;
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+        assert(uniform[i] >= 0.0 && uniform[i] < 1.0);
+        sum += uniform[i];
+        sumSquares += uniform[i] * uniform[i];
+        if (i > 0u)
+            sumLag += (uniform[i] - 0.5) * (uniform[i - 1u] - 0.5);
+    }
+    double const mean = sum / count;
+    double const variance = sumSquares / count - mean * mean;
+    double const correlation = (sumLag / (count - 1u)) / variance;
+    std::cout << "uniform mean: " << mean << ", variance: " << variance << ", lag-1 correlation: " << correlation << std::endl;
+    assert(std::abs(mean - 0.5) < 0.001);
+    assert(std::abs(variance - 1.0 / 12.0) < 0.001);
+    assert(std::abs(correlation) < 0.005);
+
+    // normal doubles: mean, standard deviation and tail frequency
+    std::vector<double> normal(count + 1u);
+    engine.fill_normal(normal, 10.0, 2.0);
+    sum = 0.0;
+    sumSquares = 0.0;
+    std::size_t tail = 0u;
+    for (auto const& value : normal)
+    {
+        sum += value;
+        sumSquares += value * value;
+        if (std::abs(value - 10.0) > 2.0 * 1.96)
+            ++tail;
+    }
+    double const normalMean = sum / normal.size();
+    double const normalDeviation = std::sqrt(sumSquares / normal.size() - normalMean * normalMean);
+    double const tailFraction = static_cast<double>(tail) / normal.size();
+    std::cout << "normal mean: " << normalMean << ", standard deviation: " << normalDeviation << ", |z| > 1.96: " << tailFraction << std::endl;
+    assert(std::abs(normalMean - 10.0) < 0.01);
+    assert(std::abs(normalDeviation - 2.0) < 0.01);
+    assert(std::abs(tailFraction - 0.05) < 0.002);
+}
+
+void test_random()
+{
+    neolib::simd_random random{ 42u };
+    std::vector<uint32_t> values(100000u);
+    random.fill(values, 10u, 20u);
+    std::array<std::size_t, 11> histogram = {};
+    for (auto const& value : values)
+    {
+        assert(value >= 10u && value <= 20u);
+        ++histogram[value - 10u];
+    }
+    for ([[maybe_unused]] auto const& n : histogram)
+        assert(n > 0u);
+    random.fill(values, 0u, 0xFFFFFFFFu);
+    assert(random.get(5u) <= 5u);
+    neolib::basic_random<double, neolib::simd_xoshiro256ss_engine> realRandom{ 42u };
+    std::vector<double> reals(1000u);
+    realRandom.fill(reals, -1.0, 1.0);
+    for ([[maybe_unused]] auto const& value : reals)
+        assert(value >= -1.0 && value <= 1.0);
+    // a secure generator with a small state must not reseed (a std::random_device read and a lane jump each) more often than std::mt19937
+    static_assert(neolib::random_traits<uint32_t, neolib::simd_xoshiro256ss_engine>::reseed_interval >= std::mt19937::state_size);
+    neolib::simd_random secureRandom;
+    secureRandom.fill(values, 1u, 6u);
+    for ([[maybe_unused]] auto const& value : values)
+        assert(value >= 1u && value <= 6u);
+    neolib::random mt{ 42u };
+    mt.fill(values, 1u, 6u);
+    for ([[maybe_unused]] auto const& value : values)
+        assert(value >= 1u && value <= 6u);
+    for (int i = 0; i < 1000; ++i)
+        assert(neolib::simd_rand(7) < 7);
+}
+
+#ifdef BENCHMARK_RANDOM
+// throughput of the SIMD engine against the standard library; only meaningful in an optimized build
+void benchmark()
+{
+    typedef std::chrono::steady_clock clock;
+    auto const elapsed = [](clock::time_point aStart) { return std::chrono::duration<double, std::milli>(clock::now() - aStart).count(); };
+    std::size_t constexpr count = 1u << 24;
+    std::vector<uint64_t> raw(count);
+    std::vector<double> reals(count);
+    uint64_t checksum = 0u;
+
+    std::mt19937_64 mt{ 42u };
+    auto start = clock::now();
+    for (auto& value : raw)
+        value = mt();
+    std::cout << "std::mt19937_64: " << elapsed(start) << " ms" << std::endl;
+    checksum += raw[count / 2u];
+
+    neolib::simd_xoshiro256ss_engine engine{ 42u };
+    start = clock::now();
+    for (auto& value : raw)
+        value = engine();
+    std::cout << "simd_xoshiro256ss_engine (single values): " << elapsed(start) << " ms" << std::endl;
+    checksum += raw[count / 2u];
+
+    start = clock::now();
+    engine.fill(raw);
+    std::cout << "simd_xoshiro256ss_engine (fill): " << elapsed(start) << " ms" << std::endl;
+    checksum += raw[count / 2u];
+
+    std::uniform_real_distribution<double> uniform;
+    start = clock::now();
+    for (auto& value : reals)
+        value = uniform(mt);
+    std::cout << "std::uniform_real_distribution<double> over std::mt19937_64: " << elapsed(start) << " ms" << std::endl;
+    checksum += static_cast<uint64_t>(reals[count / 2u] * 1000.0);
+
+    start = clock::now();
+    engine.fill_uniform(reals);
+    std::cout << "simd_xoshiro256ss_engine (fill_uniform): " << elapsed(start) << " ms" << std::endl;
+    checksum += static_cast<uint64_t>(reals[count / 2u] * 1000.0);
+
+    std::normal_distribution<double> normal;
+    start = clock::now();
+    for (auto& value : reals)
+        value = normal(mt);
+    std::cout << "std::normal_distribution<double> over std::mt19937_64: " << elapsed(start) << " ms" << std::endl;
+    checksum += static_cast<uint64_t>(reals[count / 2u] * 1000.0);
+
+    start = clock::now();
+    engine.fill_normal(reals);
+    std::cout << "simd_xoshiro256ss_engine (fill_normal): " << elapsed(start) << " ms" << std::endl;
+    checksum += static_cast<uint64_t>(reals[count / 2u] * 1000.0);
+
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+#endif
+
+int main()
+{
+    test_xoshiro256ss_kernels();
+    test_engine_sequence();
+    test_statistics();
+    test_random();
+#ifdef BENCHMARK_RANDOM
+    benchmark();
+#endif
+}
@@ -1,6 +1,8 @@
 #include <neolib/task/event.hpp>
 #include <neolib/task/async_thread.hpp>
 #include <neolib/task/timer.hpp>
+#include <neolib/task/timer_wheel.hpp>
+#include <boost/asio.hpp>
 
 namespace test
 {
@@ -23,8 +25,78 @@ namespace test
 	};
 }
 
+namespace test
+{
+	std::vector<neolib::timer_wheel::tick_type> expire(neolib::timer_wheel& aWheel, neolib::timer_wheel::tick_type aTick)
+	{
+		aWheel.advance(aTick);
+		std::vector<neolib::timer_wheel::tick_type> result;
+		while (auto n = aWheel.pop_due())
+			result.push_back(n->tick());
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	void test_timer_wheel()
+	{
+		typedef neolib::timer_wheel::tick_type tick_type;
+		neolib::timer_wheel wheel{ 10u };
+		tick_type const ticks[] = {
+			11u,                                    // level 0
+			10u + neolib::timer_wheel::kSlots,      // level 1, cascades into level 0
+			5000u,                                  // level 2, cascades twice
+			10u + neolib::timer_wheel::kRange * 2u, // beyond the top level: overflow list
+			9u };                                   // already due
+		neolib::timer_wheel::node nodes[std::size(ticks)];
+		for (std::size_t i = 0; i < std::size(ticks); ++i)
+			wheel.insert(nodes[i], ticks[i]);
+		neolib::timer_wheel::node cancelled;
+		wheel.insert(cancelled, 4999u);
+		if (wheel.size() != std::size(ticks) + 1u || wheel.due_count() != 1u || wheel.next_expiry() != tick_type{ 10u })
+			throw std::logic_error("failed");
+		wheel.remove(cancelled);
+		if (cancelled.scheduled() || wheel.size() != std::size(ticks))
+			throw std::logic_error("failed");
+		if (expire(wheel, 10u) != std::vector<tick_type>{ 9u })
+			throw std::logic_error("failed");
+		if (expire(wheel, 11u) != std::vector<tick_type>{ 11u })
+			throw std::logic_error("failed");
+		if (!expire(wheel, 10u + neolib::timer_wheel::kSlots - 1u).empty())
+			throw std::logic_error("failed");
+		if (expire(wheel, 10u + neolib::timer_wheel::kSlots) != std::vector<tick_type>{ 10u + neolib::timer_wheel::kSlots })
+			throw std::logic_error("failed");
+		if (!expire(wheel, 4999u).empty() || expire(wheel, 5000u) != std::vector<tick_type>{ 5000u })
+			throw std::logic_error("failed");
+		// re-inserting a scheduled node moves it rather than duplicating it
+		wheel.insert(nodes[0], 6000u);
+		wheel.insert(nodes[0], 7000u);
+		if (wheel.size() != 2u || !expire(wheel, 6999u).empty() || expire(wheel, 7000u) != std::vector<tick_type>{ 7000u })
+			throw std::logic_error("failed");
+		if (!expire(wheel, 10u + neolib::timer_wheel::kRange * 2u - 1u).empty())
+			throw std::logic_error("failed");
+		if (expire(wheel, 10u + neolib::timer_wheel::kRange * 2u) != std::vector<tick_type>{ 10u + neolib::timer_wheel::kRange * 2u })
+			throw std::logic_error("failed");
+		if (!wheel.empty() || wheel.next_expiry() != std::nullopt)
+			throw std::logic_error("failed");
+	}
+
+	void test_io_service_run()
+	{
+		// running the native io service to completion returns once it runs out of work
+		neolib::async_task task{ "test::io_service" };
+		auto& ioService = task.io_service().native_object<boost::asio::io_service>();
+		bool ran = false;
+		boost::asio::post(ioService, [&]() { ran = true; });
+		ioService.run();
+		if (!ran)
+			throw std::logic_error("failed");
+	}
+}
+
 int main()
 {
+	test::test_timer_wheel();
+	test::test_io_service_run();
 	std::optional<std::pair<double, double>> stats;
 	for (int32_t i = 1; i <= 200; ++i)
 	{
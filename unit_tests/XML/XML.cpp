@@ -0,0 +1,98 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cassert>
+#include <neolib/file/xml.hpp>
+
+namespace
+{
+    char const sDocument[] =
+        "<?xml version=\"1.0\"?>\n"
+        "<!-- settings -->\n"
+        "<settings version=\"2\" owner=\"Tom &amp; Jerry\">\n"
+        "  <window x=\"10\" y=\"20\">main &lt;window&gt; title</window>\n"
+        "  <![CDATA[raw <data>]]>\n"
+        "  <empty/>\n"
+        "</settings>\n";
+}
+
+void test_arena_xml()
+{
+    neolib::arena_xml document;
+    std::istringstream input{ sDocument };
+    assert(document.read(input));
+    assert(!document.error());
+    assert(document.root().name() == "settings");
+    assert(document.root().attribute_value("owner") == "Tom & Jerry");
+    auto window = document.root().find("window");
+    assert(window != document.root().end());
+    assert(static_cast<const neolib::arena_xml::element&>(*window).attribute_value("y") == "20");
+    assert(static_cast<const neolib::arena_xml::element&>(*window).text() == "main <window> title");
+    assert(document.arena().blocks() != 0u);
+
+    // nodes added through the tree come from the arena of the document they are added to
+    neolib::arena_xml other;
+    other.root().name() = "other";
+    auto const otherAllocated = other.arena().allocated();
+    auto const allocated = document.arena().allocated();
+    auto& added = document.root().append("added");
+    added.set_attribute("key", "a value long enough not to fit in a small string buffer");
+    added.append_text("some text");
+    assert(document.arena().allocated() > allocated);
+    assert(other.arena().allocated() == otherAllocated);
+    assert(added.get_allocator() == document.root().get_allocator());
+
+    std::ostringstream output;
+    document.write(output);
+    assert(output.str().find("<added key=\"a value long enough not to fit in a small string buffer\">some text</added>") != std::string::npos);
+    assert(output.str().find("owner=\"Tom &amp; Jerry\"") != std::string::npos);
+
+    // clearing releases the arena without destroying the tree node by node
+    document.clear();
+    assert(document.arena().blocks() == 0u);
+    assert(!document.got_root());
+    std::istringstream again{ sDocument };
+    assert(document.read(again));
+    assert(document.root().attribute_value("version") == "2");
+}
+
+void test_arena_wxml()
+{
+    neolib::arena_wxml document;
+    std::wistringstream input{ L"<root a=\"&lt;1&gt;\"><child>caf&#233;</child><child/></root>" };
+    assert(document.read(input));
+    assert(document.root().name() == L"root");
+    assert(document.root().attribute_value(L"a") == L"<1>");
+    std::size_t children = 0u;
+    for (auto const& child : document.root())
+    {
+        assert(child.name() == L"child");
+        ++children;
+    }
+    assert(children == 2u);
+    assert(static_cast<const neolib::arena_wxml::element&>(*document.root().begin()).text() == L"café");
+    document.root().append(L"added").set_attribute(L"key", L"a wide value that needs heap storage");
+    assert(document.root().find(L"added") != document.root().end());
+    document.clear();
+    assert(document.arena().blocks() == 0u);
+}
+
+void test_xml()
+{
+    neolib::xml document;
+    std::istringstream input{ sDocument };
+    assert(document.read(input));
+    assert(document.root().attribute_value("owner") == "Tom & Jerry");
+    document.root().append("added").set_attribute("key", "value");
+    std::ostringstream output;
+    document.write(output);
+    assert(output.str().find("<added key=\"value\" />") != std::string::npos);
+}
+
+int main()
+{
+    test_xml();
+    test_arena_xml();
+    test_arena_wxml();
+    std::cout << "XML tests passed" << std::endl;
+}
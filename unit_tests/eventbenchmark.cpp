@@ -0,0 +1,44 @@
+#include <neolib/neolib.hpp>
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <vector>
+#include <neolib/task/event.hpp>
+#include <neolib/task/async_thread.hpp>
+
+void benchmark_event_trigger()
+{
+	neolib::async_task benchmarkTask;
+	neolib::async_thread benchmarkThread{ benchmarkTask, "neolib::event benchmark", true };
+
+	const int ITERATIONS = 1000000;
+
+	for (std::size_t subscribers : { 0u, 1u, 8u, 64u })
+	{
+		neolib::event<int> e;
+		neolib::sink sink;
+		long long total = 0;
+		for (std::size_t s = 0; s < subscribers; ++s)
+			sink += e([&total](int n) { total += n; });
+
+		for (int i = 0; i < ITERATIONS / 10; ++i)
+			e.trigger(i);
+		total = 0;
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < ITERATIONS; ++i)
+			e.trigger(i);
+
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+		assert(total == static_cast<long long>(subscribers) * ITERATIONS * (ITERATIONS - 1) / 2);
+		std::cout << "\nsubscribers: " << subscribers << "\ncheck: " << total << "\ntime: " << static_cast<double>(ns) / ITERATIONS << "ns/trigger" << std::endl;
+	}
+}
+
+int main()
+{
+	benchmark_event_trigger();
+}
@@ -1,6 +1,7 @@
 #include <neolib/neolib.hpp>
 #include <iostream>
 #include <set>
+#include <optional>
 #include <neolib/task/thread.hpp>
 #include <neolib/task/thread_pool.hpp>
 
@@ -29,3 +30,274 @@ void benchmark_thread_pool()
 	std::cout << "\ncheck: " << s.size() << "\ntime: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << std::endl;
 }
 
+void benchmark_thread_pool_contention(neolib::thread_pool_scheduling aScheduling)
+{
+	neolib::thread_pool threadPool{ aScheduling };
+
+	const int PRODUCERS = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+	const int ITERATIONS = 100000;
+	const int PRIORITIES[] = { -1, 0, 1 };
+	std::atomic<int> counter = 0;
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p < PRODUCERS; ++p)
+		producers.emplace_back([&, p]()
+		{
+			for (int i = 0; i < ITERATIONS; ++i)
+				threadPool.run([&counter]()
+				{
+					counter.fetch_add(1, std::memory_order_relaxed);
+				}, PRIORITIES[(p + i) % 3]);
+		});
+	for (auto& producer : producers)
+		producer.join();
+	threadPool.wait();
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	std::cout << (aScheduling == neolib::thread_pool_scheduling::WorkStealing ? "\nwork stealing" : "\nshared queue lock") << 
+		" (" << PRODUCERS << " producers, " << threadPool.max_threads() << " threads)" <<
+		"\ncheck: " << counter << " (expected " << PRODUCERS * ITERATIONS << ")" <<
+		"\ntime: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << std::endl;
+	if (counter != PRODUCERS * ITERATIONS)
+		throw std::logic_error("failed");
+}
+
+void test_thread_pool_stop_idle()
+{
+	// tasks still queued when a work stealing pool stops are discarded and must not keep it busy
+	std::atomic<bool> release = false;
+	neolib::thread_pool threadPool{ neolib::thread_pool_scheduling::WorkStealing };
+	for (std::size_t i = 0; i < threadPool.max_threads(); ++i)
+		threadPool.run([&]() { while (!release) std::this_thread::yield(); });
+	for (int i = 0; i < 100; ++i)
+		threadPool.run([]() {});
+	std::thread releaser{ [&]() { std::this_thread::sleep_for(std::chrono::milliseconds{ 50 }); release = true; } };
+	threadPool.stop();
+	releaser.join();
+	if (!threadPool.idle())
+		throw std::logic_error("failed");
+	threadPool.wait();
+}
+
+void test_thread_pool_work_stealing_order()
+{
+	// work stealing scheduling services higher priority bands first and dequeues equal priority tasks submitted from 
+	// outside the pool in FIFO order; concurrently running workers may start them out of order by at most the number of threads
+	if (neolib::thread_pool::priority_band(5) >= neolib::thread_pool::priority_band(1) || 
+		neolib::thread_pool::priority_band(1) >= neolib::thread_pool::priority_band(0) ||
+		neolib::thread_pool::priority_band(0) >= neolib::thread_pool::priority_band(-1) ||
+		neolib::thread_pool::priority_band(42) != 0 || 
+		neolib::thread_pool::priority_band(-42) != neolib::thread_pool::kPriorityBands - 1)
+		throw std::logic_error("failed");
+	const int TASKS = 1000;
+	std::atomic<bool> release = false;
+	std::atomic<int> sequence = 0;
+	std::vector<int> started(TASKS, -1);
+	int highPriorityStarted = -1;
+	int higherPriorityStarted = -1;
+	neolib::thread_pool threadPool{ neolib::thread_pool_scheduling::WorkStealing };
+	int const threads = static_cast<int>(threadPool.max_threads());
+	for (int i = 0; i < threads; ++i)
+		threadPool.run([&]() { while (!release) std::this_thread::yield(); });
+	while (threadPool.active_threads() != static_cast<std::size_t>(threads))
+		std::this_thread::yield();
+	for (int i = 0; i < TASKS; ++i)
+		threadPool.run([&, i]() { started[i] = sequence++; });
+	threadPool.run([&]() { highPriorityStarted = sequence++; }, 1);
+	threadPool.run([&]() { higherPriorityStarted = sequence++; }, 5);
+	release = true;
+	threadPool.wait();
+	if (highPriorityStarted < 0 || highPriorityStarted > threads || higherPriorityStarted < 0 || higherPriorityStarted >= threads)
+		throw std::logic_error("failed");
+	for (int i = 0; i < TASKS; ++i)
+		if (started[i] < 0 || std::abs(started[i] - i) > threads + 2)
+			throw std::logic_error("failed");
+}
+
+void test_thread_pool_work_stealing_nested()
+{
+	// tasks a worker submits go on its own deque; idle workers steal them so all of them run
+	const int OUTER = 64;
+	const int INNER = 1000;
+	std::atomic<int> counter = 0;
+	neolib::thread_pool threadPool{ neolib::thread_pool_scheduling::WorkStealing };
+	threadPool.reserve(std::max<std::size_t>(threadPool.max_threads(), 4u));
+	for (int i = 0; i < OUTER; ++i)
+		threadPool.run([&, i]()
+		{
+			for (int j = 0; j < INNER; ++j)
+				threadPool.run([&]() { counter.fetch_add(1, std::memory_order_relaxed); }, (i + j) % 3 - 1);
+		});
+	threadPool.wait();
+	if (counter != OUTER * INNER)
+		throw std::logic_error("failed");
+}
+
+void benchmark_thread_pool_submit(neolib::thread_pool_scheduling aScheduling)
+{
+	neolib::thread_pool threadPool{ aScheduling };
+
+	const int ITERATIONS = 100000;
+	std::vector<int> v(ITERATIONS);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	std::vector<std::future<void>> futures;
+	futures.reserve(ITERATIONS);
+	for (int i = 0; i < ITERATIONS; ++i)
+		futures.push_back(threadPool.run([i, &v]() { v[i] = i; }).first);
+	for (auto& f : futures)
+		f.wait();
+
+	std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+
+	std::vector<neolib::task_handle<int>> handles;
+	handles.reserve(ITERATIONS);
+	for (int i = 0; i < ITERATIONS; ++i)
+		handles.push_back(threadPool.submit([i, &v]() { v[i] = -i; return i; }));
+	long long sum = 0;
+	for (auto& h : handles)
+		sum += h.get();
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	std::cout << (aScheduling == neolib::thread_pool_scheduling::WorkStealing ? "\nwork stealing" : "\nshared queue lock") <<
+		"\nrun (std::future): " << std::chrono::duration_cast<std::chrono::milliseconds>(middle - begin).count() << "ms" <<
+		"\nsubmit (task_handle): " << std::chrono::duration_cast<std::chrono::milliseconds>(end - middle).count() << "ms" << std::endl;
+	if (sum != static_cast<long long>(ITERATIONS) * (ITERATIONS - 1) / 2)
+		throw std::logic_error("failed");
+}
+
+void test_thread_pool_submit_abandoned(neolib::thread_pool_scheduling aScheduling)
+{
+	std::atomic<bool> release = false;
+	std::vector<neolib::task_handle<int>> handles;
+	{
+		neolib::thread_pool threadPool{ aScheduling };
+		for (std::size_t i = 0; i < threadPool.max_threads(); ++i)
+			handles.push_back(threadPool.submit([&]() { while (!release) std::this_thread::yield(); return 0; }));
+		for (int i = 1; i <= 100; ++i)
+			handles.push_back(threadPool.submit([i]() { return i; }));
+		std::thread releaser{ [&]() { std::this_thread::sleep_for(std::chrono::milliseconds{ 50 }); release = true; } };
+		threadPool.stop();
+		releaser.join();
+		// tasks submitted to a stopped pool are not run but their handles still complete
+		auto late = threadPool.submit([]() { return 42; });
+		bool cancelled = false;
+		try { late.get(); } catch (neolib::task_handle<int>::task_cancelled const&) { cancelled = true; }
+		if (!cancelled)
+			throw std::logic_error("failed");
+	}
+	// every handle completes (either run or abandoned by the stopped pool); none may block forever
+	std::size_t ran = 0;
+	std::size_t abandoned = 0;
+	for (auto& h : handles)
+	{
+		try 
+		{ 
+			h.get(); 
+			++ran; 
+		} 
+		catch (neolib::task_handle<int>::task_cancelled const&) 
+		{ 
+			++abandoned; 
+		}
+	}
+	std::cout << (aScheduling == neolib::thread_pool_scheduling::WorkStealing ? "\nwork stealing" : "\nshared queue lock") <<
+		"\nsubmit then stop: " << ran << " ran, " << abandoned << " abandoned" << std::endl;
+	if (ran + abandoned != handles.size())
+		throw std::logic_error("failed");
+}
+
+void test_thread_pool_submit_during_stop()
+{
+	// a submit racing stop() is either run or discarded; neither its handle nor wait() may block forever
+	for (int round = 0; round < 20; ++round)
+	{
+		std::vector<std::vector<neolib::task_handle<int>>> handles(4);
+		std::vector<std::thread> submitters;
+		{
+			neolib::thread_pool threadPool{ neolib::thread_pool_scheduling::WorkStealing };
+			std::atomic<bool> go = false;
+			for (auto& submitted : handles)
+				submitters.emplace_back([&]()
+				{
+					while (!go)
+						std::this_thread::yield();
+					for (int i = 0; i < 1000; ++i)
+						submitted.push_back(threadPool.submit([i]() { return i; }));
+				});
+			go = true;
+			std::this_thread::yield();
+			threadPool.stop();
+			for (auto& submitter : submitters)
+				submitter.join();
+			threadPool.wait();
+			if (!threadPool.idle())
+				throw std::logic_error("failed");
+		}
+		for (auto& submitted : handles)
+			for (auto& h : submitted)
+			{
+				try { h.get(); } catch (neolib::task_handle<int>::task_cancelled const&) {}
+			}
+	}
+}
+
+void test_thread_pool_submit_released_at_thread_exit()
+{
+	// a handle released during thread exit, after the thread's task free list has been orphaned, must not use that thread's 
+	// (destroyed) current free list
+	neolib::thread_pool threadPool{ neolib::thread_pool_scheduling::WorkStealing };
+	std::thread submitter{ [&]()
+	{
+		// constructed before the free list so destroyed after it
+		thread_local std::optional<neolib::task_handle<int>> tHandle;
+		tHandle.emplace(threadPool.submit([]() { return 42; }));
+		if (tHandle->get() != 42)
+			throw std::logic_error("failed");
+	} };
+	submitter.join();
+}
+
+void test_thread_pool_submit_cancel(neolib::thread_pool_scheduling aScheduling)
+{
+	// a task cancelled before it starts never runs and its handle reports the cancellation
+	std::atomic<bool> release = false;
+	std::atomic<bool> ran = false;
+	neolib::thread_pool threadPool{ aScheduling };
+	std::vector<neolib::task_handle<int>> blockers;
+	for (std::size_t i = 0; i < threadPool.max_threads(); ++i)
+		blockers.push_back(threadPool.submit([&]() { while (!release) std::this_thread::yield(); return 0; }));
+	auto cancelled = threadPool.submit([&]() { ran = true; return 1; });
+	cancelled.cancel();
+	release = true;
+	bool threw = false;
+	try { cancelled.get(); } catch (neolib::task_handle<int>::task_cancelled const&) { threw = true; }
+	for (auto& b : blockers)
+		b.get();
+	threadPool.wait();
+	if (!threw || ran)
+		throw std::logic_error("failed");
+}
+
+int main()
+{
+	benchmark_thread_pool();
+	benchmark_thread_pool_contention(neolib::thread_pool_scheduling::SharedQueueLock);
+	benchmark_thread_pool_contention(neolib::thread_pool_scheduling::WorkStealing);
+	test_thread_pool_stop_idle();
+	test_thread_pool_work_stealing_order();
+	test_thread_pool_work_stealing_nested();
+	benchmark_thread_pool_submit(neolib::thread_pool_scheduling::SharedQueueLock);
+	benchmark_thread_pool_submit(neolib::thread_pool_scheduling::WorkStealing);
+	test_thread_pool_submit_abandoned(neolib::thread_pool_scheduling::SharedQueueLock);
+	test_thread_pool_submit_abandoned(neolib::thread_pool_scheduling::WorkStealing);
+	test_thread_pool_submit_cancel(neolib::thread_pool_scheduling::SharedQueueLock);
+	test_thread_pool_submit_cancel(neolib::thread_pool_scheduling::WorkStealing);
+	test_thread_pool_submit_during_stop();
+	test_thread_pool_submit_released_at_thread_exit();
+}